@@ -0,0 +1,2167 @@
+/*
+
+					SpoutBenchmark.cpp
+
+		Performance comparison of the spoutCopy pixel functions
+
+		Each line conversion is timed for every instruction set tier
+		supported by the CPU at 1080p, 4K and 6K and compared with
+		the SSE versions that were the fastest available previously.
+
+		Multi-threaded copies are timed at 6K for 1 to N threads.
+
+		memcpy_sse2 is compared with memcpy for sizes from 4KB to 200MB
+		with cached and non-temporal stores.
+
+		Resampling is timed for each filter with one and all threads.
+
+		Every 3 and 4 byte layout conversion from the line template,
+		including mirror, is timed at 4K for each tier.
+
+		8 bit, 16 bit, half and float rgba conversions are timed at 4K
+		for the scalar, SSE2 and AVX2 (with F16C) tiers.
+
+		Convert with a change of format, size and orientation in one pass
+		is compared with the same conversion by chained calls through
+		intermediate buffers, with the bytes read and written by each.
+
+		A generated 33 point .cube LUT is parsed and applied at 4K to
+		8 bit, 16 bit and float rgba for the scalar and SSE2 versions
+		with one and all threads.
+
+		Transfer function conversions are timed at 4K for each format.
+
+		YUV to rgba and rgba to YUV are timed at 4K for NV12, P010, UYVY
+		and v210 with BT.709 limited range for the scalar and SSE2 versions.
+
+		Dithered conversion of 16 bit, half and float rgba to 8 bit bgra
+		is timed at 4K for each method with one and all threads and compared
+		with memcpy of the source frame.
+
+		Premultiply, unpremultiply and opaque alpha are timed at 6K for
+		8 bit, 16 bit, half and float rgba with one and all threads.
+		A change of format with premultiply in one pass by Convert is
+		compared with ConvertRGBA followed by ApplyAlpha.
+
+		Rotation and transpose of 4 and 8 byte pixels are timed at 6K for
+		each tier with one and all threads and compared with a pixel by
+		pixel loop.
+
+		A 6K canvas split across 8 outputs is copied to each output with
+		ConvertRegion and compared with resampling the whole canvas to
+		each output, with the bytes read by each.
+
+		Tile hashes for frame change detection are timed at 6K for 8 and
+		16 bit rgba for each tier with one and all threads and compared
+		with memcpy of the frame.
+
+		Thumbnails of 1/2, 1/4 and 1/8 size are made from 6K frames of each
+		rgba format with one and all threads. The cost of Submit to the
+		thumbnail publisher is timed for every frame of a 60 fps loop,
+		with a thumbnail due every 100 msec.
+
+		SpoutSharedMemory Create, Open and Close and an uncontended Lock
+		and Unlock are timed in nsec. Threads with their own objects for
+		the same memory then increment a counter in the buffer while locked.
+
+		Sender information is read with spoutSenderNames::getSharedInfo by
+		32 threads while one thread changes it with UpdateSender, and by
+		opening and locking the map for every read as getSharedInfo did
+		before, giving the reads and writes per second of each (Windows).
+
+		4K rgba frames are written to shared memory by one thread and read
+		by another as fast as they can, with one region locked by a mutex
+		and with a ring buffer of 3 slots, giving the frames written and
+		read per second and the longest time to write a frame.
+
+		Finding the data size of a memory buffer is timed in nsec for the
+		atoi of the size text used previously, the size text alone and the
+		binary buffer header.
+
+		A 4K rgba frame in a memory buffer and in a ring buffer is converted
+		to bgra by a receiver, copying it out of shared memory first as
+		ReadMemoryBuffer and ReadMemoryPixels do and converting it from
+		a lease without the copy.
+
+		A 6K rgba16 frame is copied into shared memory and rotated by 90
+		degrees out of it, with normal pages, with large pages requested
+		and with the pages on the NUMA node of the thread, showing whether
+		large pages were available. On Linux the same is done with private
+		memory with and without transparent huge pages, for the gain that
+		large pages give on the machine.
+
+		A sender thread publishes a frame every 2 msec to a receiver
+		thread that waits on the frame notifier, polls it with a 1 msec
+		sleep or polls it with a yield, giving the time in usec from
+		publishing the frame to the receiver finding it and the nsec
+		of reading the frame number.
+
+		With --suite, every public spoutCopy copy and conversion method is
+		timed instead at 720p, 1080p, 4K and 6K, with aligned and offset
+		buffers and line pitch and with invert on and off, reporting GB/s
+		and ns/pixel. --json <file> also writes the results to a file to
+		compare one release with another. The suite uses one thread unless
+		a count is given with --threads.
+
+		The benchmark only times the functions. Their results, and those
+		of every tier against the scalar tier, are checked by SpoutCopyTest
+		(see Test/SpoutCopyTest.cpp).
+
+		Build with the SPOUT_BUILD_BENCHMARK CMake option.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#include "../SpoutCopy.h"
+#include "../SpoutThreadPool.h"
+#include "../SpoutLut.h"
+#include "../SpoutTransfer.h"
+#include "../SpoutConvert.h"
+#include "../SpoutYUV.h"
+#include "../SpoutDither.h"
+#include "../SpoutFrameHash.h"
+#include "../SpoutThumbnail.h"
+#include "../SpoutSharedMemory.h"
+#include "../SpoutMemoryRing.h"
+#include "../SpoutMemoryBuffer.h"
+#include "../SpoutFrameNotify.h"
+#if defined(_WIN32)
+#include "../SpoutSenderNames.h"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cmath>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+struct Resolution {
+	const char *name;
+	unsigned int width;
+	unsigned int height;
+};
+
+static const Resolution resolutions[] = {
+	{ "1080p", 1920, 1080 },
+	{ "4K",    3840, 2160 },
+	{ "6K",    6144, 3456 },
+};
+
+struct Conversion {
+	const char *name;
+	unsigned int srcBytes; // bytes per source pixel
+	unsigned int dstBytes; // bytes per destination pixel
+	SpoutRowKernel SpoutCopyKernels::*kernel;
+};
+
+static const Conversion conversions[] = {
+	{ "rgba2bgra", 4, 4, &SpoutCopyKernels::rgba_bgra },
+	{ "rgb2rgba",  3, 4, &SpoutCopyKernels::rgb_rgba },
+	{ "bgr2rgba",  3, 4, &SpoutCopyKernels::rgb_bgra },
+	{ "rgb2rgba (pitch)", 3, 4, &SpoutCopyKernels::rgb_rgbx },
+	{ "bgr2rgba (pitch)", 3, 4, &SpoutCopyKernels::rgb_bgrx },
+	{ "rgba2rgb",  4, 3, &SpoutCopyKernels::rgba_rgb },
+	{ "rgba2bgr",  4, 3, &SpoutCopyKernels::rgba_bgr },
+};
+
+//
+// Time a frame function and return the average milliseconds per frame.
+// One untimed call warms the caches and page tables.
+//
+template <typename Function>
+static double TimeFrames(Function function, unsigned int frames)
+{
+	function();
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < frames; i++)
+		function();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / (double)frames;
+}
+
+// GB/s for the bytes read and written per frame
+static double Throughput(double bytes, double msec)
+{
+	return msec > 0.0 ? bytes / (msec * 1.0e6) : 0.0;
+}
+
+//
+// Line conversions for each tier
+//
+static void BenchmarkTiers(unsigned int frames)
+{
+	const SpoutCopyTier supported = spoutCopy::GetSupportedTier();
+	printf("Supported tier : %s\n\n", spoutCopy::GetKernels(supported)->name);
+
+	// The SSE versions are the previous fastest functions
+	const SpoutCopyTier baseline = (supported >= SPOUT_COPY_SSSE3) ? SPOUT_COPY_SSSE3 : supported;
+
+	for (const Resolution &res : resolutions) {
+
+		const size_t pixels = (size_t)res.width * res.height;
+		std::vector<unsigned char> src(pixels * 4);
+		std::vector<unsigned char> dst(pixels * 4);
+		for (size_t i = 0; i < src.size(); i++)
+			src[i] = (unsigned char)rand();
+
+		printf("%s (%ux%u)\n", res.name, res.width, res.height);
+		printf("  %-18s %-8s %10s %10s %10s\n", "function", "tier", "msec", "GB/s", "vs sse");
+
+		for (const Conversion &conv : conversions) {
+			const double bytes = (double)pixels * (conv.srcBytes + conv.dstBytes);
+			auto timeTier = [&](SpoutCopyTier tier) {
+				SpoutRowKernel kernel = spoutCopy::GetKernels(tier)->*conv.kernel;
+				return TimeFrames([&]() {
+					for (unsigned int y = 0; y < res.height; y++)
+						kernel(src.data() + (size_t)y * res.width * conv.srcBytes,
+							dst.data() + (size_t)y * res.width * conv.dstBytes, res.width);
+				}, frames);
+			};
+			const double baseMsec = timeTier(baseline);
+			for (int t = SPOUT_COPY_SCALAR; t <= supported; t++) {
+				const SpoutCopyKernels *kernels = spoutCopy::GetKernels((SpoutCopyTier)t);
+				const double msec = timeTier((SpoutCopyTier)t);
+				printf("  %-18s %-8s %10.3f %10.2f %9.2fx\n",
+					conv.name, kernels->name, msec, Throughput(bytes, msec), baseMsec / msec);
+			}
+		}
+		printf("\n");
+	}
+}
+
+//
+// Multi-threaded copy scaling at 6K
+//
+static void BenchmarkThreads(unsigned int frames, unsigned int maxThreads)
+{
+	const Resolution &res = resolutions[2];
+	const unsigned int width = res.width;
+	const unsigned int height = res.height;
+	const unsigned int pitch = width * 4;
+	const unsigned int stride = pitch + 256; // padded source for RemovePadding
+	std::vector<unsigned char> src((size_t)stride * height);
+	std::vector<unsigned char> dst((size_t)pitch * height);
+	for (size_t i = 0; i < src.size(); i++)
+		src[i] = (unsigned char)rand();
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	printf("Threads %s (%ux%u)\n", res.name, width, height);
+	printf("  %-18s %-8s %10s %10s %10s\n", "function", "threads", "msec", "GB/s", "scaling");
+
+	const double bytes = (double)pitch * height * 2;
+	spoutCopy copy;
+
+	struct ThreadTest {
+		const char *name;
+		std::function<void()> function;
+	};
+	const ThreadTest tests[] = {
+		{ "CopyPixels",    [&]() { copy.CopyPixels(src.data(), dst.data(), width, height); } },
+		{ "FlipBuffer",    [&]() { copy.FlipBuffer(src.data(), dst.data(), width, height); } },
+		{ "RemovePadding", [&]() { copy.RemovePadding(src.data(), dst.data(), width, height, stride, GL_RGBA); } },
+		{ "rgba2bgra",     [&]() { copy.rgba2bgra(src.data(), dst.data(), width, height, stride, false); } },
+	};
+
+	for (const ThreadTest &test : tests) {
+		double oneMsec = 0.0;
+		for (unsigned int n = 1; n <= maxThreads; n++) {
+			copy.SetCopyThreads(n, 0);
+			const double msec = TimeFrames(test.function, frames);
+			if (n == 1)
+				oneMsec = msec;
+			printf("  %-18s %-8u %10.3f %10.2f %9.2fx\n",
+				test.name, n, msec, Throughput(bytes, msec), oneMsec / msec);
+		}
+	}
+	printf("\n");
+}
+
+//
+// memcpy_sse2 with cached and streaming stores from 4KB to 200MB
+//
+static void BenchmarkMemcpy(unsigned int frames)
+{
+	static const size_t sizes[] = {
+		4096, 65536, 262144, 1048576, 4194304, 16777216, 67108864, 209715200
+	};
+	spoutCopy copy;
+	const size_t threshold = copy.GetStreamThreshold();
+	printf("memcpy (stream threshold %.1f MB)\n", (double)threshold / 1048576.0);
+	printf("  %-10s %10s %10s %10s %10s\n", "size", "memcpy", "auto", "cached", "stream");
+
+	// Offset source by 4 bytes to include the unaligned head
+	std::vector<unsigned char> src(sizes[7] + 64);
+	std::vector<unsigned char> dst(sizes[7] + 64);
+	for (size_t i = 0; i < src.size(); i++)
+		src[i] = (unsigned char)rand();
+
+	for (size_t size : sizes) {
+		// Same total bytes for each size so that small copies are timed long enough
+		const unsigned int repeat = (unsigned int)(sizes[7] / size);
+		const double bytes = (double)size * 2.0;
+		auto timeCopy = [&](size_t streamBytes, bool bMemcpy) {
+			copy.SetStreamThreshold(streamBytes);
+			const double msec = TimeFrames([&]() {
+				for (unsigned int i = 0; i < repeat; i++) {
+					if (bMemcpy)
+						memcpy(dst.data(), src.data() + 4, size);
+					else
+						copy.memcpy_sse2(dst.data(), src.data() + 4, size);
+				}
+			}, frames) / (double)repeat;
+			return Throughput(bytes, msec);
+		};
+		const double gbMemcpy = timeCopy(threshold, true);
+		const double gbAuto   = timeCopy(threshold, false);
+		const double gbCached = timeCopy((size_t)-1, false);
+		const double gbStream = timeCopy(0, false);
+		printf("  %-10.0f %10.2f %10.2f %10.2f %10.2f  GB/s\n",
+			(double)size / 1024.0, gbMemcpy, gbAuto, gbCached, gbStream);
+	}
+	copy.SetStreamThreshold(threshold);
+	printf("  (size in KB)\n\n");
+}
+
+//
+// Resample filters for common size changes
+//
+static void BenchmarkResample(unsigned int frames, unsigned int maxThreads)
+{
+	struct SizeChange {
+		const Resolution &from;
+		const Resolution &to;
+	};
+	const SizeChange changes[] = {
+		{ resolutions[2], resolutions[1] }, // 6K to 4K
+		{ resolutions[1], resolutions[0] }, // 4K to 1080p
+		{ resolutions[0], resolutions[1] }, // 1080p to 4K
+	};
+	static const char *filterNames[] = { "nearest", "bilinear", "area" };
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	printf("Resample\n");
+	printf("  %-18s %-8s %-8s %10s %10s %10s\n", "size", "filter", "threads", "msec", "fps", "ns/pixel");
+
+	spoutCopy copy;
+	for (const SizeChange &change : changes) {
+		const Resolution &from = change.from;
+		const Resolution &to = change.to;
+		std::vector<unsigned char> src((size_t)from.width * from.height * 4);
+		std::vector<unsigned char> dst((size_t)to.width * to.height * 4);
+		for (size_t i = 0; i < src.size(); i++)
+			src[i] = (unsigned char)rand();
+		const std::string name = std::string(from.name) + " to " + to.name;
+		for (int f = SPOUT_RESAMPLE_NEAREST; f <= SPOUT_RESAMPLE_AREA; f++) {
+			copy.SetResampleFilter((SpoutResampleFilter)f);
+			const unsigned int threads[] = { 1, maxThreads };
+			for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+				copy.SetCopyThreads(threads[t], 0);
+				const double msec = TimeFrames([&]() {
+					copy.rgba2rgbaResample(src.data(), dst.data(),
+						from.width, from.height, from.width * 4, to.width, to.height);
+				}, frames);
+				printf("  %-18s %-8s %-8u %10.3f %10.1f %10.3f\n", name.c_str(), filterNames[f], threads[t],
+					msec, 1000.0 / msec, msec * 1.0e6 / ((double)to.width * to.height));
+			}
+		}
+	}
+	printf("\n");
+}
+
+//
+// Every 3 and 4 byte line conversion at 4K
+//
+static void BenchmarkLayouts(unsigned int frames)
+{
+	const Resolution &res = resolutions[1];
+	const size_t pixels = (size_t)res.width * res.height;
+	const SpoutCopyTier supported = spoutCopy::GetSupportedTier();
+	std::vector<unsigned char> src(pixels * 4);
+	std::vector<unsigned char> dst(pixels * 4);
+	for (size_t i = 0; i < src.size(); i++)
+		src[i] = (unsigned char)rand();
+
+	printf("Layouts %s (%ux%u)\n", res.name, res.width, res.height);
+	printf("  %-18s %-8s %10s %10s %10s\n", "conversion", "tier", "msec", "GB/s", "vs scalar");
+	for (unsigned int s = 3; s <= 4; s++) {
+		for (unsigned int d = 3; d <= 4; d++) {
+			for (int swap = 0; swap < 2; swap++) {
+				for (int mirror = 0; mirror < 2; mirror++) {
+					if (s == d && !swap && !mirror)
+						continue;
+					std::string name = std::to_string(s) + ">" + std::to_string(d);
+					if (swap) name += " swap";
+					if (mirror) name += " mirror";
+					const double bytes = (double)pixels * (s + d);
+					double scalarMsec = 0.0;
+					for (int t = SPOUT_COPY_SCALAR; t <= supported; t++) {
+						SpoutRowKernel kernel = spoutCopy::GetLineKernel((SpoutCopyTier)t, s, d, swap != 0, mirror != 0);
+						const double msec = TimeFrames([&]() {
+							for (unsigned int y = 0; y < res.height; y++)
+								kernel(src.data() + (size_t)y * res.width * s,
+									dst.data() + (size_t)y * res.width * d, res.width);
+						}, frames);
+						if (t == SPOUT_COPY_SCALAR)
+							scalarMsec = msec;
+						printf("  %-18s %-8s %10.3f %10.2f %9.2fx\n", name.c_str(),
+							spoutCopy::GetKernels((SpoutCopyTier)t)->name, msec, Throughput(bytes, msec), scalarMsec / msec);
+					}
+				}
+			}
+		}
+	}
+	printf("\n");
+}
+
+//
+// 8 bit, 16 bit and floating point rgba conversion at 4K
+//
+static void BenchmarkFormats(unsigned int frames)
+{
+	struct Format {
+		const char *name;
+		GLenum glFormat;
+		unsigned int bytes;
+	};
+	static const Format formats[] = {
+		{ "rgba8", GL_RGBA, 4 },
+		{ "rgba16", GL_RGBA16, 8 },
+		{ "rgba16f", GL_RGBA16F, 8 },
+		{ "rgba32f", GL_RGBA32F, 16 },
+	};
+	const Resolution &res = resolutions[1];
+	const size_t pixels = (size_t)res.width * res.height;
+	const SpoutCopyTier supported = spoutCopy::GetSupportedTier();
+
+	// Source values in range for every format
+	std::vector<float> values(pixels * 4);
+	for (size_t i = 0; i < values.size(); i++)
+		values[i] = (float)(rand() % 65536) / 65535.0f;
+	spoutCopy copy;
+	copy.SetCopyThreads(1, 0);
+	std::vector<unsigned char> sources[4];
+	for (int f = 0; f < 4; f++) {
+		sources[f].resize(pixels * formats[f].bytes);
+		copy.ConvertRGBA(values.data(), sources[f].data(), res.width, res.height, 0, 0, GL_RGBA32F, formats[f].glFormat);
+	}
+	std::vector<unsigned char> dst(pixels * 16);
+
+	printf("RGBA formats %s (%ux%u) 1 thread\n", res.name, res.width, res.height);
+	printf("  %-18s %-8s %10s %10s %10s\n", "conversion", "tier", "msec", "GB/s", "ns/pixel");
+	for (int s = 0; s < 4; s++) {
+		for (int d = 0; d < 4; d++) {
+			if (s == d)
+				continue;
+			const std::string name = std::string(formats[s].name) + " > " + formats[d].name;
+			const double bytes = (double)pixels * (formats[s].bytes + formats[d].bytes);
+			const SpoutCopyTier tiers[] = { SPOUT_COPY_SCALAR, SPOUT_COPY_SSE2, SPOUT_COPY_AVX2 };
+			for (SpoutCopyTier tier : tiers) {
+				if (tier > supported)
+					continue;
+				copy.SetCopyTier(tier);
+				const double msec = TimeFrames([&]() {
+					copy.ConvertRGBA(sources[s].data(), dst.data(), res.width, res.height, 0, 0,
+						formats[s].glFormat, formats[d].glFormat);
+				}, frames);
+				printf("  %-18s %-8s %10.3f %10.2f %10.3f\n", name.c_str(), spoutCopy::GetKernels(tier)->name,
+					msec, Throughput(bytes, msec), msec * 1.0e6 / (double)pixels);
+			}
+		}
+	}
+	printf("\n");
+}
+
+//
+// Single pass Convert compared with chained calls, 6K to 4K
+//
+static void BenchmarkFused(unsigned int frames)
+{
+	struct Layout {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	struct Case {
+		Layout from;
+		Layout to;
+		bool bInvert;
+		bool bMirror;
+	};
+	const Layout rgba8 = { "rgba8", GL_RGBA, 4 };
+	const Layout bgra8 = { "bgra8", GL_BGRA_EXT, 4 };
+	const Layout rgb8 = { "rgb8", GL_RGB, 3 };
+	const Layout rgba16 = { "rgba16", GL_RGBA16, 8 };
+	const Layout rgba16f = { "rgba16f", GL_RGBA16F, 8 };
+	const Case cases[] = {
+		{ bgra8, rgb8, true, false },
+		{ rgba16f, bgra8, true, false },
+		{ rgba8, rgba16, false, true },
+		{ rgba16, bgra8, true, true },
+	};
+	const Resolution &from = resolutions[2];
+	const Resolution &to = resolutions[1];
+	const size_t srcPixels = (size_t)from.width * from.height;
+	const size_t dstPixels = (size_t)to.width * to.height;
+
+	spoutCopy copy;
+	copy.SetResampleFilter(SPOUT_RESAMPLE_BILINEAR);
+	std::vector<unsigned char> src(srcPixels * 8);
+	std::vector<unsigned char> dst(dstPixels * 8);
+	std::vector<unsigned char> srcRGBA(srcPixels * 4); // chained intermediate buffers
+	std::vector<unsigned char> dstRGBA(dstPixels * 4);
+	for (size_t i = 0; i < srcRGBA.size(); i++)
+		srcRGBA[i] = (unsigned char)rand();
+
+	printf("Single pass convert, %s to %s bilinear\n", from.name, to.name);
+	printf("  %-26s %-8s %8s %10s %10s %10s\n", "conversion", "method", "passes", "MB moved", "msec", "vs chain");
+	for (const Case &c : cases) {
+		std::string name = std::string(c.from.name) + " > " + c.to.name;
+		if (c.bInvert) name += " flip";
+		if (c.bMirror) name += " mirror";
+
+		SpoutPixelDesc srcDesc(c.from.format, from.width, from.height);
+		SpoutPixelDesc dstDesc(c.to.format, to.width, to.height);
+		dstDesc.bInvert = c.bInvert;
+		dstDesc.bMirror = c.bMirror;
+		// Source pixels in the source format
+		copy.Convert(srcRGBA.data(), SpoutPixelDesc(GL_RGBA, from.width, from.height), src.data(), srcDesc);
+
+		// Chained : source to 8 bit rgba if needed, resample,
+		// then convert with flip and mirror to the destination.
+		// The fused pass resamples 16 bit and half pixels, or an
+		// 8 bit source to a 16 bit destination, as float and is
+		// more precise than the chain.
+		const bool bSourceRGBA = (c.from.bytes == 4);
+		const SpoutPixelDesc interDesc(bSourceRGBA ? c.from.format : GL_RGBA, to.width, to.height);
+		double chainBytes = (double)srcPixels * 4 + (double)dstPixels * 4 // resample
+			+ (double)dstPixels * (4 + c.to.bytes); // final conversion
+		int passes = 2;
+		if (!bSourceRGBA) {
+			chainBytes += (double)srcPixels * (c.from.bytes + 4);
+			passes++;
+		}
+		const double chainMsec = TimeFrames([&]() {
+			const unsigned char *rgba = src.data();
+			if (!bSourceRGBA) {
+				copy.Convert(src.data(), srcDesc, srcRGBA.data(), SpoutPixelDesc(GL_RGBA, from.width, from.height));
+				rgba = srcRGBA.data();
+			}
+			copy.rgba2rgbaResample(rgba, dstRGBA.data(), from.width, from.height, from.width * 4, to.width, to.height);
+			copy.Convert(dstRGBA.data(), interDesc, dst.data(), dstDesc);
+		}, frames);
+
+		const double fusedBytes = (double)srcPixels * c.from.bytes + (double)dstPixels * c.to.bytes;
+		const double fusedMsec = TimeFrames([&]() {
+			copy.Convert(src.data(), srcDesc, dst.data(), dstDesc);
+		}, frames);
+
+		printf("  %-26s %-8s %8d %10.1f %10.3f %9.2fx\n", name.c_str(), "chained", passes,
+			chainBytes / 1.0e6, chainMsec, 1.0);
+		printf("  %-26s %-8s %8d %10.1f %10.3f %9.2fx\n", name.c_str(), "fused", 1,
+			fusedBytes / 1.0e6, fusedMsec, chainMsec / fusedMsec);
+	}
+	printf("\n");
+}
+
+// A contrast and warmth grade in .cube text
+static std::string GradeCube(unsigned int size)
+{
+	std::ostringstream text;
+	text.precision(6);
+	text << "TITLE \"Benchmark\"\nLUT_3D_SIZE " << size << "\n";
+	for (unsigned int b = 0; b < size; b++) {
+		for (unsigned int g = 0; g < size; g++) {
+			for (unsigned int r = 0; r < size; r++) {
+				const double v[3] = { (double)r / (size - 1), (double)g / (size - 1), (double)b / (size - 1) };
+				for (int c = 0; c < 3; c++) {
+					const double s = v[c] * v[c] * (3.0 - 2.0 * v[c]);
+					text << (c == 0 ? s * 1.05 : c == 1 ? s : s * 0.92) << (c < 2 ? " " : "\n");
+				}
+			}
+		}
+	}
+	return text.str();
+}
+
+//
+// 3D LUT grading at 4K
+//
+static void BenchmarkLut(unsigned int frames, unsigned int maxThreads)
+{
+	struct Format {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	const Format formats[] = {
+		{ "rgba8", GL_RGBA, 4 },
+		{ "rgba16", GL_RGBA16, 8 },
+		{ "rgba32f", GL_RGBA32F, 16 },
+	};
+	const Resolution &res = resolutions[1];
+	const size_t pixels = (size_t)res.width * res.height;
+	const unsigned int size = 33;
+
+	spoutLut lut;
+	const std::string cube = GradeCube(size);
+	const double parseMsec = TimeFrames([&]() { lut.Parse(cube.c_str()); }, 1);
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	printf("3D LUT %s, %u points, %.1f KB text parsed in %.3f msec\n", res.name, size,
+		(double)cube.size() / 1024.0, parseMsec);
+	printf("  %-10s %-8s %-8s %10s %10s %10s\n", "format", "tier", "threads", "msec", "fps", "ns/pixel");
+
+	spoutCopy copy;
+	std::vector<unsigned char> src(pixels * 16);
+	std::vector<unsigned char> dst(pixels * 16);
+	for (const Format &f : formats) {
+		if (f.format == GL_RGBA32F) {
+			float *p = reinterpret_cast<float *>(src.data());
+			for (size_t i = 0; i < pixels * 4; i++)
+				p[i] = (float)rand() / (float)RAND_MAX;
+		}
+		else {
+			for (size_t i = 0; i < src.size(); i++)
+				src[i] = (unsigned char)rand();
+		}
+		const SpoutCopyTier tiers[] = { SPOUT_COPY_SCALAR, SPOUT_COPY_SSE2 };
+		for (SpoutCopyTier tier : tiers) {
+			if (!copy.SetCopyTier(tier))
+				continue;
+			const unsigned int threads[] = { 1, maxThreads };
+			for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+				copy.SetCopyThreads(threads[t], 0);
+				const double msec = TimeFrames([&]() {
+					copy.ApplyLut(lut, src.data(), dst.data(), res.width, res.height, 0, 0, f.format);
+				}, frames);
+				printf("  %-10s %-8s %-8u %10.3f %10.1f %10.3f\n", f.name,
+					tier == SPOUT_COPY_SCALAR ? "scalar" : "sse2", threads[t],
+					msec, 1000.0 / msec, msec * 1.0e6 / (double)pixels);
+			}
+		}
+	}
+	printf("\n");
+}
+
+//
+// Transfer function conversion at 4K
+//
+static void BenchmarkTransfer(unsigned int frames, unsigned int maxThreads)
+{
+	static const char *transferNames[] = { "linear", "srgb", "rec709", "pq", "hlg" };
+
+	struct Format {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	const Format formats[] = {
+		{ "rgba8", GL_RGBA, 4 },
+		{ "rgba16", GL_RGBA16, 8 },
+		{ "rgba16f", GL_RGBA16F, 8 },
+		{ "rgba32f", GL_RGBA32F, 16 },
+	};
+	struct Pair {
+		SpoutTransferFunction from;
+		SpoutTransferFunction to;
+	};
+	const Pair pairs[] = {
+		{ SPOUT_TRANSFER_SRGB, SPOUT_TRANSFER_LINEAR },
+		{ SPOUT_TRANSFER_LINEAR, SPOUT_TRANSFER_PQ },
+		{ SPOUT_TRANSFER_SRGB, SPOUT_TRANSFER_HLG },
+	};
+	const Resolution &res = resolutions[1];
+	const size_t resPixels = (size_t)res.width * res.height;
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	spoutCopy copy;
+	printf("Transfer functions %s\n", res.name);
+	printf("  %-16s %-10s %-8s %-8s %10s %10s %10s\n", "conversion", "format", "tier", "threads", "msec", "fps", "ns/pixel");
+	std::vector<unsigned char> src(resPixels * 16);
+	std::vector<unsigned char> dst(resPixels * 16);
+	std::vector<unsigned char> rgba(resPixels * 4);
+	for (size_t i = 0; i < rgba.size(); i++)
+		rgba[i] = (unsigned char)rand();
+	for (const Pair &pair : pairs) {
+		const std::string name = std::string(transferNames[pair.from]) + " > " + transferNames[pair.to];
+		for (const Format &f : formats) {
+			copy.Convert(rgba.data(), SpoutPixelDesc(GL_RGBA, res.width, res.height),
+				src.data(), SpoutPixelDesc(f.format, res.width, res.height));
+			const SpoutCopyTier tiers[] = { SPOUT_COPY_SCALAR, SPOUT_COPY_SSE2 };
+			for (SpoutCopyTier tier : tiers) {
+				// Only float is different for the tiers
+				if (tier == SPOUT_COPY_SCALAR && f.format != GL_RGBA32F)
+					continue;
+				if (!copy.SetCopyTier(tier))
+					continue;
+				const unsigned int threads[] = { 1, maxThreads };
+				for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+					copy.SetCopyThreads(threads[t], 0);
+					const double msec = TimeFrames([&]() {
+						copy.ApplyTransfer(src.data(), dst.data(), res.width, res.height, 0, 0,
+							f.format, pair.from, pair.to);
+					}, frames);
+					printf("  %-16s %-10s %-8s %-8u %10.3f %10.1f %10.3f\n", name.c_str(), f.name,
+						tier == SPOUT_COPY_SCALAR ? "scalar" : "sse2", threads[t],
+						msec, 1000.0 / msec, msec * 1.0e6 / (double)resPixels);
+				}
+			}
+		}
+	}
+	printf("\n");
+}
+
+//
+// YUV conversion at 4K
+//
+static void BenchmarkYUV(unsigned int frames, unsigned int maxThreads)
+{
+	struct Format {
+		const char *name;
+		SpoutYUVFormat format;
+		const char *rgbaName;
+		GLenum rgbaFormat;
+		unsigned int rgbaBytes;
+	};
+	const Format formats[] = {
+		{ "nv12", SPOUT_YUV_NV12, "rgba8", GL_RGBA, 4 },
+		{ "p010", SPOUT_YUV_P010, "rgba16", GL_RGBA16, 8 },
+		{ "uyvy", SPOUT_YUV_UYVY, "bgra8", GL_BGRA_EXT, 4 },
+		{ "v210", SPOUT_YUV_V210, "rgba16", GL_RGBA16, 8 },
+	};
+	const Resolution &res = resolutions[1];
+	const size_t pixels = (size_t)res.width * res.height;
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	printf("YUV %s, BT.709 limited range\n", res.name);
+	printf("  %-18s %-8s %-8s %10s %10s %10s\n", "conversion", "tier", "threads", "msec", "fps", "ns/pixel");
+
+	spoutCopy copy;
+	std::vector<unsigned char> rgba(pixels * 8);
+	for (size_t i = 0; i < rgba.size(); i++)
+		rgba[i] = (unsigned char)rand();
+	for (const Format &f : formats) {
+		std::vector<unsigned char> yuv(spoutyuv::FrameBytes(f.format, res.width, res.height));
+		const std::string encode = std::string(f.rgbaName) + " > " + f.name;
+		const std::string decode = std::string(f.name) + " > " + f.rgbaName;
+		const SpoutCopyTier tiers[] = { SPOUT_COPY_SCALAR, SPOUT_COPY_SSE2 };
+		for (int direction = 0; direction < 2; direction++) {
+			for (SpoutCopyTier tier : tiers) {
+				if (!copy.SetCopyTier(tier))
+					continue;
+				const unsigned int threads[] = { 1, maxThreads };
+				for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+					copy.SetCopyThreads(threads[t], 0);
+					const double msec = TimeFrames([&]() {
+						if (direction == 0)
+							copy.RGBAToYUV(rgba.data(), yuv.data(), res.width, res.height, 0, 0, f.rgbaFormat, f.format);
+						else
+							copy.YUVToRGBA(yuv.data(), rgba.data(), res.width, res.height, 0, 0, f.format, f.rgbaFormat);
+					}, frames);
+					printf("  %-18s %-8s %-8u %10.3f %10.1f %10.3f\n", direction == 0 ? encode.c_str() : decode.c_str(),
+						tier == SPOUT_COPY_SCALAR ? "scalar" : "sse2", threads[t],
+						msec, 1000.0 / msec, msec * 1.0e6 / (double)pixels);
+				}
+			}
+		}
+	}
+	printf("\n");
+}
+
+static void BenchmarkDither(unsigned int frames, unsigned int maxThreads)
+{
+	struct Source {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	const Source sources[] = {
+		{ "rgba16", GL_RGBA16, 8 },
+		{ "rgba16f", GL_RGBA16F, 8 },
+		{ "rgba32f", GL_RGBA32F, 16 },
+	};
+	const char *methods[] = { "round", "bayer", "blue" };
+	const Resolution &res = resolutions[1];
+	const size_t pixels = (size_t)res.width * res.height;
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	// The blue noise tile is generated on first use
+	auto start = std::chrono::steady_clock::now();
+	spoutdither::BlueNoiseTile();
+	const double tileMsec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	printf("Dither to bgra8 %s (blue noise tile generated in %.1f msec)\n", res.name, tileMsec);
+	printf("  %-18s %-8s %-8s %10s %10s %10s\n", "conversion", "tier", "threads", "msec", "GB/s", "ns/pixel");
+
+	spoutCopy copy;
+	std::vector<unsigned char> source(pixels * 16);
+	std::vector<unsigned char> dest(pixels * 4);
+	std::vector<unsigned char> sourceCopy(pixels * 16);
+	for (const Source &s : sources) {
+		// Values 0-1 for every format
+		for (size_t i = 0; i < pixels * 4; i++) {
+			const float value = (float)(i % 4096) / 4095.0f;
+			if (s.format == GL_RGBA16) {
+				const uint16_t v = (uint16_t)(value * 65535.0f);
+				memcpy(&source[i * 2], &v, 2);
+			}
+			else if (s.format == GL_RGBA16F) {
+				const uint16_t v = spoutconvert::FloatToHalf(value);
+				memcpy(&source[i * 2], &v, 2);
+			}
+			else {
+				memcpy(&source[i * 4], &value, 4);
+			}
+		}
+		const double bytes = (double)pixels * (s.bytes + 4);
+		// Copy of the source frame for comparison
+		const double copyMsec = TimeFrames([&]() {
+			memcpy(sourceCopy.data(), source.data(), pixels * s.bytes);
+		}, frames);
+		printf("  %-18s %-8s %-8s %10.3f %10.2f %10.3f\n", "memcpy", "", "1",
+			copyMsec, Throughput((double)pixels * s.bytes * 2, copyMsec), copyMsec * 1.0e6 / (double)pixels);
+		for (int m = 0; m < SPOUT_DITHER_METHOD_COUNT; m++) {
+			const std::string name = std::string(s.name) + " " + methods[m];
+			// AVX2 for the F16C conversion of half float
+			const SpoutCopyTier tiers[] = { SPOUT_COPY_SCALAR, SPOUT_COPY_SSE2, SPOUT_COPY_AVX2 };
+			const char *tierNames[] = { "scalar", "sse2", "avx2" };
+			for (int k = 0; k < 3; k++) {
+				const SpoutCopyTier tier = tiers[k];
+				if (tier == SPOUT_COPY_AVX2 && s.format != GL_RGBA16F)
+					continue;
+				if (!copy.SetCopyTier(tier))
+					continue;
+				const unsigned int threads[] = { 1, maxThreads };
+				for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+					copy.SetCopyThreads(threads[t], 0);
+					unsigned int frame = 0;
+					const double msec = TimeFrames([&]() {
+						copy.DitherRGBA(source.data(), dest.data(), res.width, res.height, 0, 0,
+							s.format, GL_BGRA_EXT, (SpoutDitherMethod)m, frame++);
+					}, frames);
+					printf("  %-18s %-8s %-8u %10.3f %10.2f %10.3f\n", name.c_str(),
+						tierNames[k], threads[t],
+						msec, Throughput(bytes, msec), msec * 1.0e6 / (double)pixels);
+				}
+			}
+		}
+	}
+	printf("\n");
+}
+
+static void BenchmarkAlpha(unsigned int frames, unsigned int maxThreads)
+{
+	struct Format {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	const Format formats[] = {
+		{ "rgba8", GL_RGBA, 4 },
+		{ "rgba16", GL_RGBA16, 8 },
+		{ "rgba16f", GL_RGBA16F, 8 },
+		{ "rgba32f", GL_RGBA32F, 16 },
+	};
+	const char *ops[] = { "", "premultiply", "unpremultiply", "opaque" };
+	const Resolution &res = resolutions[2];
+	const size_t pixels = (size_t)res.width * res.height;
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	printf("Alpha %s\n", res.name);
+	printf("  %-26s %-8s %-8s %10s %10s %10s\n", "conversion", "tier", "threads", "msec", "GB/s", "ns/pixel");
+
+	spoutCopy copy;
+	std::vector<unsigned char> source(pixels * 16);
+	std::vector<unsigned char> dest(pixels * 16);
+	for (size_t i = 0; i < pixels * 4; i++) {
+		// Values 0-1 for every format
+		const float value = (float)(i % 1021) / 1020.0f;
+		memcpy(&source[i * 4], &value, 4);
+	}
+	for (const Format &f : formats) {
+		const double bytes = (double)pixels * f.bytes * 2;
+		// Valid values for the format
+		copy.ConvertRGBA(source.data(), dest.data(), res.width, res.height, 0, 0, GL_RGBA32F, f.format);
+		for (int op = SPOUT_ALPHA_OP_PREMULTIPLY; op < SPOUT_ALPHA_OP_COUNT; op++) {
+			const std::string name = std::string(f.name) + " " + ops[op];
+			// AVX2 for the F16C conversion of half float
+			const SpoutCopyTier tiers[] = { SPOUT_COPY_SCALAR, SPOUT_COPY_SSE2, SPOUT_COPY_AVX2 };
+			const char *tierNames[] = { "scalar", "sse2", "avx2" };
+			for (int k = 0; k < 3; k++) {
+				const SpoutCopyTier tier = tiers[k];
+				if (tier == SPOUT_COPY_AVX2 && f.format != GL_RGBA16F)
+					continue;
+				if (!copy.SetCopyTier(tier))
+					continue;
+				const unsigned int threads[] = { 1, maxThreads };
+				for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+					copy.SetCopyThreads(threads[t], 0);
+					const double msec = TimeFrames([&]() {
+						copy.ApplyAlpha(dest.data(), source.data(), res.width, res.height, 0, 0,
+							f.format, (SpoutAlphaOp)op);
+					}, frames);
+					printf("  %-26s %-8s %-8u %10.3f %10.2f %10.3f\n", name.c_str(), tierNames[k], threads[t],
+						msec, Throughput(bytes, msec), msec * 1.0e6 / (double)pixels);
+				}
+			}
+		}
+		copy.SetCopyTier(spoutCopy::GetSupportedTier());
+		copy.SetCopyThreads(1, 0);
+		const double copyMsec = TimeFrames([&]() {
+			memcpy(source.data(), dest.data(), pixels * f.bytes);
+		}, frames);
+		printf("  %-26s %-8s %-8s %10.3f %10.2f %10.3f\n", (std::string(f.name) + " memcpy").c_str(), "", "1",
+			copyMsec, Throughput(bytes, copyMsec), copyMsec * 1.0e6 / (double)pixels);
+	}
+
+	// Straight rgba16 to premultiplied bgra8 in one and two passes
+	copy.SetCopyTier(spoutCopy::GetSupportedTier());
+	const unsigned int threads[] = { 1, maxThreads };
+	copy.ConvertRGBA(source.data(), dest.data(), res.width, res.height, 0, 0, GL_RGBA32F, GL_RGBA16);
+	for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+		copy.SetCopyThreads(threads[t], 0);
+		SpoutPixelDesc sourceDesc(GL_RGBA16, res.width, res.height);
+		SpoutPixelDesc destDesc(GL_BGRA_EXT, res.width, res.height);
+		destDesc.alpha = SPOUT_ALPHA_PREMULTIPLIED;
+		const double fused = TimeFrames([&]() {
+			copy.Convert(dest.data(), sourceDesc, source.data(), destDesc);
+		}, frames);
+		const double chained = TimeFrames([&]() {
+			copy.ConvertRGBA(dest.data(), source.data(), res.width, res.height, 0, 0, GL_RGBA16, GL_BGRA_EXT);
+			copy.ApplyAlpha(source.data(), source.data(), res.width, res.height, 0, 0, GL_BGRA_EXT, SPOUT_ALPHA_OP_PREMULTIPLY);
+		}, frames);
+		const double bytes = (double)pixels * (8 + 4);
+		printf("  %-26s %-8s %-8u %10.3f %10.2f %10.3f\n", "rgba16 > bgra8 premul", "fused", threads[t],
+			fused, Throughput(bytes, fused), fused * 1.0e6 / (double)pixels);
+		printf("  %-26s %-8s %-8u %10.3f %10.2f %10.3f\n", "rgba16 > bgra8 premul", "chained", threads[t],
+			chained, Throughput(bytes, chained), chained * 1.0e6 / (double)pixels);
+	}
+	printf("\n");
+}
+
+//
+// Rotation by reading the source pixel of each destination pixel in turn
+//
+static void NaiveRotate(const unsigned char *src, unsigned char *dst,
+	unsigned int width, unsigned int height, unsigned int bytes, SpoutRotation rotation)
+{
+	const bool bTranspose = (rotation != SPOUT_ROTATE_NONE && rotation != SPOUT_ROTATE_180);
+	const unsigned int destWidth = bTranspose ? height : width;
+	const unsigned int destHeight = bTranspose ? width : height;
+	for (unsigned int y = 0; y < destHeight; y++) {
+		for (unsigned int x = 0; x < destWidth; x++) {
+			unsigned int xs = x, ys = y;
+			switch (rotation) {
+				case SPOUT_ROTATE_90:   xs = y; ys = height - 1 - x; break;
+				case SPOUT_ROTATE_180:  xs = width - 1 - x; ys = height - 1 - y; break;
+				case SPOUT_ROTATE_270:  xs = width - 1 - y; ys = x; break;
+				case SPOUT_TRANSPOSE:   xs = y; ys = x; break;
+				case SPOUT_TRANSVERSE:  xs = width - 1 - y; ys = height - 1 - x; break;
+				default: break;
+			}
+			memcpy(dst + ((size_t)y * destWidth + x) * bytes, src + ((size_t)ys * width + xs) * bytes, bytes);
+		}
+	}
+}
+
+static void BenchmarkRotate(unsigned int frames, unsigned int maxThreads)
+{
+	struct Format {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	const Format formats[] = {
+		{ "rgba8", GL_RGBA, 4 },
+		{ "rgba16", GL_RGBA16, 8 },
+	};
+	const char *rotations[] = { "none", "90", "180", "270", "transpose", "transverse" };
+	const Resolution &res = resolutions[2];
+	const size_t pixels = (size_t)res.width * res.height;
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	printf("Rotate %s\n", res.name);
+	printf("  %-18s %-8s %-8s %10s %10s %10s\n", "rotation", "tier", "threads", "msec", "GB/s", "ns/pixel");
+
+	spoutCopy copy;
+	std::vector<unsigned char> source(pixels * 8);
+	std::vector<unsigned char> dest(pixels * 8);
+	std::vector<unsigned char> expected(pixels * 8);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = (unsigned char)rand();
+
+	for (const Format &f : formats) {
+		const double bytes = (double)pixels * f.bytes * 2;
+		for (int r = SPOUT_ROTATE_90; r < SPOUT_ROTATION_COUNT; r++) {
+			const SpoutRotation rotation = (SpoutRotation)r;
+			const std::string name = std::string(f.name) + " " + rotations[r];
+			const double naive = TimeFrames([&]() {
+				NaiveRotate(source.data(), expected.data(), res.width, res.height, f.bytes, rotation);
+			}, frames);
+			printf("  %-18s %-8s %-8s %10.3f %10.2f %10.3f\n", name.c_str(), "naive", "1",
+				naive, Throughput(bytes, naive), naive * 1.0e6 / (double)pixels);
+			// The transposes have no AVX2 path
+			const SpoutCopyTier tiers[] = { SPOUT_COPY_SCALAR, SPOUT_COPY_SSE2 };
+			const char *tierNames[] = { "scalar", "sse2" };
+			for (int k = 0; k < 2; k++) {
+				if (!copy.SetCopyTier(tiers[k]))
+					continue;
+				const unsigned int threads[] = { 1, maxThreads };
+				for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+					copy.SetCopyThreads(threads[t], 0);
+					const double msec = TimeFrames([&]() {
+						copy.Rotate(source.data(), dest.data(), res.width, res.height, 0, 0, f.format, rotation);
+					}, frames);
+					printf("  %-18s %-8s %-8u %10.3f %10.2f %10.3f\n", name.c_str(), tierNames[k], threads[t],
+						msec, Throughput(bytes, msec), msec * 1.0e6 / (double)pixels);
+				}
+			}
+		}
+	}
+	printf("\n");
+}
+
+//
+// 6K canvas split across 8 outputs
+//
+static void BenchmarkRegion(unsigned int frames, unsigned int maxThreads)
+{
+	const Resolution &res = resolutions[2];
+	const unsigned int outputs = 8;
+	const unsigned int outputWidth = res.width / outputs;
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	printf("Region %s to %u outputs of %ux%u\n", res.name, outputs, outputWidth, res.height);
+	printf("  %-18s %-8s %10s %10s %10s\n", "method", "threads", "msec", "MB read", "ns/pixel");
+
+	spoutCopy copy;
+	std::vector<unsigned char> canvas((size_t)res.width * res.height * 4);
+	std::vector<unsigned char> output((size_t)outputWidth * res.height * 4);
+	for (size_t i = 0; i < canvas.size(); i++)
+		canvas[i] = (unsigned char)rand();
+
+	const SpoutPixelDesc canvasDesc(GL_RGBA, res.width, res.height);
+	const SpoutPixelDesc outputDesc(GL_RGBA, outputWidth, res.height);
+	const double outputPixels = (double)outputWidth * res.height * outputs;
+	const unsigned int threads[] = { 1, maxThreads };
+	for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+		copy.SetCopyThreads(threads[t], 0);
+		// Every output samples the whole canvas
+		const double whole = TimeFrames([&]() {
+			for (unsigned int i = 0; i < outputs; i++)
+				copy.Convert(canvas.data(), canvasDesc, output.data(), outputDesc);
+		}, frames);
+		printf("  %-18s %-8u %10.3f %10.1f %10.3f\n", "whole canvas", threads[t],
+			whole, (double)canvas.size() * outputs / 1.0e6, whole * 1.0e6 / outputPixels);
+		// Every output copies its own part
+		const double region = TimeFrames([&]() {
+			for (unsigned int i = 0; i < outputs; i++)
+				copy.ConvertRegion(canvas.data(), canvasDesc, SpoutRegion(i * outputWidth, 0, outputWidth, res.height),
+					output.data(), outputDesc);
+		}, frames);
+		printf("  %-18s %-8u %10.3f %10.1f %10.3f\n", "region", threads[t],
+			region, (double)canvas.size() / 1.0e6, region * 1.0e6 / outputPixels);
+	}
+	printf("\n");
+}
+
+//
+// Tile hashes of a 6K frame
+//
+static void BenchmarkFrameHash(unsigned int frames, unsigned int maxThreads)
+{
+	struct Format {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	const Format formats[] = {
+		{ "rgba8", GL_RGBA, 4 },
+		{ "rgba16", GL_RGBA16, 8 },
+	};
+	const Resolution &res = resolutions[2];
+	const size_t pixels = (size_t)res.width * res.height;
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	printf("Frame hash %s (%u x %u pixel tiles)\n", res.name, spoutFrameHash::TileSize, spoutFrameHash::TileSize);
+	printf("  %-18s %-8s %-8s %10s %10s %10s\n", "format", "tier", "threads", "msec", "GB/s", "ns/pixel");
+
+	std::vector<unsigned char> frame(pixels * 8);
+	std::vector<unsigned char> copy(pixels * 8);
+	for (size_t i = 0; i < frame.size(); i++)
+		frame[i] = (unsigned char)rand();
+
+	for (const Format &f : formats) {
+		const double bytes = (double)pixels * f.bytes;
+		const double msecCopy = TimeFrames([&]() {
+			memcpy(copy.data(), frame.data(), (size_t)bytes);
+		}, frames);
+		printf("  %-18s %-8s %-8s %10.3f %10.2f %10.3f\n", f.name, "memcpy", "1",
+			msecCopy, Throughput(bytes, msecCopy), msecCopy * 1.0e6 / (double)pixels);
+
+		const SpoutCopyTier tiers[] = { SPOUT_COPY_SCALAR, SPOUT_COPY_SSE2, SPOUT_COPY_AVX2 };
+		const char *tierNames[] = { "scalar", "sse2", "avx2" };
+		for (int k = 0; k < 3; k++) {
+			spoutFrameHash framehash;
+			if (!framehash.SetTier(tiers[k]))
+				continue;
+			const unsigned int threads[] = { 1, maxThreads };
+			for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+				framehash.SetThreads(threads[t]);
+				const double msec = TimeFrames([&]() {
+					framehash.Update(frame.data(), res.width, res.height, 0, f.format);
+				}, frames);
+				printf("  %-18s %-8s %-8u %10.3f %10.2f %10.3f\n", f.name, tierNames[k], threads[t],
+					msec, Throughput(bytes, msec), msec * 1.0e6 / (double)pixels);
+			}
+		}
+	}
+	printf("\n");
+}
+
+//
+// 6K thumbnails and the cost of the publisher to the caller
+//
+static void BenchmarkThumbnail(unsigned int frames, unsigned int maxThreads)
+{
+	struct Format {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	const Format formats[] = {
+		{ "rgba8", GL_RGBA, 4 },
+		{ "bgra8", GL_BGRA_EXT, 4 },
+		{ "rgba16", GL_RGBA16, 8 },
+		{ "rgba16f", GL_RGBA16F, 8 },
+		{ "rgba32f", GL_RGBA32F, 16 },
+	};
+	const Resolution &res = resolutions[2];
+	const size_t pixels = (size_t)res.width * res.height;
+	const unsigned int levels = 3;
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+
+	printf("Thumbnail %s to 1/2, 1/4 and 1/8\n", res.name);
+	printf("  %-18s %-8s %10s %10s %10s\n", "format", "threads", "msec", "GB/s", "ns/pixel");
+
+	std::vector<unsigned char> frame(pixels * 16);
+	for (size_t i = 0; i < frame.size(); i++)
+		frame[i] = (unsigned char)rand();
+	// Finite half and float values
+	spoutCopy copy;
+	std::vector<float> values(pixels * 4);
+	for (size_t i = 0; i < values.size(); i++)
+		values[i] = (float)(rand() & 255) / 255.0f;
+
+	std::vector<std::vector<unsigned char>> thumbnails(levels);
+	std::vector<unsigned char *> dest(levels);
+	unsigned int width = res.width;
+	unsigned int height = res.height;
+	for (unsigned int i = 0; i < levels; i++) {
+		width = spoutthumbnail::HalfSize(width);
+		height = spoutthumbnail::HalfSize(height);
+		thumbnails[i].resize((size_t)width * height * 4);
+		dest[i] = thumbnails[i].data();
+	}
+
+	for (const Format &f : formats) {
+		if (f.format == GL_RGBA32F)
+			memcpy(frame.data(), values.data(), pixels * 16);
+		else if (f.format == GL_RGBA16F)
+			copy.ConvertRGBA(values.data(), frame.data(), res.width, res.height, 0, 0, GL_RGBA32F, GL_RGBA16F);
+		const double bytes = (double)pixels * f.bytes;
+		const unsigned int threads[] = { 1, maxThreads };
+		for (unsigned int t = 0; t < (maxThreads > 1 ? 2u : 1u); t++) {
+			copy.SetCopyThreads(threads[t], 0);
+			const double msec = TimeFrames([&]() {
+				copy.Downsample(frame.data(), res.width, res.height, 0, f.format, dest.data(), levels);
+			}, frames);
+			printf("  %-18s %-8u %10.3f %10.2f %10.3f\n", f.name, threads[t],
+				msec, Throughput(bytes, msec), msec * 1.0e6 / (double)pixels);
+		}
+	}
+	copy.SetCopyThreads(1, 0);
+
+	// Submit every 16 msec for 60 frames. The first frame allocates
+	// the buffer of the publisher and is not included.
+	spoutThumbnailPublisher publisher;
+	publisher.Start(100, 8);
+	publisher.Submit(frame.data(), res.width, res.height, 0, GL_RGBA);
+	double takenMsec = 0.0;
+	double skippedMsec = 0.0;
+	unsigned int taken = 0;
+	const unsigned int submits = 60;
+	for (unsigned int i = 0; i < submits; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(16));
+		const auto start = std::chrono::steady_clock::now();
+		const bool bTaken = publisher.Submit(frame.data(), res.width, res.height, 0, GL_RGBA);
+		const double msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (bTaken) {
+			takenMsec += msec;
+			taken++;
+		}
+		else {
+			skippedMsec += msec;
+		}
+	}
+	publisher.Stop();
+	printf("  Submit rgba8 : %u of %u frames copied, %.3f msec each, %.4f msec for the others, %u thumbnails\n",
+		taken, submits, taken ? takenMsec / taken : 0.0,
+		(taken < submits) ? skippedMsec / (submits - taken) : 0.0, publisher.GetCount());
+	printf("\n");
+}
+
+//
+// SpoutSharedMemory create, open and lock
+//
+static void BenchmarkSharedMemory(unsigned int frames, unsigned int maxThreads)
+{
+	const char *name = "SpoutBenchmarkMemory";
+	const int size = 4096;
+	const unsigned int repeats = frames * 20;
+
+	if (maxThreads == 0)
+		maxThreads = spoutThreadPool::Global().GetThreadCount();
+	// Contention with at least 4 threads
+	if (maxThreads < 4)
+		maxThreads = 4;
+
+	printf("Shared memory (%d bytes)\n", size);
+	printf("  %-26s %10s\n", "operation", "nsec");
+
+	// Create and Close of a new segment
+	double msec = TimeFrames([&]() {
+		SpoutSharedMemory memory;
+		memory.Create(name, size);
+		memory.Close();
+	}, repeats);
+	printf("  %-26s %10.0f\n", "Create and Close", msec * 1.0e6);
+
+	SpoutSharedMemory sender;
+	if (sender.Create(name, size) != SPOUT_CREATE_SUCCESS) {
+		printf("  Could not create %s\n\n", name);
+		return;
+	}
+
+	msec = TimeFrames([&]() {
+		SpoutSharedMemory memory;
+		memory.Open(name);
+		memory.Close();
+	}, repeats);
+	printf("  %-26s %10.0f\n", "Open and Close", msec * 1.0e6);
+
+	msec = TimeFrames([&]() {
+		if (sender.Lock())
+			sender.Unlock();
+	}, repeats * 100);
+	printf("  %-26s %10.0f\n", "Lock and Unlock", msec * 1.0e6);
+
+	// Each thread opens the memory and increments a counter while locked
+	char *buffer = sender.Lock();
+	if (buffer) {
+		memset(buffer, 0, sizeof(uint64_t));
+		sender.Unlock();
+	}
+	const unsigned int increments = repeats * 100;
+	unsigned int failed = 0;
+	std::mutex failedMutex;
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < maxThreads; t++) {
+		threads.emplace_back([&]() {
+			SpoutSharedMemory memory;
+			unsigned int locked = 0;
+			if (memory.Open(name)) {
+				for (unsigned int i = 0; i < increments; i++) {
+					char *pBuffer = memory.Lock();
+					if (!pBuffer)
+						continue;
+					uint64_t count = 0;
+					memcpy(&count, pBuffer, sizeof(count));
+					count++;
+					memcpy(pBuffer, &count, sizeof(count));
+					memory.Unlock();
+					locked++;
+				}
+			}
+			std::lock_guard<std::mutex> lock(failedMutex);
+			failed += increments - locked;
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+	msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	sender.Close();
+
+	char label[64];
+	snprintf(label, sizeof(label), "Lock and Unlock %u threads", maxThreads);
+	printf("  %-26s %10.0f\n", label, msec * 1.0e6 / ((double)increments * maxThreads));
+	if (failed)
+		printf("  %u locks timed out\n", failed);
+	printf("\n");
+}
+
+//
+// Sender information read by 32 threads with one writer
+//
+#if defined(_WIN32)
+static void BenchmarkSenderInfo(unsigned int frames)
+{
+	const char *name = "SpoutBenchmarkInfo";
+	const unsigned int readers = 32;
+	const auto duration = std::chrono::milliseconds(10 * frames);
+
+	printf("Sender info, 1 writer and %u readers\n", readers);
+	printf("  %-14s %14s %12s %14s\n", "method", "reads/sec", "nsec/read", "writes/sec");
+
+	spoutSenderNames sender;
+	if (!sender.CreateSender(name, 1, 1, LongToHandle(1), 1)) {
+		printf("  Could not create %s\n\n", name);
+		return;
+	}
+
+	// Opening and locking the map for each read, as getSharedInfo did before
+	const char *methods[] = { "Open and Lock", "getSharedInfo" };
+	for (int m = 0; m < 2; m++) {
+		const bool bOpenLock = (m == 0);
+		std::atomic<bool> bStop(false);
+		std::atomic<uint64_t> reads(0);
+		uint64_t writes = 1;
+
+		std::vector<std::thread> threads;
+		for (unsigned int t = 0; t < readers; t++) {
+			threads.emplace_back([&]() {
+				// Each receiver has its own sender names object
+				spoutSenderNames receiver;
+				uint64_t count = 0;
+				SharedTextureInfo info;
+				while (!bStop.load(std::memory_order_relaxed)) {
+					if (bOpenLock) {
+						SpoutSharedMemory memory;
+						if (!memory.Open(name))
+							continue;
+						char *pBuf = memory.Lock();
+						if (!pBuf)
+							continue;
+						memcpy(&info, pBuf, sizeof(info));
+						memory.Unlock();
+					}
+					else if (!receiver.getSharedInfo(name, &info)) {
+						continue;
+					}
+					count++;
+				}
+				reads += count;
+			});
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - start < duration) {
+			writes++;
+			const unsigned int value = (unsigned int)writes;
+			sender.UpdateSender(name, value, value, LongToHandle((long)value), value);
+		}
+		bStop = true;
+		for (std::thread &thread : threads)
+			thread.join();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// nsec of one read for each reader
+		const double nsec = reads ? seconds * 1.0e9 * readers / (double)reads : 0.0;
+		printf("  %-14s %14.0f %12.0f %14.0f\n", methods[m], (double)reads / seconds, nsec,
+			(double)writes / seconds);
+	}
+	sender.ReleaseSenderName(name);
+	printf("\n");
+}
+#else
+static void BenchmarkSenderInfo(unsigned int frames)
+{
+	(void)frames;
+	printf("Sender info\n  spoutSenderNames is built for Windows only\n\n");
+}
+#endif
+
+//
+// 4K frames through one locked region and through a ring buffer
+//
+static void BenchmarkMemoryRing(unsigned int frames)
+{
+	const Resolution &res = resolutions[1];
+	const unsigned int size = res.width * res.height * 4;
+	const auto duration = std::chrono::milliseconds(10 * frames);
+
+	printf("Memoryshare %s rgba, 1 writer and 1 reader\n", res.name);
+	printf("  %-10s %12s %14s %12s %12s %10s\n", "method", "writes/sec", "max write msec", "reads/sec", "skipped", "failed");
+
+	std::vector<unsigned char> source(size);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = (unsigned char)rand();
+
+	const char *methods[] = { "mutex", "ring 3" };
+	for (int m = 0; m < 2; m++) {
+		const bool bRing = (m == 1);
+		const char *name = bRing ? "SpoutBenchmarkRing" : "SpoutBenchmarkMap";
+		SpoutSharedMemory region;
+		spoutMemoryRing ring;
+		if (bRing ? !ring.Create(name, size) : (region.Create(name, size + 64) == SPOUT_CREATE_FAILED)) {
+			printf("  Could not create %s\n\n", name);
+			return;
+		}
+
+		spoutCopy copy;
+		// The frame number is in front of the pixels of the mutex region
+		auto Write = [&](uint32_t number) {
+			if (bRing) {
+				unsigned char *pSlot = ring.BeginWrite();
+				copy.CopyPixels(source.data(), pSlot, res.width, res.height, GL_RGBA, false);
+				ring.EndWrite(GL_RGBA, res.width, res.height, res.width * 4, size);
+				return true;
+			}
+			char *pBuffer = region.Lock();
+			if (!pBuffer)
+				return false;
+			copy.CopyPixels(source.data(), reinterpret_cast<unsigned char *>(pBuffer) + 64, res.width, res.height, GL_RGBA, false);
+			memcpy(pBuffer, &number, sizeof(number));
+			region.Unlock();
+			return true;
+		};
+
+		// Untimed writes to every slot for the page tables
+		uint32_t writes = 0;
+		const unsigned int slots = bRing ? ring.GetSlots() : 1;
+		while (writes < slots)
+			Write(++writes);
+
+		std::atomic<bool> bStop(false);
+		uint64_t reads = 0, skipped = 0, failed = 0;
+		std::thread reader([&]() {
+			spoutCopy copy;
+			SpoutSharedMemory memory;
+			spoutMemoryRing readRing;
+			if (bRing ? !readRing.Open(name) : !memory.Open(name))
+				return;
+			std::vector<unsigned char> pixels(size);
+			uint32_t last = 0;
+			while (!bStop.load(std::memory_order_relaxed)) {
+				uint32_t number = 0;
+				if (bRing) {
+					if (!readRing.IsNewFrame()) {
+						std::this_thread::yield();
+						continue;
+					}
+					spoutMemoryFrame info;
+					if (!readRing.Read([&](const unsigned char *data, const spoutMemoryFrame &) {
+						copy.CopyPixels(data, pixels.data(), res.width, res.height, GL_RGBA, false);
+					}, &info)) {
+						failed++;
+						continue;
+					}
+					number = info.frame;
+				}
+				else {
+					char *pBuffer = memory.Lock();
+					if (!pBuffer) {
+						failed++;
+						continue;
+					}
+					memcpy(&number, pBuffer, sizeof(number));
+					if (number == last || number == 0) {
+						memory.Unlock();
+						std::this_thread::yield();
+						continue;
+					}
+					copy.CopyPixels(reinterpret_cast<unsigned char *>(pBuffer) + 64, pixels.data(), res.width, res.height, GL_RGBA, false);
+					memory.Unlock();
+				}
+				if (last && number > last + 1)
+					skipped += number - last - 1;
+				last = number;
+				reads++;
+			}
+		});
+
+		double maxWrite = 0.0;
+		const auto start = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - start < duration) {
+			const auto begin = std::chrono::steady_clock::now();
+			if (!Write(writes + 1))
+				continue;
+			writes++;
+			const double msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			if (msec > maxWrite)
+				maxWrite = msec;
+		}
+		bStop = true;
+		reader.join();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		printf("  %-10s %12.1f %14.3f %12.1f %12llu %10llu\n", methods[m], (double)(writes - slots) / seconds, maxWrite,
+			(double)reads / seconds, (unsigned long long)skipped, (unsigned long long)failed);
+	}
+	printf("\n");
+}
+
+//
+// Memory buffer size text and binary header
+//
+static void BenchmarkMemoryBuffer(unsigned int frames)
+{
+	const unsigned int size = 1920 * 1080 * 4;
+	const unsigned int repeats = frames * 200000;
+
+	printf("Memory buffer header (%u bytes)\n", size);
+	printf("  %-26s %10s\n", "method", "nsec");
+
+	// A map with the header and one as created by older writers
+	std::vector<char> map(spoutmemorybuffer::MapSize(size));
+	spoutmemorybuffer::Create(map.data(), size);
+	spoutmemorybuffer::Update(spoutmemorybuffer::Find(map.data(), map.size()), size, 1920, 1080, 1920 * 4, GL_RGBA);
+	std::vector<char> older(size + 32);
+	snprintf(older.data(), 16, "%u", size);
+
+	volatile int sink = 0;
+	double msec = TimeFrames([&]() {
+		for (unsigned int i = 0; i < 1000; i++) {
+			*(older.data() + 15) = 0; // End for atoi
+			sink = atoi(older.data());
+		}
+	}, repeats / 1000);
+	printf("  %-26s %10.2f\n", "atoi", msec * 1.0e3);
+
+	msec = TimeFrames([&]() {
+		for (unsigned int i = 0; i < 1000; i++)
+			sink = spoutmemorybuffer::TextSize(older.data(), older.size());
+	}, repeats / 1000);
+	printf("  %-26s %10.2f\n", "size text", msec * 1.0e3);
+
+	msec = TimeFrames([&]() {
+		for (unsigned int i = 0; i < 1000; i++) {
+			const spoutmemorybuffer::Header *header = spoutmemorybuffer::Find(map.data(), map.size());
+			sink = header ? (int)header->length : -1;
+		}
+	}, repeats / 1000);
+	printf("  %-26s %10.2f\n", "header", msec * 1.0e3);
+	(void)sink;
+	printf("\n");
+}
+
+//
+// Conversion from shared memory with and without a copy first
+//
+static void BenchmarkMemoryLease(unsigned int frames)
+{
+	const Resolution &res = resolutions[1];
+	const unsigned int size = res.width * res.height * 4;
+
+	printf("Memoryshare lease %s rgba > bgra\n", res.name);
+	printf("  %-26s %10s %10s %10s\n", "method", "msec", "fps", "GB/s");
+
+	std::vector<unsigned char> source(size);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = (unsigned char)rand();
+
+	// Memory buffer written with a header and a ring with one frame
+	SpoutSharedMemory writeMap, readMap;
+	spoutMemoryRing writeRing, readRing;
+	if (writeMap.Create("SpoutBenchmarkLeaseMap", (int)spoutmemorybuffer::MapSize(size)) == SPOUT_CREATE_FAILED
+		|| !writeRing.Create("SpoutBenchmarkLeaseRing", size)) {
+		printf("  Could not create shared memory\n\n");
+		return;
+	}
+	char *pBuffer = writeMap.Lock();
+	spoutmemorybuffer::Create(pBuffer, size);
+	memcpy(pBuffer + spoutmemorybuffer::TextBytes, source.data(), size);
+	spoutmemorybuffer::Update(spoutmemorybuffer::Find(pBuffer, writeMap.ViewSize()), size, res.width, res.height, res.width * 4, GL_RGBA);
+	writeMap.Unlock();
+	writeRing.Write(source.data(), size, GL_RGBA, res.width, res.height, res.width * 4);
+	if (!readMap.Open("SpoutBenchmarkLeaseMap") || !readRing.Open("SpoutBenchmarkLeaseRing")) {
+		printf("  Could not open shared memory\n\n");
+		return;
+	}
+
+	spoutCopy copy;
+	std::vector<unsigned char> pixels(size), converted(size);
+	unsigned char *dest = converted.data();
+	for (int m = 0; m < 4; m++) {
+		const bool bRing = (m >= 2);
+		const bool bLease = (m & 1) != 0;
+		const double msec = TimeFrames([&]() {
+			if (bRing) {
+				if (bLease) {
+					spoutMemoryRing::Lease lease = readRing.Acquire();
+					copy.rgba2bgra(lease.Data(), dest, res.width, res.height);
+				}
+				else {
+					readRing.Read(pixels.data(), size);
+					copy.rgba2bgra(pixels.data(), dest, res.width, res.height);
+				}
+				return;
+			}
+			if (bLease) {
+				const spoutmemorybuffer::Header *header = spoutmemorybuffer::Find(readMap.Lock(), readMap.ViewSize());
+				SpoutSharedMemory::Lease lease = readMap.Acquire(spoutmemorybuffer::TextBytes, header ? header->length : 0);
+				readMap.Unlock();
+				copy.rgba2bgra(lease.Data(), dest, res.width, res.height);
+			}
+			else {
+				const char *pMap = readMap.Lock();
+				const spoutmemorybuffer::Header *header = spoutmemorybuffer::Find(pMap, readMap.ViewSize());
+				memcpy(pixels.data(), pMap + spoutmemorybuffer::TextBytes, header ? header->length : 0);
+				readMap.Unlock();
+				copy.rgba2bgra(pixels.data(), dest, res.width, res.height);
+			}
+		}, frames);
+		const std::string name = std::string(bRing ? "ring " : "buffer ") + (bLease ? "lease" : "copy");
+		// Bytes read and written, with the copy out first
+		const double bytes = (double)size * (bLease ? 2.0 : 4.0);
+		printf("  %-26s %10.3f %10.1f %10.2f\n", name.c_str(), msec, 1000.0 / msec, Throughput(bytes, msec));
+	}
+	printf("\n");
+}
+
+//
+// Large pages and NUMA node of shared memory
+//
+static void BenchmarkLargePages(unsigned int frames)
+{
+	const Resolution &res = resolutions[2];
+	const unsigned int pitch = res.width * 8;
+	const size_t size = (size_t)pitch * res.height;
+
+	printf("Large pages %s rgba16 (%zu MB)\n", res.name, size >> 20);
+	printf("  %-22s %-9s %10s %10s %12s %10s\n", "memory", "pages", "copy msec", "GB/s", "rotate msec", "GB/s");
+
+	spoutCopy copy;
+	std::vector<unsigned char> source(size), dest(size);
+	for (size_t i = 0; i < size; i++)
+		source[i] = (unsigned char)rand();
+
+	// Copy a frame in and rotate it out, as a sender and receiver would
+	auto Measure = [&](const char *name, const char *pages, unsigned char *pMemory) {
+		const double copyMsec = TimeFrames([&]() { memcpy(pMemory, source.data(), size); }, frames);
+		const double rotateMsec = TimeFrames([&]() {
+			copy.Rotate(pMemory, dest.data(), res.width, res.height, 0, 0, GL_RGBA16, SPOUT_ROTATE_90);
+		}, frames);
+		printf("  %-22s %-9s %10.3f %10.2f %12.3f %10.2f\n", name, pages,
+			copyMsec, Throughput((double)size * 2.0, copyMsec),
+			rotateMsec, Throughput((double)size * 2.0, rotateMsec));
+	};
+
+	const char *methods[] = { "shared", "shared large pages", "shared NUMA node" };
+	for (int m = 0; m < 3; m++) {
+		SpoutSharedMemory memory;
+		memory.SetLargePages(m == 1);
+		if (m == 2)
+			memory.SetNumaNode(SpoutSharedMemory::NumaCurrent);
+		if (memory.Create("SpoutBenchmarkLargePages", (int)size) == SPOUT_CREATE_FAILED) {
+			printf("  Could not create %s memory\n", methods[m]);
+			continue;
+		}
+		const char *pages = memory.IsLargePages() ? "large" : (m == 1 ? "fallback" : "normal");
+		unsigned char *pBuffer = reinterpret_cast<unsigned char *>(memory.Lock());
+		if (!pBuffer)
+			continue;
+		Measure(methods[m], pages, pBuffer);
+		memory.Unlock();
+	}
+
+#if defined(__linux__)
+	// Private memory at a 2 MB boundary for transparent huge pages
+	const size_t hugePage = 2 << 20;
+	for (int m = 0; m < 2; m++) {
+		const size_t mapSize = size + hugePage;
+		void *pMap = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (pMap == MAP_FAILED)
+			break;
+		unsigned char *pMemory = reinterpret_cast<unsigned char *>(((uintptr_t)pMap + hugePage - 1) & ~(uintptr_t)(hugePage - 1));
+		const bool bAdvised = madvise(pMemory, size, m == 0 ? MADV_NOHUGEPAGE : MADV_HUGEPAGE) == 0;
+		Measure(m == 0 ? "private" : "private huge pages", (m == 1 && !bAdvised) ? "fallback" : (m == 0 ? "normal" : "large"), pMemory);
+		munmap(pMap, mapSize);
+	}
+#endif
+
+	printf("\n");
+}
+
+//
+// Wake-up time of a receiver for a new frame
+//
+static void BenchmarkFrameNotify(unsigned int frames)
+{
+	const unsigned int wakes = frames * 10;
+	const char *name = "SpoutBenchmarkNotify";
+
+	printf("Frame notification, %u frames 2 msec apart\n", wakes);
+	printf("  %-18s %10s %10s %10s %10s %8s\n", "method", "mean usec", "p50 usec", "p99 usec", "max usec", "missed");
+
+	spoutFrameNotify sender;
+	if (!sender.Create(name)) {
+		printf("  Could not create %s\n\n", name);
+		return;
+	}
+
+	auto Now = []() {
+		return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	};
+
+	const char *methods[] = { "wait", "poll 1 msec sleep", "poll yield" };
+	for (int m = 0; m < 3; m++) {
+		std::atomic<int64_t> published(0);
+		std::atomic<bool> bStop(false);
+		std::atomic<bool> bReady(false);
+		std::vector<double> latency;
+		latency.reserve(wakes);
+		uint64_t missed = 0;
+
+		std::thread receiver([&]() {
+			spoutFrameNotify notify;
+			if (!notify.Open(name))
+				return;
+			uint64_t last = notify.GetFrame();
+			bReady = true;
+			while (!bStop.load(std::memory_order_relaxed)) {
+				uint64_t frame = 0;
+				if (m == 0) {
+					frame = notify.Wait(last, 100);
+				}
+				else {
+					frame = notify.GetFrame();
+					if (frame == last) {
+						if (m == 1)
+							std::this_thread::sleep_for(std::chrono::milliseconds(1));
+						else
+							std::this_thread::yield();
+						continue;
+					}
+				}
+				if (frame <= last)
+					continue;
+				latency.push_back((double)(Now() - published.load(std::memory_order_acquire)) / 1000.0);
+				missed += frame - last - 1;
+				last = frame;
+			}
+		});
+
+		while (!bReady)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		for (unsigned int i = 0; i < wakes; i++) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			published.store(Now(), std::memory_order_release);
+			sender.Publish();
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		bStop = true;
+		receiver.join();
+
+		if (latency.empty()) {
+			printf("  %-18s no frames received\n", methods[m]);
+			continue;
+		}
+		std::sort(latency.begin(), latency.end());
+		double mean = 0.0;
+		for (double usec : latency)
+			mean += usec;
+		mean /= (double)latency.size();
+		printf("  %-18s %10.1f %10.1f %10.1f %10.1f %8llu\n", methods[m], mean,
+			latency[latency.size() / 2], latency[latency.size() * 99 / 100], latency.back(),
+			(unsigned long long)missed);
+	}
+
+	// Reading the frame number to poll it
+	volatile uint64_t sink = 0;
+	const double msec = TimeFrames([&]() {
+		for (unsigned int i = 0; i < 1000; i++)
+			sink = sender.GetFrame();
+	}, frames * 1000);
+	(void)sink;
+	printf("  %-18s %10.2f nsec\n", "frame number read", msec * 1.0e3);
+	printf("\n");
+}
+
+//
+// Suite of every public spoutCopy copy and conversion method
+//
+
+static const Resolution suiteResolutions[] = {
+	{ "720p",  1280,  720 },
+	{ "1080p", 1920, 1080 },
+	{ "4K",    3840, 2160 },
+	{ "6K",    6144, 3456 },
+};
+
+// Source pixel values
+enum SuiteSource {
+	SUITE_BYTES = 0, // Random bytes for 8 and 16 bit and YUV formats
+	SUITE_HALF,      // Half floats from 0 to 1
+	SUITE_FLOAT,     // Floats from 0 to 1
+	SUITE_SOURCE_COUNT
+};
+
+// Buffers and line pitch of one test
+struct SuiteFrame {
+	const unsigned char *src;
+	unsigned char *dst;
+	unsigned int width;
+	unsigned int height;
+	unsigned int srcPitch;
+	unsigned int dstPitch;
+	unsigned int padding; // bytes added to each line
+	bool bInvert;
+};
+
+struct SuiteCase {
+	const char *method;
+	const char *format;
+	SuiteSource source;
+	double srcLine;  // bytes of a source line for each pixel of width
+	double dstLine;  // bytes of a destination line for each pixel of source width
+	double srcBytes; // bytes read for each pixel of the source frame
+	double dstBytes; // bytes written for each pixel of the source frame
+	bool bInvert;    // has an invert option
+	std::function<void(const SuiteFrame &)> function;
+};
+
+struct SuiteResult {
+	const SuiteCase *test;
+	const Resolution *res;
+	bool bAligned;
+	bool bInvert;
+	double msec;
+	double gbps;
+	double nsPerPixel;
+};
+
+// Results as JSON to compare releases
+static bool WriteSuiteJson(const char *path, const std::vector<SuiteResult> &results,
+	unsigned int frames, unsigned int threads, const char *tier)
+{
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		printf("Could not write %s\n", path);
+		return false;
+	}
+	fprintf(file, "{\n");
+	fprintf(file, "  \"benchmark\": \"spoutCopy\",\n");
+	fprintf(file, "  \"tier\": \"%s\",\n", tier);
+	fprintf(file, "  \"threads\": %u,\n", threads);
+	fprintf(file, "  \"frames\": %u,\n", frames);
+	fprintf(file, "  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const SuiteResult &r = results[i];
+		fprintf(file, "    { \"method\": \"%s\", \"format\": \"%s\", \"resolution\": \"%s\", "
+			"\"width\": %u, \"height\": %u, \"aligned\": %s, \"invert\": %s, "
+			"\"msec\": %.4f, \"gbps\": %.3f, \"nsPerPixel\": %.4f }%s\n",
+			r.test->method, r.test->format, r.res->name, r.res->width, r.res->height,
+			r.bAligned ? "true" : "false", r.bInvert ? "true" : "false",
+			r.msec, r.gbps, r.nsPerPixel, (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	const bool bResult = (ferror(file) == 0);
+	fclose(file);
+	return bResult;
+}
+
+//
+// Each method is timed at 720p, 1080p, 4K and 6K with packed lines from
+// 64 byte aligned buffers and again with buffers offset by 4 bytes and
+// 4 bytes of padding on each line, with and without invert if there is
+// an option for it. GB/s is for the bytes read and written.
+// ns/pixel is for each pixel of the source frame.
+//
+static bool BenchmarkSuite(unsigned int frames, unsigned int threads, const char *jsonPath)
+{
+	spoutCopy copy;
+	copy.SetCopyThreads(threads);
+	const SpoutCopyTier tier = copy.GetCopyTier();
+
+	spoutLut lut;
+	lut.Parse(GradeCube(33).c_str());
+
+	const unsigned int levels = 3;
+	const double thumbnailBytes = 4.0 * (1.0 / 4 + 1.0 / 16 + 1.0 / 64);
+	// 4:2:0 luma and chroma planes
+	const double nv12 = 1.5;
+	const double p010 = 3.0;
+
+	// The destination of the resample tests is half the source width and height
+	auto half = [](unsigned int size) { return size / 2; };
+
+	const SuiteCase cases[] = {
+		{ "CopyPixels", "rgba8", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			copy.CopyPixels(f.src, f.dst, f.width, f.height, GL_RGBA, f.bInvert); } },
+		{ "FlipBuffer", "rgba8", SUITE_BYTES, 4, 4, 4, 4, false, [&](const SuiteFrame &f) {
+			copy.FlipBuffer(f.src, f.dst, f.width, f.height, GL_RGBA); } },
+		{ "memcpy_sse2", "rgba8", SUITE_BYTES, 4, 4, 4, 4, false, [&](const SuiteFrame &f) {
+			copy.memcpy_sse2(f.dst, f.src, (size_t)f.width * f.height * 4); } },
+		{ "RemovePadding", "rgba8", SUITE_BYTES, 4, 4, 4, 4, false, [&](const SuiteFrame &f) {
+			copy.RemovePadding(f.src, f.dst, f.width, f.height, f.srcPitch, GL_RGBA); } },
+		{ "rgba2rgba", "rgba8", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			copy.rgba2rgba(f.src, f.dst, f.width, f.height, f.srcPitch, f.bInvert); } },
+		{ "rgba2rgba (dest pitch)", "rgba8", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			copy.rgba2rgba(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch, f.bInvert); } },
+		{ "rgba2rgbaResample", "rgba8 half", SUITE_BYTES, 4, 2, 4, 1, true, [&](const SuiteFrame &f) {
+			copy.rgba2rgbaResample(f.src, f.dst, f.width, f.height, f.srcPitch,
+				half(f.width), half(f.height), f.bInvert); } },
+		{ "rgba2rgbaResample (dest pitch)", "rgba8 half", SUITE_BYTES, 4, 2, 4, 1, true, [&](const SuiteFrame &f) {
+			copy.rgba2rgbaResample(f.src, f.dst, f.width, f.height, f.srcPitch,
+				half(f.width), half(f.height), f.dstPitch, f.bInvert); } },
+		{ "rgba2bgra", "rgba8", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			copy.rgba2bgra(f.src, f.dst, f.width, f.height, f.bInvert); } },
+		{ "rgba2bgra (pitch)", "rgba8", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			copy.rgba2bgra(f.src, f.dst, f.width, f.height, f.srcPitch, f.bInvert); } },
+		{ "rgba2bgra (dest pitch)", "rgba8", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			copy.rgba2bgra(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch, f.bInvert); } },
+		{ "bgra2rgba", "bgra8", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			copy.bgra2rgba(f.src, f.dst, f.width, f.height, f.bInvert); } },
+		{ "rgb2rgba", "rgb8", SUITE_BYTES, 3, 4, 3, 4, true, [&](const SuiteFrame &f) {
+			copy.rgb2rgba(f.src, f.dst, f.width, f.height, f.bInvert); } },
+		{ "rgb2rgba (dest pitch)", "rgb8", SUITE_BYTES, 3, 4, 3, 4, true, [&](const SuiteFrame &f) {
+			copy.rgb2rgba(f.src, f.dst, f.width, f.height, f.dstPitch, f.bInvert); } },
+		{ "bgr2rgba", "bgr8", SUITE_BYTES, 3, 4, 3, 4, true, [&](const SuiteFrame &f) {
+			copy.bgr2rgba(f.src, f.dst, f.width, f.height, f.bInvert); } },
+		{ "bgr2rgba (dest pitch)", "bgr8", SUITE_BYTES, 3, 4, 3, 4, true, [&](const SuiteFrame &f) {
+			copy.bgr2rgba(f.src, f.dst, f.width, f.height, f.dstPitch, f.bInvert); } },
+		{ "rgb2bgra", "rgb8", SUITE_BYTES, 3, 4, 3, 4, true, [&](const SuiteFrame &f) {
+			copy.rgb2bgra(f.src, f.dst, f.width, f.height, f.bInvert); } },
+		{ "rgb2bgra (dest pitch)", "rgb8", SUITE_BYTES, 3, 4, 3, 4, true, [&](const SuiteFrame &f) {
+			copy.rgb2bgra(f.src, f.dst, f.width, f.height, f.dstPitch, f.bInvert); } },
+		{ "bgr2bgra", "bgr8", SUITE_BYTES, 3, 4, 3, 4, true, [&](const SuiteFrame &f) {
+			copy.bgr2bgra(f.src, f.dst, f.width, f.height, f.bInvert); } },
+		{ "rgba2bgr", "rgba8", SUITE_BYTES, 4, 3, 4, 3, true, [&](const SuiteFrame &f) {
+			copy.rgba2bgr(f.src, f.dst, f.width, f.height, f.bInvert); } },
+		{ "rgba2bgr (pitch)", "rgba8", SUITE_BYTES, 4, 3, 4, 3, true, [&](const SuiteFrame &f) {
+			copy.rgba2bgr(f.src, f.dst, f.width, f.height, f.srcPitch, f.bInvert); } },
+		{ "bgra2rgb", "bgra8", SUITE_BYTES, 4, 3, 4, 3, true, [&](const SuiteFrame &f) {
+			copy.bgra2rgb(f.src, f.dst, f.width, f.height, f.bInvert); } },
+		{ "bgra2bgr", "bgra8", SUITE_BYTES, 4, 3, 4, 3, true, [&](const SuiteFrame &f) {
+			copy.bgra2bgr(f.src, f.dst, f.width, f.height, f.bInvert); } },
+		{ "rgba2rgb (pitch)", "rgba8", SUITE_BYTES, 4, 3, 4, 3, true, [&](const SuiteFrame &f) {
+			copy.rgba2rgb(f.src, f.dst, f.width, f.height, f.srcPitch, f.bInvert); } },
+		{ "rgba2rgbResample", "rgba8 half", SUITE_BYTES, 4, 1.5, 4, 0.75, true, [&](const SuiteFrame &f) {
+			copy.rgba2rgbResample(f.src, f.dst, f.width, f.height, f.srcPitch,
+				half(f.width), half(f.height), f.bInvert); } },
+		{ "rgba2bgrResample", "rgba8 half", SUITE_BYTES, 4, 1.5, 4, 0.75, true, [&](const SuiteFrame &f) {
+			copy.rgba2bgrResample(f.src, f.dst, f.width, f.height, f.srcPitch,
+				half(f.width), half(f.height), f.bInvert); } },
+		{ "Convert", "rgba8 > bgra8", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			SpoutPixelDesc source(GL_RGBA, f.width, f.height, f.srcPitch);
+			source.bInvert = f.bInvert;
+			copy.Convert(f.src, source, f.dst, SpoutPixelDesc(GL_BGRA_EXT, f.width, f.height, f.dstPitch)); } },
+		{ "Convert", "rgba16 > rgba8", SUITE_BYTES, 8, 4, 8, 4, true, [&](const SuiteFrame &f) {
+			SpoutPixelDesc source(GL_RGBA16, f.width, f.height, f.srcPitch);
+			source.bInvert = f.bInvert;
+			copy.Convert(f.src, source, f.dst, SpoutPixelDesc(GL_RGBA, f.width, f.height, f.dstPitch)); } },
+		{ "ConvertRegion", "rgba8 quarter", SUITE_BYTES, 4, 2, 1, 1, true, [&](const SuiteFrame &f) {
+			SpoutPixelDesc source(GL_RGBA, f.width, f.height, f.srcPitch);
+			source.bInvert = f.bInvert;
+			const SpoutRegion region(f.width / 4, f.height / 4, half(f.width), half(f.height));
+			copy.ConvertRegion(f.src, source, region, f.dst,
+				SpoutPixelDesc(GL_RGBA, region.width, region.height, f.dstPitch)); } },
+		{ "ConvertRGBA", "rgba16 > bgra8", SUITE_BYTES, 8, 4, 8, 4, true, [&](const SuiteFrame &f) {
+			copy.ConvertRGBA(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch,
+				GL_RGBA16, GL_BGRA_EXT, f.bInvert); } },
+		{ "ConvertRGBA", "rgba16f > rgba8", SUITE_HALF, 8, 4, 8, 4, true, [&](const SuiteFrame &f) {
+			copy.ConvertRGBA(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch,
+				GL_RGBA16F, GL_RGBA, f.bInvert); } },
+		{ "ConvertRGBA", "rgba32f > rgba16f", SUITE_FLOAT, 16, 8, 16, 8, true, [&](const SuiteFrame &f) {
+			copy.ConvertRGBA(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch,
+				GL_RGBA32F, GL_RGBA16F, f.bInvert); } },
+		{ "ApplyLut", "rgba8", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			copy.ApplyLut(lut, f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch,
+				GL_RGBA, f.bInvert); } },
+		{ "ApplyTransfer", "rgba16 srgb > linear", SUITE_BYTES, 8, 8, 8, 8, true, [&](const SuiteFrame &f) {
+			copy.ApplyTransfer(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch, GL_RGBA16,
+				SPOUT_TRANSFER_SRGB, SPOUT_TRANSFER_LINEAR, f.bInvert); } },
+		{ "YUVToRGBA", "nv12 > rgba8", SUITE_BYTES, 1, 4, nv12, 4, true, [&](const SuiteFrame &f) {
+			copy.YUVToRGBA(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch,
+				SPOUT_YUV_NV12, GL_RGBA, SPOUT_YUV_BT709, false, f.bInvert); } },
+		{ "YUVToRGBA", "p010 > rgba16", SUITE_BYTES, 2, 8, p010, 8, true, [&](const SuiteFrame &f) {
+			copy.YUVToRGBA(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch,
+				SPOUT_YUV_P010, GL_RGBA16, SPOUT_YUV_BT709, false, f.bInvert); } },
+		{ "RGBAToYUV", "rgba8 > nv12", SUITE_BYTES, 4, 1, 4, nv12, true, [&](const SuiteFrame &f) {
+			copy.RGBAToYUV(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch,
+				GL_RGBA, SPOUT_YUV_NV12, SPOUT_YUV_BT709, false, f.bInvert); } },
+		{ "DitherRGBA", "rgba16 > bgra8", SUITE_BYTES, 8, 4, 8, 4, true, [&](const SuiteFrame &f) {
+			copy.DitherRGBA(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch,
+				GL_RGBA16, GL_BGRA_EXT, SPOUT_DITHER_BLUE_NOISE, 0, f.bInvert); } },
+		{ "ApplyAlpha", "rgba8 premultiply", SUITE_BYTES, 4, 4, 4, 4, true, [&](const SuiteFrame &f) {
+			copy.ApplyAlpha(f.src, f.dst, f.width, f.height, f.srcPitch, f.dstPitch,
+				GL_RGBA, SPOUT_ALPHA_OP_PREMULTIPLY, f.bInvert); } },
+		{ "Rotate", "rgba8 90", SUITE_BYTES, 4, 4, 4, 4, false, [&](const SuiteFrame &f) {
+			// The destination has a line for each source column
+			copy.Rotate(f.src, f.dst, f.width, f.height, f.srcPitch, f.height * 4 + f.padding,
+				GL_RGBA, SPOUT_ROTATE_90); } },
+		{ "Downsample", "rgba8 1/2 1/4 1/8", SUITE_BYTES, 4, 0, 4, thumbnailBytes, true, [&](const SuiteFrame &f) {
+			unsigned char *dest[levels];
+			unsigned char *level = f.dst;
+			unsigned int width = f.width;
+			unsigned int height = f.height;
+			for (unsigned int i = 0; i < levels; i++) {
+				dest[i] = level;
+				width = spoutthumbnail::HalfSize(width);
+				height = spoutthumbnail::HalfSize(height);
+				level += (size_t)width * height * 4;
+			}
+			copy.Downsample(f.src, f.width, f.height, f.srcPitch, GL_RGBA, dest, levels, f.bInvert); } },
+	};
+
+	// Buffers for the largest frame with line padding and offset,
+	// allowing for a rotated destination. Float sources are 16 bytes
+	// per pixel and others 8 at most.
+	const Resolution &largest = suiteResolutions[sizeof(suiteResolutions) / sizeof(suiteResolutions[0]) - 1];
+	const size_t largestPixels = (size_t)largest.width * largest.height;
+	const size_t extraBytes = (size_t)64 * (largest.width + largest.height) + 128;
+	std::vector<unsigned char> sources[SUITE_SOURCE_COUNT];
+	sources[SUITE_BYTES].resize(largestPixels * 8 + extraBytes);
+	sources[SUITE_HALF].resize(largestPixels * 8 + extraBytes);
+	sources[SUITE_FLOAT].resize(largestPixels * 16 + extraBytes);
+	std::vector<unsigned char> dest(largestPixels * 8 + extraBytes);
+	for (size_t i = 0; i < sources[SUITE_BYTES].size(); i++)
+		sources[SUITE_BYTES][i] = (unsigned char)rand();
+	float *values = reinterpret_cast<float *>(sources[SUITE_FLOAT].data());
+	for (size_t i = 0; i < sources[SUITE_FLOAT].size() / sizeof(float); i++)
+		values[i] = (float)(rand() & 255) / 255.0f;
+	copy.ConvertRGBA(values, sources[SUITE_HALF].data(), (unsigned int)(sources[SUITE_FLOAT].size() / 16), 1,
+		0, 0, GL_RGBA32F, GL_RGBA16F);
+
+	// 64 byte aligned start of each buffer
+	auto aligned = [](unsigned char *buffer) {
+		return buffer + ((64 - ((uintptr_t)buffer & 63)) & 63);
+	};
+
+	printf("spoutCopy suite, %s, %u thread%s\n", spoutCopy::GetKernels(tier)->name,
+		threads, threads == 1 ? "" : "s");
+	printf("  %-30s %-20s %-6s %-9s %-6s %10s %10s %10s\n",
+		"method", "format", "size", "alignment", "invert", "msec", "GB/s", "ns/pixel");
+
+	std::vector<SuiteResult> results;
+	for (const SuiteCase &test : cases) {
+		for (const Resolution &res : suiteResolutions) {
+			for (int a = 0; a < 2; a++) {
+				for (int i = 0; i < (test.bInvert ? 2 : 1); i++) {
+					const bool bAligned = (a == 0);
+					const unsigned int padding = bAligned ? 0 : 4;
+					SuiteFrame f;
+					f.src = aligned(sources[test.source].data()) + padding;
+					f.dst = aligned(dest.data()) + padding;
+					f.width = res.width;
+					f.height = res.height;
+					f.srcPitch = (unsigned int)(res.width * test.srcLine) + padding;
+					f.dstPitch = (unsigned int)(res.width * test.dstLine) + padding;
+					f.padding = padding;
+					f.bInvert = (i == 1);
+
+					const double msec = TimeFrames([&]() { test.function(f); }, frames);
+					const double pixels = (double)res.width * res.height;
+					SuiteResult r;
+					r.test = &test;
+					r.res = &res;
+					r.bAligned = bAligned;
+					r.bInvert = f.bInvert;
+					r.msec = msec;
+					r.gbps = Throughput(pixels * (test.srcBytes + test.dstBytes), msec);
+					r.nsPerPixel = msec * 1.0e6 / pixels;
+					results.push_back(r);
+					printf("  %-30s %-20s %-6s %-9s %-6s %10.3f %10.2f %10.3f\n",
+						test.method, test.format, res.name, bAligned ? "aligned" : "offset",
+						f.bInvert ? "yes" : "no", r.msec, r.gbps, r.nsPerPixel);
+				}
+			}
+		}
+	}
+	printf("\n");
+
+	if (jsonPath && *jsonPath) {
+		if (!WriteSuiteJson(jsonPath, results, frames, threads, spoutCopy::GetKernels(tier)->name))
+			return false;
+		printf("Results written to %s\n\n", jsonPath);
+	}
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int frames = 50;
+	unsigned int maxThreads = 0; // all hardware threads
+	bool bSuite = false;
+	const char *jsonPath = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			maxThreads = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--suite") == 0)
+			bSuite = true;
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			jsonPath = argv[++i];
+			bSuite = true;
+		}
+	}
+	if (frames == 0)
+		frames = 1;
+
+	// The suite is single threaded unless a thread count is given
+	if (bSuite)
+		return BenchmarkSuite(frames, maxThreads ? maxThreads : 1, jsonPath) ? 0 : 1;
+
+	BenchmarkTiers(frames);
+	BenchmarkThreads(frames, maxThreads);
+	BenchmarkMemcpy(frames);
+	BenchmarkResample(frames, maxThreads);
+	BenchmarkLayouts(frames);
+	BenchmarkFormats(frames);
+	BenchmarkFused(frames);
+	BenchmarkLut(frames, maxThreads);
+	BenchmarkTransfer(frames, maxThreads);
+	BenchmarkYUV(frames, maxThreads);
+	BenchmarkDither(frames, maxThreads);
+	BenchmarkAlpha(frames, maxThreads);
+	BenchmarkRotate(frames, maxThreads);
+	BenchmarkRegion(frames, maxThreads);
+	BenchmarkFrameHash(frames, maxThreads);
+	BenchmarkThumbnail(frames, maxThreads);
+	BenchmarkSharedMemory(frames, maxThreads);
+	BenchmarkSenderInfo(frames);
+	BenchmarkMemoryRing(frames);
+	BenchmarkMemoryBuffer(frames);
+	BenchmarkMemoryLease(frames);
+	BenchmarkLargePages(frames);
+	BenchmarkFrameNotify(frames);
+
+	return 0;
+}
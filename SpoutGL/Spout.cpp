@@ -217,6 +217,9 @@
 //					  Adapter index and name are retrieved with Get functions
 //		20.12.21	- Restore log notice for ReleaseSender
 //		24.02.22	- Restore GetSenderAdpater for testing
+//		16.10.26	- Close the memoryshare ring buffer in ReleaseSender and ReleaseReceiver
+//					- Add WaitNewFrame
+//					- Close the sender maps kept open by getSharedInfo in ReleaseReceiver
 //
 // ====================================================================================
 /*
@@ -395,6 +398,7 @@ void Spout::ReleaseSender()
 
 	// Close shared memory and sync event if used
 	memoryshare.Close();
+	memoryring.Close();
 	frame.CloseFrameSync();
 
 	// Release OpenGL resources
@@ -682,6 +686,9 @@ void Spout::ReleaseReceiver()
 	frame.CloseAccessMutex();
 	frame.CleanupFrameCount();
 
+	// Close sender information maps kept open for reads
+	sendernames.CloseSharedInfo();
+
 	// Zero width and height so that they are reset when a sender is found
 	m_Width = 0;
 	m_Height = 0;
@@ -707,6 +714,7 @@ void Spout::ReleaseReceiver()
 
 	// Close shared memory and sync event if used
 	memoryshare.Close();
+	memoryring.Close();
 	frame.CloseFrameSync();
 	
 	m_bConnected = false;
@@ -893,6 +901,18 @@ bool Spout::IsFrameNew()
 	return frame.IsFrameNew();
 }
 
+//---------------------------------------------------------
+// Function: WaitNewFrame
+// Wait for the sender to produce a new frame
+//
+//   The thread sleeps until the sender has a frame after the last received
+//   or the timeout, instead of polling with ReceiveTexture or ReceiveImage.
+//   Frame counting must be enabled by the sender and the receiver.
+bool Spout::WaitNewFrame(DWORD dwTimeout)
+{
+	return frame.WaitNewFrame(dwTimeout);
+}
+
 //---------------------------------------------------------
 // Function: GetSenderFormat
 // Get sender DirectX texture format
@@ -119,6 +119,9 @@ class SPOUT_DLLEXP Spout : public spoutGL {
 	//   The receiving texture or pixel buffer is only refreshed if the sender has produced a new frame  
 	//   This can be queried to process texture data only for new frames
 	bool IsFrameNew();
+	// Wait for the sender to produce a new frame
+	//   Returns false after the timeout in msec or if frame counting is not enabled
+	bool WaitNewFrame(DWORD dwTimeout = INFINITE);
 	// Received sender name
 	const char * GetSenderName();
 	// Received sender width
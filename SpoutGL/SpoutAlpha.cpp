@@ -0,0 +1,390 @@
+/*
+
+					SpoutAlpha.cpp
+
+		Premultiply, unpremultiply and opaque alpha for rgba pixels
+
+		Senders may have straight alpha, premultiplied alpha, or no
+		alpha at all (rgbx and bgrx) where the alpha byte is undefined.
+		These functions change pixels from one to another.
+
+		Premultiply
+
+		Colour is multiplied by alpha. 8 bit values are rounded exactly,
+		(c*a + 127)/255, with integer arithmetic for 4 pixels at a time.
+
+		Unpremultiply
+
+		Colour is divided by alpha and clamped for integer formats.
+		Colour is zero where alpha is zero. 8 bit pixels use one float
+		division for 4 pixels.
+
+		Opaque
+
+		Alpha is set to the maximum, 255, 65535 or 1.0, with a mask
+		for 16 bytes at a time.
+
+		16 bit and float pixels use float arithmetic with the same
+		operations for the scalar and SSE2 versions, so the results are
+		the same. Half float is converted to float in blocks.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutAlpha.h"
+#include "SpoutConvert.h"
+#include <string.h>
+
+namespace spoutalpha {
+
+	SpoutAlphaOp GetOp(SpoutAlphaMode sourceMode, SpoutAlphaMode destMode)
+	{
+		if (destMode == SPOUT_ALPHA_IGNORED || sourceMode == destMode)
+			return SPOUT_ALPHA_OP_NONE;
+		// Alpha of 1 is the same for straight and premultiplied
+		if (sourceMode == SPOUT_ALPHA_IGNORED)
+			return SPOUT_ALPHA_OP_OPAQUE;
+		return (destMode == SPOUT_ALPHA_PREMULTIPLIED) ? SPOUT_ALPHA_OP_PREMULTIPLY : SPOUT_ALPHA_OP_UNPREMULTIPLY;
+	}
+
+	//
+	// 8 bit
+	//
+
+	static inline unsigned char Multiply8(unsigned int c, unsigned int a)
+	{
+		const unsigned int t = c * a + 128;
+		return (unsigned char)((t + (t >> 8)) >> 8);
+	}
+
+	static void premultiply8_scalar(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		for (unsigned int x = 0; x < width; x++) {
+			const unsigned char *s = src + (size_t)x * 4;
+			unsigned char *d = dst + (size_t)x * 4;
+			const unsigned int a = s[3];
+			d[0] = Multiply8(s[0], a);
+			d[1] = Multiply8(s[1], a);
+			d[2] = Multiply8(s[2], a);
+			d[3] = (unsigned char)a;
+		}
+	}
+
+	static void premultiply8_sse2(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(128);
+		// Alpha multiplied by 255 is unchanged
+		const __m128i alpha = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+		unsigned int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 4));
+			__m128i half[2] = { _mm_unpacklo_epi8(p, zero), _mm_unpackhi_epi8(p, zero) };
+			for (int i = 0; i < 2; i++) {
+				__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(half[i], _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+				a = _mm_or_si128(a, alpha);
+				__m128i t = _mm_add_epi16(_mm_mullo_epi16(half[i], a), round);
+				half[i] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4), _mm_packus_epi16(half[0], half[1]));
+		}
+		if (x < width)
+			premultiply8_scalar(src + (size_t)x * 4, dst + (size_t)x * 4, width - x);
+	}
+
+	// Exact results are multiples of 1/alpha. An offset less than 1/255
+	// rounds halves up despite the error of the float reciprocal.
+	static const float Round8 = 0.5f + 1.0f / 1024.0f;
+
+	static void unpremultiply8_scalar(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		for (unsigned int x = 0; x < width; x++) {
+			const unsigned char *s = src + (size_t)x * 4;
+			unsigned char *d = dst + (size_t)x * 4;
+			const unsigned char a = s[3];
+			const float scale = a ? 255.0f / (float)a : 0.0f;
+			for (int c = 0; c < 3; c++) {
+				const float v = (float)s[c] * scale + Round8;
+				d[c] = (unsigned char)(v < 255.0f ? v : 255.0f);
+			}
+			d[3] = a;
+		}
+	}
+
+	static void unpremultiply8_sse2(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 zerof = _mm_setzero_ps();
+		const __m128 max = _mm_set1_ps(255.0f);
+		const __m128 round = _mm_set1_ps(Round8);
+		const __m128 rgb = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		const __m128 one = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+		unsigned int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 4));
+			// Scale for each pixel, zero for zero alpha
+			const __m128 a = _mm_cvtepi32_ps(_mm_srli_epi32(p, 24));
+			const __m128 scales = _mm_and_ps(_mm_div_ps(max, a), _mm_cmpneq_ps(a, zerof));
+			const __m128i lo = _mm_unpacklo_epi8(p, zero);
+			const __m128i hi = _mm_unpackhi_epi8(p, zero);
+			const __m128 v[4] = {
+				_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)),
+				_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)) };
+			const __m128 s[4] = {
+				_mm_shuffle_ps(scales, scales, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(1, 1, 1, 1)),
+				_mm_shuffle_ps(scales, scales, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(3, 3, 3, 3)) };
+			__m128i q[4];
+			for (int i = 0; i < 4; i++) {
+				// Alpha is multiplied by 1
+				const __m128 scale = _mm_or_ps(_mm_and_ps(s[i], rgb), one);
+				q[i] = _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(_mm_mul_ps(v[i], scale), round), max));
+			}
+			const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4), packed);
+		}
+		if (x < width)
+			unpremultiply8_scalar(src + (size_t)x * 4, dst + (size_t)x * 4, width - x);
+	}
+
+	//
+	// 16 bit
+	//
+
+	template <bool bPremultiply>
+	static void unorm16_scalar(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		for (unsigned int x = 0; x < width; x++) {
+			uint16_t p[4];
+			memcpy(p, src + (size_t)x * 8, 8);
+			float scale = 0.0f;
+			if (bPremultiply)
+				scale = (float)p[3] * (1.0f / 65535.0f);
+			else if (p[3])
+				scale = 65535.0f / (float)p[3];
+			for (int c = 0; c < 3; c++) {
+				const float v = (float)p[c] * scale + 0.5f;
+				p[c] = (uint16_t)(v < 65535.0f ? v : 65535.0f);
+			}
+			memcpy(dst + (size_t)x * 8, p, 8);
+		}
+	}
+
+	template <bool bPremultiply>
+	static void unorm16_sse2(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 zerof = _mm_setzero_ps();
+		const __m128 max = _mm_set1_ps(65535.0f);
+		const __m128 inverse = _mm_set1_ps(1.0f / 65535.0f);
+		const __m128 round = _mm_set1_ps(0.5f);
+		const __m128 rgb = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		const __m128 one = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+		const __m128i offset = _mm_set1_epi32(32768);
+		const __m128i sign = _mm_set1_epi16((short)0x8000);
+		for (unsigned int x = 0; x < width; x++) {
+			const __m128i p = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + (size_t)x * 8));
+			const __m128 v = _mm_cvtepi32_ps(_mm_unpacklo_epi16(p, zero));
+			const __m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+			__m128 scale;
+			if (bPremultiply)
+				scale = _mm_mul_ps(a, inverse);
+			else
+				scale = _mm_and_ps(_mm_div_ps(max, a), _mm_cmpneq_ps(a, zerof));
+			scale = _mm_or_ps(_mm_and_ps(scale, rgb), one);
+			const __m128 d = _mm_min_ps(_mm_add_ps(_mm_mul_ps(v, scale), round), max);
+			// No unsigned 32 to 16 bit pack in SSE2. Offset to signed and back.
+			__m128i i = _mm_sub_epi32(_mm_cvttps_epi32(d), offset);
+			i = _mm_xor_si128(_mm_packs_epi32(i, i), sign);
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + (size_t)x * 8), i);
+		}
+	}
+
+	//
+	// Float
+	//
+
+	template <bool bPremultiply>
+	static void float_scalar(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		for (unsigned int x = 0; x < width; x++) {
+			float p[4];
+			memcpy(p, src + (size_t)x * 16, 16);
+			float scale = 0.0f;
+			if (bPremultiply)
+				scale = p[3];
+			else if (p[3] != 0.0f)
+				scale = 1.0f / p[3];
+			p[0] *= scale;
+			p[1] *= scale;
+			p[2] *= scale;
+			memcpy(dst + (size_t)x * 16, p, 16);
+		}
+	}
+
+	template <bool bPremultiply>
+	static void float_sse2(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 ones = _mm_set1_ps(1.0f);
+		unsigned int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			const float *s = reinterpret_cast<const float *>(src + (size_t)x * 16);
+			float *d = reinterpret_cast<float *>(dst + (size_t)x * 16);
+			const __m128 v[4] = { _mm_loadu_ps(s), _mm_loadu_ps(s + 4), _mm_loadu_ps(s + 8), _mm_loadu_ps(s + 12) };
+			// Alpha of the 4 pixels in one vector
+			const __m128 a01 = _mm_shuffle_ps(v[0], v[1], _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128 a23 = _mm_shuffle_ps(v[2], v[3], _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128 a = _mm_shuffle_ps(a01, a23, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 scales = a;
+			if (!bPremultiply)
+				scales = _mm_and_ps(_mm_div_ps(ones, a), _mm_cmpneq_ps(a, zero));
+			// Scale for each pixel with 1 for alpha
+			const __m128 lo = _mm_unpacklo_ps(scales, scales); // s0 s0 s1 s1
+			const __m128 hi = _mm_unpackhi_ps(scales, scales); // s2 s2 s3 s3
+			const __m128 s01 = _mm_shuffle_ps(lo, ones, _MM_SHUFFLE(0, 0, 2, 0)); // s0 s1 1 1
+			const __m128 s23 = _mm_shuffle_ps(hi, ones, _MM_SHUFFLE(0, 0, 2, 0)); // s2 s3 1 1
+			_mm_storeu_ps(d,      _mm_mul_ps(v[0], _mm_shuffle_ps(s01, s01, _MM_SHUFFLE(2, 0, 0, 0))));
+			_mm_storeu_ps(d + 4,  _mm_mul_ps(v[1], _mm_shuffle_ps(s01, s01, _MM_SHUFFLE(2, 1, 1, 1))));
+			_mm_storeu_ps(d + 8,  _mm_mul_ps(v[2], _mm_shuffle_ps(s23, s23, _MM_SHUFFLE(2, 0, 0, 0))));
+			_mm_storeu_ps(d + 12, _mm_mul_ps(v[3], _mm_shuffle_ps(s23, s23, _MM_SHUFFLE(2, 1, 1, 1))));
+		}
+		if (x < width)
+			float_scalar<bPremultiply>(src + (size_t)x * 16, dst + (size_t)x * 16, width - x);
+	}
+
+	//
+	// Half float in blocks converted to float
+	//
+
+	template <bool bPremultiply, bool bSSE2, bool bF16C>
+	static void half_line(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		const SpoutCopyTier tier = bSSE2 ? SPOUT_COPY_SSE2 : SPOUT_COPY_SCALAR;
+		const SpoutRowKernel toFloat = spoutconvert::GetKernel(SPOUT_RGBA16F, SPOUT_RGBA32F, false, false, tier, bF16C);
+		const SpoutRowKernel toHalf = spoutconvert::GetKernel(SPOUT_RGBA32F, SPOUT_RGBA16F, false, false, tier, bF16C);
+		const unsigned int blockSize = 64;
+		float block[blockSize * 4];
+		unsigned char *line = reinterpret_cast<unsigned char *>(block);
+		for (unsigned int x = 0; x < width; x += blockSize) {
+			const unsigned int n = (width - x < blockSize) ? width - x : blockSize;
+			toFloat(src + (size_t)x * 8, line, n);
+			if (bSSE2)
+				float_sse2<bPremultiply>(line, line, n);
+			else
+				float_scalar<bPremultiply>(line, line, n);
+			toHalf(line, dst + (size_t)x * 8, n);
+		}
+	}
+
+	//
+	// Opaque
+	//
+
+	// Alpha of 255, 65535, half 1.0 or float 1.0 in the last bytes of a pixel
+	static void OpaqueAlpha(SpoutRGBAFormat format, unsigned int &bytes, uint32_t &alpha, unsigned int &alphaBytes)
+	{
+		switch (format) {
+			case SPOUT_RGBA16:  bytes = 8;  alpha = 0xFFFF;     alphaBytes = 2; break;
+			case SPOUT_RGBA16F: bytes = 8;  alpha = 0x3C00;     alphaBytes = 2; break;
+			case SPOUT_RGBA32F: bytes = 16; alpha = 0x3F800000; alphaBytes = 4; break;
+			default:            bytes = 4;  alpha = 0xFF;       alphaBytes = 1; break;
+		}
+	}
+
+	template <SpoutRGBAFormat F>
+	static void opaque_scalar(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		unsigned int bytes = 0, alphaBytes = 0;
+		uint32_t alpha = 0;
+		OpaqueAlpha(F, bytes, alpha, alphaBytes);
+		if (src != dst)
+			memcpy(dst, src, (size_t)width * bytes);
+		// Little-endian alpha value
+		for (unsigned int x = 0; x < width; x++)
+			memcpy(dst + (size_t)x * bytes + bytes - alphaBytes, &alpha, alphaBytes);
+	}
+
+	template <SpoutRGBAFormat F>
+	static void opaque_sse2(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		unsigned int bytes = 0, alphaBytes = 0;
+		uint32_t alpha = 0;
+		OpaqueAlpha(F, bytes, alpha, alphaBytes);
+
+		// Masks for 16 bytes, a whole number of pixels
+		alignas(16) unsigned char keep[16];
+		alignas(16) unsigned char value[16];
+		memset(keep, 0xFF, 16);
+		memset(value, 0, 16);
+		for (unsigned int p = 0; p < 16; p += bytes) {
+			memset(keep + p + bytes - alphaBytes, 0, alphaBytes);
+			memcpy(value + p + bytes - alphaBytes, &alpha, alphaBytes);
+		}
+		const __m128i keepMask = _mm_load_si128(reinterpret_cast<const __m128i *>(keep));
+		const __m128i alphaBits = _mm_load_si128(reinterpret_cast<const __m128i *>(value));
+
+		const size_t size = (size_t)width * bytes;
+		size_t i = 0;
+		for (; i + 16 <= size; i += 16) {
+			const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(_mm_and_si128(p, keepMask), alphaBits));
+		}
+		if (i < size)
+			opaque_scalar<F>(src + i, dst + i, (unsigned int)((size - i) / bytes));
+	}
+
+	template <SpoutRGBAFormat F>
+	static SpoutRowKernel OpaqueKernel(bool bSSE2)
+	{
+		return bSSE2 ? opaque_sse2<F> : opaque_scalar<F>;
+	}
+
+	template <bool bPremultiply>
+	static SpoutRowKernel HalfKernel(bool bSSE2, bool bF16C)
+	{
+		if (!bSSE2)
+			return half_line<bPremultiply, false, false>;
+		return bF16C ? half_line<bPremultiply, true, true> : half_line<bPremultiply, true, false>;
+	}
+
+	SpoutRowKernel GetKernel(SpoutRGBAFormat format, SpoutAlphaOp op,
+		SpoutCopyTier tier, bool bF16C)
+	{
+		if (format >= SPOUT_RGBA_FORMAT_COUNT)
+			return nullptr;
+
+		const bool bSSE2 = (tier != SPOUT_COPY_SCALAR);
+		switch (op) {
+			case SPOUT_ALPHA_OP_PREMULTIPLY:
+				switch (format) {
+					case SPOUT_RGBA16:  return bSSE2 ? unorm16_sse2<true> : unorm16_scalar<true>;
+					case SPOUT_RGBA16F: return HalfKernel<true>(bSSE2, bF16C);
+					case SPOUT_RGBA32F: return bSSE2 ? float_sse2<true> : float_scalar<true>;
+					default:            return bSSE2 ? premultiply8_sse2 : premultiply8_scalar;
+				}
+			case SPOUT_ALPHA_OP_UNPREMULTIPLY:
+				switch (format) {
+					case SPOUT_RGBA16:  return bSSE2 ? unorm16_sse2<false> : unorm16_scalar<false>;
+					case SPOUT_RGBA16F: return HalfKernel<false>(bSSE2, bF16C);
+					case SPOUT_RGBA32F: return bSSE2 ? float_sse2<false> : float_scalar<false>;
+					default:            return bSSE2 ? unpremultiply8_sse2 : unpremultiply8_scalar;
+				}
+			case SPOUT_ALPHA_OP_OPAQUE:
+				switch (format) {
+					case SPOUT_RGBA16:  return OpaqueKernel<SPOUT_RGBA16>(bSSE2);
+					case SPOUT_RGBA16F: return OpaqueKernel<SPOUT_RGBA16F>(bSSE2);
+					case SPOUT_RGBA32F: return OpaqueKernel<SPOUT_RGBA32F>(bSSE2);
+					default:            return OpaqueKernel<SPOUT_RGBA8>(bSSE2);
+				}
+			default:
+				return nullptr;
+		}
+	}
+
+}
@@ -0,0 +1,38 @@
+/*
+
+					SpoutAlpha.h
+
+		Premultiply, unpremultiply and opaque alpha for rgba pixels
+
+		8 bit, 16 bit, half and float rgba and bgra.
+		Use spoutCopy::ApplyAlpha to convert an image with multiple threads,
+		or the alpha mode of SpoutPixelDesc to convert with spoutCopy::Convert
+		in the same pass as a change of format or size.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutAlpha__ // standard way as well
+#define __spoutAlpha__
+
+#include "SpoutCopy.h"
+
+namespace spoutalpha {
+
+	// Operation to change from one alpha mode to another.
+	// SPOUT_ALPHA_OP_NONE if nothing is needed.
+	SpoutAlphaOp GetOp(SpoutAlphaMode sourceMode, SpoutAlphaMode destMode);
+
+	// Line function for an operation on a format, or nullptr for
+	// SPOUT_ALPHA_OP_NONE. Source and destination can be the same.
+	// Red and blue are not distinguished so the functions are the
+	// same for rgba and bgra. bF16C uses the hardware conversion of half float.
+	SpoutRowKernel GetKernel(SpoutRGBAFormat format, SpoutAlphaOp op,
+		SpoutCopyTier tier, bool bF16C = false);
+
+}
+
+#endif
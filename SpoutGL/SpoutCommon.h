@@ -67,6 +67,10 @@
 //
 
 // Common utility functions namespace
+// SpoutUtils is Windows only. Other platforms can still build
+// the pixel copy functions without it.
+#if defined(_WIN32)
 #include "SpoutUtils.h"
+#endif
 
 #endif
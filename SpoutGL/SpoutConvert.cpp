@@ -0,0 +1,515 @@
+/*
+
+					SpoutConvert.cpp
+
+		Pixel conversion between 8 bit, 16 bit and floating point formats
+
+		Each pixel is loaded to four floats, red and blue swapped if
+		required, and stored in the destination format. The line
+		functions are generated from templates for each pair of formats.
+
+		Rounding
+
+		Unsigned normalized to float is value/max, which is correctly
+		rounded by the division. Float to unsigned normalized is clamped
+		to 0-1 and multiplied by max in double precision, which is exact,
+		then rounded to nearest even. NaN converts to 0. Float to half is
+		rounded to nearest even. 16 bit to half uses a table calculated
+		by rounding to odd, because value/max rounded to float and then
+		to half is not correctly rounded for two values.
+
+		8 bit to 16 bit (value*257) and 16 bit to 8 bit (value/257 rounded)
+		use integer SSE2 functions with the same result.
+
+		The scalar functions give the same result as the SSE2 and F16C
+		functions and are used for the scalar tier.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutConvert.h"
+#include <string.h>
+#include <vector>
+
+namespace spoutconvert {
+
+	//
+	// Half float
+	//
+	// Adapted from Fabian Giesen's float_to_half_fast3_rtne and half_to_float
+	// https://gist.github.com/rygorous/2156668
+	//
+
+	static inline uint32_t FloatBits(float f)
+	{
+		uint32_t u;
+		memcpy(&u, &f, 4);
+		return u;
+	}
+
+	static inline float BitsFloat(uint32_t u)
+	{
+		float f;
+		memcpy(&f, &u, 4);
+		return f;
+	}
+
+	float HalfToFloat(uint16_t h)
+	{
+		const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+		const uint32_t exponent = (h >> 10) & 0x1F;
+		const uint32_t mantissa = h & 0x3FF;
+		if (exponent == 0x1F) // Infinity, or NaN made quiet as F16C
+			return BitsFloat(sign | 0x7F800000 | (mantissa ? 0x400000 | (mantissa << 13) : 0));
+		if (exponent == 0) // Zero or subnormal, mantissa * 2^-24
+			return BitsFloat(sign | FloatBits((float)mantissa * (1.0f / 16777216.0f)));
+		return BitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+	}
+
+	uint16_t FloatToHalf(float f)
+	{
+		const uint32_t f32infinity = 255u << 23;
+		const uint32_t f16max = (127u + 16) << 23;
+		const uint32_t denormMagic = ((127u - 15) + (23 - 10) + 1) << 23;
+		uint32_t u = FloatBits(f);
+		const uint32_t sign = u & 0x80000000u;
+		u ^= sign;
+		uint16_t h = 0;
+		if (u >= f16max) {
+			// Infinity, overflow, or NaN made quiet keeping the high mantissa bits
+			h = (u > f32infinity) ? (uint16_t)(0x7E00 | ((u >> 13) & 0x3FF)) : 0x7C00;
+		}
+		else if (u < (113u << 23)) {
+			// Subnormal. The addition rounds the mantissa to nearest even.
+			h = (uint16_t)(FloatBits(BitsFloat(u) + BitsFloat(denormMagic)) - denormMagic);
+		}
+		else {
+			// Rebias the exponent and round to nearest even
+			const uint32_t odd = (u >> 13) & 1;
+			u += ((uint32_t)(15 - 127) << 23) + 0xFFF;
+			u += odd;
+			h = (uint16_t)(u >> 13);
+		}
+		return (uint16_t)(h | (sign >> 16));
+	}
+
+	// Correctly rounded half for each 16 bit value/65535. The float is
+	// rounded to odd so that rounding again to half is correct.
+	static std::vector<uint16_t> BuildUnorm16HalfTable()
+	{
+		std::vector<uint16_t> table(65536);
+		for (unsigned int v = 0; v < 65536; v++) {
+			const double q = (double)v / 65535.0;
+			float f = (float)q;
+			if ((double)f != q) {
+				uint32_t u = FloatBits(f);
+				if ((double)f > q)
+					u--;
+				f = BitsFloat(u | 1);
+			}
+			table[v] = FloatToHalf(f);
+		}
+		return table;
+	}
+
+	static const uint16_t *Unorm16HalfTable()
+	{
+		static const std::vector<uint16_t> table = BuildUnorm16HalfTable();
+		return table.data();
+	}
+
+	// Clamp to 0-1 and scale to an unsigned normalized value.
+	// Compare with > so that NaN is 0 as with the SSE max.
+	static inline unsigned int ToUnorm(float x, double scale)
+	{
+		if (!(x > 0.0f))
+			x = 0.0f;
+		else if (x > 1.0f)
+			x = 1.0f;
+		return (unsigned int)std::nearbyint((double)x * scale);
+	}
+
+	//
+	// Scalar format traits. Four channels in v[0] to v[3].
+	//
+
+	struct ScalarRGBA8 {
+		static const unsigned int bytes = 4;
+		static inline void Load(const unsigned char *p, float *v) {
+			for (int c = 0; c < 4; c++) v[c] = (float)p[c] / 255.0f;
+		}
+		static inline void Store(unsigned char *p, const float *v) {
+			for (int c = 0; c < 4; c++) p[c] = (unsigned char)ToUnorm(v[c], 255.0);
+		}
+	};
+
+	struct ScalarRGBA16 {
+		static const unsigned int bytes = 8;
+		static inline void Load(const unsigned char *p, float *v) {
+			uint16_t s[4];
+			memcpy(s, p, 8);
+			for (int c = 0; c < 4; c++) v[c] = (float)s[c] / 65535.0f;
+		}
+		static inline void Store(unsigned char *p, const float *v) {
+			uint16_t d[4];
+			for (int c = 0; c < 4; c++) d[c] = (uint16_t)ToUnorm(v[c], 65535.0);
+			memcpy(p, d, 8);
+		}
+	};
+
+	struct ScalarRGBA16F {
+		static const unsigned int bytes = 8;
+		static inline void Load(const unsigned char *p, float *v) {
+			uint16_t s[4];
+			memcpy(s, p, 8);
+			for (int c = 0; c < 4; c++) v[c] = HalfToFloat(s[c]);
+		}
+		static inline void Store(unsigned char *p, const float *v) {
+			uint16_t d[4];
+			for (int c = 0; c < 4; c++) d[c] = FloatToHalf(v[c]);
+			memcpy(p, d, 8);
+		}
+	};
+
+	struct ScalarRGBA32F {
+		static const unsigned int bytes = 16;
+		static inline void Load(const unsigned char *p, float *v) { memcpy(v, p, 16); }
+		static inline void Store(unsigned char *p, const float *v) { memcpy(p, v, 16); }
+	};
+
+	struct ScalarFormats {
+		typedef ScalarRGBA8 RGBA8;
+		typedef ScalarRGBA16 RGBA16;
+		typedef ScalarRGBA16F RGBA16F;
+		typedef ScalarRGBA32F RGBA32F;
+		template <typename Src, typename Dst, bool bSwap, bool bMirror>
+		static void Line(const unsigned char *src, unsigned char *dst, unsigned int width) {
+			float v[4];
+			for (unsigned int x = 0; x < width; x++) {
+				Src::Load(src + (size_t)(bMirror ? width - 1 - x : x) * Src::bytes, v);
+				if (bSwap) {
+					const float r = v[0];
+					v[0] = v[2];
+					v[2] = r;
+				}
+				Dst::Store(dst + (size_t)x * Dst::bytes, v);
+			}
+		}
+	};
+
+	//
+	// SSE2 format traits. Four channels in one register.
+	//
+
+	// Clamp to 0-1, scale in double precision and round to nearest even.
+	// _mm_max_ps returns the second operand for NaN.
+	static inline __m128i ToUnorm(__m128 v, double scale)
+	{
+		v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		const __m128d s = _mm_set1_pd(scale);
+		const __m128i lo = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(v), s));
+		const __m128i hi = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), s));
+		return _mm_unpacklo_epi64(lo, hi);
+	}
+
+	struct SimdRGBA8 {
+		static const unsigned int bytes = 4;
+		static inline __m128 Load(const unsigned char *p) {
+			int32_t u;
+			memcpy(&u, p, 4);
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i i = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(u), zero), zero);
+			return _mm_div_ps(_mm_cvtepi32_ps(i), _mm_set1_ps(255.0f));
+		}
+		static inline void Store(unsigned char *p, __m128 v) {
+			__m128i i = ToUnorm(v, 255.0);
+			i = _mm_packs_epi32(i, i);
+			const int32_t u = _mm_cvtsi128_si32(_mm_packus_epi16(i, i));
+			memcpy(p, &u, 4);
+		}
+	};
+
+	struct SimdRGBA16 {
+		static const unsigned int bytes = 8;
+		static inline __m128 Load(const unsigned char *p) {
+			const __m128i i = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)), _mm_setzero_si128());
+			return _mm_div_ps(_mm_cvtepi32_ps(i), _mm_set1_ps(65535.0f));
+		}
+		static inline void Store(unsigned char *p, __m128 v) {
+			// No unsigned 32 to 16 bit pack in SSE2. Offset to signed and back.
+			__m128i i = _mm_sub_epi32(ToUnorm(v, 65535.0), _mm_set1_epi32(32768));
+			i = _mm_xor_si128(_mm_packs_epi32(i, i), _mm_set1_epi16((short)0x8000));
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(p), i);
+		}
+	};
+
+	// Software half conversion for CPUs without F16C
+	struct SimdRGBA16F {
+		static const unsigned int bytes = 8;
+		static inline __m128 Load(const unsigned char *p) {
+			float v[4];
+			ScalarRGBA16F::Load(p, v);
+			return _mm_loadu_ps(v);
+		}
+		static inline void Store(unsigned char *p, __m128 v) {
+			float f[4];
+			_mm_storeu_ps(f, v);
+			ScalarRGBA16F::Store(p, f);
+		}
+	};
+
+	struct F16CRGBA16F {
+		static const unsigned int bytes = 8;
+		SPOUT_TARGET_F16C
+		static inline __m128 Load(const unsigned char *p) {
+			return _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+		}
+		SPOUT_TARGET_F16C
+		static inline void Store(unsigned char *p, __m128 v) {
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_cvtps_ph(v, 0)); // nearest even
+		}
+	};
+
+	struct SimdRGBA32F {
+		static const unsigned int bytes = 16;
+		static inline __m128 Load(const unsigned char *p) { return _mm_loadu_ps(reinterpret_cast<const float *>(p)); }
+		static inline void Store(unsigned char *p, __m128 v) { _mm_storeu_ps(reinterpret_cast<float *>(p), v); }
+	};
+
+	struct SSE2Formats {
+		typedef SimdRGBA8 RGBA8;
+		typedef SimdRGBA16 RGBA16;
+		typedef SimdRGBA16F RGBA16F;
+		typedef SimdRGBA32F RGBA32F;
+		template <typename Src, typename Dst, bool bSwap, bool bMirror>
+		static void Line(const unsigned char *src, unsigned char *dst, unsigned int width) {
+			for (unsigned int x = 0; x < width; x++) {
+				__m128 v = Src::Load(src + (size_t)(bMirror ? width - 1 - x : x) * Src::bytes);
+				if (bSwap)
+					v = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 1, 2));
+				Dst::Store(dst + (size_t)x * Dst::bytes, v);
+			}
+		}
+	};
+
+	// The same with F16C half conversion. The target
+	// must be set for the whole function.
+	struct F16CFormats {
+		typedef SimdRGBA8 RGBA8;
+		typedef SimdRGBA16 RGBA16;
+		typedef F16CRGBA16F RGBA16F;
+		typedef SimdRGBA32F RGBA32F;
+		template <typename Src, typename Dst, bool bSwap, bool bMirror>
+		SPOUT_TARGET_F16C
+		static void Line(const unsigned char *src, unsigned char *dst, unsigned int width) {
+			for (unsigned int x = 0; x < width; x++) {
+				__m128 v = Src::Load(src + (size_t)(bMirror ? width - 1 - x : x) * Src::bytes);
+				if (bSwap)
+					v = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 1, 2));
+				Dst::Store(dst + (size_t)x * Dst::bytes, v);
+			}
+		}
+	};
+
+	//
+	// Integer conversions
+	//
+
+	// Swap words 0 and 2 of each pixel
+	static inline __m128i SwapRB16(__m128i v)
+	{
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+	}
+
+	// Destination channel for source channel c
+	static inline int SwapChannel(int c, bool bSwap)
+	{
+		return (bSwap && c != 3) ? 2 - c : c;
+	}
+
+	// 8 bit to 16 bit. value * 257 is each byte repeated.
+	template <bool bSwap>
+	static void rgba8_rgba16_sse2(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		unsigned int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 4));
+			__m128i lo = _mm_unpacklo_epi8(p, p);
+			__m128i hi = _mm_unpackhi_epi8(p, p);
+			if (bSwap) {
+				lo = SwapRB16(lo);
+				hi = SwapRB16(hi);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 8), lo);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 8 + 16), hi);
+		}
+		for (; x < width; x++) {
+			uint16_t d[4];
+			for (int c = 0; c < 4; c++)
+				d[SwapChannel(c, bSwap)] = (uint16_t)(src[(size_t)x * 4 + c] * 257);
+			memcpy(dst + (size_t)x * 8, d, 8);
+		}
+	}
+
+	// 16 bit to 8 bit. (value * 255 + 32895) >> 16 is value/257
+	// rounded to nearest. There are no ties.
+	static inline __m128i Unorm16To8(__m128i v)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi32(32895);
+		__m128i lo = _mm_unpacklo_epi16(v, zero);
+		__m128i hi = _mm_unpackhi_epi16(v, zero);
+		lo = _mm_srli_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(lo, 8), lo), round), 16);
+		hi = _mm_srli_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(hi, 8), hi), round), 16);
+		return _mm_packs_epi32(lo, hi);
+	}
+
+	template <bool bSwap>
+	static void rgba16_rgba8_sse2(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		unsigned int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 8));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 8 + 16));
+			if (bSwap) {
+				a = SwapRB16(a);
+				b = SwapRB16(b);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4),
+				_mm_packus_epi16(Unorm16To8(a), Unorm16To8(b)));
+		}
+		for (; x < width; x++) {
+			uint16_t s[4];
+			memcpy(s, src + (size_t)x * 8, 8);
+			for (int c = 0; c < 4; c++)
+				dst[(size_t)x * 4 + SwapChannel(c, bSwap)] = (unsigned char)((s[c] * 255u + 32895u) >> 16);
+		}
+	}
+
+	// 16 bit to half from the table
+	template <bool bSwap, bool bMirror>
+	static void rgba16_rgba16f_table(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		const uint16_t *table = Unorm16HalfTable();
+		for (unsigned int x = 0; x < width; x++) {
+			uint16_t s[4], d[4];
+			memcpy(s, src + (size_t)(bMirror ? width - 1 - x : x) * 8, 8);
+			for (int c = 0; c < 4; c++)
+				d[SwapChannel(c, bSwap)] = table[s[c]];
+			memcpy(dst + (size_t)x * 8, d, 8);
+		}
+	}
+
+	template <unsigned int bytes>
+	static void CopyLine(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		memcpy(dst, src, (size_t)width * bytes);
+	}
+
+	template <unsigned int bytes>
+	static void MirrorLine(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		for (unsigned int x = 0; x < width; x++)
+			memcpy(dst + (size_t)x * bytes, src + (size_t)(width - 1 - x) * bytes, bytes);
+	}
+
+	//
+	// Line function for a pair of formats from a set of traits
+	//
+
+	template <typename Set, typename Src, bool bSwap, bool bMirror>
+	static SpoutRowKernel KernelTo(SpoutRGBAFormat destFormat)
+	{
+		switch (destFormat) {
+			case SPOUT_RGBA8:   return &Set::template Line<Src, typename Set::RGBA8, bSwap, bMirror>;
+			case SPOUT_RGBA16:  return &Set::template Line<Src, typename Set::RGBA16, bSwap, bMirror>;
+			case SPOUT_RGBA16F: return &Set::template Line<Src, typename Set::RGBA16F, bSwap, bMirror>;
+			case SPOUT_RGBA32F: return &Set::template Line<Src, typename Set::RGBA32F, bSwap, bMirror>;
+			default: return nullptr;
+		}
+	}
+
+	template <typename Set, bool bSwap, bool bMirror>
+	static SpoutRowKernel KernelFor(SpoutRGBAFormat sourceFormat, SpoutRGBAFormat destFormat)
+	{
+		switch (sourceFormat) {
+			case SPOUT_RGBA8:   return KernelTo<Set, typename Set::RGBA8, bSwap, bMirror>(destFormat);
+			case SPOUT_RGBA16:  return KernelTo<Set, typename Set::RGBA16, bSwap, bMirror>(destFormat);
+			case SPOUT_RGBA16F: return KernelTo<Set, typename Set::RGBA16F, bSwap, bMirror>(destFormat);
+			case SPOUT_RGBA32F: return KernelTo<Set, typename Set::RGBA32F, bSwap, bMirror>(destFormat);
+			default: return nullptr;
+		}
+	}
+
+	template <typename Set>
+	static SpoutRowKernel KernelFor(SpoutRGBAFormat sourceFormat, SpoutRGBAFormat destFormat, bool bSwapRB, bool bMirror)
+	{
+		if (bMirror)
+			return bSwapRB ? KernelFor<Set, true, true>(sourceFormat, destFormat)
+				: KernelFor<Set, false, true>(sourceFormat, destFormat);
+		return bSwapRB ? KernelFor<Set, true, false>(sourceFormat, destFormat)
+			: KernelFor<Set, false, false>(sourceFormat, destFormat);
+	}
+
+
+	unsigned int PixelBytes(SpoutRGBAFormat format)
+	{
+		switch (format) {
+			case SPOUT_RGBA8:   return 4;
+			case SPOUT_RGBA16:
+			case SPOUT_RGBA16F: return 8;
+			case SPOUT_RGBA32F: return 16;
+			default: return 0;
+		}
+	}
+
+
+	SpoutRowKernel GetKernel(SpoutRGBAFormat sourceFormat, SpoutRGBAFormat destFormat,
+		bool bSwapRB, bool bMirror, SpoutCopyTier tier, bool bF16C)
+	{
+		if (PixelBytes(sourceFormat) == 0 || PixelBytes(destFormat) == 0)
+			return nullptr;
+
+		// rgba <> bgra and mirror from the 4 byte line conversions
+		if (sourceFormat == SPOUT_RGBA8 && destFormat == SPOUT_RGBA8)
+			return spoutCopy::GetLineKernel(tier, 4, 4, bSwapRB, bMirror);
+
+		// Copy
+		if (sourceFormat == destFormat && !bSwapRB) {
+			if (PixelBytes(sourceFormat) == 8)
+				return bMirror ? MirrorLine<8> : CopyLine<8>;
+			return bMirror ? MirrorLine<16> : CopyLine<16>;
+		}
+
+		// Correctly rounded half from the table
+		if (sourceFormat == SPOUT_RGBA16 && destFormat == SPOUT_RGBA16F) {
+			if (bMirror)
+				return bSwapRB ? rgba16_rgba16f_table<true, true> : rgba16_rgba16f_table<false, true>;
+			return bSwapRB ? rgba16_rgba16f_table<true, false> : rgba16_rgba16f_table<false, false>;
+		}
+
+		if (tier == SPOUT_COPY_SCALAR)
+			return KernelFor<ScalarFormats>(sourceFormat, destFormat, bSwapRB, bMirror);
+
+		// The integer functions are not mirrored. The float
+		// functions give the same result.
+		if (!bMirror) {
+			if (sourceFormat == SPOUT_RGBA8 && destFormat == SPOUT_RGBA16)
+				return bSwapRB ? rgba8_rgba16_sse2<true> : rgba8_rgba16_sse2<false>;
+			if (sourceFormat == SPOUT_RGBA16 && destFormat == SPOUT_RGBA8)
+				return bSwapRB ? rgba16_rgba8_sse2<true> : rgba16_rgba8_sse2<false>;
+		}
+
+		if (bF16C)
+			return KernelFor<F16CFormats>(sourceFormat, destFormat, bSwapRB, bMirror);
+
+		return KernelFor<SSE2Formats>(sourceFormat, destFormat, bSwapRB, bMirror);
+	}
+
+}
@@ -0,0 +1,37 @@
+/*
+
+					SpoutConvert.h
+
+		Pixel conversion between 8 bit, 16 bit and floating point formats
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutConvert__ // standard way as well
+#define __spoutConvert__
+
+#include "SpoutCopy.h"
+
+namespace spoutconvert {
+
+	// Bytes per pixel of a format
+	unsigned int PixelBytes(SpoutRGBAFormat format);
+
+	// Line conversion between two formats for an instruction set tier.
+	// bSwapRB swaps red and blue and bMirror reverses the pixels.
+	// bF16C uses the hardware half float conversion instructions,
+	// which need an AVX capable CPU.
+	SpoutRowKernel GetKernel(SpoutRGBAFormat sourceFormat, SpoutRGBAFormat destFormat,
+		bool bSwapRB, bool bMirror, SpoutCopyTier tier, bool bF16C);
+
+	// Half float conversion with rounding to nearest even,
+	// the same as the F16C instructions
+	float HalfToFloat(uint16_t h);
+	uint16_t FloatToHalf(float f);
+
+}
+
+#endif
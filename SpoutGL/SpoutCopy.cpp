@@ -54,10 +54,527 @@
 	13.03.21 - Change CopyPixels and FlipBuffer to accept GL_LUMINANCE
 	09.07.21 - memcpy_sse2 - return for null dst or src
 	21.02.22 - use std:: prefix for floor in rgba2rgbResample for Clang compatibility. PR#81
+	16.10.26 - Add line conversion dispatch table with SSSE3, AVX2 and AVX-512 versions
+			   selected once per process by cpuid. Build with GCC and Clang.
+			   bgr2rgba with dest pitch - swap red and blue
+			   Add SetCopyThreads for multi-threaded copy in stripes of lines
+			   memcpy_sse2 - copy all bytes with unaligned head and tail.
+			   Non-temporal stores only for copies larger than the cache.
+			   CopyPixels, FlipBuffer, RemovePadding and rgba2rgba use it for any width.
+			   Resample functions - nearest, bilinear and area filters (SpoutResample.cpp)
+			   with cached fixed point coordinates. Bilinear by default.
+			   Add SetResampleFilter and rgba2rgbaResample with destination pitch.
+			   Add ConvertRGBA for 8 bit, 16 bit, half and float rgba (SpoutConvert.cpp)
+			   Line conversions generated from one template for every combination
+			   of 3 and 4 byte pixels, red/blue swap, mirror and alpha.
+			   Add Convert with source and destination SpoutPixelDesc.
+			   rgba2rgb with mirror uses the SIMD functions.
+			   Convert resamples different sizes in one pass with the source and
+			   destination lines converted as they are read and written.
+			   16 bit and floating point pixels are resampled as float.
+			   Add ApplyLut for 3D LUT colour grading (SpoutLut.cpp)
+			   Add ApplyTransfer for sRGB, Rec.709, PQ and HLG (SpoutTransfer.cpp)
+			   Add YUVToRGBA and RGBAToYUV for NV12, P010, UYVY and v210 (SpoutYUV.cpp)
+			   Add DitherRGBA for ordered and blue noise dither to 8 bit (SpoutDither.cpp)
+			   Add ApplyAlpha to premultiply, unpremultiply or make alpha opaque (SpoutAlpha.cpp)
+			   and SpoutPixelDesc alpha mode for the change in the same pass with Convert.
+			   Add Rotate for 90, 180 and 270 degrees and transpose in cache sized tiles (SpoutRotate.cpp)
+			   Add ConvertRegion to copy or resample a region of a larger source.
+			   Add Downsample for 8 bit rgba thumbnails with a box filter (SpoutThumbnail.cpp)
+			   Add GetPixelBytes.
 
 
 */
 #include "SpoutCopy.h"
+#include "SpoutThreadPool.h"
+#include "SpoutResample.h"
+#include "SpoutConvert.h"
+#include "SpoutLut.h"
+#include "SpoutTransfer.h"
+#include "SpoutYUV.h"
+#include "SpoutDither.h"
+#include "SpoutAlpha.h"
+#include "SpoutRotate.h"
+#include "SpoutThumbnail.h"
+#include <string.h> // for memcpy
+#include <climits> // for UINT_MAX
+
+static void spout_cpuid(int CPUInfo[4], int function, int subfunction)
+{
+#if defined(_MSC_VER)
+	__cpuidex(CPUInfo, function, subfunction);
+#else
+	__asm__ __volatile__("cpuid"
+		: "=a"(CPUInfo[0]), "=b"(CPUInfo[1]), "=c"(CPUInfo[2]), "=d"(CPUInfo[3])
+		: "a"(function), "c"(subfunction));
+#endif
+}
+
+// Register state enabled by the operating system (XCR0)
+static unsigned long long spout_xgetbv()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int eax = 0;
+	unsigned int edx = 0;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+//
+// Line conversions between 3 and 4 byte pixels
+//
+// The conversions for every combination of source and destination
+// pixel size, red/blue swap, mirror and destination alpha are generated
+// from one template. Each instruction set tier converts as many pixels
+// as it can and passes the rest of the line to the next lower tier,
+// down to the scalar version.
+//
+// SSE2 rgba <> bgra adapted from : https://searchcode.com/codesearch/view/5070982/
+// Copyright (c) 2002-2010 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+// https://chromium.googlesource.com/angle/angle/+/master/LICENSE
+//
+// SSSE3 byte shuffle adapted from a Gist snippet by Aurelien Vallee (NewbiZ)
+// http://newbiz.github.io/ https://gist.github.com/NewbiZ/5541524
+//
+
+//
+// Byte shuffle mask for 4 pixels in a 16 byte lane.
+// Masks are in memory order. -1 (0x80) zeroes the byte.
+// Source pixels start at "offset" and are reversed for mirror.
+// A 3 byte destination uses the first 12 bytes, and the alpha
+// of a 3 byte source is zero.
+//
+static inline __m128i spout_shuffle_mask(unsigned int srcBytes, unsigned int dstBytes,
+	bool bSwap, bool bMirror, unsigned int offset)
+{
+	char mask[16];
+	for (unsigned int i = 0; i < 16; i++)
+		mask[i] = -1;
+	for (unsigned int j = 0; j < 4; j++) {
+		const unsigned int s = offset + (bMirror ? 3 - j : j) * srcBytes;
+		for (unsigned int c = 0; c < 3; c++)
+			mask[j * dstBytes + c] = (char)(s + ((bSwap && c != 1) ? 2 - c : c));
+		if (dstBytes == 4 && srcBytes == 4)
+			mask[j * 4 + 3] = (char)(s + 3);
+	}
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask));
+}
+
+//
+// S, D   - source and destination bytes per pixel (3 or 4)
+// bSwap  - swap red and blue
+// bMirror - destination pixels in reverse order
+// bAlpha - alpha 255 for a 3 byte source and 4 byte destination,
+//          otherwise the existing destination alpha is not changed
+//
+// Each version converts destination pixels from "x" to the end of the line.
+//
+template <unsigned int S, unsigned int D, bool bSwap, bool bMirror, bool bAlpha>
+struct spoutLineConvert {
+
+	// Start of the 16 bytes with the 4 source pixels of destination pixel x.
+	// Mirrored blocks end at the last of the 4 pixels so that reads
+	// stay within the line in the same way as forward blocks.
+	static inline const unsigned char *Block(const unsigned char *src, unsigned int width, unsigned int x)
+	{
+		return bMirror ? src + (size_t)(width - x) * S - 16 : src + (size_t)x * S;
+	}
+
+	static void Scalar(const unsigned char *src, unsigned char *dst, unsigned int width, unsigned int x)
+	{
+		for (; x < width; x++) {
+			const unsigned char *s = src + (size_t)(bMirror ? width - 1 - x : x) * S;
+			unsigned char *d = dst + (size_t)x * D;
+			// Read all first for conversion in place
+			const unsigned char r = s[bSwap ? 2 : 0];
+			const unsigned char g = s[1];
+			const unsigned char b = s[bSwap ? 0 : 2];
+			const unsigned char a = (S == 4) ? s[3] : 255;
+			d[0] = r;
+			d[1] = g;
+			d[2] = b;
+			if (D == 4 && (S == 4 || bAlpha))
+				d[3] = a;
+		}
+	}
+
+	// SSE2 has no byte shuffle, so only 4 byte pixels have an SSE2 version
+	static void SSE2(const unsigned char *src, unsigned char *dst, unsigned int width, unsigned int x)
+	{
+		if (S == 4 && D == 4) {
+			const __m128i brMask = _mm_set1_epi32(0x00ff00ff); // argb
+			for (; x + 4 <= width; x += 4) {
+				__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Block(src, width, x)));
+				if (bMirror)
+					p = _mm_shuffle_epi32(p, _MM_SHUFFLE(0, 1, 2, 3));
+				if (bSwap) {
+					// Mask out g and a, which don't change
+					__m128i gaComponents = _mm_andnot_si128(brMask, p);
+					// Mask out b and r
+					__m128i brComponents = _mm_and_si128(p, brMask);
+					// Swap b and r
+					__m128i brSwapped = _mm_shufflehi_epi16(_mm_shufflelo_epi16(brComponents, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+					p = _mm_or_si128(gaComponents, brSwapped);
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4), p);
+			}
+		}
+		Scalar(src, dst, width, x);
+	}
+
+	// 4 pixels at a time. With 3 byte pixels, 16 bytes are
+	// read or written for 12 used, so stop 6 pixels before the end.
+	SPOUT_TARGET_SSSE3
+	static void SSSE3(const unsigned char *src, unsigned char *dst, unsigned int width, unsigned int x)
+	{
+		const __m128i mask = spout_shuffle_mask(S, D, bSwap, bMirror, bMirror ? 16 - 4 * S : 0);
+		const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+		const unsigned int n = (S == 3 || D == 3) ? 6 : 4;
+		for (; x + n <= width; x += 4) {
+			__m128i p = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Block(src, width, x))), mask);
+			unsigned char *d = dst + (size_t)x * D;
+			if (S == 3 && D == 4) {
+				if (bAlpha)
+					p = _mm_or_si128(p, alpha);
+				else // Keep the existing destination alpha
+					p = _mm_or_si128(p, _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(d)), alpha));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(d), p);
+		}
+		Scalar(src, dst, width, x);
+	}
+
+	// 8 pixels at a time. The AVX2 byte shuffle works within each
+	// 128 bit lane, so each lane is loaded as for SSSE3 and uses the
+	// same mask. For a 3 byte destination, a dword permute packs the
+	// two 12 byte lanes into 24 contiguous bytes.
+	SPOUT_TARGET_AVX2
+	static void AVX2(const unsigned char *src, unsigned char *dst, unsigned int width, unsigned int x)
+	{
+		const __m256i mask = _mm256_broadcastsi128_si256(spout_shuffle_mask(S, D, bSwap, bMirror, bMirror ? 16 - 4 * S : 0));
+		const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+		const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+		const unsigned int n = (S == 3) ? 10 : 8;
+		for (; x + n <= width; x += 8) {
+			__m256i p;
+			if (S == 4 && !bMirror) {
+				p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (size_t)x * 4));
+			}
+			else {
+				p = _mm256_inserti128_si256(
+					_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Block(src, width, x)))),
+					_mm_loadu_si128(reinterpret_cast<const __m128i *>(Block(src, width, x + 4))), 1);
+			}
+			p = _mm256_shuffle_epi8(p, mask);
+			unsigned char *d = dst + (size_t)x * D;
+			if (D == 3) {
+				p = _mm256_permutevar8x32_epi32(p, pack);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm256_castsi256_si128(p));
+				_mm_storel_epi64(reinterpret_cast<__m128i *>(d + 16), _mm256_extracti128_si256(p, 1));
+			}
+			else {
+				if (S == 3) {
+					if (bAlpha)
+						p = _mm256_or_si256(p, alpha);
+					else // Keep the existing destination alpha
+						p = _mm256_or_si256(p, _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(d)), alpha));
+				}
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(d), p);
+			}
+		}
+		SSSE3(src, dst, width, x);
+	}
+
+	// 16 pixels at a time (AVX512F and AVX512BW).
+	// A dword permute gives each 128 bit lane the 16 bytes starting
+	// at its first pixel. A mirrored 3 byte source is reversed by
+	// taking the lanes in reverse order and reversing the pixels in
+	// each lane, and a 4 byte source by reversing all the dwords.
+	// For a 3 byte destination, the lanes are packed into 48 bytes.
+	// Masked loads and stores handle the end of the line, except for
+	// mirror where the remaining pixels are passed to the AVX2 version.
+	// The lane mask is loaded from a 64 byte table and the permutes are
+	// zero masked, because _mm512_broadcast_i32x4 and the unmasked
+	// _mm512_permutexvar_epi32 use _mm512_undefined_epi32, which GCC
+	// reports as uninitialized with -Wall.
+	SPOUT_TARGET_AVX512
+	static void AVX512(const unsigned char *src, unsigned char *dst, unsigned int width, unsigned int x)
+	{
+		alignas(64) unsigned char lanes[64];
+		const __m128i laneMask = spout_shuffle_mask(S, D, bSwap, bMirror && S == 3, 0);
+		for (int i = 0; i < 4; i++)
+			_mm_store_si128(reinterpret_cast<__m128i *>(lanes + i * 16), laneMask);
+		const __m512i mask = _mm512_load_si512(lanes);
+		const __m512i spread = bMirror ? _mm512_setr_epi32(9, 10, 11, 12, 6, 7, 8, 9, 3, 4, 5, 6, 0, 1, 2, 3)
+			: _mm512_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6, 6, 7, 8, 9, 9, 10, 11, 12);
+		const __m512i reverse = _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+		const __m512i pack = _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 3, 7, 11, 15);
+		const __m512i alpha = _mm512_set1_epi32((int)0xff000000);
+		// Keep the existing destination alpha by not writing it
+		const __mmask64 rgbBytes = (S == 3 && D == 4 && !bAlpha) ? 0x7777777777777777ULL : ~0ULL;
+		while (x < width) {
+			const unsigned int n = (width - x < 16) ? (width - x) : 16;
+			if (bMirror && n < 16)
+				break;
+			const unsigned char *s = src + (size_t)(bMirror ? width - x - 16 : x) * S;
+			__m512i p;
+			if (S == 3) {
+				p = _mm512_maskz_loadu_epi8((n == 16) ? 0xFFFFFFFFFFFFULL : ((1ULL << (n * 3)) - 1), s);
+				p = _mm512_maskz_permutexvar_epi32(0xFFFF, spread, p);
+			}
+			else {
+				p = _mm512_maskz_loadu_epi32((__mmask16)((n == 16) ? 0xFFFF : ((1u << n) - 1)), s);
+				if (bMirror)
+					p = _mm512_maskz_permutexvar_epi32(0xFFFF, reverse, p);
+			}
+			p = _mm512_shuffle_epi8(p, mask);
+			unsigned char *d = dst + (size_t)x * D;
+			if (D == 3) {
+				p = _mm512_maskz_permutexvar_epi32(0xFFFF, pack, p);
+				_mm512_mask_storeu_epi8(d, (1ULL << (n * 3)) - 1, p);
+			}
+			else {
+				if (S == 3)
+					p = _mm512_or_si512(p, alpha);
+				_mm512_mask_storeu_epi8(d, ((n == 16) ? ~0ULL : ((1ULL << (n * 4)) - 1)) & rgbBytes, p);
+			}
+			x += n;
+		}
+		if (x < width)
+			AVX2(src, dst, width, x);
+	}
+
+	// Line conversion functions for the dispatch table
+	static void ScalarRow(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		Scalar(src, dst, width, 0);
+	}
+
+	static void SSE2Row(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		SSE2(src, dst, width, 0);
+	}
+
+	SPOUT_TARGET_SSSE3
+	static void SSSE3Row(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		SSSE3(src, dst, width, 0);
+	}
+
+	SPOUT_TARGET_AVX2
+	static void AVX2Row(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		AVX2(src, dst, width, 0);
+	}
+
+	SPOUT_TARGET_AVX512
+	static void AVX512Row(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		AVX512(src, dst, width, 0);
+	}
+
+	static SpoutRowKernel Row(SpoutCopyTier tier)
+	{
+		switch (tier) {
+			case SPOUT_COPY_SCALAR: return ScalarRow;
+			case SPOUT_COPY_SSE2:   return SSE2Row;
+			case SPOUT_COPY_SSSE3:  return SSSE3Row;
+			case SPOUT_COPY_AVX2:   return AVX2Row;
+			default:                return AVX512Row;
+		}
+	}
+};
+
+// Copy without conversion
+template <unsigned int S>
+static void spout_copy_row(const unsigned char *src, unsigned char *dst, unsigned int width)
+{
+	memcpy(dst, src, (size_t)width * S);
+}
+
+// Line conversion from the template for a pixel size pair
+template <unsigned int S, unsigned int D>
+static SpoutRowKernel spout_line_kernel(SpoutCopyTier tier, bool bSwap, bool bMirror, bool bAlpha)
+{
+	if (S == D && !bSwap && !bMirror)
+		return spout_copy_row<S>;
+	// bAlpha only applies to a 3 byte source and 4 byte destination
+	if (S == 4 || D == 3)
+		bAlpha = true;
+	if (bSwap) {
+		if (bMirror)
+			return bAlpha ? spoutLineConvert<S, D, true, true, true>::Row(tier) : spoutLineConvert<S, D, true, true, false>::Row(tier);
+		return bAlpha ? spoutLineConvert<S, D, true, false, true>::Row(tier) : spoutLineConvert<S, D, true, false, false>::Row(tier);
+	}
+	if (bMirror)
+		return bAlpha ? spoutLineConvert<S, D, false, true, true>::Row(tier) : spoutLineConvert<S, D, false, true, false>::Row(tier);
+	return bAlpha ? spoutLineConvert<S, D, false, false, true>::Row(tier) : spoutLineConvert<S, D, false, false, false>::Row(tier);
+}
+
+//
+// Dispatch tables
+//
+// The named conversions used by the spoutCopy functions.
+// spoutCopy::GetLineKernel has every combination.
+//
+#define SPOUT_KERNELS(tier, name, row) \
+	{ tier, name, \
+		spoutLineConvert<4, 4, true,  false, true >::row, \
+		spoutLineConvert<3, 4, false, false, true >::row, \
+		spoutLineConvert<3, 4, true,  false, true >::row, \
+		spoutLineConvert<3, 4, false, false, false>::row, \
+		spoutLineConvert<3, 4, true,  false, false>::row, \
+		spoutLineConvert<4, 3, false, false, true >::row, \
+		spoutLineConvert<4, 3, true,  false, true >::row }
+
+static const SpoutCopyKernels spout_kernels[SPOUT_COPY_TIER_COUNT] = {
+	SPOUT_KERNELS(SPOUT_COPY_SCALAR, "scalar", ScalarRow),
+	SPOUT_KERNELS(SPOUT_COPY_SSE2,   "sse2",   SSE2Row),
+	SPOUT_KERNELS(SPOUT_COPY_SSSE3,  "ssse3",  SSSE3Row),
+	SPOUT_KERNELS(SPOUT_COPY_AVX2,   "avx2",   AVX2Row),
+	SPOUT_KERNELS(SPOUT_COPY_AVX512, "avx512", AVX512Row),
+};
+
+//
+// CPU features, detected once per process
+//
+// https://msdn.microsoft.com/en-us/library/hskdteyh.aspx
+//
+// EAX = 1
+//   SSE2   | [bit 26] EDX
+//   SSE3   | [bit 0]  ECX
+//   SSSE3  | [bit 9]  ECX
+//   OSXSAVE | [bit 27] ECX
+//   AVX    | [bit 28] ECX
+//   F16C   | [bit 29] ECX
+// EAX = 7, ECX = 0
+//   AVX2     | [bit 5]  EBX
+//   AVX512F  | [bit 16] EBX
+//   AVX512BW | [bit 30] EBX
+//
+// AVX and AVX-512 also require the operating system to save the
+// extended registers. XCR0 bits 1-2 (XMM, YMM) for AVX
+// and bits 5-7 (opmask, ZMM) for AVX-512.
+//
+// The L2 cache size is from extended function 0x80000006 ECX[31:16]
+// which is supported by Intel and AMD.
+//
+// The last level cache size is from the deterministic cache parameters,
+// function 4 for Intel and 0x8000001D for AMD. For each sub-function :
+//   Cache type       | EAX[4:0] (0 = no more caches, 1 = data, 3 = unified)
+//   Cache level      | EAX[7:5]
+//   Ways - 1         | EBX[31:22]
+//   Partitions - 1   | EBX[21:12]
+//   Line size - 1    | EBX[11:0]
+//   Sets - 1         | ECX
+//
+struct SpoutCPUFeatures {
+	bool bSSE2;
+	bool bSSE3;
+	bool bSSSE3;
+	bool bAVX2;
+	bool bAVX512;
+	bool bF16C;
+	unsigned int L2CacheBytes;
+	size_t LLCacheBytes;
+};
+
+// Size of the highest level data or unified cache
+static size_t spout_cache_size(int function)
+{
+	int CPUInfo[4] = { 0, 0, 0, 0 };
+	unsigned int level = 0;
+	size_t size = 0;
+	for (int i = 0; i < 16; i++) {
+		spout_cpuid(CPUInfo, function, i);
+		const unsigned int type = CPUInfo[0] & 0x1F;
+		if (type == 0)
+			break;
+		if (type != 1 && type != 3)
+			continue;
+		const unsigned int cacheLevel = (CPUInfo[0] >> 5) & 0x7;
+		const size_t ways = (((unsigned int)CPUInfo[1] >> 22) & 0x3FF) + 1;
+		const size_t partitions = (((unsigned int)CPUInfo[1] >> 12) & 0x3FF) + 1;
+		const size_t lineSize = ((unsigned int)CPUInfo[1] & 0xFFF) + 1;
+		const size_t sets = (size_t)(unsigned int)CPUInfo[2] + 1;
+		if (cacheLevel >= level) {
+			level = cacheLevel;
+			size = ways * partitions * lineSize * sets;
+		}
+	}
+	return size;
+}
+
+static SpoutCPUFeatures spout_detect_cpu()
+{
+	SpoutCPUFeatures features = { false, false, false, false, false, false, 256 * 1024, 8 * 1024 * 1024 };
+
+	// An array of four integers that contains the information returned
+	// in EAX (0), EBX (1), ECX (2), and EDX (3) about supported features of the CPU.
+	int CPUInfo[4] = { -1, -1, -1, -1 };
+
+	//-- Get number of valid info ids
+	spout_cpuid(CPUInfo, 0, 0);
+	const int nIds = CPUInfo[0];
+	if (nIds < 1)
+		return features;
+
+	//-- Get the L2 cache size in KB
+	spout_cpuid(CPUInfo, 0x80000000, 0);
+	const unsigned int nExIds = (unsigned int)CPUInfo[0];
+	if (nExIds >= 0x80000006) {
+		spout_cpuid(CPUInfo, 0x80000006, 0);
+		const unsigned int L2KB = ((unsigned int)CPUInfo[2] >> 16) & 0xFFFF;
+		if (L2KB > 0)
+			features.L2CacheBytes = L2KB * 1024;
+	}
+
+	//-- Get the last level cache size
+	size_t LLC = 0;
+	if (nIds >= 4)
+		LLC = spout_cache_size(4);
+	if (LLC == 0 && nExIds >= 0x8000001D)
+		LLC = spout_cache_size(0x8000001D);
+	if (LLC > 0)
+		features.LLCacheBytes = LLC;
+
+	//-- Get info for id "1"
+	spout_cpuid(CPUInfo, 1, 0);
+	features.bSSE2 = (CPUInfo[3] & (0x1 << 26)) != 0;
+	features.bSSE3 = (CPUInfo[2] & 0x1) != 0;
+	features.bSSSE3 = (CPUInfo[2] & (0x1 << 9)) != 0;
+	const bool bOSXSAVE = (CPUInfo[2] & (0x1 << 27)) != 0;
+	const bool bAVX = (CPUInfo[2] & (0x1 << 28)) != 0;
+	const bool bF16C = (CPUInfo[2] & (0x1 << 29)) != 0;
+	if (!bOSXSAVE || !bAVX || nIds < 7)
+		return features;
+
+	const unsigned long long xcr0 = spout_xgetbv();
+	const bool bOSAVX = (xcr0 & 0x6) == 0x6;
+	const bool bOSAVX512 = (xcr0 & 0xE6) == 0xE6;
+	features.bF16C = bOSAVX && bF16C;
+
+	//-- Get info for id "7"
+	spout_cpuid(CPUInfo, 7, 0);
+	features.bAVX2 = bOSAVX && (CPUInfo[1] & (0x1 << 5)) != 0;
+	features.bAVX512 = bOSAVX512
+		&& (CPUInfo[1] & (0x1 << 16)) != 0
+		&& (CPUInfo[1] & (0x1 << 30)) != 0;
+
+	return features;
+}
+
+static const SpoutCPUFeatures &spout_cpu_features()
+{
+	static const SpoutCPUFeatures features = spout_detect_cpu();
+	return features;
+}
+
 
 //
 // Class: spoutCopy
@@ -71,7 +588,16 @@ spoutCopy::spoutCopy() {
 	m_bSSE2 = false;
 	m_bSSE3 = false;
 	m_bSSSE3 = false;
-	CheckSSE(); // SSE available - sets m_bSSE2, m_bSSE3, m_bSSSE3
+	m_bAVX2 = false;
+	m_bAVX512 = false;
+	m_bF16C = false;
+	m_pKernels = nullptr;
+	m_nCopyThreads = 1;
+	m_MinThreadBytes = 4194304;
+	// Both source and destination compete for the cache
+	m_StreamBytes = spout_cpu_features().LLCacheBytes / 2;
+	m_ResampleFilter = SPOUT_RESAMPLE_BILINEAR;
+	CheckSSE(); // SSE and AVX available - sets m_bSSE2, m_bSSE3, m_bSSSE3, m_bAVX2, m_bAVX512 and m_pKernels
 }
 
 
@@ -83,34 +609,26 @@ void spoutCopy::CopyPixels(const unsigned char *source, unsigned char *dest,
 	unsigned int width, unsigned int height, 
 	GLenum glFormat, bool bInvert) const
 {
-	unsigned int Size = width*height; // GL_LUMINANCE default
+	unsigned int pitch = width; // GL_LUMINANCE default
 
 	if (glFormat == GL_RGBA || glFormat == GL_BGRA_EXT)
-		Size = width * height * 4;
+		pitch = width * 4;
 	else if (glFormat == GL_RGB || glFormat == GL_BGR_EXT)
-		Size = width*height * 3;
+		pitch = width * 3;
+
+	const unsigned int Size = pitch * height;
 
 	if (bInvert) {
 		FlipBuffer(source, dest, width, height, glFormat);
+		return;
 	}
-	else {
-		if (width < 320) { // Too small for assembler
-			memcpy(reinterpret_cast<void *>(dest),
-				reinterpret_cast<const void *>(source), Size);
-		}
-		else if ((Size % 16) == 0 && m_bSSE2) { // 16 byte aligned SSE assembler
-			memcpy_sse2(reinterpret_cast<void *>(dest),
-				reinterpret_cast<const void *>(source), Size);
-		}
-		else if ((Size % 4) == 0) { // 4 byte aligned assembler
-			__movsd(reinterpret_cast<unsigned long *>(dest),
-				reinterpret_cast<const unsigned long *>(source), Size / 4);
-		}
-		else { // Default is standard memcpy
-			memcpy(reinterpret_cast<void *>(dest),
-				reinterpret_cast<const void *>(source), Size);
-		}
-	}
+
+	// The buffers are contiguous, so each stripe is one block
+	const bool bStream = Size >= m_StreamBytes;
+	ForEachStripe(height, (size_t)pitch * 2, [&](unsigned int y0, unsigned int y1) {
+		const size_t offset = (size_t)y0 * pitch;
+		CopyBlock(dest + offset, source + offset, (size_t)(y1 - y0) * pitch, bStream);
+	});
 }
 
 void spoutCopy::FlipBuffer(const unsigned char *src,
@@ -125,26 +643,15 @@ void spoutCopy::FlipBuffer(const unsigned char *src,
 	else if (glFormat == GL_RGB || glFormat == GL_BGR_EXT)
 		pitch = width * 3; // RGB format specified
 
-	unsigned int line_s = 0;
-	unsigned int line_t = (height - 1)*pitch;
-
-	for (unsigned int y = 0; y<height; y++) {
-		if (width < 320 || height < 240) // too small for assembler
-			memcpy(reinterpret_cast<void *>(dst + line_t),
-				reinterpret_cast<const void *>(src + line_s), pitch);
-		else if ((pitch % 16) == 0 && m_bSSE2) // use sse assembler function
-			memcpy_sse2(reinterpret_cast<void *>(dst + line_t),
-				reinterpret_cast<const void *>(src + line_s), pitch);
-		else if ((pitch % 4) == 0) // use 4 byte move assembler function
-			__movsd(reinterpret_cast<unsigned long *>(dst + line_t),
-				reinterpret_cast<const unsigned long *>(src + line_s),
-				pitch / 4);
-		else
-			memcpy(reinterpret_cast<void *>(dst + line_t),
-				reinterpret_cast<const void *>(src + line_s), pitch);
-		line_s += pitch;
-		line_t -= pitch;
-	}
+	// Stream if the whole image is larger than the cache
+	const bool bStream = (size_t)pitch * height >= m_StreamBytes;
+	ForEachStripe(height, (size_t)pitch * 2, [&](unsigned int y0, unsigned int y1) {
+		for (unsigned int y = y0; y < y1; y++) {
+			const size_t line_s = (size_t)y * pitch;
+			const size_t line_t = (size_t)(height - 1 - y) * pitch;
+			CopyBlock(dst + line_t, src + line_s, pitch, bStream);
+		}
+	});
 
 }
 
@@ -158,31 +665,17 @@ void spoutCopy::RemovePadding(const unsigned char *source, unsigned char *dest,
 		pitch = width*3; // rgb
 
 	// Remove the padding (stride-pitch)
-	for (unsigned int y = 0; y < height; y++) {
-
-		if (pitch < 320 || stride < 320) { // too small for assembler
-			memcpy(reinterpret_cast<void *>(dest), reinterpret_cast<const void *>(source), pitch);
-		}
-		else if ((pitch % 16) == 0 && (stride % 16) == 0 && m_bSSE2) { // use sse
-			memcpy_sse2(reinterpret_cast<void *>(dest), reinterpret_cast<const void *>(source), pitch);
-		}
-		else if ((pitch % 4) == 0 && (stride % 4) == 0) { // 4 byte move
-			__movsd(reinterpret_cast<unsigned long *>(dest), reinterpret_cast<const unsigned long *>(source), pitch/4);
-		}
-		else {
-			memcpy(reinterpret_cast<void *>(dest), reinterpret_cast<const void *>(source), pitch);
-		}
-		source += stride;
-		dest   += pitch;
-	}
+	const bool bStream = (size_t)pitch * height >= m_StreamBytes;
+	ForEachStripe(height, (size_t)pitch + stride, [&](unsigned int y0, unsigned int y1) {
+		for (unsigned int y = y0; y < y1; y++)
+			CopyBlock(dest + (size_t)y * pitch, source + (size_t)y * stride, pitch, bStream);
+	});
 }
 
 
 //
 // Fast memcpy
 //
-// Approx 1.7 times speed of memcpy (0.84 msec per frame 1920x1080)
-//
 // Original source - William Chan
 // (dead link) http://williamchan.ca/portfolio/assembly/ssememcpy/
 // See also :
@@ -192,42 +685,72 @@ void spoutCopy::RemovePadding(const unsigned char *source, unsigned char *dest,
 // Video : https://level1techs.com/video/level1-diagnostic-fixing-our-memcpy-troubles-looking-glass//
 // Source : https://github.com/level1wendell/memcpy_sse and others.
 //
+// Copies of any size and alignment. Copies larger than the stream
+// threshold (half the last level cache by default) use non-temporal
+// stores so that the destination does not evict the cache.
+// Smaller copies use memcpy with normal cached stores,
+// because the destination is likely to be read again soon.
+//
 void spoutCopy::memcpy_sse2(void* dst, const void* src, size_t Size) const
 {
+	CopyBlock(dst, src, Size, Size >= m_StreamBytes);
+}
+
+// Copies smaller than this use memcpy in all cases
+#define SPOUT_STREAM_MIN 4096
+
+void spoutCopy::CopyBlock(void* dst, const void* src, size_t Size, bool bStream) const
+{
+	if (!dst || !src || Size == 0)
+		return;
 
-	if (!dst || !src)
+	if (!bStream || !m_bSSE2 || Size < SPOUT_STREAM_MIN) {
+		memcpy(dst, src, Size);
 		return;
+	}
 
 	auto pSrc = static_cast<const char *>(src); // Source buffer
 	auto pDst = static_cast<char *>(dst); // Destination buffer
-	unsigned int n = (unsigned int)Size >> 7; // Counter = size divided by 128 (8 * 128bit registers)
 
+	// Unaligned head to align the destination to 16 bytes for the streaming stores
+	const size_t head = (16 - (reinterpret_cast<uintptr_t>(pDst) & 15)) & 15;
+	memcpy(pDst, pSrc, head);
+	pSrc += head;
+	pDst += head;
+	Size -= head;
+
+	// Blocks of 128 bytes (8 * 128bit registers)
+	// Source loads are unaligned unless the source has the same alignment.
+	size_t n = Size >> 7;
+	const bool bAligned = (reinterpret_cast<uintptr_t>(pSrc) & 15) == 0;
 	__m128i Reg0, Reg1, Reg2, Reg3, Reg4, Reg5, Reg6, Reg7;
-	for (unsigned int Index = n; Index > 0; --Index) {
+	for (; n > 0; --n) {
 
-		// SSE2 prefetch
+		// Prefetch two blocks ahead.
+		// Each 128 byte block spans two 64 byte cache lines.
 		_mm_prefetch(pSrc + 256, _MM_HINT_NTA);
-		_mm_prefetch(pSrc + 256 + 64, _MM_HINT_NTA); // ??? TODO : why
-
-		// TODO - research and optimize - minor (0.1msec) speed difference noted
-		// _mm_prefetch(pSrc, _MM_HINT_NTA);
-
-		// move data from src to registers
-		// 8 x 128 bit (16 bytes each)
-		// Increment source pointer by 16 bytes each
-		// for a total of 128 bytes per cycle
-		Reg0 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc));
-		Reg1 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 16));
-		Reg2 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 32));
-		Reg3 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 48));
-		Reg4 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 64));
-		Reg5 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 80));
-		Reg6 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 96));
-		Reg7 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 112));
-
-		// move data from registers to dest
-		// TODO
-		// _mm_prefetch((const char*)(pSrc + 256), _MM_HINT_NTA);
+		_mm_prefetch(pSrc + 256 + 64, _MM_HINT_NTA);
+
+		if (bAligned) {
+			Reg0 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc));
+			Reg1 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 16));
+			Reg2 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 32));
+			Reg3 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 48));
+			Reg4 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 64));
+			Reg5 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 80));
+			Reg6 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 96));
+			Reg7 = _mm_load_si128(reinterpret_cast<const __m128i *>(pSrc + 112));
+		}
+		else {
+			Reg0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc));
+			Reg1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + 16));
+			Reg2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + 32));
+			Reg3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + 48));
+			Reg4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + 64));
+			Reg5 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + 80));
+			Reg6 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + 96));
+			Reg7 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + 112));
+		}
 
 		_mm_stream_si128(reinterpret_cast<__m128i *>(pDst), Reg0);
 		_mm_stream_si128(reinterpret_cast<__m128i *>(pDst + 16), Reg1);
@@ -241,75 +764,178 @@ void spoutCopy::memcpy_sse2(void* dst, const void* src, size_t Size) const
 		pSrc += 128;
 		pDst += 128;
 	}
+	Size &= 127;
+
+	// Remaining 16 byte blocks
+	for (; Size >= 16; Size -= 16) {
+		_mm_stream_si128(reinterpret_cast<__m128i *>(pDst),
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc)));
+		pSrc += 16;
+		pDst += 16;
+	}
+
+	// Unaligned tail
+	memcpy(pDst, pSrc, Size);
+
+	// Streaming stores are weakly ordered. Make them visible
+	// before any following store, for example a frame count
+	// or mutex release that signals the copy is complete.
+	_mm_sfence();
+
+}
+
+// Copies at least this size use non-temporal stores.
+// 0 streams all copies. Half the last level cache by default.
+void spoutCopy::SetStreamThreshold(size_t bytes)
+{
+	m_StreamBytes = bytes;
+}
 
+size_t spoutCopy::GetStreamThreshold() const
+{
+	return m_StreamBytes;
 }
 
 
 //
 //					CheckSSE()
 //
-// https://msdn.microsoft.com/en-us/library/hskdteyh.aspx
-//
-// static bool SSE2 (void) { return CPU_Rep.f_1_EDX_[26]; }
-// SSE2 | [bit 26] EDX
-// SSE2 = (cpuid03 & (0x1 << 26))
-//
-// static bool SSE3 (void) { return CPU_Rep.f_1_ECX_[0]; }
-// SSE3 | [bit 0] ECX
-// SSE3 = (cpuid02 & (0x1)
+// Sets the SSE and AVX flags and selects the widest line conversion
+// functions supported. Refer to spout_detect_cpu for the cpuid bits.
 //
-// static bool SSSE3(void) { return CPU_Rep.f_1_ECX_[9]; }
-// SSSE3 | [bit 9] ECX
-// SSSE3 = (cpuid02 & (0x1 << 9)
-//
-// SSE4 not currently used :
-//
-// SSE4.1 and SSE4.2 are extensions of SSE, SSE2, SSE3, and SSSE3. 
-// To check if the processor supports SSE4.1, execute CPUID with EAX = 1 as input.
-// If bit 19 of ECX is set, then the processor supports SSE4.1.
-// To check if the processor supports SSE4.2 instructions for string / text processing,
-// PCMPGTQ, and CRC32, execute CPUID with EAX = 1 as input.
-// If bit 20 of ECX is set, then the processor supports these SSE4.2 in structions.
+// For intrinsics and SSE : https://software.intel.com/sites/landingpage/IntrinsicsGuide/
 //
-// static bool SSE41(void) { return CPU_Rep.f_1_ECX_[19]; }
-// SSE41 | [bit 19] ECX
-// SSE41 = (cpuid02 & (0x1 << 19))
+void spoutCopy::CheckSSE()
+{
+	const SpoutCPUFeatures &cpu = spout_cpu_features();
+	m_bSSE2   = cpu.bSSE2;
+	m_bSSE3   = cpu.bSSE3;
+	m_bSSSE3  = cpu.bSSSE3;
+	m_bAVX2   = cpu.bAVX2;
+	m_bAVX512 = cpu.bAVX512;
+	m_bF16C   = cpu.bF16C;
+	m_pKernels = &spout_kernels[GetSupportedTier()];
+}
+
+// Highest instruction set tier supported by the CPU
+SpoutCopyTier spoutCopy::GetSupportedTier()
+{
+	const SpoutCPUFeatures &cpu = spout_cpu_features();
+	if (cpu.bAVX512)
+		return SPOUT_COPY_AVX512;
+	if (cpu.bAVX2)
+		return SPOUT_COPY_AVX2;
+	if (cpu.bSSE2 && cpu.bSSSE3)
+		return SPOUT_COPY_SSSE3;
+	if (cpu.bSSE2)
+		return SPOUT_COPY_SSE2;
+	return SPOUT_COPY_SCALAR;
+}
+
+// Line conversion functions for a tier
+// The caller must check that the tier is supported.
+const SpoutCopyKernels *spoutCopy::GetKernels(SpoutCopyTier tier)
+{
+	if (tier < SPOUT_COPY_SCALAR || tier >= SPOUT_COPY_TIER_COUNT)
+		return nullptr;
+	return &spout_kernels[tier];
+}
+
+SpoutRowKernel spoutCopy::GetLineKernel(SpoutCopyTier tier, unsigned int sourceBytes, unsigned int destBytes,
+	bool bSwapRB, bool bMirror, bool bAlpha)
+{
+	if (tier < SPOUT_COPY_SCALAR || tier >= SPOUT_COPY_TIER_COUNT)
+		return nullptr;
+	if (sourceBytes == 4 && destBytes == 4)
+		return spout_line_kernel<4, 4>(tier, bSwapRB, bMirror, bAlpha);
+	if (sourceBytes == 3 && destBytes == 4)
+		return spout_line_kernel<3, 4>(tier, bSwapRB, bMirror, bAlpha);
+	if (sourceBytes == 4 && destBytes == 3)
+		return spout_line_kernel<4, 3>(tier, bSwapRB, bMirror, bAlpha);
+	if (sourceBytes == 3 && destBytes == 3)
+		return spout_line_kernel<3, 3>(tier, bSwapRB, bMirror, bAlpha);
+	return nullptr;
+}
+
+SpoutCopyTier spoutCopy::GetCopyTier() const
+{
+	return m_pKernels->tier;
+}
+
+// Select a lower tier, for example to compare performance
+bool spoutCopy::SetCopyTier(SpoutCopyTier tier)
+{
+	if (tier < SPOUT_COPY_SCALAR || tier > GetSupportedTier())
+		return false;
+	m_pKernels = &spout_kernels[tier];
+	return true;
+}
+
 //
-// static bool SSE42(void) { return CPU_Rep.f_1_ECX_[20]; }
-// SSE42 | [bit 20] ECX
-// SSE42 = (cpuid02 & (0x1 << 20))
+// Multi-threaded copy
 //
-// EAX - CPUInfo[0]
-// EBX - CPUInfo[1]
-// ECX - CPUInfo[2]
-// EDX - CPUInfo[3]
+void spoutCopy::SetCopyThreads(unsigned int nThreads, unsigned int minBytes)
+{
+	m_nCopyThreads = nThreads;
+	m_MinThreadBytes = minBytes;
+}
+
+unsigned int spoutCopy::GetCopyThreads() const
+{
+	return m_nCopyThreads;
+}
+
 //
-// For intrinsics and SSE : https://software.intel.com/sites/landingpage/IntrinsicsGuide/
+// Divide the image into stripes of lines that fit in the L2 cache
+// so that each thread streams through its own cache.
+// Stripes are taken in order by the next free thread.
 //
-void spoutCopy::CheckSSE()
+void spoutCopy::ForEachStripe(unsigned int height, size_t lineBytes,
+	const std::function<void(unsigned int, unsigned int)> &function) const
 {
-	// An array of four integers that contains the information returned
-	// in EAX (0), EBX (1), ECX (2), and EDX (3) about supported features of the CPU.
-	int CPUInfo[4] = { -1, -1, -1, -1 };
+	if (m_nCopyThreads == 1 || height < 2 || lineBytes == 0
+		|| (size_t)height * lineBytes < m_MinThreadBytes) {
+		function(0, height);
+		return;
+	}
 
-	//-- Get number of valid info ids
-	__cpuid(CPUInfo, 0);
-	int nIds = CPUInfo[0];
+	spoutThreadPool &pool = spoutThreadPool::Global();
+	const unsigned int nThreads = m_nCopyThreads == 0 ? pool.GetThreadCount() : m_nCopyThreads;
 
-	//-- Get info for id "1"
-	if (nIds >= 1) {
-		// SSE2 | [bit 26] EDX
-		// SSE2 = (cpuid03 & (0x1 << 26))
-		__cpuid(CPUInfo, 1); // EAX = 1 for __cpuid
-		m_bSSE2 = ((CPUInfo[3] & (0x1 << 26)) || false);
-		// SSE3 | [bit 0] ECX
-		// SSE3 = (cpuid02 & (0x1)
-		m_bSSE3 = ((CPUInfo[2] & (0x1)) || false);
-		// SSSE3 | [bit 9] ECX
-		// SSSE3 = (cpuid02 & (0x1 << 9)
-		m_bSSSE3 = ((CPUInfo[2] & (0x1 << 9)) || false);
-	}
+	size_t lines = spout_cpu_features().L2CacheBytes / lineBytes;
+	if (lines < 1)
+		lines = 1;
+	const unsigned int stripeLines = (unsigned int)(lines < height ? lines : height);
+	const unsigned int nStripes = (height + stripeLines - 1) / stripeLines;
 
+	pool.ParallelFor(nStripes, nThreads, [&](unsigned int stripe) {
+		const unsigned int y0 = stripe * stripeLines;
+		const unsigned int y1 = (height - y0 < stripeLines) ? height : y0 + stripeLines;
+		function(y0, y1);
+	});
+}
+
+//
+// Convert line by line allowing for source and destination pitch.
+// The source is read from the bottom up for invert.
+// The alpha function is applied while the line is in the cache.
+//
+void spoutCopy::ConvertRows(SpoutRowKernel kernel, const void *source, void *dest,
+	unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch, bool bInvert,
+	SpoutRowKernel alphaKernel) const
+{
+	auto src = static_cast<const unsigned char *>(source);
+	auto dst = static_cast<unsigned char *>(dest);
+	ForEachStripe(height, (size_t)sourcePitch + destPitch, [&](unsigned int y0, unsigned int y1) {
+		for (unsigned int y = y0; y < y1; y++) {
+			const unsigned int ys = bInvert ? (height - 1 - y) : y;
+			unsigned char *d = dst + (size_t)y * destPitch;
+			kernel(src + (size_t)ys * sourcePitch, d, width);
+			if (alphaKernel)
+				alphaKernel(d, d, width);
+		}
+	});
 }
 
 //
@@ -318,15 +944,7 @@ void spoutCopy::CheckSSE()
 void spoutCopy::rgba2bgra(const void *rgba_source, void *bgra_dest,
 	unsigned int width, unsigned int height, bool bInvert) const
 {
-	if ((width % 16) == 0) { // 16 byte aligned width
-		if (m_bSSE2 && m_bSSSE3) // SSE3 available
-			rgba_bgra_sse3(rgba_source, bgra_dest, width, height, bInvert);
-		else if (m_bSSE2) // SSE2 available
-			rgba_bgra_sse2(rgba_source, bgra_dest, width, height, bInvert);
-	}
-	else {
-		rgba_bgra(rgba_source, bgra_dest, width, height, bInvert);
-	}
+	ConvertRows(m_pKernels->rgba_bgra, rgba_source, bgra_dest, width, height, width * 4, width * 4, bInvert);
 }
 
 
@@ -334,33 +952,7 @@ void spoutCopy::rgba2bgra(const void *rgba_source, void *bgra_dest,
 void spoutCopy::rgba2bgra(const void *rgba_source, void *bgra_dest,
 	unsigned int width, unsigned int height, unsigned int sourcePitch, bool bInvert) const
 {
-	for (unsigned int y = 0; y < height; y++) {
-		// Start of buffer
-		auto source = static_cast<const unsigned __int32 *>(rgba_source); // unsigned int = 4 bytes
-		auto dest = static_cast<unsigned __int32 *>(bgra_dest);
-		// Increment to current line.
-		// Pitch is line length in bytes.
-		// Divide by 4 to get the line width in rgba pixels.
-		if (bInvert) {
-			source += (unsigned long)((height - 1 - y)*sourcePitch / 4);
-			dest += (unsigned long)(y * width); // dest is not inverted
-		}
-		else {
-			source += (unsigned long)(y * sourcePitch / 4);
-			dest += (unsigned long)(y * width);
-		}
-		// Copy the line
-		if ((width % 16) == 0) { // 16 byte aligned width
-			if (m_bSSE2 && m_bSSSE3) // SSE3 available
-				rgba_bgra_sse3(source, dest, width, 1, bInvert);
-			else if (m_bSSE2) // SSE2 available
-				rgba_bgra_sse2(source, dest, width, 1, bInvert);
-		}
-		else {
-			rgba_bgra(source, dest, width, 1, bInvert);
-		}
-	}
-
+	ConvertRows(m_pKernels->rgba_bgra, rgba_source, bgra_dest, width, height, sourcePitch, width * 4, bInvert);
 }
 
 // line by line with source and dest pitch
@@ -368,32 +960,7 @@ void spoutCopy::rgba2bgra(const void* rgba_source, void* bgra_dest,
 	unsigned int width, unsigned int height,
 	unsigned int sourcePitch, unsigned int destPitch, bool bInvert) const
 {
-	for (unsigned int y = 0; y < height; y++) {
-		// Start of buffer
-		auto source = static_cast<const unsigned __int32 *>(rgba_source); // unsigned int = 4 bytes
-		auto dest = static_cast<unsigned __int32 *>(bgra_dest);
-		// Increment to current line.
-		// Pitch is line length in bytes.
-		// Divide by 4 to get the line width in rgba pixels.
-		if (bInvert) {
-			source += (unsigned long)((height - 1 - y)*sourcePitch / 4);
-			dest   += (unsigned long)(y * destPitch / 4); // dest is not inverted
-		}
-		else {
-			source += (unsigned long)(y * sourcePitch / 4);
-			dest   += (unsigned long)(y * destPitch / 4);
-		}
-		// Copy the line
-		if ((width % 16) == 0) { // 16 byte aligned width
-			if (m_bSSE2 && m_bSSSE3) // SSE3 available
-				rgba_bgra_sse3(source, dest, width, 1, bInvert);
-			else if (m_bSSE2) // SSE2 available
-				rgba_bgra_sse2(source, dest, width, 1, bInvert);
-		}
-		else {
-			rgba_bgra(source, dest, width, 1, bInvert);
-		}
-	}
+	ConvertRows(m_pKernels->rgba_bgra, rgba_source, bgra_dest, width, height, sourcePitch, destPitch, bInvert);
 }
 
 
@@ -408,180 +975,608 @@ void spoutCopy::bgra2rgba(const void *bgra_source, void *rgba_dest, unsigned int
 void spoutCopy::rgba_bgra(const void *rgba_source, void *bgra_dest,
 	unsigned int width, unsigned int height, bool bInvert) const
 {
-    for (unsigned int y = 0; y < height; y++) {
+	ConvertRows(spout_kernels[SPOUT_COPY_SCALAR].rgba_bgra, rgba_source, bgra_dest,
+		width, height, width * 4, width * 4, bInvert);
+} // end rgba_bgra
 
-		// Start of buffer
-		auto source = static_cast<const unsigned __int32 *>(rgba_source);; // unsigned int = 4 bytes
-		auto dest = static_cast<unsigned __int32 *>(bgra_dest);
 
-		// Increment to current line
-		if (bInvert) {
-			// https://docs.microsoft.com/en-us/visualstudio/code-quality/c26451?view=vs-2017
-			source += (unsigned long)((height - 1 - y)*width);
-			dest += (unsigned long)(y * width); // dest is not inverted
-		}
-		else {
-			source += (unsigned long)(y * width);
-			dest += (unsigned long)(y * width);
-		}
+// SSE2 version. Refer to spoutLineConvert::SSE2.
+void spoutCopy::rgba_bgra_sse2(const void *rgba_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert) const
+{
+	ConvertRows(spout_kernels[SPOUT_COPY_SSE2].rgba_bgra, rgba_source, bgra_dest,
+		width, height, width * 4, width * 4, bInvert);
+} // end rgba_bgra_sse2
 
-		for (unsigned int x = 0; x < width; x++) {
-			auto rgbapix = source[x];
-			dest[x] = (_rotl(rgbapix, 16) & 0x00ff00ff) | (rgbapix & 0xff00ff00);
-		}
-	}
-} // end rgba_bgra
+
+// SSSE3 version. Refer to spoutLineConvert::SSSE3.
+void spoutCopy::rgba_bgra_sse3(const void* rgba_source,  void *bgra_dest, unsigned int width, unsigned int height, bool bInvert) const
+{
+	ConvertRows(spout_kernels[SPOUT_COPY_SSSE3].rgba_bgra, rgba_source, bgra_dest,
+		width, height, width * 4, width * 4, bInvert);
+} // end rgba_bgra_ssse3
 
 
 //
-// Adapted from : https://searchcode.com/codesearch/view/5070982/
-// 
-// Copyright (c) 2002-2010 The ANGLE Project Authors. All rights reserved.
-// Use of this source code is governed by a BSD-style license that can be
-// found in the LICENSE file.
-//
-// https://chromium.googlesource.com/angle/angle/+/master/LICENSE
-//
-// All instructions SSE2.
+// Conversion between pixel layouts
 //
-void spoutCopy::rgba_bgra_sse2(const void *rgba_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert) const
-{
-	const __m128i brMask = _mm_set1_epi32(0x00ff00ff); // argb
 
-	for (unsigned int y = 0; y < height; y++) {
+// Conversion format and bytes per pixel for a GL format.
+// bBGR is set for GL_BGRA_EXT and GL_BGR_EXT.
+static bool spout_pixel_format(GLenum glFormat, SpoutRGBAFormat &format, unsigned int &bytes, bool &bBGR)
+{
+	format = SPOUT_RGBA8;
+	bytes = 4;
+	bBGR = false;
+	switch (glFormat) {
+		case GL_RGBA:
+		case GL_RGBA8:
+			return true;
+		case GL_BGRA_EXT:
+			bBGR = true;
+			return true;
+		case GL_RGB:
+			bytes = 3;
+			return true;
+		case GL_BGR_EXT:
+			bytes = 3;
+			bBGR = true;
+			return true;
+		case GL_RGBA16:
+			format = SPOUT_RGBA16;
+			bytes = 8;
+			return true;
+		case GL_RGBA16F:
+			format = SPOUT_RGBA16F;
+			bytes = 8;
+			return true;
+		case GL_RGBA32F:
+			format = SPOUT_RGBA32F;
+			bytes = 16;
+			return true;
+		default:
+			return false;
+	}
+}
 
-		// Start of buffer
-		auto source = static_cast<const unsigned __int32 *>(rgba_source); // unsigned int = 4 bytes
-		auto dest = static_cast<unsigned __int32 *>(bgra_dest);
+unsigned int spoutCopy::GetPixelBytes(GLenum glFormat)
+{
+	SpoutRGBAFormat format;
+	unsigned int bytes;
+	bool bBGR;
+	return spout_pixel_format(glFormat, format, bytes, bBGR) ? bytes : 0;
+}
 
-		// Increment to current line
-		if (bInvert)
-			source += (unsigned long)((height - 1 - y)*width);
+bool spoutCopy::Convert(const void* source, const SpoutPixelDesc& sourceDesc,
+	void* dest, const SpoutPixelDesc& destDesc, bool bSwapRB) const
+{
+	if (!source || !dest || sourceDesc.width == 0 || sourceDesc.height == 0
+		|| destDesc.width == 0 || destDesc.height == 0)
+		return false;
+
+	SpoutRGBAFormat srcFormat, dstFormat;
+	unsigned int srcBytes, dstBytes;
+	bool bSrcBGR, bDstBGR;
+	if (!spout_pixel_format(sourceDesc.format, srcFormat, srcBytes, bSrcBGR)
+		|| !spout_pixel_format(destDesc.format, dstFormat, dstBytes, bDstBGR))
+		return false;
+
+	bSwapRB = (bSwapRB != (bSrcBGR != bDstBGR));
+	const bool bMirror = (sourceDesc.bMirror != destDesc.bMirror);
+	const bool bInvert = (sourceDesc.bInvert != destDesc.bInvert);
+	const unsigned int sourcePitch = sourceDesc.pitch ? sourceDesc.pitch : sourceDesc.width * srcBytes;
+	const unsigned int destPitch = destDesc.pitch ? destDesc.pitch : destDesc.width * dstBytes;
+	// F16C is only used with the AVX2 tier so that
+	// SetCopyTier can select the SSE2 functions
+	const SpoutCopyTier tier = m_pKernels->tier;
+	const bool bF16C = m_bF16C && tier >= SPOUT_COPY_AVX2;
+
+	// Change of alpha mode. rgb and bgr sources have alpha 255
+	// and rgb and bgr destinations have none.
+	SpoutAlphaOp alphaOp = SPOUT_ALPHA_OP_NONE;
+	if (srcBytes != 3 && dstBytes != 3)
+		alphaOp = spoutalpha::GetOp(sourceDesc.alpha, destDesc.alpha);
+
+	// The resampled pixels replace the destination alpha
+	const bool bResample = (sourceDesc.width != destDesc.width || sourceDesc.height != destDesc.height);
+	if (bResample && srcBytes == 3 && dstBytes == 4 && destDesc.bKeepAlpha)
+		return false;
+
+	if (bResample && (srcFormat != SPOUT_RGBA8 || dstFormat != SPOUT_RGBA8)) {
+		// 16 bit and floating point pixels are resampled as float so that
+		// they are not reduced to 8 bit. rgb and bgr are 8 bit only.
+		if (srcBytes == 3 || dstBytes == 3)
+			return false;
+		SpoutRowKernel sourceKernel = nullptr;
+		if (srcFormat != SPOUT_RGBA32F)
+			sourceKernel = spoutconvert::GetKernel(srcFormat, SPOUT_RGBA32F, false, false, tier, bF16C);
+		SpoutRowKernel destKernel = nullptr;
+		if (dstFormat != SPOUT_RGBA32F || bSwapRB)
+			destKernel = spoutconvert::GetKernel(SPOUT_RGBA32F, dstFormat, bSwapRB, false, tier, bF16C);
+		SpoutRowKernel sourceAlpha = nullptr;
+		SpoutRowKernel destAlpha = nullptr;
+		if (alphaOp == SPOUT_ALPHA_OP_PREMULTIPLY)
+			sourceAlpha = spoutalpha::GetKernel(SPOUT_RGBA32F, alphaOp, tier);
 		else
-			source += (unsigned long)(y * width);
-
-		dest += (unsigned long)(y * width); // dest is not inverted
-
-		// Make output writes aligned
-		unsigned int x;
-		for (x = 0; ((reinterpret_cast<intptr_t>(&dest[x]) & 15) != 0) && x < width; x++) {
-			auto rgbapix = source[x];
-			// rgbapix << 16		: a r g b > g b a r
-			//        & 0x00ff00ff  : r g b . > . b . r
-			// rgbapix & 0xff00ff00 : a r g b > a . g .
-			// result of or			:           a b g r
-			dest[x] = (_rotl(rgbapix, 16) & 0x00ff00ff) | (rgbapix & 0xff00ff00);
-		}
+			destAlpha = spoutalpha::GetKernel(dstFormat, alphaOp, tier, bF16C);
+		Resample(source, dest, sourceDesc.width, sourceDesc.height, sourcePitch,
+			destDesc.width, destDesc.height, destPitch, sourceKernel, destKernel, bInvert, bMirror,
+			sourceAlpha, destAlpha, true);
+		return true;
+	}
 
-		for (; x + 3 < width; x += 4) {
-			__m128i sourceData = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source[x]));
-			// Mask out g and a, which don't change
-			__m128i gaComponents = _mm_andnot_si128(brMask, sourceData);
-			// Mask out b and r
-			__m128i brComponents = _mm_and_si128(sourceData, brMask);
-			// Swap b and r
-			__m128i brSwapped = _mm_shufflehi_epi16(_mm_shufflelo_epi16(brComponents, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
-			__m128i result = _mm_or_si128(gaComponents, brSwapped);
-			_mm_store_si128(reinterpret_cast<__m128i*>(&dest[x]), result);
-		}
+	if (bResample) {
+		// Resample 8 bit pixels in one pass from and to 4 byte pixels in source order.
+		// Source lines are converted as they are read and destination
+		// lines as they are written.
+		SpoutRowKernel sourceKernel = nullptr;
+		if (srcBytes == 3)
+			sourceKernel = GetLineKernel(tier, 3, 4, false);
+		SpoutRowKernel destKernel = nullptr;
+		if (dstBytes == 3)
+			destKernel = GetLineKernel(tier, 4, 3, bSwapRB);
+		else if (bSwapRB)
+			destKernel = GetLineKernel(tier, 4, 4, true);
+		// Premultiplied pixels are resampled without dark fringes
+		// at the edges of transparent areas
+		SpoutRowKernel sourceAlpha = nullptr;
+		SpoutRowKernel destAlpha = nullptr;
+		if (alphaOp == SPOUT_ALPHA_OP_PREMULTIPLY)
+			sourceAlpha = spoutalpha::GetKernel(SPOUT_RGBA8, alphaOp, tier);
+		else
+			destAlpha = spoutalpha::GetKernel(SPOUT_RGBA8, alphaOp, tier);
+		Resample(source, dest, sourceDesc.width, sourceDesc.height, sourcePitch,
+			destDesc.width, destDesc.height, destPitch, sourceKernel, destKernel, bInvert, bMirror,
+			sourceAlpha, destAlpha);
+		return true;
+	}
 
-		// Perform leftover writes
-		for (; x < width; x++) {
-			auto rgbapix = source[x];
-			dest[x] = (_rotl(rgbapix, 16) & 0x00ff00ff) | (rgbapix & 0xff00ff00);
-		}
+	SpoutRowKernel kernel = nullptr;
+	SpoutRowKernel alphaKernel = spoutalpha::GetKernel(dstFormat, alphaOp, tier, bF16C);
+	if (srcBytes == 3 || dstBytes == 3) {
+		// rgb and bgr are 8 bit only
+		if (srcFormat == SPOUT_RGBA8 && dstFormat == SPOUT_RGBA8)
+			kernel = GetLineKernel(tier, srcBytes, dstBytes, bSwapRB, bMirror, !destDesc.bKeepAlpha);
+	}
+	else if (alphaKernel && srcFormat == dstFormat && !bSwapRB && !bMirror) {
+		// Only the alpha mode is changed
+		kernel = alphaKernel;
+		alphaKernel = nullptr;
+	}
+	else {
+		kernel = spoutconvert::GetKernel(srcFormat, dstFormat, bSwapRB, bMirror, tier, bF16C);
 	}
+	if (!kernel)
+		return false;
 
-} // end rgba_bgra_sse2
+	ConvertRows(kernel, source, dest, sourceDesc.width, sourceDesc.height, sourcePitch, destPitch, bInvert,
+		alphaKernel);
 
+	return true;
+}
 
 //
-//	Adapted from a Gist snippet by Aurlien Valle (NewbiZ) http://newbiz.github.io/
+// Region of a larger source. The source pointer is moved to the first
+// pixel of the region and the source pitch is kept, so that only the
+// lines and pixels of the region are read.
 //
-//	https://gist.github.com/NewbiZ/5541524
+bool spoutCopy::ConvertRegion(const void* source, const SpoutPixelDesc& sourceDesc,
+	const SpoutRegion& region, void* dest, const SpoutPixelDesc& destDesc, bool bSwapRB) const
+{
+	if (!source || region.width == 0 || region.height == 0
+		|| region.x >= sourceDesc.width || region.y >= sourceDesc.height)
+		return false;
+
+	SpoutRGBAFormat format;
+	unsigned int bytes;
+	bool bBGRA;
+	if (!spout_pixel_format(sourceDesc.format, format, bytes, bBGRA))
+		return false;
+
+	// Clip to the source
+	const unsigned int width = (region.width < sourceDesc.width - region.x) ? region.width : sourceDesc.width - region.x;
+	const unsigned int height = (region.height < sourceDesc.height - region.y) ? region.height : sourceDesc.height - region.y;
+
+	// Inverted lines start at the bottom and mirrored pixels at the right
+	const unsigned int x = sourceDesc.bMirror ? sourceDesc.width - region.x - width : region.x;
+	const unsigned int y = sourceDesc.bInvert ? sourceDesc.height - region.y - height : region.y;
+
+	SpoutPixelDesc regionDesc = sourceDesc;
+	regionDesc.width = width;
+	regionDesc.height = height;
+	regionDesc.pitch = sourceDesc.pitch ? sourceDesc.pitch : sourceDesc.width * bytes;
+	const unsigned char *first = static_cast<const unsigned char *>(source)
+		+ (size_t)y * regionDesc.pitch + (size_t)x * bytes;
+
+	return Convert(first, regionDesc, dest, destDesc, bSwapRB);
+}
+
 //
-//	Approximately 15% faster than SSE2 function
+// 8 bit, 16 bit and floating point rgba. See SpoutConvert.cpp
 //
-void spoutCopy::rgba_bgra_sse3(const void* rgba_source,  void *bgra_dest, unsigned int width, unsigned int height, bool bInvert) const
+bool spoutCopy::ConvertRGBA(const void* source, void* dest, unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch,
+	GLenum sourceFormat, GLenum destFormat,
+	bool bInvert, bool bSwapRB) const
 {
-	// Shuffling mask (RGBA -> BGRA) x 4, in reverse byte order
-	static const __m128i m = _mm_set_epi8(15, 12, 13, 14, 11, 8, 9, 10, 7, 4, 5, 6, 3, 0, 1, 2);
+	// rgba formats only
+	if (sourceFormat == GL_RGB || sourceFormat == GL_BGR_EXT
+		|| destFormat == GL_RGB || destFormat == GL_BGR_EXT)
+		return false;
+
+	SpoutPixelDesc sourceDesc(sourceFormat, width, height, sourcePitch);
+	SpoutPixelDesc destDesc(destFormat, width, height, destPitch);
+	destDesc.bInvert = bInvert;
+	return Convert(source, sourceDesc, dest, destDesc, bSwapRB);
+}
+
+//
+// 3D LUT colour grading. See SpoutLut.cpp
+//
+bool spoutCopy::ApplyLut(const spoutLut &lut, const void* source, void* dest,
+	unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch,
+	GLenum glFormat, bool bInvert) const
+{
+	if (!lut.IsLoaded() || !source || !dest || width == 0 || height == 0)
+		return false;
+
+	SpoutRGBAFormat format = SPOUT_RGBA8;
+	unsigned int bytes = 0;
+	bool bBGRA = false;
+	if (!spout_pixel_format(glFormat, format, bytes, bBGRA)
+		|| bytes == 3 || format == SPOUT_RGBA16F)
+		return false;
+
+	// Inverted lines overwrite source lines not yet read
+	if (bInvert && source == dest)
+		return false;
+
+	if (sourcePitch == 0) sourcePitch = width * bytes;
+	if (destPitch == 0) destPitch = width * bytes;
+
+	auto src = static_cast<const unsigned char *>(source);
+	auto dst = static_cast<unsigned char *>(dest);
+	const SpoutCopyTier tier = m_pKernels->tier;
+	ForEachStripe(height, (size_t)sourcePitch + destPitch, [&](unsigned int y0, unsigned int y1) {
+		for (unsigned int y = y0; y < y1; y++) {
+			const unsigned int ys = bInvert ? (height - 1 - y) : y;
+			lut.ApplyLine(src + (size_t)ys * sourcePitch, dst + (size_t)y * destPitch,
+				width, format, bBGRA, tier);
+		}
+	});
 
-	for (unsigned int y = 0; y < height; y++) {
+	return true;
+}
 
-		// Start of buffer
-		auto source = static_cast<const unsigned __int32 *>(rgba_source); // unsigned int = 4 bytes
-		auto dest = static_cast<unsigned __int32 *>(bgra_dest);
+//
+// Transfer function conversion. See SpoutTransfer.cpp
+//
+bool spoutCopy::ApplyTransfer(const void* source, void* dest,
+	unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch, GLenum glFormat,
+	SpoutTransferFunction sourceTransfer, SpoutTransferFunction destTransfer,
+	bool bInvert) const
+{
+	if (!source || !dest || width == 0 || height == 0
+		|| sourceTransfer >= SPOUT_TRANSFER_COUNT || destTransfer >= SPOUT_TRANSFER_COUNT)
+		return false;
+
+	SpoutRGBAFormat format = SPOUT_RGBA8;
+	unsigned int bytes = 0;
+	bool bBGRA = false;
+	if (!spout_pixel_format(glFormat, format, bytes, bBGRA) || bytes == 3)
+		return false;
+
+	// Inverted lines overwrite source lines not yet read
+	if (bInvert && source == dest)
+		return false;
+
+	if (sourcePitch == 0) sourcePitch = width * bytes;
+	if (destPitch == 0) destPitch = width * bytes;
+
+	// Build the tables before the threads start
+	spouttransfer::Prepare(format, sourceTransfer, destTransfer);
+
+	auto src = static_cast<const unsigned char *>(source);
+	auto dst = static_cast<unsigned char *>(dest);
+	const SpoutCopyTier tier = m_pKernels->tier;
+	ForEachStripe(height, (size_t)sourcePitch + destPitch, [&](unsigned int y0, unsigned int y1) {
+		for (unsigned int y = y0; y < y1; y++) {
+			const unsigned int ys = bInvert ? (height - 1 - y) : y;
+			spouttransfer::ApplyLine(src + (size_t)ys * sourcePitch, dst + (size_t)y * destPitch,
+				width, format, sourceTransfer, destTransfer, tier);
+		}
+	});
 
-		// Increment to current line
-		if (bInvert)
-			source += (unsigned long)((height - 1 - y)*width);
-		else
-			source += (unsigned long)(y * width);
-		dest += (unsigned long)(y * width); // dest is not inverted
+	return true;
+}
 
-		// Assert pixels will NOT be aliased here : TODO
-		// __m128i* __restrict__ pix = (__m128i*)pixels;
-		auto src = reinterpret_cast<const __m128i *>(source);
-		auto dst = reinterpret_cast<__m128i *>(dest);
+//
+// YUV conversion. See SpoutYUV.cpp
+//
+bool spoutCopy::YUVToRGBA(const void* source, void* dest,
+	unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch,
+	SpoutYUVFormat yuvFormat, GLenum rgbaFormat,
+	SpoutYUVMatrix matrix, bool bFullRange, bool bInvert) const
+{
+	if (!source || !dest || width == 0 || height == 0
+		|| yuvFormat >= SPOUT_YUV_FORMAT_COUNT || matrix >= SPOUT_YUV_MATRIX_COUNT)
+		return false;
+
+	SpoutRGBAFormat format = SPOUT_RGBA8;
+	unsigned int bytes = 0;
+	bool bBGRA = false;
+	if (!spout_pixel_format(rgbaFormat, format, bytes, bBGRA)
+		|| bytes == 3 || format == SPOUT_RGBA16F)
+		return false;
+
+	const spoutyuv::Frame frame = { yuvFormat, matrix, bFullRange, width, height,
+		sourcePitch ? sourcePitch : spoutyuv::LinePitch(yuvFormat, width) };
+	if (destPitch == 0) destPitch = width * bytes;
+
+	auto src = static_cast<const unsigned char *>(source);
+	auto dst = static_cast<unsigned char *>(dest);
+	const SpoutCopyTier tier = m_pKernels->tier;
+	ForEachStripe(height, (size_t)frame.pitch + destPitch, [&](unsigned int y0, unsigned int y1) {
+		spoutyuv::DecodeLines(frame, src, dst, destPitch, format, bBGRA, bInvert, tier, y0, y1);
+	});
+
+	return true;
+}
 
-		// Tile the LHS to match 64B cache line size
-		const auto srcEnd = reinterpret_cast<const __m128i *>(source + width);
-		for (; src < srcEnd; src += 4, dst += 4) {
+bool spoutCopy::RGBAToYUV(const void* source, void* dest,
+	unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch,
+	GLenum rgbaFormat, SpoutYUVFormat yuvFormat,
+	SpoutYUVMatrix matrix, bool bFullRange, bool bInvert) const
+{
+	if (!source || !dest || width == 0 || height == 0
+		|| yuvFormat >= SPOUT_YUV_FORMAT_COUNT || matrix >= SPOUT_YUV_MATRIX_COUNT)
+		return false;
+
+	SpoutRGBAFormat format = SPOUT_RGBA8;
+	unsigned int bytes = 0;
+	bool bBGRA = false;
+	if (!spout_pixel_format(rgbaFormat, format, bytes, bBGRA)
+		|| bytes == 3 || format == SPOUT_RGBA16F)
+		return false;
+
+	const spoutyuv::Frame frame = { yuvFormat, matrix, bFullRange, width, height,
+		destPitch ? destPitch : spoutyuv::LinePitch(yuvFormat, width) };
+	if (sourcePitch == 0) sourcePitch = width * bytes;
+
+	auto src = static_cast<const unsigned char *>(source);
+	auto dst = static_cast<unsigned char *>(dest);
+	const SpoutCopyTier tier = m_pKernels->tier;
+	if (spoutyuv::IsVerticalSubsampled(yuvFormat)) {
+		// Pairs of lines share a chroma line
+		const unsigned int pairs = (height + 1) / 2;
+		ForEachStripe(pairs, ((size_t)sourcePitch + frame.pitch) * 2, [&](unsigned int p0, unsigned int p1) {
+			spoutyuv::EncodeLines(frame, src, sourcePitch, format, bBGRA, dst, bInvert, tier,
+				p0 * 2, (p1 * 2 < height) ? p1 * 2 : height);
+		});
+	}
+	else {
+		ForEachStripe(height, (size_t)sourcePitch + frame.pitch, [&](unsigned int y0, unsigned int y1) {
+			spoutyuv::EncodeLines(frame, src, sourcePitch, format, bBGRA, dst, bInvert, tier, y0, y1);
+		});
+	}
 
-			__m128i p1 = _mm_load_si128(src); // SSE2
-			__m128i p2 = _mm_load_si128(src + 1);
-			__m128i p3 = _mm_load_si128(src + 2);
-			__m128i p4 = _mm_load_si128(src + 3);
+	return true;
+}
 
-			p1 = _mm_shuffle_epi8(p1, m); // SSSE3
-			p2 = _mm_shuffle_epi8(p2, m);
-			p3 = _mm_shuffle_epi8(p3, m);
-			p4 = _mm_shuffle_epi8(p4, m);
+//
+// Alpha premultiply, unpremultiply and opaque. See SpoutAlpha.cpp
+//
+bool spoutCopy::ApplyAlpha(const void* source, void* dest,
+	unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch,
+	GLenum glFormat, SpoutAlphaOp op, bool bInvert) const
+{
+	if (!source || !dest || width == 0 || height == 0 || op >= SPOUT_ALPHA_OP_COUNT)
+		return false;
+
+	SpoutRGBAFormat format = SPOUT_RGBA8;
+	unsigned int bytes = 0;
+	bool bBGRA = false;
+	if (!spout_pixel_format(glFormat, format, bytes, bBGRA) || bytes == 3)
+		return false;
+
+	// Inverted lines overwrite source lines not yet read
+	if (bInvert && source == dest)
+		return false;
+
+	if (sourcePitch == 0) sourcePitch = width * bytes;
+	if (destPitch == 0) destPitch = width * bytes;
+
+	const SpoutCopyTier tier = m_pKernels->tier;
+	SpoutRowKernel kernel = spoutalpha::GetKernel(format, op, tier, m_bF16C && tier >= SPOUT_COPY_AVX2);
+	if (!kernel) {
+		// No change
+		if (source == dest)
+			return true;
+		kernel = spoutconvert::GetKernel(format, format, false, false, tier, false);
+	}
+	ConvertRows(kernel, source, dest, width, height, sourcePitch, destPitch, bInvert);
 
-			_mm_store_si128(dst, p1); // SSE2
-			_mm_store_si128(dst + 1, p2);
-			_mm_store_si128(dst + 2, p3);
-			_mm_store_si128(dst + 3, p4);
+	return true;
+}
 
-		}
+//
+// Rotate and transpose. See SpoutRotate.cpp
+//
+bool spoutCopy::Rotate(const void* source, void* dest,
+	unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch,
+	GLenum glFormat, SpoutRotation rotation) const
+{
+	if (!source || !dest || source == dest || width == 0 || height == 0
+		|| rotation >= SPOUT_ROTATION_COUNT)
+		return false;
+
+	SpoutRGBAFormat format = SPOUT_RGBA8;
+	unsigned int bytes = 0;
+	bool bBGRA = false;
+	if (!spout_pixel_format(glFormat, format, bytes, bBGRA) || (bytes != 4 && bytes != 8))
+		return false;
+
+	const bool bTranspose = spoutrotate::IsTransposed(rotation);
+	const unsigned int destWidth = bTranspose ? height : width;
+	const unsigned int destHeight = bTranspose ? width : height;
+	if (sourcePitch == 0) sourcePitch = width * bytes;
+	if (destPitch == 0) destPitch = destWidth * bytes;
+
+	const SpoutCopyTier tier = m_pKernels->tier;
+	if (!bTranspose) {
+		// Copy, or lines and pixels in reverse order for 180
+		const bool bReverse = (rotation == SPOUT_ROTATE_180);
+		SpoutRowKernel kernel = (bytes == 4) ? GetLineKernel(tier, 4, 4, false, bReverse)
+			: spoutconvert::GetKernel(format, format, false, bReverse, tier, false);
+		ConvertRows(kernel, source, dest, width, height, sourcePitch, destPitch, bReverse);
+		return true;
 	}
 
-} // end rgba_bgra_ssse3
+	auto src = static_cast<const unsigned char *>(source);
+	auto dst = static_cast<unsigned char *>(dest);
+	ForEachStripe(destHeight, (size_t)destWidth * bytes * 2, [&](unsigned int y0, unsigned int y1) {
+		spoutrotate::TransposeLines(src, sourcePitch, width, height, bytes, rotation,
+			dst, destPitch, tier, y0, y1);
+	});
 
+	return true;
+}
 
 //
-// rgb2rgba, bgr2rgba, rgba2rgb, rgba2bgr, rgb2bgra
+// Dithered conversion to 8 bit. See SpoutDither.cpp
 //
-
-void spoutCopy::rgb2rgba(const void *rgb_source, void *rgba_dest, unsigned int width, unsigned int height, bool bInvert) const
+bool spoutCopy::DitherRGBA(const void* source, void* dest,
+	unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch,
+	GLenum sourceFormat, GLenum destFormat,
+	SpoutDitherMethod method, unsigned int frame, bool bInvert) const
 {
-	const unsigned long rgbsize = width * height * 3;
-	const unsigned long rgbpitch = width * 3;
+	if (!source || !dest || width == 0 || height == 0
+		|| method >= SPOUT_DITHER_METHOD_COUNT)
+		return false;
+
+	SpoutRGBAFormat format = SPOUT_RGBA8;
+	SpoutRGBAFormat destRGBA = SPOUT_RGBA8;
+	unsigned int sourceBytes = 0;
+	unsigned int destBytes = 0;
+	bool bSourceBGRA = false;
+	bool bBGRA = false;
+	if (!spout_pixel_format(sourceFormat, format, sourceBytes, bSourceBGRA)
+		|| !spout_pixel_format(destFormat, destRGBA, destBytes, bBGRA)
+		|| format == SPOUT_RGBA8 || destRGBA != SPOUT_RGBA8 || destBytes != 4)
+		return false;
+
+	if (sourcePitch == 0) sourcePitch = width * sourceBytes;
+	if (destPitch == 0) destPitch = width * 4;
+
+	auto src = static_cast<const unsigned char *>(source);
+	auto dst = static_cast<unsigned char *>(dest);
+	const SpoutCopyTier tier = m_pKernels->tier;
+	const bool bF16C = m_bF16C && tier >= SPOUT_COPY_AVX2;
+	ForEachStripe(height, (size_t)sourcePitch + destPitch, [&](unsigned int y0, unsigned int y1) {
+		// Thresholds follow the destination line
+		float thresholds[spoutdither::TileSize];
+		for (unsigned int y = y0; y < y1; y++) {
+			const unsigned int ys = bInvert ? (height - 1 - y) : y;
+			spoutdither::GetThresholds(method, frame, y, thresholds);
+			spoutdither::DitherLine(src + (size_t)ys * sourcePitch, dst + (size_t)y * destPitch,
+				width, format, thresholds, bBGRA, tier, bF16C);
+		}
+	});
 
-	// Start of buffers
-	auto rgb = static_cast<const unsigned char *>(rgb_source); // RGB
-	auto rgba = static_cast<unsigned char *>(rgba_dest); // RGBA
+	return true;
+}
 
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
+//
+// Thumbnails with a 2 x 2 box filter at each level. See SpoutThumbnail.cpp
+//
+bool spoutCopy::Downsample(const void* source, unsigned int width, unsigned int height,
+	unsigned int sourcePitch, GLenum sourceFormat,
+	unsigned char* const* dest, unsigned int levels, bool bInvert) const
+{
+	if (!source || !dest || width == 0 || height == 0 || levels == 0)
+		return false;
+	for (unsigned int i = 0; i < levels; i++) {
+		if (!dest[i])
+			return false;
 	}
 
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// rgb source - rgba dest
-			*(rgba + 0) = *(rgb + 0); // red
-			*(rgba + 1) = *(rgb + 1); // grn
-			*(rgba + 2) = *(rgb + 2); // blu
-			*(rgba + 3) = (unsigned char)255; // alpha
-			rgb += 3;
-			rgba += 4;
+	SpoutRGBAFormat format = SPOUT_RGBA8;
+	unsigned int bytes = 0;
+	bool bBGR = false;
+	if (!spout_pixel_format(sourceFormat, format, bytes, bBGR))
+		return false;
+	if (sourcePitch == 0) sourcePitch = width * bytes;
+
+	// Source lines to 8 bit rgba, or used directly
+	const SpoutCopyTier tier = m_pKernels->tier;
+	const bool bF16C = m_bF16C && tier >= SPOUT_COPY_AVX2;
+	SpoutRowKernel kernel = nullptr;
+	if (bytes == 3)
+		kernel = GetLineKernel(tier, 3, 4, bBGR);
+	else if (format != SPOUT_RGBA8)
+		kernel = spoutconvert::GetKernel(format, SPOUT_RGBA8, bBGR, false, tier, bF16C);
+	else if (bBGR)
+		kernel = GetLineKernel(tier, 4, 4, true);
+
+	auto src = static_cast<const unsigned char *>(source);
+	unsigned int destWidth = spoutthumbnail::HalfSize(width);
+	unsigned int destHeight = spoutthumbnail::HalfSize(height);
+	ForEachStripe(destHeight, (size_t)sourcePitch * 2, [&](unsigned int y0, unsigned int y1) {
+		std::vector<unsigned char> lines(kernel ? (size_t)width * 8 : 0);
+		for (unsigned int y = y0; y < y1; y++) {
+			// The last line is repeated for an odd height
+			unsigned int s0 = y * 2;
+			unsigned int s1 = (s0 + 1 < height) ? s0 + 1 : s0;
+			if (bInvert) {
+				s0 = height - 1 - s0;
+				s1 = height - 1 - s1;
+			}
+			const unsigned char *line0 = src + (size_t)s0 * sourcePitch;
+			const unsigned char *line1 = src + (size_t)s1 * sourcePitch;
+			if (kernel) {
+				kernel(line0, lines.data(), width);
+				kernel(line1, lines.data() + (size_t)width * 4, width);
+				line0 = lines.data();
+				line1 = lines.data() + (size_t)width * 4;
+			}
+			spoutthumbnail::HalveLine(line0, line1, dest[0] + (size_t)y * destWidth * 4, width, tier);
 		}
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
+	});
+
+	// Each further level from the one before
+	for (unsigned int i = 1; i < levels; i++) {
+		const unsigned char *level = dest[i - 1];
+		const unsigned int levelWidth = destWidth;
+		const unsigned int levelHeight = destHeight;
+		destWidth = spoutthumbnail::HalfSize(levelWidth);
+		destHeight = spoutthumbnail::HalfSize(levelHeight);
+		ForEachStripe(destHeight, (size_t)levelWidth * 8, [&](unsigned int y0, unsigned int y1) {
+			for (unsigned int y = y0; y < y1; y++) {
+				const unsigned int s0 = y * 2;
+				const unsigned int s1 = (s0 + 1 < levelHeight) ? s0 + 1 : s0;
+				spoutthumbnail::HalveLine(level + (size_t)s0 * levelWidth * 4, level + (size_t)s1 * levelWidth * 4,
+					dest[i] + (size_t)y * destWidth * 4, levelWidth, tier);
+			}
+		});
 	}
 
+	return true;
+}
+
+
+//
+// rgb2rgba, bgr2rgba, rgba2rgb, rgba2bgr, rgb2bgra
+//
+
+void spoutCopy::rgb2rgba(const void *rgb_source, void *rgba_dest, unsigned int width, unsigned int height, bool bInvert) const
+{
+	ConvertRows(m_pKernels->rgb_rgba, rgb_source, rgba_dest, width, height, width * 3, width * 4, bInvert);
 } // end rgb2rgba
 
 
@@ -589,134 +1584,32 @@ void spoutCopy::rgb2rgba(const void *rgb_source, void *rgba_dest,
 	unsigned int width, unsigned int height,
 	unsigned int dest_pitch, bool bInvert) const
 {
-	// RGB dest does not have padding
-	const unsigned long rgbsize = width * height * 3;
-	const unsigned long rgbpitch = width * 3;
-	const unsigned long rgba_padding = dest_pitch - (width * 4);
-
-	// RGBA dest may have padding 
+	// RGB source does not have padding
+	// RGBA dest may have padding and alpha is not changed
 	// Dest and source must be the same dimensions otherwise
-
-	// Start of buffers
-	auto rgb = static_cast<const unsigned char *>(rgb_source); // rgb/bgr
-	auto rgba = static_cast<unsigned char *>(rgba_dest); // rgba/bgra
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			*(rgba + 0) = *(rgb + 0); // red
-			*(rgba + 1) = *(rgb + 1); // grn
-			*(rgba + 2) = *(rgb + 2); // blu
-			rgb += 3;
-			rgba += 4;
-		}
-		rgba += rgba_padding;
-
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(m_pKernels->rgb_rgbx, rgb_source, rgba_dest, width, height, width * 3, dest_pitch, bInvert);
 } // end rgb2rgba
 
 
 void spoutCopy::bgr2rgba(const void *bgr_source, void *rgba_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-
-	const unsigned long bgrsize = width * height * 3;
-	const unsigned long bgrpitch = width * 3;
-
-	// Start of buffers
-	auto bgr = static_cast<const unsigned char *>(bgr_source); // BGR
-	auto rgba = static_cast<unsigned char *>(rgba_dest); // RGBA
-
-	if (bInvert) {
-		bgr += bgrsize; // end of rgb buffer
-		bgr -= bgrpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// bgr source - rgba dest
-			*(rgba + 0) = *(bgr + 2); // red
-			*(rgba + 1) = *(bgr + 1); // grn
-			*(rgba + 2) = *(bgr + 0); // blu
-			*(rgba + 3) = (unsigned char)255; // alpha
-			bgr += 3;
-			rgba += 4;
-		}
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(m_pKernels->rgb_bgra, bgr_source, rgba_dest, width, height, width * 3, width * 4, bInvert);
 } // end bgr2rgba
 
 void spoutCopy::bgr2rgba(const void *bgr_source, void *rgba_dest,
 	unsigned int width, unsigned int height,
 	unsigned int dest_pitch, bool bInvert) const
 {
-	// BGR buffer dest does not have padding
-	const unsigned long bgrsize = width * height * 3;
-	const unsigned long bgrpitch = width * 3;
-	const unsigned long rgba_padding = dest_pitch - (width * 4);
-
-	// RGBA dest may have padding 
+	// BGR source does not have padding
+	// RGBA dest may have padding and alpha is not changed
 	// Dest and source must be the same dimensions otherwise
-
-	// Start of buffers
-	auto bgr = static_cast<const unsigned char *>(bgr_source); // rgb/bgr
-	auto rgba = static_cast<unsigned char *>(rgba_dest); // rgba/bgra
-	if (bInvert) {
-		bgr += bgrsize; // end of rgb buffer
-		bgr -= bgrpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			*(rgba + 0) = *(bgr + 0); // blu
-			*(rgba + 1) = *(bgr + 1); // grn
-			*(rgba + 2) = *(bgr + 2); // red
-			bgr += 3;
-			rgba += 4;
-		}
-		rgba += rgba_padding;
-
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(m_pKernels->rgb_bgrx, bgr_source, rgba_dest, width, height, width * 3, dest_pitch, bInvert);
 } // end bgr2rgba with dest pitch
 
 
 void spoutCopy::rgb2bgra(const void *rgb_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	const unsigned long rgbsize = width * height * 3;
-	const unsigned long rgbpitch = width * 3;
-
-	// Start of buffers
-	auto rgb = static_cast<const unsigned char *>(rgb_source); // RGB
-	auto bgra = static_cast<unsigned char *>(bgra_dest); // BGRA
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// rgb source - bgra dest
-			*(bgra + 0) = *(rgb + 2); // blu
-			*(bgra + 1) = *(rgb + 1); // grn
-			*(bgra + 2) = *(rgb + 0); // red
-			*(bgra + 3) = (unsigned char)255; // alpha
-			rgb += 3;
-			bgra += 4;
-		}
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(m_pKernels->rgb_bgra, rgb_source, bgra_dest, width, height, width * 3, width * 4, bInvert);
 } // end rgb2bgra
 
 
@@ -725,65 +1618,16 @@ void spoutCopy::rgb2bgra(const void *rgb_source, void *bgra_dest,
 	unsigned int dest_pitch, bool bInvert) const
 {
 	// RGB source does not have padding
-	const unsigned long rgbsize = width * height * 3;
-	const unsigned long rgbpitch = width * 3;
-	// BGRA dest may have padding 
-	const unsigned long bgra_padding = dest_pitch - (width * 4);
+	// BGRA dest may have padding and alpha is not changed
 	// Dest and source must be the same dimensions otherwise
-
-	// Start of buffers
-	auto rgb = static_cast<const unsigned char *>(rgb_source); // rgb/bgr
-	auto bgra = static_cast<unsigned char *>(bgra_dest); // rgba/bgra
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			*(bgra + 0) = *(rgb + 2); // blu
-			*(bgra + 1) = *(rgb + 1); // grn
-			*(bgra + 2) = *(rgb + 0); // red
-			rgb += 3;
-			bgra += 4;
-		}
-		bgra += bgra_padding;
-
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(m_pKernels->rgb_bgrx, rgb_source, bgra_dest, width, height, width * 3, dest_pitch, bInvert);
 } // end rgb2bgra
 
 
 
 void spoutCopy::bgr2bgra(const void *bgr_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	const unsigned long bgrsize = width * height * 3;
-	const unsigned long bgrpitch = width * 3;
-
-	// Start of buffers
-	auto bgr = static_cast<const unsigned char *>(bgr_source); // BGR
-	auto bgra = static_cast<unsigned char *>(bgra_dest); // BGRA
-	if (bInvert) {
-		bgr += bgrsize; // end of rgb buffer
-		bgr -= bgrpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// bgr source - bgra dest
-			*(bgra + 0) = *(bgr + 0); // blu
-			*(bgra + 1) = *(bgr + 1); // grn
-			*(bgra + 2) = *(bgr + 2); // red
-			*(bgra + 3) = (unsigned char)255; // alpha
-			bgr += 3;
-			bgra += 4;
-		}
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(m_pKernels->rgb_rgba, bgr_source, bgra_dest, width, height, width * 3, width * 4, bInvert);
 } // end bgr2bgra
 
 
@@ -791,81 +1635,17 @@ void spoutCopy::rgba2rgb(const void *rgba_source, void *rgb_dest,
 	unsigned int width, unsigned int height,
 	unsigned int rgba_pitch, bool bInvert, bool bMirror, bool bSwapRB) const
 {
-	// RGB dest does not have padding
-	const unsigned long rgbsize = width * height * 3;
-	const unsigned long rgbpitch = width * 3;
-	const unsigned long rgba_padding = rgba_pitch-(width * 4);
-
 	// RGBA source may have padding 
+	// RGB dest does not have padding
 	// Dest and source must be the same dimensions otherwise
-
-	// Start of buffers
-	auto rgba = static_cast<const unsigned char *>(rgba_source); // rgba/bgra
-	auto rgb = static_cast<unsigned char *>(rgb_dest); // rgb/bgr
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
-	}
-
-	// Swap red and blue option
-	int ir = 0; int ig = 1; int ib = 2;
-	if(bSwapRB)	{
-		ir = 2; ib = 0;
-	}
-
-	unsigned int z = 0;
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			if (bMirror) {
-				z = (width - x - 1)*3;
-				*(rgb + z + ir) = *(rgba + 0); // red
-				*(rgb + z + ig) = *(rgba + 1); // grn
-				*(rgb + z + ib) = *(rgba + 2); // blu
-			}
-			else {
-				z = x * 3;
-				*(rgb + z + ir) = *(rgba + 0); // red
-				*(rgb + z + ig) = *(rgba + 1); // grn
-				*(rgb + z + ib) = *(rgba + 2); // blu
-			}
-			rgba += 4;
-		}
-		rgb += width * 3;
-		rgba += rgba_padding;
-		
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(GetLineKernel(m_pKernels->tier, 4, 3, bSwapRB, bMirror),
+		rgba_source, rgb_dest, width, height, rgba_pitch, width * 3, bInvert);
 } // end rgba2rgb
 
 
 void spoutCopy::rgba2bgr(const void *rgba_source, void *bgr_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	const unsigned long bgrsize = width * height * 3;
-	const unsigned long bgrpitch = width * 3;
-
-	// Start of buffers
-	auto rgba = static_cast<const unsigned char *>(rgba_source); // RGBA
-	auto bgr = static_cast<unsigned char *>(bgr_dest); // BGR
-	if (bInvert) {
-		bgr += bgrsize; // end of rgb buffer
-		bgr -= bgrpitch; // beginning of the last bgr line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// rgba source - bgr dest
-			*(bgr + 0) = *(rgba + 2); // blu
-			*(bgr + 1) = *(rgba + 1); // grn
-			*(bgr + 2) = *(rgba + 0); // red
-			bgr += 3;
-			rgba += 4;
-		}
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(m_pKernels->rgba_bgr, rgba_source, bgr_dest, width, height, width * 4, width * 3, bInvert);
 } // end rgba2bgr
 
 
@@ -873,247 +1653,218 @@ void spoutCopy::rgba2bgr(const void *rgba_source, void *bgr_dest,
 	unsigned int width, unsigned int height,
 	unsigned int rgba_pitch, bool bInvert) const
 {
-	// RGB dest does not have padding
-	const unsigned long rgbsize = width * height * 3;
-	const unsigned long rgbpitch = width * 3;
-	const unsigned long rgba_padding = rgba_pitch - (width * 4);
-
 	// RGBA source may have padding 
+	// BGR dest does not have padding
 	// Dest and source must be the same dimensions otherwise
-
-	// Start of buffers
-	auto rgba = static_cast<const unsigned char *>(rgba_source); // rgba/bgra
-	auto bgr = static_cast<unsigned char *>(bgr_dest); // rgb/bgr
-	if (bInvert) {
-		bgr += rgbsize; // end of rgb buffer
-		bgr -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			*(bgr + 2) = *(rgba + 0); // red
-			*(bgr + 1) = *(rgba + 1); // grn
-			*(bgr + 0) = *(rgba + 2); // blu
-			bgr += 3;
-			rgba += 4;
-		}
-		rgba += rgba_padding;
-
-		if (bInvert)
-			bgr -= rgbpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(m_pKernels->rgba_bgr, rgba_source, bgr_dest, width, height, rgba_pitch, width * 3, bInvert);
 } // end rgba2bgr
 
 
 void spoutCopy::bgra2rgb(const void *bgra_source, void *rgb_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	const unsigned long rgbsize = width * height * 3;
-	const unsigned long rgbpitch = width * 3;
-
-	// Start of buffers
-	auto bgra = static_cast<const unsigned char *>(bgra_source); // BGRA
-	auto rgb = static_cast<unsigned char *>(rgb_dest); // RGB
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// bgra source - rgb dest
-			*(rgb + 0) = *(bgra + 2); // red
-			*(rgb + 1) = *(bgra + 1); // grn
-			*(rgb + 2) = *(bgra + 0); // blu
-			rgb += 3;
-			bgra += 4;
-		}
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
-	}
-
+	ConvertRows(m_pKernels->rgba_bgr, bgra_source, rgb_dest, width, height, width * 4, width * 3, bInvert);
 } // end bgra2rgb
 
 
 void spoutCopy::bgra2bgr(const void *bgra_source, void *bgr_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	const unsigned long bgrsize = width * height * 3;
-	const unsigned long bgrpitch = width * 3;
-
-	// Start of buffers
-	auto bgra = static_cast<const unsigned char *>(bgra_source); // BGRA
-	auto bgr = static_cast<unsigned char *>(bgr_dest); // BGR
-	if (bInvert) {
-		bgr += bgrsize; // end of bgr buffer
-		bgr -= bgrpitch; // beginning of the last bgr line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// bgra source - bgr dest
-			*(bgr + 2) = *(bgra + 2); // red
-			*(bgr + 1) = *(bgra + 1); // grn
-			*(bgr + 0) = *(bgra + 0); // blu
-			bgr += 3;
-			bgra += 4;
-		}
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
-	}
+	ConvertRows(m_pKernels->rgba_rgb, bgra_source, bgr_dest, width, height, width * 4, width * 3, bInvert);
 } // end bgra2bgr
 
 
 void spoutCopy::rgba2rgba(const void* rgba_source, void* rgba_dest,
 	unsigned int width, unsigned int height, unsigned int sourcePitch, bool bInvert) const
 {
-	for (unsigned int y = 0; y < height; y++) {
-		// Start of buffer
-		auto source = static_cast<const unsigned __int32 *>(rgba_source); // unsigned int = 4 bytes
-		auto dest   = static_cast<unsigned __int32 *>(rgba_dest);
-		// Increment to current line
-		// pitch is line length in bytes. Divide by 4 to get the width in rgba pixels.
-		if (bInvert) {
-			source += (unsigned long)((height - 1 - y)*sourcePitch/4);
-			dest   += (unsigned long)(y * width); // dest is not inverted
-		}
-		else {
-			source += (unsigned long)(y * sourcePitch/4);
-			dest   += (unsigned long)(y * width);
-		}
-		// Copy the line as fast as possible
-		CopyPixels((const unsigned char *)source, (unsigned char *)dest, width, 1);
-	}
+	rgba2rgba(rgba_source, rgba_dest, width, height, sourcePitch, width * 4, bInvert);
 }
 
 void spoutCopy::rgba2rgba(const void* rgba_source, void* rgba_dest,
 	unsigned int width, unsigned int height,
 	unsigned int sourcePitch, unsigned int destPitch, bool bInvert) const
 {
+	// Stream if the whole image is larger than the cache
+	const bool bStream = (size_t)width * 4 * height >= m_StreamBytes;
 	// For all rows
-	for (unsigned int y = 0; y < height; y++) {
-		// Start of buffers
-		auto source = static_cast<const unsigned __int32 *>(rgba_source); // unsigned int = 4 bytes
-		auto dest   = static_cast<unsigned __int32 *>(rgba_dest);
-		// Increment to current line
-		// Pitch is line length in bytes. Divide by 4 to get the width in rgba pixels.
-		if (bInvert) {
-			source += (unsigned long)((height - 1 - y)*sourcePitch / 4);
-			dest   += (unsigned long)(y * destPitch / 4); // dest is not inverted
-		}
-		else {
-			source += (unsigned long)(y * sourcePitch / 4);
-			dest   += (unsigned long)(y * destPitch / 4);
+	ForEachStripe(height, (size_t)sourcePitch + destPitch, [&](unsigned int y0, unsigned int y1) {
+		for (unsigned int y = y0; y < y1; y++) {
+			// Start of buffers
+			auto source = static_cast<const unsigned char *>(rgba_source);
+			auto dest   = static_cast<unsigned char *>(rgba_dest);
+			// Increment to current line
+			// Pitch is line length in bytes.
+			if (bInvert) {
+				source += (size_t)(height - 1 - y) * sourcePitch;
+				dest   += (size_t)y * destPitch; // dest is not inverted
+			}
+			else {
+				source += (size_t)y * sourcePitch;
+				dest   += (size_t)y * destPitch;
+			}
+			// Copy the line as fast as possible
+			CopyBlock(dest, source, (size_t)width * 4, bStream);
 		}
-		// Copy the line as fast as possible
-		CopyPixels((const unsigned char *)source, (unsigned char *)dest, width, 1);
-	}
+	});
 }
 
-// Adapted from :
+//
+// Resample functions
+//
+// Originally nearest neighbour, adapted from :
 // http://tech-algorithm.com/articles/nearest-neighbor-image-scaling/
 // http://www.cplusplus.com/forum/general/2615/#msg10482
+//
+// Now use the filter selected by SetResampleFilter. See SpoutResample.cpp
+//
 void spoutCopy::rgba2rgbaResample(const void* source, void* dest,
 	unsigned int sourceWidth, unsigned int sourceHeight, unsigned int sourcePitch,
 	unsigned int destWidth, unsigned int destHeight, bool bInvert) const
 {
-	unsigned char *srcBuffer = (unsigned char *)source; // bgra source
-	unsigned char *dstBuffer = (unsigned char *)dest; // bgr dest
-
-	// horizontal and vertical ratios between the original image and the to be scaled image
-	float x_ratio = (float)sourceWidth / (float)destWidth;
-	float y_ratio = (float)sourceHeight / (float)destHeight;
-	float px, py;
-	unsigned int i, j;
-	unsigned int pixel, nearestMatch;
-	for (i = 0; i < destHeight; i++) {
-		for (j = 0; j < destWidth; j++) {
-			px = floor((float)j*x_ratio);
-			py = floor((float)i*y_ratio);
-			if (bInvert)
-				pixel = (destHeight - i - 1)*destWidth * 4 + j * 4; // flip vertically
-			else
-				pixel = i * destWidth * 4 + j * 4;
-			nearestMatch = (unsigned int)(py*sourcePitch + px * 4);
-			dstBuffer[pixel + 0] = srcBuffer[nearestMatch + 0];
-			dstBuffer[pixel + 1] = srcBuffer[nearestMatch + 1];
-			dstBuffer[pixel + 2] = srcBuffer[nearestMatch + 2];
-			dstBuffer[pixel + 3] = srcBuffer[nearestMatch + 3];
-		}
-	}
+	Resample(source, dest, sourceWidth, sourceHeight, sourcePitch,
+		destWidth, destHeight, destWidth * 4, nullptr, nullptr, bInvert, false);
 }
 
+void spoutCopy::rgba2rgbaResample(const void* source, void* dest,
+	unsigned int sourceWidth, unsigned int sourceHeight, unsigned int sourcePitch,
+	unsigned int destWidth, unsigned int destHeight, unsigned int destPitch,
+	bool bInvert) const
+{
+	Resample(source, dest, sourceWidth, sourceHeight, sourcePitch,
+		destWidth, destHeight, destPitch, nullptr, nullptr, bInvert, false);
+}
 
 void spoutCopy::rgba2rgbResample(const void* source, void* dest,
 	unsigned int sourceWidth, unsigned int sourceHeight, unsigned int sourcePitch,
 	unsigned int destWidth, unsigned int destHeight, bool bInvert, bool bMirror, bool bSwapRB) const
 {
-	unsigned char *srcBuffer = (unsigned char *)source; // bgra source
-	unsigned char *dstBuffer = (unsigned char *)dest; // bgr dest
-
-	float x_ratio = (float)sourceWidth / (float)destWidth;
-	float y_ratio = (float)sourceHeight / (float)destHeight;
-
 	// Swap red and blue option
-	int ir = 0; int ig = 1; int ib = 2;
-	if (bSwapRB) {
-		ir = 2; ib = 0;
-	}
+	Resample(source, dest, sourceWidth, sourceHeight, sourcePitch,
+		destWidth, destHeight, destWidth * 3,
+		nullptr, bSwapRB ? m_pKernels->rgba_bgr : m_pKernels->rgba_rgb, bInvert, bMirror);
+}
 
-	float px, py;
-	unsigned int i, j;
-	unsigned int pixel, nearestMatch;
-	for (i = 0; i < destHeight; i++) {
-		for (j = 0; j < destWidth; j++) {
-			px = floor((float)j*x_ratio);
-			py = floor((float)i*y_ratio);
-
-			if (bMirror) {
-				if (bInvert)
-					pixel = (destHeight - i - 1)*destWidth * 3 + (destWidth - j - 1) * 3; // flip vertically
-				else
-					pixel = i * destWidth * 3 + (destWidth - j - 1) * 3;
-			}
-			else {
-				if (bInvert)
-					pixel = (destHeight - i - 1)*destWidth * 3 + j * 3; // flip vertically
-				else
-					pixel = i * destWidth * 3 + j * 3;
-			}
+void spoutCopy::rgba2bgrResample(const void* source, void* dest,
+	unsigned int sourceWidth, unsigned int sourceHeight, unsigned int sourcePitch,
+	unsigned int destWidth, unsigned int destHeight, bool bInvert) const
+{
+	Resample(source, dest, sourceWidth, sourceHeight, sourcePitch,
+		destWidth, destHeight, destWidth * 3, nullptr, m_pKernels->rgba_bgr, bInvert, false);
+}
 
-			nearestMatch = (unsigned int)(py*sourcePitch + px * 4);
+void spoutCopy::SetResampleFilter(SpoutResampleFilter filter)
+{
+	m_ResampleFilter = filter;
+}
 
-			dstBuffer[pixel + ir] = srcBuffer[nearestMatch + 0];
-			dstBuffer[pixel + ig] = srcBuffer[nearestMatch + 1];
-			dstBuffer[pixel + ib] = srcBuffer[nearestMatch + 2];
-		}
-	}
+SpoutResampleFilter spoutCopy::GetResampleFilter() const
+{
+	return m_ResampleFilter;
 }
 
-void spoutCopy::rgba2bgrResample(const void* source, void* dest,
+//
+// Resample 4 byte pixels in stripes of destination lines.
+//
+// Nearest copies the source pixels directly.
+// For bilinear and area, the source lines used by each destination line
+// are combined vertically, then resampled horizontally.
+//
+// Source lines that need conversion are converted once into a ring of
+// lines for each stripe. Each source line is used by consecutive
+// destination lines, so a ring one longer than the vertical taps
+// keeps every line of the current window.
+//
+void spoutCopy::Resample(const void *source, void *dest,
 	unsigned int sourceWidth, unsigned int sourceHeight, unsigned int sourcePitch,
-	unsigned int destWidth, unsigned int destHeight, bool bInvert) const
+	unsigned int destWidth, unsigned int destHeight, unsigned int destPitch,
+	SpoutRowKernel sourceKernel, SpoutRowKernel kernel, bool bInvert, bool bMirror,
+	SpoutRowKernel sourceAlpha, SpoutRowKernel destAlpha, bool bFloat) const
 {
-	unsigned char *srcBuffer = (unsigned char *)source; // bgra source
-	unsigned char *dstBuffer = (unsigned char *)dest; // bgr dest
-
-	float x_ratio = (float)sourceWidth / (float)destWidth;
-	float y_ratio = (float)sourceHeight / (float)destHeight;
-	float px, py;
-	unsigned int i, j;
-	unsigned int pixel, nearestMatch;
-	for (i = 0; i < destHeight; i++) {
-		for (j = 0; j < destWidth; j++) {
-			px = std::floor((float)j*x_ratio);
-			py = std::floor((float)i*y_ratio);
-			if (bInvert)
-				pixel = (destHeight - i - 1)*destWidth * 3 + j * 3; // flip vertically
-			else
-				pixel = i * destWidth * 3 + j * 3;
-			nearestMatch = (unsigned int)(py*sourcePitch + px * 4);
-			dstBuffer[pixel + 2] = srcBuffer[nearestMatch + 0];
-			dstBuffer[pixel + 1] = srcBuffer[nearestMatch + 1];
-			dstBuffer[pixel + 0] = srcBuffer[nearestMatch + 2];
+	if (!source || !dest || sourceWidth == 0 || sourceHeight == 0 || destWidth == 0 || destHeight == 0)
+		return;
+
+	const SpoutResampleFilter filter = m_ResampleFilter;
+	const std::shared_ptr<const spoutResampleAxis> axisX = spoutresample::GetAxis(filter, sourceWidth, destWidth, bMirror);
+	const std::shared_ptr<const spoutResampleAxis> axisY = spoutresample::GetAxis(filter, sourceHeight, destHeight);
+	const unsigned char *src = static_cast<const unsigned char *>(source);
+	unsigned char *dst = static_cast<unsigned char *>(dest);
+	const unsigned int pixelBytes = bFloat ? 16 : 4;
+	const size_t rowBytes = (size_t)destWidth * pixelBytes;
+	const size_t sourceBytes = (size_t)sourceWidth * pixelBytes;
+	const SpoutCopyTier tier = m_pKernels->tier;
+	const unsigned int tapsX = axisX->taps;
+	const unsigned int tapsY = axisY->taps;
+
+	// Source bytes read for each destination line
+	const size_t readBytes = (size_t)sourcePitch * (sourceHeight + destHeight - 1) / destHeight;
+
+	// Lines past the end of a source smaller than the taps have zero weight
+	std::vector<unsigned char> zeroLine(sourceHeight < tapsY ? sourceBytes : 0);
+
+	ForEachStripe(destHeight, readBytes + destPitch, [&](unsigned int y0, unsigned int y1) {
+		// Converted source lines
+		const unsigned int slots = (sourceKernel || sourceAlpha) ? tapsY + 1 : 0;
+		std::vector<unsigned char> ring(slots * sourceBytes);
+		std::vector<unsigned int> ringLine(slots, UINT_MAX);
+		auto sourceLine = [&](unsigned int r) -> const unsigned char * {
+			if (r >= sourceHeight)
+				return zeroLine.data();
+			const unsigned char *s = src + (size_t)r * sourcePitch;
+			if (slots == 0)
+				return s;
+			const unsigned int slot = r % slots;
+			unsigned char *line = ring.data() + slot * sourceBytes;
+			if (ringLine[slot] != r) {
+				if (sourceKernel)
+					sourceKernel(s, line, sourceWidth);
+				else
+					memcpy(line, s, sourceBytes);
+				if (sourceAlpha)
+					sourceAlpha(line, line, sourceWidth);
+				ringLine[slot] = r;
+			}
+			return line;
+		};
+
+		// Line for conversion to the destination format
+		std::vector<unsigned char> line(kernel ? rowBytes : 0);
+
+		if (filter == SPOUT_RESAMPLE_NEAREST) {
+			for (unsigned int y = y0; y < y1; y++) {
+				unsigned char *d = dst + (size_t)(bInvert ? destHeight - 1 - y : y) * destPitch;
+				unsigned char *rgba = kernel ? line.data() : d;
+				spoutresample::NearestRow(*axisX, sourceLine(axisY->first[y]), rgba, pixelBytes);
+				if (kernel)
+					kernel(rgba, d, destWidth);
+				if (destAlpha)
+					destAlpha(d, d, destWidth);
+			}
+			return;
 		}
-	}
-}
 
+		std::vector<const unsigned char *> rows(tapsY);
+		// Vertical pass result. At least "taps" pixels for the horizontal pass.
+		const size_t verticalCount = (size_t)(sourceWidth > tapsX ? sourceWidth : tapsX) * 4;
+		std::vector<int16_t> vertical(bFloat ? 0 : verticalCount);
+		std::vector<float> verticalFloat(bFloat ? verticalCount : 0);
+		for (unsigned int y = y0; y < y1; y++) {
+			const unsigned int first = axisY->first[y];
+			for (unsigned int t = 0; t < tapsY; t++)
+				rows[t] = sourceLine(first + t);
+			const int16_t *weights = axisY->weights.data() + (size_t)y * tapsY;
+			unsigned char *d = dst + (size_t)(bInvert ? destHeight - 1 - y : y) * destPitch;
+			unsigned char *rgba = kernel ? line.data() : d;
+			if (bFloat) {
+				spoutresample::VerticalRowFloat(reinterpret_cast<const float *const *>(rows.data()), weights,
+					tapsY, sourceWidth * 4, verticalFloat.data(), tier);
+				spoutresample::HorizontalRowFloat(*axisX, verticalFloat.data(), reinterpret_cast<float *>(rgba), tier);
+			}
+			else {
+				spoutresample::VerticalRow(rows.data(), weights, tapsY, sourceWidth * 4, vertical.data(), tier);
+				spoutresample::HorizontalRow(*axisX, vertical.data(), rgba, tier);
+			}
+			if (kernel)
+				kernel(rgba, d, destWidth);
+			if (destAlpha)
+				destAlpha(d, d, destWidth);
+		}
+	});
+}
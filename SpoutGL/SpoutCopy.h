@@ -34,14 +34,196 @@
 #define __spoutCopy__
 
 #include "SpoutCommon.h"
+#if defined(_WIN32)
 #include <windows.h>
-#include <stdio.h> // for debug printf
 #include <gl/gl.h> // For OpenGL definitions
 #include <intrin.h> // for cpuid to test for SSE2
+#else
+#include <GL/gl.h> // For OpenGL definitions
+#include <x86intrin.h> // for _rotl
+#endif
+#include <stdio.h> // for debug printf
+#include <stdint.h> // for uint32_t
 #include <emmintrin.h> // for SSE2
 #include <tmmintrin.h> // for SSSE3
+#include <immintrin.h> // for AVX2 and AVX-512
 #include <cmath> // For compatibility with Clang. PR#81
+#include <functional> // for stripe functions
+
+#ifndef GL_BGRA_EXT
+#define GL_BGR_EXT  0x80E0
+#define GL_BGRA_EXT 0x80E1
+#endif
+#ifndef GL_RGBA32F
+#define GL_RGBA32F 0x8814
+#endif
+#ifndef GL_RGBA16F
+#define GL_RGBA16F 0x881A
+#endif
+
+//
+// Instruction set tiers for the pixel conversion dispatch table.
+// The highest tier supported by the CPU is detected once per process.
+//
+enum SpoutCopyTier {
+	SPOUT_COPY_SCALAR = 0,
+	SPOUT_COPY_SSE2,
+	SPOUT_COPY_SSSE3,
+	SPOUT_COPY_AVX2,
+	SPOUT_COPY_AVX512,
+	SPOUT_COPY_TIER_COUNT
+};
+
+//
+// Compiler specific support for the dispatch table.
+//
+// MSVC allows any intrinsic without compiler flags.
+// GCC and Clang need the instruction set enabled per function.
+//
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SPOUT_TARGET_SSSE3
+#define SPOUT_TARGET_AVX2
+#define SPOUT_TARGET_AVX512
+#define SPOUT_TARGET_F16C
+#else
+#define SPOUT_TARGET_SSSE3  __attribute__((target("ssse3")))
+#define SPOUT_TARGET_AVX2   __attribute__((target("avx2")))
+#define SPOUT_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#define SPOUT_TARGET_F16C   __attribute__((target("f16c")))
+#endif
+
+// Filters for the resample functions
+enum SpoutResampleFilter {
+	SPOUT_RESAMPLE_NEAREST = 0, // Nearest source pixel
+	SPOUT_RESAMPLE_BILINEAR,    // Linear between the two nearest pixels
+	SPOUT_RESAMPLE_AREA         // Average of all source pixels covered (box)
+};
+
+// Four channel formats for high bit depth conversion
+enum SpoutRGBAFormat {
+	SPOUT_RGBA8 = 0, // 8 bit unsigned normalized
+	SPOUT_RGBA16,    // 16 bit unsigned normalized
+	SPOUT_RGBA16F,   // 16 bit half float
+	SPOUT_RGBA32F,   // 32 bit float
+	SPOUT_RGBA_FORMAT_COUNT
+};
+
+// Transfer functions for ApplyTransfer (see SpoutTransfer.cpp)
+enum SpoutTransferFunction {
+	SPOUT_TRANSFER_LINEAR = 0,
+	SPOUT_TRANSFER_SRGB,   // IEC 61966-2-1
+	SPOUT_TRANSFER_REC709, // ITU-R BT.709
+	SPOUT_TRANSFER_PQ,     // SMPTE ST 2084, linear 1.0 is 10000 cd/m2
+	SPOUT_TRANSFER_HLG,    // ITU-R BT.2100 hybrid log-gamma, scene linear
+	SPOUT_TRANSFER_COUNT
+};
+
+// YUV formats for YUVToRGBA and RGBAToYUV (see SpoutYUV.cpp)
+enum SpoutYUVFormat {
+	SPOUT_YUV_NV12 = 0, // 8 bit 4:2:0, Y plane followed by a CbCr plane
+	SPOUT_YUV_P010,     // 10 bit 4:2:0 in the high bits of 16 bit words, planes as NV12
+	SPOUT_YUV_UYVY,     // 8 bit 4:2:2, Cb Y0 Cr Y1
+	SPOUT_YUV_V210,     // 10 bit 4:2:2, 6 pixels in 16 bytes, 128 byte aligned lines
+	SPOUT_YUV_FORMAT_COUNT
+};
+
+// YUV colour matrix
+enum SpoutYUVMatrix {
+	SPOUT_YUV_BT601 = 0, // Standard definition
+	SPOUT_YUV_BT709,     // High definition
+	SPOUT_YUV_BT2020,    // Ultra high definition, non-constant luminance
+	SPOUT_YUV_MATRIX_COUNT
+};
+
+// Dither for DitherRGBA (see SpoutDither.cpp)
+enum SpoutDitherMethod {
+	SPOUT_DITHER_NONE = 0,   // Round to nearest
+	SPOUT_DITHER_BAYER,      // 8x8 ordered dither
+	SPOUT_DITHER_BLUE_NOISE, // 64x64 blue noise tile
+	SPOUT_DITHER_METHOD_COUNT
+};
+
+// How alpha is stored (see SpoutAlpha.cpp)
+enum SpoutAlphaMode {
+	SPOUT_ALPHA_STRAIGHT = 0,  // Colour independent of alpha
+	SPOUT_ALPHA_PREMULTIPLIED, // Colour multiplied by alpha
+	SPOUT_ALPHA_IGNORED        // rgbx and bgrx, alpha is undefined
+};
+
+// Alpha operation for ApplyAlpha
+enum SpoutAlphaOp {
+	SPOUT_ALPHA_OP_NONE = 0,
+	SPOUT_ALPHA_OP_PREMULTIPLY,   // Multiply colour by alpha
+	SPOUT_ALPHA_OP_UNPREMULTIPLY, // Divide colour by alpha
+	SPOUT_ALPHA_OP_OPAQUE,        // Set alpha to the maximum
+	SPOUT_ALPHA_OP_COUNT
+};
+
+// Rotations for Rotate (see SpoutRotate.cpp)
+enum SpoutRotation {
+	SPOUT_ROTATE_NONE = 0,
+	SPOUT_ROTATE_90,   // Clockwise
+	SPOUT_ROTATE_180,
+	SPOUT_ROTATE_270,  // Counter-clockwise
+	SPOUT_TRANSPOSE,   // Top left to bottom right diagonal
+	SPOUT_TRANSVERSE,  // Top right to bottom left diagonal
+	SPOUT_ROTATION_COUNT
+};
+
+// Convert one line of "width" pixels from src to dst
+typedef void (*SpoutRowKernel)(const unsigned char *src, unsigned char *dst, unsigned int width);
+
+//
+// Line conversion functions for one instruction set tier.
+// Tiers without a specific version of a conversion use
+// the widest lower tier version.
+//
+struct SpoutCopyKernels {
+	SpoutCopyTier tier;
+	const char *name;
+	SpoutRowKernel rgba_bgra; // rgba <> bgra
+	SpoutRowKernel rgb_rgba;  // rgb > rgba, bgr > bgra, alpha 255
+	SpoutRowKernel rgb_bgra;  // rgb > bgra, bgr > rgba, alpha 255
+	SpoutRowKernel rgb_rgbx;  // rgb > rgba, bgr > bgra, dest alpha unchanged
+	SpoutRowKernel rgb_bgrx;  // rgb > bgra, bgr > rgba, dest alpha unchanged
+	SpoutRowKernel rgba_rgb;  // rgba > rgb, bgra > bgr
+	SpoutRowKernel rgba_bgr;  // rgba > bgr, bgra > rgb
+};
+
+//
+// Pixel buffer layout for spoutCopy::Convert.
+// Lines and pixels are reversed when bInvert or bMirror
+// are different for the source and destination.
+// Alpha is premultiplied, unpremultiplied or made opaque
+// when the alpha modes are different.
+//
+struct SpoutPixelDesc {
+	GLenum format;      // GL_RGBA, GL_RGBA8, GL_BGRA_EXT, GL_RGB, GL_BGR_EXT,
+	                    // GL_RGBA16, GL_RGBA16F or GL_RGBA32F
+	unsigned int width;
+	unsigned int height;
+	unsigned int pitch; // Bytes per line. 0 for no padding.
+	bool bInvert;       // Lines from the bottom up
+	bool bMirror;       // Pixels from right to left
+	bool bKeepAlpha;    // Destination alpha is not changed for a source without alpha
+	                    // of the same size (see Convert)
+	SpoutAlphaMode alpha; // Straight, premultiplied or ignored
+	SpoutPixelDesc(GLenum glFormat = GL_RGBA, unsigned int w = 0, unsigned int h = 0, unsigned int linePitch = 0)
+		: format(glFormat), width(w), height(h), pitch(linePitch),
+		bInvert(false), bMirror(false), bKeepAlpha(false), alpha(SPOUT_ALPHA_STRAIGHT) {}
+};
+
+// Rectangle of an image in pixels from the top left as shown
+struct SpoutRegion {
+	unsigned int x;
+	unsigned int y;
+	unsigned int width;
+	unsigned int height;
+	SpoutRegion(unsigned int left = 0, unsigned int top = 0, unsigned int w = 0, unsigned int h = 0)
+		: x(left), y(top), width(w), height(h) {}
+};
 
+class spoutLut;
 
 class SPOUT_DLLEXP spoutCopy {
 
@@ -60,9 +242,15 @@ class SPOUT_DLLEXP spoutCopy {
 						unsigned int width, unsigned int height,
 						GLenum glFormat = GL_RGBA) const;
 
-		// SSE2 version of memcpy
+		// SSE2 version of memcpy for any size and alignment.
+		// Uses non-temporal stores for copies larger than the stream threshold.
 		void memcpy_sse2(void* dst, const void* src, size_t size) const;
 
+		// Copy size in bytes above which non-temporal stores are used.
+		// Half the last level cache by default. 0 streams all copies.
+		void SetStreamThreshold(size_t bytes);
+		size_t GetStreamThreshold() const;
+
 		// Copy rgba buffers line by line allowing for source pitch using the fastest method
 		void rgba2rgba(const void* source, void* dest, unsigned int width, unsigned int height,
 			unsigned int sourcePitch, bool bInvert = false) const;
@@ -76,6 +264,143 @@ class SPOUT_DLLEXP spoutCopy {
 			unsigned int sourceWidth, unsigned int sourceHeight, unsigned int sourcePitch,
 			unsigned int destWidth, unsigned int destHeight, bool bInvert = false) const;
 
+		// Copy rgba buffers of differing size allowing for destination pitch
+		void rgba2rgbaResample(const void* source, void* dest,
+			unsigned int sourceWidth, unsigned int sourceHeight, unsigned int sourcePitch,
+			unsigned int destWidth, unsigned int destHeight, unsigned int destPitch,
+			bool bInvert) const;
+
+		// Convert between any two pixel layouts. rgb and bgr are
+		// converted to and from 8 bit rgba and bgra only.
+		// If the sizes are different, the source is resampled with the
+		// filter selected by SetResampleFilter in the same pass. Each source
+		// line is read and each destination line written once. 8 bit pixels
+		// are resampled at 8 bit precision. If either format is 16 bit or
+		// floating point, pixels are resampled as float.
+		// bKeepAlpha of the destination keeps its alpha for an rgb or bgr
+		// source of the same size. Resampling writes the whole pixel, so
+		// Convert returns false for bKeepAlpha with a change of size.
+		// A change of alpha mode is made in the same pass. Premultiply is
+		// before resampling and unpremultiply after. There is no change
+		// for rgb and bgr destinations.
+		// bSwapRB swaps red and blue in addition to any change of order.
+		// Returns false for an unsupported conversion.
+		bool Convert(const void* source, const SpoutPixelDesc& sourceDesc,
+			void* dest, const SpoutPixelDesc& destDesc, bool bSwapRB = false) const;
+
+		// Convert a region of the source with Convert, e.g. the part of a
+		// large canvas clipped for one output. Only the lines and pixels of
+		// the region are read. It is copied if it is the destination size
+		// and resampled otherwise. The region is clipped to the source and
+		// measured from the top left of the image as shown, allowing for
+		// bInvert and bMirror of the source.
+		// Returns false if the region is outside the source.
+		bool ConvertRegion(const void* source, const SpoutPixelDesc& sourceDesc,
+			const SpoutRegion& region, void* dest, const SpoutPixelDesc& destDesc,
+			bool bSwapRB = false) const;
+
+		// Convert between 8 bit, 16 bit and floating point rgba pixels
+		// allowing for source and destination pitch (0 for no padding).
+		// Formats : GL_RGBA, GL_RGBA8, GL_BGRA_EXT, GL_RGBA16, GL_RGBA16F, GL_RGBA32F
+		// Red and blue are swapped between GL_BGRA_EXT and the other formats, and by bSwapRB.
+		// Returns false for an unsupported format.
+		bool ConvertRGBA(const void* source, void* dest, unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch,
+			GLenum sourceFormat, GLenum destFormat,
+			bool bInvert = false, bool bSwapRB = false) const;
+
+		// Grade rgba pixels with a 3D LUT (see SpoutLut.h)
+		// allowing for source and destination pitch (0 for no padding).
+		// Formats : GL_RGBA, GL_RGBA8, GL_BGRA_EXT, GL_RGBA16, GL_RGBA32F
+		// Source and destination can be the same if not inverted.
+		// Returns false for an unsupported format or if the LUT is not loaded.
+		bool ApplyLut(const spoutLut &lut, const void* source, void* dest,
+			unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch,
+			GLenum glFormat, bool bInvert = false) const;
+
+		// Convert rgba pixels from one transfer function to another,
+		// e.g. sRGB to linear, linear to PQ or sRGB to HLG,
+		// allowing for source and destination pitch (0 for no padding).
+		// Formats : GL_RGBA, GL_RGBA8, GL_BGRA_EXT, GL_RGBA16, GL_RGBA16F, GL_RGBA32F
+		// Values are clamped to 0-1 and alpha is not changed.
+		// Source and destination can be the same if not inverted.
+		bool ApplyTransfer(const void* source, void* dest,
+			unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch, GLenum glFormat,
+			SpoutTransferFunction sourceTransfer, SpoutTransferFunction destTransfer,
+			bool bInvert = false) const;
+
+		// Convert YUV to rgba pixels (SpoutYUV.cpp).
+		// sourcePitch is the line pitch of the YUV frame. For NV12 and P010
+		// the CbCr plane follows the Y plane with the same pitch.
+		// 0 for no padding (see spoutyuv::LinePitch).
+		// Limited range is 16-235 for 8 bit Y, or full range 0-255.
+		// rgba formats : GL_RGBA, GL_RGBA8, GL_BGRA_EXT, GL_RGBA16, GL_RGBA32F
+		// Use GL_RGBA16 to keep the precision of 10 bit formats.
+		bool YUVToRGBA(const void* source, void* dest,
+			unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch,
+			SpoutYUVFormat yuvFormat, GLenum rgbaFormat,
+			SpoutYUVMatrix matrix = SPOUT_YUV_BT709, bool bFullRange = false,
+			bool bInvert = false) const;
+		// Convert rgba to YUV pixels. Alpha is not used.
+		bool RGBAToYUV(const void* source, void* dest,
+			unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch,
+			GLenum rgbaFormat, SpoutYUVFormat yuvFormat,
+			SpoutYUVMatrix matrix = SPOUT_YUV_BT709, bool bFullRange = false,
+			bool bInvert = false) const;
+
+		// Convert 16 bit, half or float rgba to 8 bit rgba or bgra
+		// with dither to prevent banding (SpoutDither.cpp).
+		// The pattern is varied by frame number and is the same
+		// for the same frame number and size.
+		// Source formats : GL_RGBA16, GL_RGBA16F, GL_RGBA32F
+		// Destination formats : GL_RGBA, GL_RGBA8, GL_BGRA_EXT
+		bool DitherRGBA(const void* source, void* dest,
+			unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch,
+			GLenum sourceFormat, GLenum destFormat,
+			SpoutDitherMethod method = SPOUT_DITHER_BLUE_NOISE,
+			unsigned int frame = 0, bool bInvert = false) const;
+
+		// Premultiply, unpremultiply or make alpha opaque (SpoutAlpha.cpp)
+		// allowing for source and destination pitch (0 for no padding).
+		// Formats : GL_RGBA, GL_RGBA8, GL_BGRA_EXT, GL_RGBA16, GL_RGBA16F, GL_RGBA32F
+		// Source and destination can be the same if not inverted.
+		// Use Convert to change the alpha mode with a change of format.
+		bool ApplyAlpha(const void* source, void* dest,
+			unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch,
+			GLenum glFormat, SpoutAlphaOp op, bool bInvert = false) const;
+
+		// Rotate or transpose 4 and 8 byte pixels (SpoutRotate.cpp)
+		// allowing for source and destination pitch (0 for no padding).
+		// Width and height are the source size. The destination is height x width
+		// for 90 and 270 degrees, transpose and transverse.
+		// Formats : GL_RGBA, GL_RGBA8, GL_BGRA_EXT, GL_RGBA16, GL_RGBA16F
+		// Source and destination must be different.
+		bool Rotate(const void* source, void* dest,
+			unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch,
+			GLenum glFormat, SpoutRotation rotation) const;
+
+		// Downsample to 8 bit rgba thumbnails (SpoutThumbnail.cpp)
+		// "levels" destinations of 1/2, 1/4, 1/8 ... the source size, each
+		// half the width and height of the one before rounded up and at least 1,
+		// without padding (see spoutthumbnail::HalfSize).
+		// Each pixel is the average of 2 x 2 pixels of the level before.
+		// Source formats : any supported by Convert
+		bool Downsample(const void* source, unsigned int width, unsigned int height,
+			unsigned int sourcePitch, GLenum sourceFormat,
+			unsigned char* const* dest, unsigned int levels, bool bInvert = false) const;
+
+		// Filter used by the resample functions. Bilinear by default.
+		// Area is best for reducing by more than half.
+		void SetResampleFilter(SpoutResampleFilter filter);
+		SpoutResampleFilter GetResampleFilter() const;
+
 		// Copy rgba to bgra
 		void rgba2bgra(const void* rgba_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert = false) const;
 		
@@ -138,12 +463,72 @@ class SPOUT_DLLEXP spoutCopy {
 			unsigned int sourceWidth, unsigned int sourceHeight, unsigned int sourcePitch,
 			unsigned int destWidth, unsigned int destHeight, bool bInvert = false) const;
 
+		// Instruction set tier used by this object
+		SpoutCopyTier GetCopyTier() const;
+		// Select a tier up to the highest supported by the CPU
+		bool SetCopyTier(SpoutCopyTier tier);
+		// Highest tier supported by the CPU
+		static SpoutCopyTier GetSupportedTier();
+		// Bytes per pixel of a supported GL format, 0 if not supported
+		static unsigned int GetPixelBytes(GLenum glFormat);
+		// Line conversion functions for a tier
+		static const SpoutCopyKernels *GetKernels(SpoutCopyTier tier);
+		// Line conversion between 3 and 4 byte pixels for a tier.
+		// bAlpha sets the alpha of a 4 byte destination from a 3 byte source
+		// to 255, otherwise the existing destination alpha is not changed.
+		static SpoutRowKernel GetLineKernel(SpoutCopyTier tier, unsigned int sourceBytes, unsigned int destBytes,
+			bool bSwapRB, bool bMirror = false, bool bAlpha = true);
+
+		// Multi-threaded copy and conversion of large images.
+		// Images are divided into stripes of lines sized for the L2 cache.
+		// nThreads 0 uses all hardware threads. 1 is single threaded (default).
+		// Images smaller than minBytes are always copied by the calling thread.
+		void SetCopyThreads(unsigned int nThreads, unsigned int minBytes = 4194304);
+		unsigned int GetCopyThreads() const;
+
 	protected :
 
 		void CheckSSE();
 		bool m_bSSE2;
 		bool m_bSSE3;
 		bool m_bSSSE3;
+		bool m_bAVX2;
+		bool m_bAVX512;
+		bool m_bF16C;
+		const SpoutCopyKernels *m_pKernels;
+		unsigned int m_nCopyThreads;
+		unsigned int m_MinThreadBytes;
+		size_t m_StreamBytes;
+		SpoutResampleFilter m_ResampleFilter;
+
+		// Copy a block with non-temporal or cached stores
+		void CopyBlock(void* dst, const void* src, size_t size, bool bStream) const;
+
+		// Call function(firstLine, endLine) for stripes of lines, in parallel if enabled.
+		// lineBytes is the number of bytes read and written for each line.
+		void ForEachStripe(unsigned int height, size_t lineBytes,
+			const std::function<void(unsigned int, unsigned int)> &function) const;
+
+		// Convert lines using a conversion function allowing for source and destination pitch.
+		// "alphaKernel" is applied to each destination line after conversion.
+		void ConvertRows(SpoutRowKernel kernel, const void *source, void *dest,
+			unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch, bool bInvert,
+			SpoutRowKernel alphaKernel = nullptr) const;
+
+		// Resample 4 byte pixels in one pass. "sourceKernel" converts each source
+		// line to 4 byte pixels as it is read, or nullptr for a 4 byte source.
+		// "kernel" converts each resampled line to the destination format,
+		// or nullptr for a 4 byte destination.
+		// "sourceAlpha" is applied to the 4 byte source lines before
+		// resampling and "destAlpha" to the destination lines.
+		// bFloat resamples pixels of four floats (GL_RGBA32F) in place of 4 byte pixels.
+		void Resample(const void *source, void *dest,
+			unsigned int sourceWidth, unsigned int sourceHeight, unsigned int sourcePitch,
+			unsigned int destWidth, unsigned int destHeight, unsigned int destPitch,
+			SpoutRowKernel sourceKernel, SpoutRowKernel kernel, bool bInvert, bool bMirror,
+			SpoutRowKernel sourceAlpha = nullptr, SpoutRowKernel destAlpha = nullptr,
+			bool bFloat = false) const;
 
 		void rgba_bgra(const void *rgba_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert = false) const;
 		void rgba_bgra_sse2(const void *rgba_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert = false) const;
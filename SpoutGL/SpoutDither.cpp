@@ -0,0 +1,305 @@
+/*
+
+					SpoutDither.cpp
+
+		Dithered conversion of 16 bit and float pixels to 8 bit
+
+		Each value is scaled to 0-255, a threshold from 0 to 1 is added
+		and the result truncated. The average of the 8 bit values over an
+		area is then the same as the average of the source values, so
+		gradients do not show bands.
+
+		Bayer
+
+		An 8x8 ordered dither matrix. Regular and fast but the pattern
+		can be visible on flat areas.
+
+		Blue noise
+
+		A 64x64 tile generated by the void-and-cluster method (Ulichney 1993)
+		with a Gaussian filter (sigma 1.5) on a wrapped tile. The thresholds
+		have no low frequencies, so the noise is less visible than the Bayer
+		pattern and has no structure. The tile is generated once on first
+		use with integer arithmetic so that it is the same for every build.
+
+		Frames
+
+		The thresholds of each frame are rotated by the golden ratio,
+		threshold = fraction(threshold + frame * 0.618...), so that successive
+		frames use different values at each pixel and the noise averages out
+		over time. The result depends only on the frame number.
+
+		Pixels are converted four at a time with SSE2. Red, green and blue
+		of a pixel use the same threshold and alpha is rounded.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutDither.h"
+#include "SpoutConvert.h"
+#include <string.h>
+#include <cmath>
+#include <vector>
+
+namespace spoutdither {
+
+	static const unsigned char bayer8[8][8] = {
+		{  0, 32,  8, 40,  2, 34, 10, 42 },
+		{ 48, 16, 56, 24, 50, 18, 58, 26 },
+		{ 12, 44,  4, 36, 14, 46,  6, 38 },
+		{ 60, 28, 52, 20, 62, 30, 54, 22 },
+		{  3, 35, 11, 43,  1, 33,  9, 41 },
+		{ 51, 19, 59, 27, 49, 17, 57, 25 },
+		{ 15, 47,  7, 39, 13, 45,  5, 37 },
+		{ 63, 31, 55, 23, 61, 29, 53, 21 },
+	};
+
+	//
+	// Void-and-cluster blue noise
+	//
+	static std::vector<uint16_t> BuildBlueNoise()
+	{
+		const int n = (int)TileSize;
+		const int count = n * n;
+		const int radius = 6;
+
+		// Gaussian filter in fixed point
+		uint32_t kernel[2 * radius + 1][2 * radius + 1];
+		for (int dy = -radius; dy <= radius; dy++) {
+			for (int dx = -radius; dx <= radius; dx++)
+				kernel[dy + radius][dx + radius] = (uint32_t)(65536.0 * std::exp(-(dx * dx + dy * dy) / (2.0 * 1.5 * 1.5)) + 0.5);
+		}
+
+		std::vector<unsigned char> pattern(count, 0);
+		std::vector<uint32_t> energy(count, 0);
+		auto update = [&](int index, bool bAdd) {
+			const int x = index % n;
+			const int y = index / n;
+			for (int dy = -radius; dy <= radius; dy++) {
+				const int row = ((y + dy + n) % n) * n;
+				for (int dx = -radius; dx <= radius; dx++) {
+					uint32_t &e = energy[row + (x + dx + n) % n];
+					if (bAdd)
+						e += kernel[dy + radius][dx + radius];
+					else
+						e -= kernel[dy + radius][dx + radius];
+				}
+			}
+		};
+		// Set pixel with the most energy
+		auto tightestCluster = [&]() {
+			int best = -1;
+			for (int i = 0; i < count; i++) {
+				if (pattern[i] && (best < 0 || energy[i] > energy[best]))
+					best = i;
+			}
+			return best;
+		};
+		// Clear pixel with the least energy
+		auto largestVoid = [&]() {
+			int best = -1;
+			for (int i = 0; i < count; i++) {
+				if (!pattern[i] && (best < 0 || energy[i] < energy[best]))
+					best = i;
+			}
+			return best;
+		};
+
+		// Initial pattern of one tenth of the pixels from a fixed sequence
+		const int ones = count / 10;
+		uint32_t seed = 1;
+		for (int placed = 0; placed < ones; ) {
+			seed = seed * 1664525u + 1013904223u;
+			const int i = (int)((seed >> 8) % (uint32_t)count);
+			if (!pattern[i]) {
+				pattern[i] = 1;
+				update(i, true);
+				placed++;
+			}
+		}
+
+		// Move pixels from the tightest cluster to the largest void
+		// until the pixel removed is the one put back
+		for (int iteration = 0; iteration < count; iteration++) {
+			const int cluster = tightestCluster();
+			pattern[cluster] = 0;
+			update(cluster, false);
+			const int space = largestVoid();
+			pattern[space] = 1;
+			update(space, true);
+			if (space == cluster)
+				break;
+		}
+
+		std::vector<uint16_t> rank(count);
+		const std::vector<unsigned char> prototype = pattern;
+		const std::vector<uint32_t> prototypeEnergy = energy;
+
+		// Ranks below the initial pattern by removing the tightest clusters
+		for (int r = ones - 1; r >= 0; r--) {
+			const int cluster = tightestCluster();
+			pattern[cluster] = 0;
+			update(cluster, false);
+			rank[cluster] = (uint16_t)r;
+		}
+
+		// Ranks above by filling the largest voids. Past half full this
+		// is the same as the tightest cluster of clear pixels, because
+		// the energy of the clear pixels is the filter total less the
+		// energy of the set pixels.
+		pattern = prototype;
+		energy = prototypeEnergy;
+		for (int r = ones; r < count; r++) {
+			const int space = largestVoid();
+			pattern[space] = 1;
+			update(space, true);
+			rank[space] = (uint16_t)r;
+		}
+
+		return rank;
+	}
+
+	const uint16_t *BlueNoiseTile()
+	{
+		static const std::vector<uint16_t> tile = BuildBlueNoise();
+		return tile.data();
+	}
+
+	void GetThresholds(SpoutDitherMethod method, unsigned int frame, unsigned int line, float *thresholds)
+	{
+		// Fraction of frame * golden ratio without loss of precision for large frame numbers
+		const double rotation = std::fmod((double)frame * 0.6180339887498949, 1.0);
+		const uint16_t *tile = (method == SPOUT_DITHER_BLUE_NOISE) ? BlueNoiseTile() : nullptr;
+		for (unsigned int x = 0; x < TileSize; x++) {
+			double t = 0.5;
+			if (method == SPOUT_DITHER_BAYER)
+				t = (bayer8[line & 7][x & 7] + 0.5) / 64.0;
+			else if (method == SPOUT_DITHER_BLUE_NOISE)
+				t = (tile[(line % TileSize) * TileSize + x] + 0.5) / (double)(TileSize * TileSize);
+			if (method != SPOUT_DITHER_NONE) {
+				t += rotation;
+				if (t >= 1.0)
+					t -= 1.0;
+			}
+			thresholds[x] = (float)t;
+		}
+	}
+
+	//
+	// Lines
+	//
+
+	static void DitherScalar(const unsigned char *src, unsigned char *dst, unsigned int width,
+		SpoutRGBAFormat format, const float *thresholds, bool bSwapRB)
+	{
+		const float scale = (format == SPOUT_RGBA16) ? 255.0f / 65535.0f : 255.0f;
+		const int ir = bSwapRB ? 2 : 0;
+		const int ib = bSwapRB ? 0 : 2;
+		for (unsigned int x = 0; x < width; x++) {
+			float v[4];
+			if (format == SPOUT_RGBA16) {
+				uint16_t s[4];
+				memcpy(s, src + (size_t)x * 8, 8);
+				for (int c = 0; c < 4; c++)
+					v[c] = (float)s[c];
+			}
+			else {
+				memcpy(v, src + (size_t)x * 16, 16);
+			}
+			const float t = thresholds[x % TileSize];
+			unsigned char q[4];
+			for (int c = 0; c < 4; c++) {
+				float d = v[c] * scale + (c < 3 ? t : 0.5f);
+				d = (d > 0.0f) ? ((d < 255.0f) ? d : 255.0f) : 0.0f;
+				q[c] = (unsigned char)d;
+			}
+			unsigned char *p = dst + (size_t)x * 4;
+			p[0] = q[ir];
+			p[1] = q[1];
+			p[2] = q[ib];
+			p[3] = q[3];
+		}
+	}
+
+	static void DitherSSE2(const unsigned char *src, unsigned char *dst, unsigned int width,
+		SpoutRGBAFormat format, const float *thresholds, bool bSwapRB)
+	{
+		// Thresholds for the pixels of the tile line
+		__m128 tile[TileSize];
+		for (unsigned int i = 0; i < TileSize; i++)
+			tile[i] = _mm_setr_ps(thresholds[i], thresholds[i], thresholds[i], 0.5f);
+
+		const __m128 scale = _mm_set1_ps((format == SPOUT_RGBA16) ? 255.0f / 65535.0f : 255.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 max = _mm_set1_ps(255.0f);
+		const __m128i zeroi = _mm_setzero_si128();
+		unsigned int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			__m128 p[4];
+			if (format == SPOUT_RGBA16) {
+				const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 8));
+				const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (size_t)x * 8 + 16));
+				p[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zeroi));
+				p[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zeroi));
+				p[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zeroi));
+				p[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zeroi));
+			}
+			else {
+				for (int i = 0; i < 4; i++)
+					p[i] = _mm_loadu_ps(reinterpret_cast<const float *>(src + (size_t)x * 16 + i * 16));
+			}
+			__m128i q[4];
+			for (int i = 0; i < 4; i++) {
+				__m128 d = _mm_add_ps(_mm_mul_ps(p[i], scale), tile[(x + i) % TileSize]);
+				// _mm_max_ps returns the second operand for NaN
+				d = _mm_min_ps(_mm_max_ps(d, zero), max);
+				if (bSwapRB)
+					d = _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 0, 1, 2));
+				q[i] = _mm_cvttps_epi32(d);
+			}
+			const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4), packed);
+		}
+		if (x < width) {
+			// Thresholds continue from x
+			float rest[TileSize];
+			for (unsigned int i = 0; i < TileSize; i++)
+				rest[i] = thresholds[(x + i) % TileSize];
+			DitherScalar(src + (size_t)x * ((format == SPOUT_RGBA16) ? 8 : 16), dst + (size_t)x * 4,
+				width - x, format, rest, bSwapRB);
+		}
+	}
+
+	void DitherLine(const unsigned char *src, unsigned char *dst, unsigned int width,
+		SpoutRGBAFormat format, const float *thresholds, bool bSwapRB, SpoutCopyTier tier,
+		bool bF16C)
+	{
+		if (!src || !dst || !thresholds || width == 0 || format == SPOUT_RGBA8)
+			return;
+
+		if (format == SPOUT_RGBA16F) {
+			// Half to float in blocks of a tile width
+			const SpoutRowKernel toFloat = spoutconvert::GetKernel(SPOUT_RGBA16F, SPOUT_RGBA32F, false, false, tier, bF16C);
+			float block[TileSize * 4];
+			for (unsigned int x = 0; x < width; x += TileSize) {
+				const unsigned int n = (width - x < TileSize) ? width - x : TileSize;
+				toFloat(src + (size_t)x * 8, reinterpret_cast<unsigned char *>(block), n);
+				DitherLine(reinterpret_cast<const unsigned char *>(block), dst + (size_t)x * 4, n,
+					SPOUT_RGBA32F, thresholds, bSwapRB, tier);
+			}
+			return;
+		}
+
+		if (tier == SPOUT_COPY_SCALAR)
+			DitherScalar(src, dst, width, format, thresholds, bSwapRB);
+		else
+			DitherSSE2(src, dst, width, format, thresholds, bSwapRB);
+	}
+
+}
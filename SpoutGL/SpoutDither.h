@@ -0,0 +1,43 @@
+/*
+
+					SpoutDither.h
+
+		Dithered conversion of 16 bit and float pixels to 8 bit
+
+		Ordered Bayer and blue noise thresholds, repeated every 8 or 64
+		pixels and varied by frame number.
+		Use spoutCopy::DitherRGBA to convert an image with multiple threads.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutDither__ // standard way as well
+#define __spoutDither__
+
+#include "SpoutCopy.h"
+
+namespace spoutdither {
+
+	// Size of the repeated threshold tile
+	const unsigned int TileSize = 64;
+
+	// Thresholds from 0 to 1 for a line of the tile, for a method and frame.
+	// "thresholds" has TileSize values.
+	void GetThresholds(SpoutDitherMethod method, unsigned int frame, unsigned int line, float *thresholds);
+
+	// Blue noise rank of each tile pixel from 0 to TileSize*TileSize-1
+	const uint16_t *BlueNoiseTile();
+
+	// Convert a line of 16 bit or float rgba pixels to 8 bit rgba
+	// using thresholds from GetThresholds. bSwapRB for bgra.
+	// bF16C uses the hardware conversion of half float.
+	void DitherLine(const unsigned char *src, unsigned char *dst, unsigned int width,
+		SpoutRGBAFormat format, const float *thresholds, bool bSwapRB, SpoutCopyTier tier,
+		bool bF16C = false);
+
+}
+
+#endif
@@ -54,6 +54,10 @@
 //		27.07.22	- Change "_uuidof" to "__uuidof" in AllowKeyedAccess. PR#84
 //		29.07.22	- Correct "case case" typo in CheckKeyedAccess
 //					  Add case E_FAIL
+//		16.10.26	- Frame number in shared memory (SpoutFrameNotify) published
+//					  by SetNewFrame and read by GetNewFrame with one atomic load
+//					  instead of a semaphore wait and release. Semaphore count
+//					  still used for older senders. Add WaitNewFrame.
 //
 // ====================================================================================
 //
@@ -292,6 +296,13 @@ void spoutFrameCount::EnableFrameCount(const char* SenderName)
 	// Save the handle for access
 	m_hCountSemaphore = hSemaphore;
 
+	// Frame number in shared memory that a receiver can wait on.
+	// Either the sender or receiver can create it.
+	if (m_notify.Create(SenderName))
+		SpoutLogNotice("SpoutFrameCount::EnableFrameCount - frame notifier [%s] enabled", SenderName);
+	else
+		SpoutLogWarning("SpoutFrameCount::EnableFrameCount - frame notifier [%s] not available", SenderName);
+
 }
 
 // -----------------------------------------------
@@ -345,6 +356,8 @@ void spoutFrameCount::SetNewFrame()
 			else {
 				// Increment the sender frame count
 				m_FrameCount++;
+				// Publish the frame and wake receivers waiting for it
+				m_notify.Publish();
 				// Update the sender fps calculations for the new frame
 				UpdateSenderFps(1);
 			}
@@ -386,28 +399,36 @@ bool spoutFrameCount::GetNewFrame()
 		return true;
 	}
 
-	// Access the frame count semaphore
-	DWORD dwWaitResult = WaitForSingleObject(m_hCountSemaphore, 0);
-	switch (dwWaitResult) {
-		case WAIT_OBJECT_0:
-			// Call ReleaseSemaphore with a release count of 1 to return it
-			// to what it was before the wait and record the previous count.
-			// The next time round it will either be the same count because
-			// the receiver released it, or increased because the sender
-			// released and incremented it.
-			if (ReleaseSemaphore(m_hCountSemaphore, 1, &framecount) == false) {
-				SpoutLogError("spoutFrameCount::GetNewFrame - ReleaseSemaphore failed");
-				return true; // do not block
-			}
-			break;
-		case WAIT_ABANDONED :
-			SpoutLogWarning("SpoutFrameCount::GetNewFrame - WAIT_ABANDONED");
-			break;
-		case WAIT_FAILED :
-			SpoutLogWarning("SpoutFrameCount::GetNewFrame - WAIT_FAILED");
-			break;
-		default :
-			break;
+	// The frame number published by the sender is read with one atomic load.
+	// It stays zero for a sender that does not publish to the notifier.
+	const uint64_t published = m_notify.GetFrame();
+	if (published > 0) {
+		framecount = (long)published;
+	}
+	else {
+		// Access the frame count semaphore
+		DWORD dwWaitResult = WaitForSingleObject(m_hCountSemaphore, 0);
+		switch (dwWaitResult) {
+			case WAIT_OBJECT_0:
+				// Call ReleaseSemaphore with a release count of 1 to return it
+				// to what it was before the wait and record the previous count.
+				// The next time round it will either be the same count because
+				// the receiver released it, or increased because the sender
+				// released and incremented it.
+				if (ReleaseSemaphore(m_hCountSemaphore, 1, &framecount) == false) {
+					SpoutLogError("spoutFrameCount::GetNewFrame - ReleaseSemaphore failed");
+					return true; // do not block
+				}
+				break;
+			case WAIT_ABANDONED :
+				SpoutLogWarning("SpoutFrameCount::GetNewFrame - WAIT_ABANDONED");
+				break;
+			case WAIT_FAILED :
+				SpoutLogWarning("SpoutFrameCount::GetNewFrame - WAIT_FAILED");
+				break;
+			default :
+				break;
+		}
 	}
 
 	// Update the global frame count
@@ -441,6 +462,26 @@ bool spoutFrameCount::GetNewFrame()
 }
 
 
+// -----------------------------------------------
+//
+// Wait for the sender to publish a frame after the last received.
+//
+// The receiver thread sleeps until the sender calls SetNewFrame,
+// instead of polling for a new frame. Returns true if there is a
+// new frame to receive, or false after the timeout in msec or if
+// frame counting is not enabled. Always times out for an older
+// sender that does not publish frame numbers.
+//
+bool spoutFrameCount::WaitNewFrame(DWORD dwTimeout)
+{
+	if (!m_bFrameCount || m_bDisabled || !m_notify.IsOpen())
+		return false;
+
+	// INFINITE is the same as spoutFrameNotify::Infinite
+	const uint64_t last = (m_LastFrameCount > 0) ? (uint64_t)m_LastFrameCount : 0;
+	return m_notify.Wait(last, (unsigned int)dwTimeout) > last;
+}
+
 // -----------------------------------------------
 void spoutFrameCount::CleanupFrameCount()
 {
@@ -456,6 +497,7 @@ void spoutFrameCount::CleanupFrameCount()
 	// opened the semaphore it will not be finally closed here.
 	CloseHandle(m_hCountSemaphore);
 	m_hCountSemaphore = NULL;
+	m_notify.Close();
 
 	// Clear the sender name in case the same one opens again
 	m_SenderName[0] = 0;
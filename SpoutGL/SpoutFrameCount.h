@@ -35,6 +35,7 @@
 #include <vector>
 #include "SpoutCommon.h"
 #include "SpoutSharedMemory.h"
+#include "SpoutFrameNotify.h"
 
 
 #include <d3d11.h> // for keyed mutex texture access
@@ -81,6 +82,8 @@ class SPOUT_DLLEXP spoutFrameCount {
 	void SetNewFrame();
 	// Receiver read the semaphore count
 	bool GetNewFrame();
+	// Receiver wait for the sender to publish a new frame
+	bool WaitNewFrame(DWORD dwTimeout = INFINITE);
 	// For class cleanup functions
 	void CleanupFrameCount();
 
@@ -133,6 +136,7 @@ protected:
 	bool m_bIsNewFrame; // received frame is new
 
 	HANDLE m_hCountSemaphore; // semaphore handle
+	spoutFrameNotify m_notify; // frame number in shared memory
 	char m_CountSemaphoreName[256]; // semaphore name
 	char m_SenderName[256]; // sender currently connected to a receiver
 	long m_FrameCount; // sender frame count
@@ -0,0 +1,426 @@
+/*
+
+					SpoutFrameHash.cpp
+
+		Detection of changed frames by a hash of each tile
+
+		Hash
+
+		The accumulate and scramble steps of XXH3 (Yann Collet) on four
+		64 bit lanes. Each 32 bytes of a tile line, with a key for the
+		position in the line, are added to the lanes as
+
+			acc[i] += lo32(data[i] ^ key[i]) * hi32(data[i] ^ key[i])
+			acc[i ^ 1] += data[i]
+
+		and the lanes are scrambled at the end of each tile line so that
+		the hash depends on the order of the lines. The four lanes are
+		then mixed into one 64 bit value. A line that is not a multiple
+		of 32 bytes is completed with zeros.
+
+		The lanes are one AVX2 register or two SSE2 registers and the
+		32 x 32 bit multiplies are _mm_mul_epu32, so the SIMD versions
+		give the same hash as the scalar version. This is not the XXH3
+		hash of the tile and is not for use outside the process.
+
+		Tiles
+
+		The frame is read line by line from top to bottom. Each line adds
+		to the lanes of every tile across, so the pixels are read in order
+		and the state of a row of tiles (32 bytes per tile) stays in the
+		level 1 cache. Rows of tiles are shared between threads.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutFrameHash.h"
+#include "SpoutThreadPool.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+// Keys for 32 stripes of 32 bytes, enough for a tile line of 64 float
+// rgba pixels, and 4 for the scramble at the end of each line
+static const unsigned int spout_hash_stripes = 32;
+
+static const uint64_t spout_prime32_1 = 0x9E3779B1ULL;
+static const uint64_t spout_prime32_3 = 0xC2B2AE3DULL;
+static const uint64_t spout_prime64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t spout_prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t spout_prime64_3 = 0x165667B19E3779F9ULL;
+
+static const uint64_t *spout_hash_keys()
+{
+	// splitmix64 sequence, the same for every build
+	struct Keys {
+		uint64_t key[(spout_hash_stripes + 1) * 4];
+		Keys() {
+			uint64_t x = 0;
+			for (unsigned int i = 0; i < (spout_hash_stripes + 1) * 4; i++) {
+				x += 0x9E3779B97F4A7C15ULL;
+				uint64_t z = x;
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+				key[i] = z ^ (z >> 31);
+			}
+		}
+	};
+	static const Keys keys;
+	return keys.key;
+}
+
+static uint64_t spout_hash_mix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static void spout_hash_init(uint64_t *acc)
+{
+	acc[0] = spout_prime32_3;
+	acc[1] = spout_prime64_1;
+	acc[2] = spout_prime64_2;
+	acc[3] = spout_prime64_3;
+}
+
+static uint64_t spout_hash_final(const uint64_t *acc, unsigned int lineBytes, unsigned int height)
+{
+	uint64_t h = (uint64_t)lineBytes * spout_prime64_1 + (uint64_t)height * spout_prime64_2;
+	for (int i = 0; i < 4; i++)
+		h = spout_hash_mix(h ^ acc[i]);
+	return h;
+}
+
+//
+// One line of every tile across. "state" has 4 lanes for each tile.
+//
+
+static void spout_hash_line_scalar(const unsigned char *line, unsigned int lineBytes,
+	unsigned int tileBytes, uint64_t *state)
+{
+	const uint64_t *keys = spout_hash_keys();
+	const uint64_t *scramble = keys + spout_hash_stripes * 4;
+	for (unsigned int x = 0; x < lineBytes; x += tileBytes, state += 4) {
+		const unsigned int n = (lineBytes - x < tileBytes) ? lineBytes - x : tileBytes;
+		const unsigned char *p = line + x;
+		uint64_t acc[4];
+		memcpy(acc, state, sizeof(acc));
+		for (unsigned int s = 0; s * 32 < n; s++) {
+			uint64_t data[4] = { 0, 0, 0, 0 };
+			if (n - s * 32 >= 32)
+				memcpy(data, p + s * 32, 32);
+			else
+				memcpy(data, p + s * 32, n - s * 32);
+			const uint64_t *key = keys + (s % spout_hash_stripes) * 4;
+			for (int i = 0; i < 4; i++) {
+				const uint64_t k = data[i] ^ key[i];
+				acc[i ^ 1] += data[i];
+				acc[i] += (k & 0xFFFFFFFFULL) * (k >> 32);
+			}
+		}
+		for (int i = 0; i < 4; i++) {
+			acc[i] ^= acc[i] >> 47;
+			acc[i] ^= scramble[i];
+			acc[i] *= spout_prime32_1;
+		}
+		memcpy(state, acc, sizeof(acc));
+	}
+}
+
+static inline __m128i spout_hash_accumulate_sse2(__m128i acc, __m128i data, __m128i key)
+{
+	const __m128i k = _mm_xor_si128(data, key);
+	const __m128i product = _mm_mul_epu32(k, _mm_srli_epi64(k, 32));
+	const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+	return _mm_add_epi64(acc, _mm_add_epi64(swapped, product));
+}
+
+static inline __m128i spout_hash_scramble_sse2(__m128i acc, __m128i key)
+{
+	const __m128i prime = _mm_set1_epi32((int)spout_prime32_1);
+	acc = _mm_xor_si128(acc, _mm_srli_epi64(acc, 47));
+	acc = _mm_xor_si128(acc, key);
+	// 64 x 32 bit multiply
+	const __m128i lo = _mm_mul_epu32(acc, prime);
+	const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(acc, 32), prime);
+	return _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+}
+
+static void spout_hash_line_sse2(const unsigned char *line, unsigned int lineBytes,
+	unsigned int tileBytes, uint64_t *state)
+{
+	const uint64_t *keys = spout_hash_keys();
+	const __m128i *k = reinterpret_cast<const __m128i *>(keys);
+	const __m128i scramble0 = _mm_loadu_si128(k + spout_hash_stripes * 2);
+	const __m128i scramble1 = _mm_loadu_si128(k + spout_hash_stripes * 2 + 1);
+	for (unsigned int x = 0; x < lineBytes; x += tileBytes, state += 4) {
+		const unsigned int n = (lineBytes - x < tileBytes) ? lineBytes - x : tileBytes;
+		const unsigned char *p = line + x;
+		__m128i acc0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state));
+		__m128i acc1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 2));
+		unsigned int s = 0;
+		for (; (s + 1) * 32 <= n; s++) {
+			const __m128i *key = k + (s % spout_hash_stripes) * 2;
+			acc0 = spout_hash_accumulate_sse2(acc0, _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + s * 32)), _mm_loadu_si128(key));
+			acc1 = spout_hash_accumulate_sse2(acc1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + s * 32 + 16)), _mm_loadu_si128(key + 1));
+		}
+		if (s * 32 < n) {
+			unsigned char block[32] = {};
+			memcpy(block, p + s * 32, n - s * 32);
+			const __m128i *key = k + (s % spout_hash_stripes) * 2;
+			acc0 = spout_hash_accumulate_sse2(acc0, _mm_loadu_si128(reinterpret_cast<const __m128i *>(block)), _mm_loadu_si128(key));
+			acc1 = spout_hash_accumulate_sse2(acc1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16)), _mm_loadu_si128(key + 1));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(state), spout_hash_scramble_sse2(acc0, scramble0));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(state + 2), spout_hash_scramble_sse2(acc1, scramble1));
+	}
+}
+
+SPOUT_TARGET_AVX2
+static inline __m256i spout_hash_accumulate_avx2(__m256i acc, __m256i data, __m256i key)
+{
+	const __m256i k = _mm256_xor_si256(data, key);
+	const __m256i product = _mm256_mul_epu32(k, _mm256_srli_epi64(k, 32));
+	const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+	return _mm256_add_epi64(acc, _mm256_add_epi64(swapped, product));
+}
+
+SPOUT_TARGET_AVX2
+static void spout_hash_line_avx2(const unsigned char *line, unsigned int lineBytes,
+	unsigned int tileBytes, uint64_t *state)
+{
+	const uint64_t *keys = spout_hash_keys();
+	const __m256i *k = reinterpret_cast<const __m256i *>(keys);
+	const __m256i scramble = _mm256_loadu_si256(k + spout_hash_stripes);
+	const __m256i prime = _mm256_set1_epi32((int)spout_prime32_1);
+	for (unsigned int x = 0; x < lineBytes; x += tileBytes, state += 4) {
+		const unsigned int n = (lineBytes - x < tileBytes) ? lineBytes - x : tileBytes;
+		const unsigned char *p = line + x;
+		__m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(state));
+		unsigned int s = 0;
+		for (; (s + 1) * 32 <= n; s++)
+			acc = spout_hash_accumulate_avx2(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + s * 32)),
+				_mm256_loadu_si256(k + s % spout_hash_stripes));
+		if (s * 32 < n) {
+			unsigned char block[32] = {};
+			memcpy(block, p + s * 32, n - s * 32);
+			acc = spout_hash_accumulate_avx2(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block)),
+				_mm256_loadu_si256(k + s % spout_hash_stripes));
+		}
+		acc = _mm256_xor_si256(acc, _mm256_srli_epi64(acc, 47));
+		acc = _mm256_xor_si256(acc, scramble);
+		const __m256i lo = _mm256_mul_epu32(acc, prime);
+		const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(acc, 32), prime);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(state), _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+	}
+}
+
+typedef void (*SpoutHashLine)(const unsigned char *, unsigned int, unsigned int, uint64_t *);
+
+static SpoutHashLine spout_hash_line(SpoutCopyTier tier)
+{
+	if (tier >= SPOUT_COPY_AVX2)
+		return spout_hash_line_avx2;
+	if (tier >= SPOUT_COPY_SSE2)
+		return spout_hash_line_sse2;
+	return spout_hash_line_scalar;
+}
+
+struct spoutFrameHashData {
+	std::vector<uint64_t> hashes;
+	std::vector<uint64_t> dirty;
+	// Hash state of every tile during Update
+	std::vector<uint64_t> state;
+};
+
+spoutFrameHash::spoutFrameHash()
+{
+	m_pData = new spoutFrameHashData;
+	m_Width = 0;
+	m_Height = 0;
+	m_Bytes = 0;
+	m_TilesX = 0;
+	m_TilesY = 0;
+	m_Changed = 0;
+	m_bReset = true;
+	m_Tier = spoutCopy::GetSupportedTier();
+	m_Threads = 1;
+}
+
+spoutFrameHash::~spoutFrameHash()
+{
+	delete m_pData;
+}
+
+bool spoutFrameHash::Update(const void* pixels, unsigned int width, unsigned int height,
+	unsigned int pitch, GLenum glFormat)
+{
+	const unsigned int bytes = spoutCopy::GetPixelBytes(glFormat);
+	if (!pixels || width == 0 || height == 0 || bytes == 0)
+		return false;
+	if (pitch == 0)
+		pitch = width * bytes;
+
+	std::vector<uint64_t> &hashes = m_pData->hashes;
+	std::vector<uint64_t> &dirty = m_pData->dirty;
+	std::vector<uint64_t> &states = m_pData->state;
+
+	if (width != m_Width || height != m_Height || bytes != m_Bytes) {
+		m_Width = width;
+		m_Height = height;
+		m_Bytes = bytes;
+		m_TilesX = (width + TileSize - 1) / TileSize;
+		m_TilesY = (height + TileSize - 1) / TileSize;
+		const size_t tiles = (size_t)m_TilesX * m_TilesY;
+		hashes.assign(tiles, 0);
+		dirty.assign((tiles + 63) / 64, 0);
+		states.assign(tiles * 4, 0);
+		m_bReset = true;
+	}
+
+	const SpoutHashLine hashLine = spout_hash_line(m_Tier);
+	const unsigned int lineBytes = width * bytes;
+	const unsigned int tileBytes = TileSize * bytes;
+	const unsigned char *src = static_cast<const unsigned char *>(pixels);
+
+	// Hash rows of tiles into the state, four lanes and then the hash
+	auto hashRow = [&](unsigned int ty) {
+		uint64_t *state = states.data() + (size_t)ty * m_TilesX * 4;
+		for (unsigned int tx = 0; tx < m_TilesX; tx++)
+			spout_hash_init(state + tx * 4);
+		const unsigned int y0 = ty * TileSize;
+		const unsigned int y1 = (height - y0 < TileSize) ? height : y0 + TileSize;
+		for (unsigned int y = y0; y < y1; y++)
+			hashLine(src + (size_t)y * pitch, lineBytes, tileBytes, state);
+		for (unsigned int tx = 0; tx < m_TilesX; tx++) {
+			const unsigned int n = (lineBytes - tx * tileBytes < tileBytes) ? lineBytes - tx * tileBytes : tileBytes;
+			state[tx * 4] = spout_hash_final(state + tx * 4, n, y1 - y0);
+		}
+	};
+	if (m_Threads == 1 || m_TilesY < 2) {
+		for (unsigned int ty = 0; ty < m_TilesY; ty++)
+			hashRow(ty);
+	}
+	else {
+		spoutThreadPool &pool = spoutThreadPool::Global();
+		pool.ParallelFor(m_TilesY, m_Threads == 0 ? pool.GetThreadCount() : m_Threads, hashRow);
+	}
+
+	// Compare with the previous frame
+	std::fill(dirty.begin(), dirty.end(), 0);
+	m_Changed = 0;
+	const size_t tiles = hashes.size();
+	for (size_t i = 0; i < tiles; i++) {
+		const uint64_t hash = states[i * 4];
+		if (m_bReset || hash != hashes[i]) {
+			hashes[i] = hash;
+			dirty[i / 64] |= 1ULL << (i % 64);
+			m_Changed++;
+		}
+	}
+	m_bReset = false;
+
+	return m_Changed > 0;
+}
+
+void spoutFrameHash::Reset()
+{
+	m_bReset = true;
+}
+
+bool spoutFrameHash::IsChanged() const
+{
+	return m_Changed > 0;
+}
+
+unsigned int spoutFrameHash::GetChangedTiles() const
+{
+	return m_Changed;
+}
+
+unsigned int spoutFrameHash::GetTilesX() const
+{
+	return m_TilesX;
+}
+
+unsigned int spoutFrameHash::GetTilesY() const
+{
+	return m_TilesY;
+}
+
+bool spoutFrameHash::IsTileChanged(unsigned int tileX, unsigned int tileY) const
+{
+	if (tileX >= m_TilesX || tileY >= m_TilesY)
+		return false;
+	const size_t i = (size_t)tileY * m_TilesX + tileX;
+	return (m_pData->dirty[i / 64] >> (i % 64)) & 1;
+}
+
+const uint64_t *spoutFrameHash::GetDirtyBitmap() const
+{
+	return m_pData->dirty.data();
+}
+
+const uint64_t *spoutFrameHash::GetTileHashes() const
+{
+	return m_pData->hashes.data();
+}
+
+uint64_t spoutFrameHash::GetFrameHash() const
+{
+	uint64_t h = (uint64_t)m_Width * spout_prime64_1 + (uint64_t)m_Height * spout_prime64_2 + m_Bytes;
+	for (const uint64_t hash : m_pData->hashes)
+		h = spout_hash_mix(h ^ hash);
+	return h;
+}
+
+bool spoutFrameHash::SetTier(SpoutCopyTier tier)
+{
+	if (tier < SPOUT_COPY_SCALAR || tier > spoutCopy::GetSupportedTier())
+		return false;
+	m_Tier = tier;
+	return true;
+}
+
+SpoutCopyTier spoutFrameHash::GetTier() const
+{
+	return m_Tier;
+}
+
+void spoutFrameHash::SetThreads(unsigned int nThreads)
+{
+	m_Threads = nThreads;
+}
+
+unsigned int spoutFrameHash::GetThreads() const
+{
+	return m_Threads;
+}
+
+uint64_t spoutFrameHash::HashTile(const void* pixels, unsigned int width, unsigned int height,
+	unsigned int pitch, unsigned int bytes, SpoutCopyTier tier)
+{
+	if (!pixels || width == 0 || height == 0 || bytes == 0)
+		return 0;
+	if (pitch == 0)
+		pitch = width * bytes;
+	const SpoutHashLine hashLine = spout_hash_line(tier);
+	const unsigned char *src = static_cast<const unsigned char *>(pixels);
+	// One tile as wide as the region
+	const unsigned int lineBytes = width * bytes;
+	uint64_t acc[4];
+	spout_hash_init(acc);
+	for (unsigned int y = 0; y < height; y++)
+		hashLine(src + (size_t)y * pitch, lineBytes, lineBytes, acc);
+	return spout_hash_final(acc, lineBytes, height);
+}
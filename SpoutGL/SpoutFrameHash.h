@@ -0,0 +1,103 @@
+/*
+
+					SpoutFrameHash.h
+
+		Detection of changed frames by a hash of each tile
+
+		A frame is divided into tiles of 64 x 64 pixels and a 64 bit hash
+		of each tile is compared with the hash of the previous frame.
+		Where nothing has changed, a copy, upload or send can be skipped
+		and the previous output used again. Where some tiles have changed,
+		the dirty tile bitmap gives the tiles to update.
+
+			spoutFrameHash framehash;
+			...
+			if (framehash.Update(pixels, width, height, 0, GL_RGBA))
+				... copy and send the new frame
+			else
+				... send the previous output again
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutFrameHash__ // standard way as well
+#define __spoutFrameHash__
+
+#include "SpoutCopy.h"
+
+struct spoutFrameHashData;
+
+class SPOUT_DLLEXP spoutFrameHash {
+
+	public:
+
+		spoutFrameHash();
+		~spoutFrameHash();
+
+		// Pixels per side of a tile
+		static const unsigned int TileSize = 64;
+
+		// Hash the tiles of a frame and compare with the previous frame,
+		// allowing for line pitch (0 for no padding).
+		// Formats : GL_RGB, GL_BGR_EXT, GL_RGBA, GL_RGBA8, GL_BGRA_EXT,
+		// GL_RGBA16, GL_RGBA16F, GL_RGBA32F
+		// Returns true if any tile is different, or for the first frame
+		// and a change of size or format when every tile is marked.
+		bool Update(const void* pixels, unsigned int width, unsigned int height,
+			unsigned int pitch, GLenum glFormat);
+		// Mark every tile as changed for the next Update
+		void Reset();
+
+		// Result of the last Update
+		bool IsChanged() const;
+		unsigned int GetChangedTiles() const;
+		unsigned int GetTilesX() const;
+		unsigned int GetTilesY() const;
+		bool IsTileChanged(unsigned int tileX, unsigned int tileY) const;
+		// One bit for each tile, set if changed. Tiles are in rows from
+		// the first line, 64 to a word with the first tile in bit 0.
+		// Tile (x, y) is bit n % 64 of word n / 64 for n = y * tiles across + x.
+		const uint64_t *GetDirtyBitmap() const;
+		// Hash of each tile in the same order
+		const uint64_t *GetTileHashes() const;
+		// Hash of the whole frame from the tile hashes
+		uint64_t GetFrameHash() const;
+
+		// Instruction set tier. The hash is the same for every tier.
+		// The highest supported by default.
+		bool SetTier(SpoutCopyTier tier);
+		SpoutCopyTier GetTier() const;
+		// Threads to hash rows of tiles (see spoutCopy::SetCopyThreads)
+		void SetThreads(unsigned int nThreads);
+		unsigned int GetThreads() const;
+
+		// Hash of one tile of "width" pixels of "bytes" each and "height" lines.
+		// The same as the hash of a tile of that size from Update.
+		static uint64_t HashTile(const void* pixels, unsigned int width, unsigned int height,
+			unsigned int pitch, unsigned int bytes, SpoutCopyTier tier);
+
+	protected :
+
+		unsigned int m_Width;
+		unsigned int m_Height;
+		unsigned int m_Bytes;
+		unsigned int m_TilesX;
+		unsigned int m_TilesY;
+		unsigned int m_Changed;
+		bool m_bReset;
+		SpoutCopyTier m_Tier;
+		unsigned int m_Threads;
+		// Tile hashes, dirty bitmap and hash state
+		spoutFrameHashData *m_pData;
+
+	private :
+
+		spoutFrameHash(const spoutFrameHash &) = delete;
+		spoutFrameHash &operator=(const spoutFrameHash &) = delete;
+
+};
+
+#endif
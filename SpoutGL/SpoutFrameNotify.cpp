@@ -0,0 +1,261 @@
+/*
+
+					SpoutFrameNotify.cpp
+
+		New frame notification in shared memory
+
+		See SpoutFrameNotify.h
+
+		Layout
+
+			magic    set when the notifier is created
+			wake     low 32 bits of the frame number, the futex word
+			waiters  receivers in Wait
+			frame    newest frame number
+
+		Publish increments the frame number, then the wake word, and
+		wakes receivers if any are counted as waiting. Wait counts itself
+		as waiting before it reads the wake word and the frame number, so
+		either Publish finds the waiter or the waiter finds the new frame.
+		A futex wait returns at once if the wake word is no longer the
+		value that was read.
+
+		On Windows a waiter that finds the frame without waiting leaves
+		a semaphore count that wakes a later wait early. Wait then checks
+		the frame number again and waits for the time that is left.
+
+	========================
+
+	16.10.26 - Create file
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#include "SpoutFrameNotify.h"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <string>
+#if !defined(_WIN32)
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#include <thread>
+#endif
+#endif
+
+namespace {
+
+	const uint32_t NotifyMagic = 0x46525053; // "SPRF"
+	const int NotifySize = 64;
+
+	struct NotifyHeader {
+		std::atomic<uint32_t> magic;
+		std::atomic<uint32_t> wake;
+		std::atomic<uint32_t> waiters;
+		uint32_t reserved;
+		std::atomic<uint64_t> frame;
+	};
+
+	static_assert(sizeof(NotifyHeader) <= NotifySize, "NotifyHeader must fit 64 bytes");
+
+	NotifyHeader *GetNotifyHeader(char *pBuffer)
+	{
+		return reinterpret_cast<NotifyHeader *>(pBuffer);
+	}
+
+#if !defined(_WIN32)
+	// Wait while the word is "value", up to "msec" or without a timeout.
+	// Not FUTEX_PRIVATE_FLAG, so that a sender in another process wakes it.
+	void WaitWord(std::atomic<uint32_t> *word, uint32_t value, unsigned int msec)
+	{
+#if defined(__linux__)
+		struct timespec ts;
+		ts.tv_sec = msec / 1000;
+		ts.tv_nsec = (long)(msec % 1000) * 1000000L;
+		syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, value,
+			msec == spoutFrameNotify::Infinite ? nullptr : &ts, nullptr, 0);
+#else
+		// No shared wait primitive, poll at a short interval
+		(void)msec;
+		if (word->load(std::memory_order_acquire) == value)
+			std::this_thread::sleep_for(std::chrono::microseconds(500));
+#endif
+	}
+
+	void WakeWord(std::atomic<uint32_t> *word)
+	{
+#if defined(__linux__)
+		syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+#else
+		(void)word;
+#endif
+	}
+#endif
+
+}
+
+spoutFrameNotify::spoutFrameNotify()
+{
+	m_pBuffer = nullptr;
+#if defined(_WIN32)
+	m_hSemaphore = NULL;
+#endif
+}
+
+spoutFrameNotify::~spoutFrameNotify()
+{
+	Close();
+}
+
+bool spoutFrameNotify::Create(const char *name)
+{
+	if (!name || !name[0])
+		return false;
+
+	if (m_pBuffer)
+		return true;
+
+	std::string mapName = name;
+	mapName += "_notify";
+	const SpoutCreateResult result = m_memory.Create(mapName.c_str(), NotifySize);
+	if (result == SPOUT_CREATE_FAILED)
+		return false;
+
+	// New shared memory is zeros, which is a notifier with no frame
+	m_pBuffer = m_memory.Buffer();
+	GetNotifyHeader(m_pBuffer)->magic.store(NotifyMagic, std::memory_order_release);
+
+#if defined(_WIN32)
+	mapName += "_semaphore";
+	m_hSemaphore = CreateSemaphoreA(NULL, 0, LONG_MAX, mapName.c_str());
+	if (!m_hSemaphore) {
+		Close();
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+bool spoutFrameNotify::Open(const char *name)
+{
+	if (!name || !name[0])
+		return false;
+
+	if (m_pBuffer)
+		return true;
+
+	std::string mapName = name;
+	mapName += "_notify";
+	if (!m_memory.Open(mapName.c_str()))
+		return false;
+
+	m_pBuffer = m_memory.Buffer();
+	if (GetNotifyHeader(m_pBuffer)->magic.load(std::memory_order_acquire) != NotifyMagic) {
+		Close();
+		return false;
+	}
+
+#if defined(_WIN32)
+	mapName += "_semaphore";
+	m_hSemaphore = CreateSemaphoreA(NULL, 0, LONG_MAX, mapName.c_str());
+	if (!m_hSemaphore) {
+		Close();
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+void spoutFrameNotify::Close()
+{
+#if defined(_WIN32)
+	if (m_hSemaphore)
+		CloseHandle(m_hSemaphore);
+	m_hSemaphore = NULL;
+#endif
+	m_memory.Close();
+	m_pBuffer = nullptr;
+}
+
+bool spoutFrameNotify::IsOpen() const
+{
+	return m_pBuffer != nullptr;
+}
+
+uint64_t spoutFrameNotify::Publish()
+{
+	if (!m_pBuffer)
+		return 0;
+
+	NotifyHeader *header = GetNotifyHeader(m_pBuffer);
+	const uint64_t frame = header->frame.fetch_add(1, std::memory_order_seq_cst) + 1;
+	header->wake.fetch_add(1, std::memory_order_seq_cst);
+
+	const uint32_t waiters = header->waiters.load(std::memory_order_seq_cst);
+	if (waiters > 0) {
+#if defined(_WIN32)
+		ReleaseSemaphore(m_hSemaphore, (LONG)waiters, NULL);
+#else
+		WakeWord(&header->wake);
+#endif
+	}
+
+	return frame;
+}
+
+uint64_t spoutFrameNotify::GetFrame() const
+{
+	if (!m_pBuffer)
+		return 0;
+	return GetNotifyHeader(m_pBuffer)->frame.load(std::memory_order_acquire);
+}
+
+uint64_t spoutFrameNotify::Wait(uint64_t frame, unsigned int timeout)
+{
+	if (!m_pBuffer)
+		return 0;
+
+	NotifyHeader *header = GetNotifyHeader(m_pBuffer);
+	uint64_t newest = header->frame.load(std::memory_order_acquire);
+	if (newest > frame || timeout == 0)
+		return newest;
+
+	const auto start = std::chrono::steady_clock::now();
+	header->waiters.fetch_add(1, std::memory_order_seq_cst);
+	for (;;) {
+		const uint32_t wake = header->wake.load(std::memory_order_seq_cst);
+		newest = header->frame.load(std::memory_order_seq_cst);
+		if (newest > frame)
+			break;
+
+		// Time left of the timeout
+		unsigned int msec = Infinite;
+		if (timeout != Infinite) {
+			const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - start).count();
+			if (elapsed >= (long long)timeout)
+				break;
+			msec = timeout - (unsigned int)elapsed;
+		}
+
+#if defined(_WIN32)
+		(void)wake;
+		if (WaitForSingleObject(m_hSemaphore, msec == Infinite ? INFINITE : (DWORD)msec) == WAIT_FAILED)
+			break;
+#else
+		WaitWord(&header->wake, wake, msec);
+#endif
+	}
+	header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+
+	return newest;
+}
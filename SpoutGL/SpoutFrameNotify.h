@@ -0,0 +1,88 @@
+/*
+
+					SpoutFrameNotify.h
+
+		New frame notification in shared memory
+
+		A receiver found whether a sender had a new frame by taking and
+		releasing the frame count semaphore for every frame, and had no
+		way to wait for one other than to poll. The notifier is a 64 bit
+		frame number in shared memory that a receiver can read with one
+		atomic load, or wait on until the sender publishes a later frame.
+
+		Linux waits with a futex on the shared word, which wakes waiters
+		in any process. WaitOnAddress only wakes threads of the process
+		that calls WakeByAddress, so Windows waits on a named semaphore
+		that the sender releases once for each receiver that is waiting.
+		The sender does not make a system call if no receiver is waiting.
+
+			Sender :
+				notify.Create("name");
+				... write the frame
+				notify.Publish();
+
+			Receiver :
+				notify.Open("name");
+				uint64_t frame = notify.GetFrame();
+				...
+				frame = notify.Wait(frame, 100); // a later frame or timeout
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutFrameNotify__ // standard way as well
+#define __spoutFrameNotify__
+
+#include "SpoutSharedMemory.h"
+#include <stdint.h>
+
+class SPOUT_DLLEXP spoutFrameNotify {
+
+	public:
+
+		spoutFrameNotify();
+		~spoutFrameNotify();
+
+		// Wait without a timeout
+		static const unsigned int Infinite = 0xFFFFFFFF;
+
+		// Create the notifier of a sender, or use it if it exists.
+		// A receiver can create it before the sender.
+		bool Create(const char *name);
+		// Open the notifier of a sender
+		bool Open(const char *name);
+		void Close();
+		bool IsOpen() const;
+
+		// Sender
+		// Make the next frame number known and wake waiting receivers.
+		// Returns the new frame number.
+		uint64_t Publish();
+
+		// Receiver
+		// Newest frame number, 0 if none has been published
+		uint64_t GetFrame() const;
+		// Wait up to "timeout" msec for a frame later than "frame".
+		// Returns the newest frame number, which is still "frame"
+		// or less after a timeout.
+		uint64_t Wait(uint64_t frame, unsigned int timeout = Infinite);
+
+	protected :
+
+		SpoutSharedMemory m_memory;
+		char *m_pBuffer;
+#if defined(_WIN32)
+		HANDLE m_hSemaphore; // Released by Publish for each waiter
+#endif
+
+	private :
+
+		spoutFrameNotify(const spoutFrameNotify &) = delete;
+		spoutFrameNotify &operator=(const spoutFrameNotify &) = delete;
+
+};
+
+#endif
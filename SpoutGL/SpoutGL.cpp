@@ -89,6 +89,25 @@
 //					  Pending implementation of glFencSync for glMapBufferRange method
 //		16.03.22	- Use m_hInteropObject in LinkGLDXtextures so that CleanupInterp releases the imterop object
 //					- Allow for success test in GLDXReady();
+//		16.10.26	- Ring buffer of frames for WriteMemoryPixels, ReadMemoryPixels
+//					  and ReadMemoryTexture. The writer never waits for a reader and
+//					  readers copy the newest complete frame. 2.006 memory maps are
+//					  still read if there is no ring. Add SetMemoryRingSlots.
+//					- Binary header after the data of memory buffers with the size,
+//					  length, image size and format, frame count and time.
+//					  The size text is kept for older readers and is no longer
+//					  changed by ReadMemoryBuffer. WriteMemoryBuffer checks the
+//					  length and creates the map with the correct name.
+//					  CreateMemoryBuffer does not use an existing map that is
+//					  too small for the header. The previous WriteMemoryBuffer and
+//					  ReadMemoryBuffer are kept next to the functions with the header.
+//					- Add LeaseMemoryBuffer and LeaseMemoryPixels for a view of shared
+//					  memory without a copy. ReadMemoryBuffer copies from a lease.
+//					  A memory buffer closed while it is leased stays mapped until
+//					  the lease is released.
+//					- The memory buffer header and size text are only used if they
+//					  are inside the view of the map.
+//					- Add SetMemoryLargePages and SetMemoryNumaNode
 // ====================================================================================
 /*
 	Copyright (c) 2021-2022, Lynn Jarvis. All rights reserved.
@@ -216,6 +235,7 @@ spoutGL::spoutGL()
 	// Only set if 2.006 SpoutSettings has been used
 	// Removed by 2.007 SpoutSettings
 	m_bMemoryShare = GetMemoryShareMode();
+	m_memoryRingSlots = spoutMemoryRing::DefaultSlots;
 
 	// Extensions are loaded in OpenSpout() if a context is not available here
 	LoadGLextensions();
@@ -241,6 +261,7 @@ spoutGL::~spoutGL()
 
 	// Close 2.006 or buffer shared memory if used
 	memoryshare.Close();
+	memoryring.Close();
 
 	// Release event if used
 	frame.CloseFrameSync();
@@ -2082,6 +2103,19 @@ bool spoutGL::ReadDX11texture(GLuint TextureID, GLuint TextureTarget,
 //    The map is closed when the sender is released.
 //
 bool spoutGL::WriteMemoryBuffer(const char *name, const char* data, int length)
+{
+	return WriteMemoryBuffer(name, data, length, 0, 0);
+}
+
+//---------------------------------------------------------
+// Function: WriteMemoryBuffer
+// Write buffer to shared memory with an image description.
+//
+//    For an image, the width, height, line pitch and GL format
+//    are recorded in the buffer header. Zero for no image.
+//
+bool spoutGL::WriteMemoryBuffer(const char *name, const char* data, int length,
+	unsigned int width, unsigned int height, unsigned int pitch, unsigned int format)
 {
 	// Quit if 2.006 memoryshare mode
 	if (m_bMemoryShare)
@@ -2098,12 +2132,9 @@ bool spoutGL::WriteMemoryBuffer(const char *name, const char* data, int length)
 	}
 
 	// Create a shared memory map if it does not exist.
+	// CreateMemoryBuffer adds "_map" to the name.
 	if (memoryshare.Size() == 0) {
-		// Create a name for the map
-		std::string namestring = name;
-		namestring += "_map";
-		// Create a shared memory map
-		if (!CreateMemoryBuffer(namestring.c_str(), length))
+		if (!CreateMemoryBuffer(name, length))
 			return false;
 	}
 
@@ -2113,13 +2144,23 @@ bool spoutGL::WriteMemoryBuffer(const char *name, const char* data, int length)
 		return false;
 	}
 
+	// The data must fit the size the map was created with
+	spoutmemorybuffer::Header* header = spoutmemorybuffer::Find(pBuffer, memoryshare.ViewSize());
+	if (!header || length < 0 || (unsigned int)length > header->size) {
+		memoryshare.Unlock();
+		SpoutLogError("spoutGL::WriteMemoryBuffer - length %d is more than the buffer size", length);
+		return false;
+	}
+
 	// Write user data to shared memory (skip the first 16 bytes containing the map size)
 	memcpy(reinterpret_cast<void *>(pBuffer + 16), reinterpret_cast<const void *>(data), length);
 
 	// Terminate the shared memory data with a null.
 	// The map is created larger in advance to allow for it.
-	if (memoryshare.Size() > (16 + length))
-		*(pBuffer + 16 + length) = 0;
+	*(pBuffer + 16 + length) = 0;
+
+	// Record the write in the header
+	spoutmemorybuffer::Update(header, (unsigned int)length, width, height, pitch, format);
 
 	memoryshare.Unlock();
 
@@ -2133,20 +2174,71 @@ bool spoutGL::WriteMemoryBuffer(const char *name, const char* data, int length)
 //
 //    Open a memory map and retain the handle.
 //    The map is closed when the receiver is released.
+//
+//    If the writer has a buffer header, the length of the last write
+//    is read. Otherwise the whole buffer is read.
+//
 int spoutGL::ReadMemoryBuffer(const char* name, char* data, int maxlength)
 {
-	// Quit if 2.006 memoryshare mode
-	if (m_bMemoryShare)
-		return 0;
+	return ReadMemoryBuffer(name, data, maxlength, nullptr);
+}
 
-	if (!name || !name[0]) {
-		SpoutLogError("spoutGL::ReadMemoryBuffer - no name");
+//---------------------------------------------------------
+// Function: ReadMemoryBuffer
+// Read shared memory to a buffer with the buffer header.
+//
+//    As above. If the writer has a buffer header, it is copied
+//    to "header" if one is given. Otherwise "header" is cleared.
+//
+int spoutGL::ReadMemoryBuffer(const char* name, char* data, int maxlength, spoutmemorybuffer::Header* header)
+{
+	if (!data) {
+		SpoutLogError("spoutGL::ReadMemoryBuffer - no data");
 		return 0;
 	}
 
-	if (!data) {
-		SpoutLogError("spoutGL::ReadMemoryBuffer - no data");
+	SpoutSharedMemory::Lease lease = LeaseMemoryBuffer(name, header);
+	if (!lease.IsValid())
 		return 0;
+
+	// Reduce if the user buffer max length is less
+	int nbytes = (int)lease.Size();
+	if (maxlength < nbytes)
+		nbytes = maxlength;
+
+	// Copy bytes from shared memory to the user buffer
+	if (nbytes > 0)
+		memcpy(reinterpret_cast<void *>(data), reinterpret_cast<const void *>(lease.Data()), nbytes);
+
+	// The map is unlocked when the lease goes out of scope
+	return nbytes;
+}
+
+//---------------------------------------------------------
+// Function: LeaseMemoryBuffer
+// Lease shared memory data without a copy.
+//
+//    The map is opened as for ReadMemoryBuffer and stays locked
+//    while the lease exists, so that the data can be converted
+//    from shared memory to where it is needed. The view is the
+//    length of the last write, or the whole buffer for an older
+//    writer without a buffer header.
+//
+//    The writer waits for the lease, so release it as soon as
+//    the data has been used. The lease is not valid if there
+//    is no data. If the map is closed, for example by
+//    ReleaseReceiver, it stays locked and mapped until the
+//    lease is released and can't be opened again until then.
+//
+SpoutSharedMemory::Lease spoutGL::LeaseMemoryBuffer(const char* name, spoutmemorybuffer::Header* header)
+{
+	// Quit if 2.006 memoryshare mode
+	if (m_bMemoryShare)
+		return SpoutSharedMemory::Lease();
+
+	if (!name || !name[0]) {
+		SpoutLogError("spoutGL::LeaseMemoryBuffer - no name");
+		return SpoutSharedMemory::Lease();
 	}
 
 	// Open a shared memory map for read if not done already
@@ -2157,35 +2249,42 @@ int spoutGL::ReadMemoryBuffer(const char* name, char* data, int maxlength)
 		// Open the shared memory. This also creates a mutex
 		// for the reader to lock and unlock the map for reads.
 		if (!memoryshare.Open(namestring.c_str())) {
-			return 0;
+			return SpoutSharedMemory::Lease();
 		}
-		SpoutLogNotice("spoutGL::ReadMemoryBuffer - opened memory map [%s]", memoryshare.Name());
+		SpoutLogNotice("spoutGL::LeaseMemoryBuffer - opened memory map [%s]", memoryshare.Name());
 	}
 
 	char* pBuffer = memoryshare.Lock();
 	if (!pBuffer) {
-		SpoutLogError("spoutGL::ReadMemoryBuffer - no buffer lock");
-		return 0;
+		SpoutLogError("spoutGL::LeaseMemoryBuffer - no buffer lock");
+		return SpoutSharedMemory::Lease();
+	}
+
+	// Number of bytes of the last write from the buffer header,
+	// or for an older writer the map size saved as the first 16 bytes.
+	// Neither is used unless it is inside the view of the map.
+	const size_t viewSize = memoryshare.ViewSize();
+	int nbytes = 0;
+	const spoutmemorybuffer::Header* pHeader = spoutmemorybuffer::Find(pBuffer, viewSize);
+	if (pHeader)
+		nbytes = (int)pHeader->length;
+	else
+		nbytes = spoutmemorybuffer::TextSize(pBuffer, viewSize);
+	if (header) {
+		if (pHeader)
+			*header = *pHeader;
+		else
+			memset(header, 0, sizeof(spoutmemorybuffer::Header));
 	}
 
-	// The memory map includes it's size, saved as the first 16 bytes
-	*(pBuffer + 15) = 0; // End for atoi
-
-	// Number of bytes available for data transfer
-	int nbytes = atoi(reinterpret_cast<char *>(pBuffer));
-
-	// Reduce if the user buffer max length is less
-	if (maxlength < nbytes)
-		nbytes = maxlength;
-
-	// Copy bytes from shared memory to the user buffer
+	// The lease locks the map again and holds it after this lock
+	SpoutSharedMemory::Lease lease;
 	if (nbytes > 0)
-		memcpy(reinterpret_cast<void *>(data), reinterpret_cast<const void *>(pBuffer + 16), nbytes);
+		lease = memoryshare.Acquire(spoutmemorybuffer::TextBytes, (size_t)nbytes);
 
-	// Done with the shared memory pointer
 	memoryshare.Unlock();
 
-	return nbytes;
+	return lease;
 }
 
 //---------------------------------------------------------
@@ -2218,12 +2317,29 @@ bool spoutGL::CreateMemoryBuffer(const char *name, int length)
 
 	// The first 16 bytes are reserved to record the number of bytes available
 	// for data transfer. Make the map 16 bytes larger to compensate. 
-	// Add another 16 bytes to allow for a null terminator.
+	// Add another 16 bytes to allow for a null terminator
+	// and 64 bytes for the buffer header (SpoutMemoryBuffer.h).
 	// (Use multiples of 16 for alignment to allow for SSE copy : TODO).
-	if (!memoryshare.Create(namestring.c_str(), length + 32)) {
+	if (length <= 0) {
 		SpoutLogError("spoutGL::CreateMemoryBuffer - could not create shared memory");
 		return false;
 	}
+	const size_t mapSize = spoutmemorybuffer::MapSize((unsigned int)length);
+	const SpoutCreateResult result = memoryshare.Create(namestring.c_str(), (int)mapSize);
+	if (result == SPOUT_CREATE_FAILED) {
+		SpoutLogError("spoutGL::CreateMemoryBuffer - could not create shared memory");
+		return false;
+	}
+
+	// A map that exists already keeps the size it was created with,
+	// which may be too small for the header, e.g. the map of an older
+	// writer. Only use it if the header fits.
+	if (result != SPOUT_CREATE_SUCCESS && memoryshare.ViewSize() < mapSize) {
+		SpoutLogError("spoutGL::CreateMemoryBuffer - existing shared memory is smaller than %d bytes", (int)mapSize);
+		if (result == SPOUT_ALREADY_EXISTS)
+			memoryshare.Close();
+		return false;
+	}
 
 	// The length requested is the number of bytes to be
 	// available for data transfer (map data size).
@@ -2234,8 +2350,9 @@ bool spoutGL::CreateMemoryBuffer(const char *name, int length)
 	}
 
 	// Convert the map data size to decimal digit chars
-	// directly to the first 16 bytes of the shared memory.
-	_itoa_s(length, reinterpret_cast<char *>(pBuffer), 16, 10);
+	// directly to the first 16 bytes of the shared memory,
+	// followed by the marker and the header after the data.
+	spoutmemorybuffer::Create(pBuffer, (unsigned int)length);
 
 	memoryshare.Unlock();
 	SpoutLogNotice("spoutGL::CreateMemoryBuffer - created shared memory buffer %d bytes", length);
@@ -2277,10 +2394,12 @@ int spoutGL::GetMemoryBufferSize(const char *name)
 {
 	// A writer has created the map (Create) and set the map size.
 	// The data length is recorded in the first 16 bytes.
-	// Another 16 bytes is added to allow for a terminating NULL. (See CreateMemoryBuffer)
+	// Another 16 bytes is added to allow for a terminating NULL
+	// and 64 bytes for the header. (See CreateMemoryBuffer)
 	// The remaining length is the number of bytes available for data transfer.
-	if (memoryshare.Size() > 32) {
-		return memoryshare.Size()-32;
+	const int mapOverhead = (int)spoutmemorybuffer::MapSize(0);
+	if (memoryshare.Size() > mapOverhead) {
+		return memoryshare.Size() - mapOverhead;
 	}
 
 	// A reader must read the map to get the size.
@@ -2307,9 +2426,12 @@ int spoutGL::GetMemoryBufferSize(const char *name)
 	}
 
 	// The number of bytes of the memory map available for data transfer
-	// is saved in the first 16 bytes.
-	*(pBuffer + 15) = 0; // End for atoi
-	int nbytes = atoi(reinterpret_cast<char *>(pBuffer));
+	// is in the header, and saved in the first 16 bytes for older writers.
+	const size_t viewSize = memoryshare.ViewSize();
+	const spoutmemorybuffer::Header* pHeader = spoutmemorybuffer::Find(pBuffer, viewSize);
+	int nbytes = pHeader ? (int)pHeader->size : spoutmemorybuffer::TextSize(pBuffer, viewSize);
+	if (nbytes < 0)
+		nbytes = 0;
 
 	memoryshare.Unlock();
 
@@ -2317,6 +2439,81 @@ int spoutGL::GetMemoryBufferSize(const char *name)
 
 }
 
+//---------------------------------------------------------
+// Function: SetMemoryRingSlots
+// Set the number of frames in the ring buffer used by WriteMemoryPixels.
+//
+//    The writer fills the slot after the newest frame, so with 3 slots
+//    a receiver has the time of two frames to copy the newest.
+//    More slots allow for slower receivers at the cost of memory.
+//    Takes effect when the ring is next created.
+//
+void spoutGL::SetMemoryRingSlots(unsigned int slots)
+{
+	m_memoryRingSlots = (slots < 2) ? 2 : slots;
+}
+
+//---------------------------------------------------------
+// Function: GetMemoryRingSlots
+// Number of frames in the memoryshare ring buffer.
+//
+unsigned int spoutGL::GetMemoryRingSlots()
+{
+	return m_memoryRingSlots;
+}
+
+//---------------------------------------------------------
+// Function: SetMemoryLargePages
+// Use large pages for memoryshare maps and ring buffers.
+//
+//    A 4K or larger frame copied through shared memory with normal
+//    pages needs many TLB entries. Maps of at least one large page
+//    use large pages if the system has them, otherwise normal pages.
+//    Windows needs the "Lock pages in memory" right for the account
+//    and Linux a hugetlbfs mount with pages reserved, or transparent
+//    huge pages for shared memory. Takes effect when a map is next
+//    created or opened.
+//
+void spoutGL::SetMemoryLargePages(bool bLarge)
+{
+	memoryshare.SetLargePages(bLarge);
+	memoryring.SetLargePages(bLarge);
+}
+
+//---------------------------------------------------------
+// Function: GetMemoryLargePages
+// Whether large pages are requested for memoryshare.
+//
+bool spoutGL::GetMemoryLargePages()
+{
+	return memoryshare.GetLargePages();
+}
+
+//---------------------------------------------------------
+// Function: SetMemoryNumaNode
+// NUMA node for the pages of memoryshare maps and ring buffers.
+//
+//    SpoutSharedMemory::NumaCurrent is the node of the thread that
+//    creates the map and SpoutSharedMemory::NumaDefault leaves it
+//    to the system. The node of the receiver is usually better for
+//    frames that are written once and read by the receiver.
+//    Takes effect when a map is next created.
+//
+void spoutGL::SetMemoryNumaNode(int node)
+{
+	memoryshare.SetNumaNode(node);
+	memoryring.SetNumaNode(node);
+}
+
+//---------------------------------------------------------
+// Function: GetMemoryNumaNode
+// NUMA node requested for memoryshare.
+//
+int spoutGL::GetMemoryNumaNode()
+{
+	return memoryshare.GetNumaNode();
+}
+
 
 // Copy OpenGL texture data to a pixel buffer via fbo
 bool spoutGL::ReadTextureData(GLuint SourceID, GLuint SourceTarget,
@@ -2710,6 +2907,37 @@ bool spoutGL::CheckStagingTextures(unsigned int width, unsigned int height, int
 bool spoutGL::ReadMemoryTexture(const char* sendername, GLuint TexID, GLuint TextureTarget,
 	unsigned int width, unsigned int height, bool bInvert, GLuint HostFBO)
 {
+	// Ring buffer of a sender using WriteMemoryPixels.
+	// The newest frame is uploaded without holding up the sender.
+	if (OpenMemoryRing(sendername)) {
+		if (!memoryring.IsNewFrame())
+			return true;
+		// Invert by a copy from a local OpenGL texture
+		GLuint uploadID = TexID;
+		GLuint uploadTarget = TextureTarget;
+		if (bInvert) {
+			CheckOpenGLTexture(m_TexID, GL_RGBA, width, height);
+			uploadID = m_TexID;
+			uploadTarget = GL_TEXTURE_2D;
+		}
+		bool bSize = false;
+		const bool bRead = memoryring.Read([&](const unsigned char* data, const spoutMemoryFrame& info) {
+			bSize = (info.width == width && info.height == height && info.size >= width*height*4);
+			if (!bSize)
+				return;
+			// Uploaded again if the sender reuses the slot meanwhile
+			glBindTexture(uploadTarget, uploadID);
+			glTexSubImage2D(uploadTarget, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (const GLvoid *)data);
+			glBindTexture(uploadTarget, 0);
+		});
+		if (!bRead || !bSize)
+			return false;
+		// Copy to the user texture, inverting at the same time
+		if (bInvert)
+			return CopyTexture(m_TexID, GL_TEXTURE_2D, TexID, TextureTarget, width, height, true, HostFBO);
+		return true;
+	}
+
 	// Open a shared memory map if it not already
 	if (!memoryshare.Name()) {
 		// Create a name for the map from the sender name
@@ -2767,6 +2995,20 @@ bool spoutGL::ReadMemoryPixels(const char* sendername, unsigned char* pixels,
 		return false;
 	}
 
+	// Ring buffer of a sender using WriteMemoryPixels.
+	// The newest frame is copied without holding up the sender.
+	if (OpenMemoryRing(sendername)) {
+		if (!memoryring.IsNewFrame())
+			return true;
+		bool bSize = false;
+		const bool bRead = memoryring.Read([&](const unsigned char* data, const spoutMemoryFrame& info) {
+			bSize = (info.width == width && info.height == height && info.size >= width*height*4);
+			if (bSize)
+				spoutcopy.CopyPixels(data, pixels, width, height, glFormat, bInvert);
+		});
+		return bRead && bSize;
+	}
+
 	// Open a shared memory map if it not already
 	if (!memoryshare.Name()) {
 		// Create a name for the map from the sender name
@@ -2807,32 +3049,79 @@ bool spoutGL::WriteMemoryPixels(const char *sendername, const unsigned char* pix
 		return false;
 	}
 
-	// Create a shared memory map if it does not exist yet
-	char* pBuffer = nullptr;
-	if (memoryshare.Size() == 0) {
+	// Create the ring buffer if it does not exist yet or the frame is larger.
+	// Each frame is written to the slot after the newest without waiting for receivers.
+	const unsigned int size = width*height*4;
+	if (!memoryring.IsWriter() || memoryring.GetSlotSize() < size || memoryring.GetSlots() != m_memoryRingSlots) {
 		// Create a name for the map from the sender name
 		std::string namestring = sendername;
-		namestring += "_map";
-		if (!memoryshare.Create(sendername, width*4*height)) {
+		namestring += "_ring";
+		memoryring.Close();
+		if (!memoryring.Create(namestring.c_str(), size, m_memoryRingSlots)) {
+			// A previous ring of another size is still open by a receiver
 			SpoutLogError("SpoutSharedMemory::WriteMemoryPixels - could not create shared memory");
 			return false;
 		}
-		pBuffer = memoryshare.Lock();
-		if (!pBuffer) {
-			SpoutLogError("SpoutSharedMemory::WriteMemoryPixels - no buffer lock");
-			return false;
-		}
+	}
+
+	unsigned char* pBuffer = memoryring.BeginWrite();
+	if (!pBuffer) {
+		SpoutLogError("SpoutSharedMemory::WriteMemoryPixels - no buffer");
+		return false;
 	}
 
 	// Write pixel data to shared memory
-	spoutcopy.CopyPixels(pixels, reinterpret_cast<unsigned char *>(pBuffer), width, height, glFormat, bInvert);
+	spoutcopy.CopyPixels(pixels, pBuffer, width, height, glFormat, bInvert);
 
-	memoryshare.Unlock();
+	memoryring.EndWrite(glFormat, width, height, width*4, size);
 
 	return true;
 
 }
 
+//
+// Lease the newest frame of a sender using WriteMemoryPixels.
+// The frame can be converted from shared memory instead of being
+// copied by ReadMemoryPixels first. The sender uses another slot while
+// the lease is held and Release returns false if it could not.
+// A ring closed by the next receive stays mapped until the lease is released,
+// but is not opened again until then.
+// There is no lease of a 2.006 memory map.
+//
+spoutMemoryRing::Lease spoutGL::LeaseMemoryPixels(const char* sendername)
+{
+	if (!sendername || !sendername[0] || !OpenMemoryRing(sendername))
+		return spoutMemoryRing::Lease();
+
+	return memoryring.Acquire();
+}
+
+//
+// Open the ring buffer of a sender if it exists
+//
+bool spoutGL::OpenMemoryRing(const char* sendername)
+{
+	if (memoryring.IsOpen()) {
+		if (!memoryring.IsClosed())
+			return true;
+		// The sender has closed the ring, or is creating it again at another size
+		memoryring.Close();
+	}
+
+	// Reading a 2.006 memory map
+	if (memoryshare.Name())
+		return false;
+
+	// Create a name for the map from the sender name
+	std::string namestring = sendername;
+	namestring += "_ring";
+	if (!memoryring.Open(namestring.c_str()))
+		return false;
+
+	SpoutLogNotice("spoutGL::OpenMemoryRing - opened sender ring buffer [%s] %u slots", namestring.c_str(), memoryring.GetSlots());
+	return true;
+}
+
 //
 // Directx 11
 //
@@ -39,6 +39,8 @@
 #include "SpoutDirectX.h" // for DX11 shared textures
 #include "SpoutFrameCount.h" // for mutex lock and new frame signal
 #include "SpoutCopy.h" // for pixel copy
+#include "SpoutMemoryRing.h" // for memoryshare pixels
+#include "SpoutMemoryBuffer.h" // for the memory buffer header
 #include "SpoutUtils.h" // Registry utiities
 #include "SpoutGLextensions.h" // include last due to redefinition problems with OpenCL
 
@@ -241,14 +243,32 @@ class SPOUT_DLLEXP spoutGL {
 
 	// Write data to shared memory
 	bool WriteMemoryBuffer(const char *name, const char* data, int length);
+	// Write data to shared memory, with the image size and format for the buffer header
+	bool WriteMemoryBuffer(const char *name, const char* data, int length,
+		unsigned int width, unsigned int height, unsigned int pitch = 0, unsigned int format = 0);
 	// Read data from shared memory
 	int ReadMemoryBuffer(const char* name, char* data, int maxlength);
+	// Read data from shared memory, and the buffer header if the writer has one
+	int ReadMemoryBuffer(const char* name, char* data, int maxlength, spoutmemorybuffer::Header* header);
+	// Lease the data of shared memory to use without a copy. The map is locked until the lease is released.
+	SpoutSharedMemory::Lease LeaseMemoryBuffer(const char* name, spoutmemorybuffer::Header* header = nullptr);
+	// Lease the newest frame of a sender using WriteMemoryPixels to convert without a copy
+	spoutMemoryRing::Lease LeaseMemoryPixels(const char* sendername);
 	// Create a shared memory buffer
 	bool CreateMemoryBuffer(const char *name, int length);
 	// Delete a shared memory buffer
 	bool DeleteMemoryBuffer();
 	// Get the number of bytes available for data transfer
 	int GetMemoryBufferSize(const char *name);
+	// Slots of the ring buffer used by WriteMemoryPixels (default 3)
+	void SetMemoryRingSlots(unsigned int slots);
+	unsigned int GetMemoryRingSlots();
+	// Large pages for memoryshare maps and rings created after this
+	void SetMemoryLargePages(bool bLarge);
+	bool GetMemoryLargePages();
+	// NUMA node for memoryshare maps and rings created after this
+	void SetMemoryNumaNode(int node);
+	int GetMemoryNumaNode();
 
 	//
 	// For external access
@@ -268,6 +288,10 @@ protected :
 	
 	// For 2.006(receive only) / WriteMemoryBuffer / ReadMemoryBuffer
 	SpoutSharedMemory memoryshare;
+	// Ring buffer for WriteMemoryPixels / ReadMemoryPixels / ReadMemoryTexture
+	spoutMemoryRing memoryring;
+	unsigned int m_memoryRingSlots;
+	bool OpenMemoryRing(const char* sendername);
 
 	// GL/DX functions
 	bool CreateInterop(unsigned int width, unsigned int height, DWORD dwFormat, bool bReceive);
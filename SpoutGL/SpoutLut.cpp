@@ -0,0 +1,474 @@
+/*
+
+					SpoutLut.cpp
+
+		3D colour lookup table for grading pixel buffers
+
+		.cube format
+
+		Text lines with keywords followed by the table values.
+		# starts a comment.
+
+			TITLE "name"
+			LUT_3D_SIZE N          (2 - 256)
+			DOMAIN_MIN r g b       (default 0 0 0)
+			DOMAIN_MAX r g b       (default 1 1 1)
+			LUT_3D_INPUT_RANGE min max
+			N*N*N lines of "r g b" with red changing fastest, then green, then blue
+
+		Other keywords are ignored. Files with LUT_1D_SIZE are rejected.
+
+		Tetrahedral interpolation
+
+		The cube between the eight lattice points around a colour is divided
+		into six tetrahedra by the order of the fractional distances along
+		each axis. The result is a weighted sum of the four corners of the
+		tetrahedron containing the colour, walking from the lower corner
+		along the axis with the largest fraction, then the next largest,
+		to the upper corner. This uses four lattice points instead of the
+		eight for trilinear and keeps the grey axis exact.
+
+		Lattice points are stored as four floats so that each is one
+		16 byte load and the three channels are interpolated together with SSE.
+		A 33 point lattice is 562KB and fits the L2 cache of most processors.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutLut.h"
+#include <fstream>
+#include <sstream>
+#include <locale>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <string.h>
+
+//
+// Tetrahedron for each order of the fractions. The index has bit 0 for
+// red > green, bit 1 for green > blue and bit 2 for red > blue. Each
+// entry is the channel with the largest, middle and smallest fraction.
+// Indices 3 and 4 are not possible and use any valid order.
+//
+static const unsigned char spout_tetra_order[8][3] = {
+	{ 2, 1, 0 }, // b >= g >= r
+	{ 2, 0, 1 }, // b >= r > g
+	{ 1, 2, 0 }, // g > b >= r
+	{ 0, 1, 2 },
+	{ 2, 1, 0 },
+	{ 0, 2, 1 }, // r > b >= g
+	{ 1, 0, 2 }, // g >= r > b
+	{ 0, 1, 2 }, // r > g > b
+};
+
+struct spoutLutData {
+	std::string title;
+	// Lattice points as r, g, b, 0 floats, red changing fastest
+	std::vector<float> lattice;
+	// Lattice point and fraction for each 8 bit input value
+	std::vector<unsigned int> index8;
+	std::vector<float> fraction8;
+};
+
+spoutLut::spoutLut()
+{
+	m_pData = new spoutLutData;
+	Clear();
+}
+
+spoutLut::~spoutLut()
+{
+	delete m_pData;
+}
+
+void spoutLut::Clear()
+{
+	m_Size = 0;
+	m_pData->title.clear();
+	m_pData->lattice.clear();
+	m_pData->index8.clear();
+	m_pData->fraction8.clear();
+	for (int c = 0; c < 3; c++) {
+		m_Offset[c] = 0.0f;
+		m_Scale[c] = 0.0f;
+	}
+}
+
+bool spoutLut::IsLoaded() const
+{
+	return m_Size > 0;
+}
+
+unsigned int spoutLut::GetSize() const
+{
+	return m_Size;
+}
+
+const char *spoutLut::GetTitle() const
+{
+	return m_pData->title.c_str();
+}
+
+bool spoutLut::Load(const char *path)
+{
+	if (!path)
+		return false;
+	std::ifstream file(path);
+	if (!file.is_open())
+		return false;
+	std::stringstream text;
+	text << file.rdbuf();
+	return Parse(text.str().c_str());
+}
+
+bool spoutLut::Parse(const char *text)
+{
+	Clear();
+	if (!text)
+		return false;
+
+	std::string title;
+	unsigned int size = 0;
+	float domainMin[3] = { 0.0f, 0.0f, 0.0f };
+	float domainMax[3] = { 1.0f, 1.0f, 1.0f };
+	std::vector<float> values;
+
+	// Numbers always use a decimal point
+	std::istringstream lines(text);
+	std::string line;
+	while (std::getline(lines, line)) {
+		const size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+		std::istringstream words(line);
+		words.imbue(std::locale::classic());
+		std::string key;
+		if (!(words >> key))
+			continue;
+
+		const char first = key[0];
+		if ((first >= '0' && first <= '9') || first == '-' || first == '+' || first == '.') {
+			// Table values
+			std::istringstream rgb(line);
+			rgb.imbue(std::locale::classic());
+			float r, g, b;
+			if (!(rgb >> r >> g >> b))
+				return false;
+			values.push_back(r);
+			values.push_back(g);
+			values.push_back(b);
+		}
+		else if (key == "TITLE") {
+			const size_t open = line.find('"');
+			const size_t close = line.rfind('"');
+			if (open != std::string::npos && close > open)
+				title = line.substr(open + 1, close - open - 1);
+		}
+		else if (key == "LUT_3D_SIZE") {
+			if (!(words >> size) || size < 2 || size > 256)
+				return false;
+		}
+		else if (key == "LUT_1D_SIZE") {
+			return false;
+		}
+		else if (key == "DOMAIN_MIN") {
+			if (!(words >> domainMin[0] >> domainMin[1] >> domainMin[2]))
+				return false;
+		}
+		else if (key == "DOMAIN_MAX") {
+			if (!(words >> domainMax[0] >> domainMax[1] >> domainMax[2]))
+				return false;
+		}
+		else if (key == "LUT_3D_INPUT_RANGE") {
+			float rangeMin, rangeMax;
+			if (!(words >> rangeMin >> rangeMax))
+				return false;
+			for (int c = 0; c < 3; c++) {
+				domainMin[c] = rangeMin;
+				domainMax[c] = rangeMax;
+			}
+		}
+	}
+
+	if (size == 0 || values.size() != (size_t)size * size * size * 3)
+		return false;
+
+	if (!SetLattice(size, values.data(), domainMin, domainMax))
+		return false;
+	m_pData->title = title;
+	return true;
+}
+
+bool spoutLut::SetLattice(unsigned int size, const float *rgb,
+	const float *domainMin, const float *domainMax)
+{
+	Clear();
+	if (!rgb || size < 2 || size > 256)
+		return false;
+
+	for (int c = 0; c < 3; c++) {
+		const float lo = domainMin ? domainMin[c] : 0.0f;
+		const float hi = domainMax ? domainMax[c] : 1.0f;
+		if (!(hi > lo))
+			return false;
+		m_Offset[c] = lo;
+		m_Scale[c] = (float)(size - 1) / (hi - lo);
+	}
+
+	const size_t points = (size_t)size * size * size;
+	std::vector<float> &lattice = m_pData->lattice;
+	lattice.resize(points * 4);
+	for (size_t i = 0; i < points; i++) {
+		lattice[i * 4 + 0] = rgb[i * 3 + 0];
+		lattice[i * 4 + 1] = rgb[i * 3 + 1];
+		lattice[i * 4 + 2] = rgb[i * 3 + 2];
+		lattice[i * 4 + 3] = 0.0f;
+	}
+	m_Size = size;
+
+	// Lattice float offset and fraction for each 8 bit value of each channel
+	const unsigned int stride[3] = { 4, 4 * size, 4 * size * size };
+	std::vector<unsigned int> &index8 = m_pData->index8;
+	std::vector<float> &fraction8 = m_pData->fraction8;
+	index8.resize(3 * 256);
+	fraction8.resize(3 * 256);
+	for (int c = 0; c < 3; c++) {
+		for (unsigned int v = 0; v < 256; v++) {
+			float x = ((float)v / 255.0f - m_Offset[c]) * m_Scale[c];
+			if (!(x > 0.0f))
+				x = 0.0f;
+			else if (x > (float)(size - 1))
+				x = (float)(size - 1);
+			const unsigned int i = (x < (float)(size - 2)) ? (unsigned int)x : size - 2;
+			index8[c * 256 + v] = i * stride[c];
+			fraction8[c * 256 + v] = x - (float)i;
+		}
+	}
+
+	return true;
+}
+
+void spoutLut::ApplyLine(const unsigned char *src, unsigned char *dst, unsigned int width,
+	SpoutRGBAFormat format, bool bBGRA, SpoutCopyTier tier) const
+{
+	if (!m_Size || !src || !dst || width == 0)
+		return;
+	if (format != SPOUT_RGBA8 && format != SPOUT_RGBA16 && format != SPOUT_RGBA32F)
+		return;
+	if (format != SPOUT_RGBA8)
+		bBGRA = false;
+	if (tier == SPOUT_COPY_SCALAR)
+		ApplyScalar(src, dst, width, format, bBGRA);
+	else
+		ApplySSE2(src, dst, width, format, bBGRA);
+}
+
+//
+// Scalar version. The same operations as the SSE2 version.
+//
+void spoutLut::ApplyScalar(const unsigned char *src, unsigned char *dst, unsigned int width,
+	SpoutRGBAFormat format, bool bBGRA) const
+{
+	const unsigned int n = m_Size;
+	const unsigned int stride[3] = { 4, 4 * n, 4 * n * n };
+	const float *lattice = m_pData->lattice.data();
+	const unsigned int *index8 = m_pData->index8.data();
+	const float *fraction8 = m_pData->fraction8.data();
+	const int ir = bBGRA ? 2 : 0;
+	const int ib = bBGRA ? 0 : 2;
+
+	for (unsigned int x = 0; x < width; x++) {
+		unsigned int base = 0;
+		float f[3];
+		if (format == SPOUT_RGBA8) {
+			const unsigned char *p = src + (size_t)x * 4;
+			const unsigned char v[3] = { p[ir], p[1], p[ib] };
+			for (int c = 0; c < 3; c++) {
+				base += index8[c * 256 + v[c]];
+				f[c] = fraction8[c * 256 + v[c]];
+			}
+		}
+		else {
+			float v[3];
+			if (format == SPOUT_RGBA16) {
+				uint16_t s[3];
+				memcpy(s, src + (size_t)x * 8, 6);
+				for (int c = 0; c < 3; c++)
+					v[c] = (float)s[c] * (1.0f / 65535.0f);
+			}
+			else {
+				memcpy(v, src + (size_t)x * 16, 12);
+			}
+			for (int c = 0; c < 3; c++) {
+				float l = (v[c] - m_Offset[c]) * m_Scale[c];
+				if (!(l > 0.0f))
+					l = 0.0f;
+				else if (l > (float)(n - 1))
+					l = (float)(n - 1);
+				const float i = (l < (float)(n - 2)) ? (float)(int)l : (float)(n - 2);
+				base += (unsigned int)i * stride[c];
+				f[c] = l - i;
+			}
+		}
+
+		const unsigned int order = (f[0] > f[1] ? 1 : 0) | (f[1] > f[2] ? 2 : 0) | (f[0] > f[2] ? 4 : 0);
+		const unsigned char *o = spout_tetra_order[order];
+		const float *c0 = lattice + base;
+		const float *c1 = c0 + stride[o[0]];
+		const float *c2 = c1 + stride[o[1]];
+		const float *c3 = lattice + base + stride[0] + stride[1] + stride[2];
+		const float x1 = f[o[0]];
+		const float x2 = f[o[1]];
+		const float x3 = f[o[2]];
+		float out[3];
+		for (int c = 0; c < 3; c++)
+			out[c] = c0[c] + x1 * (c1[c] - c0[c]) + x2 * (c2[c] - c1[c]) + x3 * (c3[c] - c2[c]);
+
+		if (format == SPOUT_RGBA8) {
+			unsigned char *d = dst + (size_t)x * 4;
+			const unsigned char a = src[(size_t)x * 4 + 3];
+			unsigned char q[3];
+			for (int c = 0; c < 3; c++) {
+				const float v = (out[c] > 0.0f) ? ((out[c] < 1.0f) ? out[c] : 1.0f) : 0.0f;
+				q[c] = (unsigned char)std::nearbyint(v * 255.0f);
+			}
+			d[ir] = q[0];
+			d[1] = q[1];
+			d[ib] = q[2];
+			d[3] = a;
+		}
+		else if (format == SPOUT_RGBA16) {
+			uint16_t q[3];
+			for (int c = 0; c < 3; c++) {
+				const float v = (out[c] > 0.0f) ? ((out[c] < 1.0f) ? out[c] : 1.0f) : 0.0f;
+				q[c] = (uint16_t)std::nearbyint(v * 65535.0f);
+			}
+			// Alpha is not written
+			memcpy(dst + (size_t)x * 8, q, 6);
+			if (dst != src)
+				memcpy(dst + (size_t)x * 8 + 6, src + (size_t)x * 8 + 6, 2);
+		}
+		else {
+			memcpy(dst + (size_t)x * 16, out, 12);
+			if (dst != src)
+				memcpy(dst + (size_t)x * 16 + 12, src + (size_t)x * 16 + 12, 4);
+		}
+	}
+}
+
+//
+// SSE2 version. Each pixel is interpolated with the three channels
+// in one register. The lattice coordinates of 16 bit and float pixels
+// are also calculated together.
+//
+void spoutLut::ApplySSE2(const unsigned char *src, unsigned char *dst, unsigned int width,
+	SpoutRGBAFormat format, bool bBGRA) const
+{
+	const unsigned int n = m_Size;
+	const unsigned int stride[3] = { 4, 4 * n, 4 * n * n };
+	const unsigned int upper = stride[0] + stride[1] + stride[2];
+	const float *lattice = m_pData->lattice.data();
+	const unsigned int *index8 = m_pData->index8.data();
+	const float *fraction8 = m_pData->fraction8.data();
+	const int ir = bBGRA ? 2 : 0;
+	const int ib = bBGRA ? 0 : 2;
+
+	// Offsets of the second and third corners for each order
+	unsigned int step1[8], step2[8];
+	for (int i = 0; i < 8; i++) {
+		step1[i] = stride[spout_tetra_order[i][0]];
+		step2[i] = step1[i] + stride[spout_tetra_order[i][1]];
+	}
+
+	const __m128 offset = _mm_setr_ps(m_Offset[0], m_Offset[1], m_Offset[2], 0.0f);
+	const __m128 scale = _mm_setr_ps(m_Scale[0], m_Scale[1], m_Scale[2], 0.0f);
+	const __m128 last = _mm_set1_ps((float)(n - 1));
+	const __m128 lastCell = _mm_set1_ps((float)(n - 2));
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128i strides = _mm_setr_epi32((int)stride[0], (int)stride[1], (int)stride[2], 0);
+
+	for (unsigned int x = 0; x < width; x++) {
+		unsigned int base = 0;
+		__m128 f;
+		if (format == SPOUT_RGBA8) {
+			const unsigned char *p = src + (size_t)x * 4;
+			const unsigned int r = p[ir], g = p[1], b = p[ib];
+			base = index8[r] + index8[256 + g] + index8[512 + b];
+			f = _mm_setr_ps(fraction8[r], fraction8[256 + g], fraction8[512 + b], 0.0f);
+		}
+		else {
+			__m128 v;
+			if (format == SPOUT_RGBA16) {
+				const __m128i i = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + (size_t)x * 8)), _mm_setzero_si128());
+				v = _mm_mul_ps(_mm_cvtepi32_ps(i), _mm_set1_ps(1.0f / 65535.0f));
+			}
+			else {
+				v = _mm_loadu_ps(reinterpret_cast<const float *>(src + (size_t)x * 16));
+			}
+			// Clamp to the lattice. _mm_max_ps returns the second operand for NaN.
+			__m128 l = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(v, offset), scale), zero), last);
+			const __m128i cell = _mm_cvttps_epi32(_mm_min_ps(l, lastCell));
+			f = _mm_sub_ps(l, _mm_cvtepi32_ps(cell));
+			// Lattice offset. No 32 bit multiply in SSE2, so multiply pairs.
+			const __m128i even = _mm_mul_epu32(cell, strides);
+			const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(cell, 32), _mm_srli_epi64(strides, 32));
+			base = (unsigned int)_mm_cvtsi128_si32(even) + (unsigned int)_mm_cvtsi128_si32(odd)
+				+ (unsigned int)_mm_cvtsi128_si32(_mm_srli_si128(even, 8));
+		}
+
+		// Order of the fractions from comparisons of (r, g, r) with (g, b, b)
+		const __m128 fa = _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 0, 1, 0));
+		const __m128 fb = _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 2, 2, 1));
+		const unsigned int order = (unsigned int)_mm_movemask_ps(_mm_cmpgt_ps(fa, fb)) & 7;
+		const unsigned char *o = spout_tetra_order[order];
+		float fs[4];
+		_mm_storeu_ps(fs, f);
+
+		const __m128 c0 = _mm_loadu_ps(lattice + base);
+		const __m128 c1 = _mm_loadu_ps(lattice + base + step1[order]);
+		const __m128 c2 = _mm_loadu_ps(lattice + base + step2[order]);
+		const __m128 c3 = _mm_loadu_ps(lattice + base + upper);
+		__m128 out = _mm_add_ps(c0, _mm_mul_ps(_mm_set1_ps(fs[o[0]]), _mm_sub_ps(c1, c0)));
+		out = _mm_add_ps(out, _mm_mul_ps(_mm_set1_ps(fs[o[1]]), _mm_sub_ps(c2, c1)));
+		out = _mm_add_ps(out, _mm_mul_ps(_mm_set1_ps(fs[o[2]]), _mm_sub_ps(c3, c2)));
+
+		if (format == SPOUT_RGBA8) {
+			const unsigned char *p = src + (size_t)x * 4;
+			__m128i q = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(out, zero), one), _mm_set1_ps(255.0f)));
+			q = _mm_packs_epi32(q, q);
+			q = _mm_packus_epi16(q, q);
+			uint32_t rgb = (uint32_t)_mm_cvtsi128_si32(q);
+			unsigned char *d = dst + (size_t)x * 4;
+			const unsigned char a = p[3];
+			d[ir] = (unsigned char)rgb;
+			d[1] = (unsigned char)(rgb >> 8);
+			d[ib] = (unsigned char)(rgb >> 16);
+			d[3] = a;
+		}
+		else if (format == SPOUT_RGBA16) {
+			__m128i q = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(out, zero), one), _mm_set1_ps(65535.0f)));
+			// No unsigned 32 to 16 bit pack in SSE2, so offset to signed and back
+			q = _mm_packs_epi32(_mm_sub_epi32(q, _mm_set1_epi32(32768)), _mm_setzero_si128());
+			q = _mm_xor_si128(q, _mm_set1_epi16((short)0x8000));
+			uint16_t s[4];
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(s), q);
+			memcpy(dst + (size_t)x * 8, s, 6);
+			if (dst != src)
+				memcpy(dst + (size_t)x * 8 + 6, src + (size_t)x * 8 + 6, 2);
+		}
+		else {
+			float s[4];
+			_mm_storeu_ps(s, out);
+			memcpy(dst + (size_t)x * 16, s, 12);
+			if (dst != src)
+				memcpy(dst + (size_t)x * 16 + 12, src + (size_t)x * 16 + 12, 4);
+		}
+	}
+}
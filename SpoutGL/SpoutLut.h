@@ -0,0 +1,74 @@
+/*
+
+					SpoutLut.h
+
+		3D colour lookup table for grading pixel buffers
+
+		Loads .cube 3D LUT files (Adobe / Resolve format) and applies
+		them to rgba pixels with tetrahedral interpolation.
+		Use spoutCopy::ApplyLut to grade an image with multiple threads.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutLut__ // standard way as well
+#define __spoutLut__
+
+#include "SpoutCopy.h"
+
+struct spoutLutData;
+
+class SPOUT_DLLEXP spoutLut {
+
+	public:
+
+		spoutLut();
+		~spoutLut();
+
+		// Load a .cube file. Returns false if the file cannot be read
+		// or is not a 3D LUT. 1D LUTs are not supported.
+		bool Load(const char *path);
+		// Load .cube text
+		bool Parse(const char *text);
+		// Set the lattice directly. "size" points on each axis (2 to 256)
+		// and size*size*size rgb values with red changing fastest.
+		// The input domain is 0-1 unless given.
+		bool SetLattice(unsigned int size, const float *rgb,
+			const float *domainMin = nullptr, const float *domainMax = nullptr);
+		void Clear();
+
+		bool IsLoaded() const;
+		unsigned int GetSize() const;
+		const char *GetTitle() const;
+
+		// Grade one line of 8 bit, 16 bit or float rgba pixels.
+		// bBGRA for 8 bit bgra pixels. Alpha is not changed.
+		// Source and destination can be the same.
+		void ApplyLine(const unsigned char *src, unsigned char *dst, unsigned int width,
+			SpoutRGBAFormat format, bool bBGRA, SpoutCopyTier tier) const;
+
+	protected :
+
+		unsigned int m_Size;
+		// Title, lattice and tables for 8 bit values
+		spoutLutData *m_pData;
+		// Input domain to lattice coordinates : (value - offset) * scale
+		float m_Offset[3];
+		float m_Scale[3];
+
+		void ApplyScalar(const unsigned char *src, unsigned char *dst, unsigned int width,
+			SpoutRGBAFormat format, bool bBGRA) const;
+		void ApplySSE2(const unsigned char *src, unsigned char *dst, unsigned int width,
+			SpoutRGBAFormat format, bool bBGRA) const;
+
+	private :
+
+		spoutLut(const spoutLut &) = delete;
+		spoutLut &operator=(const spoutLut &) = delete;
+
+};
+
+#endif
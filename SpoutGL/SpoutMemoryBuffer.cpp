@@ -0,0 +1,147 @@
+/*
+
+					SpoutMemoryBuffer.cpp
+
+		Binary header of a shared memory buffer
+
+		See SpoutMemoryBuffer.h
+
+		The header is found from the size text, which has at most 10 digits,
+		and is only used if the marker, magic number and checksum agree and
+		the size recorded in the header is the size of the text. The text is
+		read without writing a null into the map as older readers did.
+		The size text is not trusted until the header or data it gives the
+		offset of is known to be inside the view of the map, which can be
+		smaller for a map of an older writer or one that is not complete.
+
+		The checksum is FNV-1a of the 12 words before it in the header,
+		a word at a time, so that a header that is being changed by a writer
+		without the lock, or overwritten by data, is not used.
+
+	========================
+
+	16.10.26 - Create file
+			 - Find and TextSize check the size against the view of the map
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#include "SpoutMemoryBuffer.h"
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+namespace spoutmemorybuffer {
+
+	static_assert(sizeof(Header) == 64, "Header must be 64 bytes");
+	static_assert(offsetof(Header, checksum) == 48, "Checksum must follow 48 bytes");
+
+	static uint32_t Checksum(const Header *header)
+	{
+		uint32_t words[offsetof(Header, checksum) / 4];
+		memcpy(words, header, sizeof(words));
+		uint32_t hash = 2166136261u;
+		for (uint32_t word : words) {
+			hash ^= word;
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	size_t MapSize(unsigned int size)
+	{
+		return (size_t)TextBytes + size + EndBytes + sizeof(Header);
+	}
+
+	void Create(char *pBuffer, unsigned int size)
+	{
+		// Size text for older readers
+		char text[TextBytes] = {};
+		snprintf(text, sizeof(text), "%u", size);
+		memcpy(pBuffer, text, MarkerOffset);
+		memcpy(pBuffer + MarkerOffset, &Magic, sizeof(Magic));
+		pBuffer[TextBytes - 1] = 0;
+
+		Header *header = reinterpret_cast<Header *>(pBuffer + TextBytes + size + EndBytes);
+		memset(header, 0, sizeof(Header));
+		header->magic = Magic;
+		header->version = Version;
+		header->headerSize = (uint16_t)sizeof(Header);
+		header->size = size;
+		header->checksum = Checksum(header);
+	}
+
+	// Size text without a check of the view
+	static int ParseSize(const char *pBuffer)
+	{
+		// Up to 10 digits of a positive int
+		int64_t size = 0;
+		unsigned int digits = 0;
+		while (digits < 10 && pBuffer[digits] >= '0' && pBuffer[digits] <= '9') {
+			size = size * 10 + (pBuffer[digits] - '0');
+			digits++;
+		}
+		if (digits == 0 || size > 0x7FFFFFFF)
+			return -1;
+		return (int)size;
+	}
+
+	int TextSize(const char *pBuffer, size_t viewSize)
+	{
+		if (!pBuffer || viewSize < TextBytes)
+			return -1;
+
+		const int size = ParseSize(pBuffer);
+		if (size < 0 || (size_t)TextBytes + (size_t)size > viewSize)
+			return -1;
+		return size;
+	}
+
+	const Header *Find(const char *pBuffer, size_t viewSize)
+	{
+		if (!pBuffer || viewSize < TextBytes
+			|| memcmp(pBuffer + MarkerOffset, &Magic, sizeof(Magic)) != 0)
+			return nullptr;
+
+		const int size = ParseSize(pBuffer);
+		if (size < 0 || MapSize((unsigned int)size) > viewSize)
+			return nullptr;
+
+		const Header *header = reinterpret_cast<const Header *>(pBuffer + TextBytes + size + EndBytes);
+		if (!IsValid(header) || header->size != (uint32_t)size || header->length > header->size)
+			return nullptr;
+
+		return header;
+	}
+
+	Header *Find(char *pBuffer, size_t viewSize)
+	{
+		return const_cast<Header *>(Find(const_cast<const char *>(pBuffer), viewSize));
+	}
+
+	void Update(Header *header, unsigned int length, unsigned int width,
+		unsigned int height, unsigned int pitch, unsigned int format)
+	{
+		header->length = length;
+		header->width = width;
+		header->height = height;
+		header->pitch = pitch;
+		header->format = format;
+		header->frame++;
+		header->timestamp = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		header->checksum = Checksum(header);
+	}
+
+	bool IsValid(const Header *header)
+	{
+		return header
+			&& header->magic == Magic
+			&& header->version >= 1
+			&& header->headerSize >= sizeof(Header)
+			&& header->checksum == Checksum(header);
+	}
+
+}
@@ -0,0 +1,90 @@
+/*
+
+					SpoutMemoryBuffer.h
+
+		Binary header of a shared memory buffer
+
+		The first 16 bytes of a memory buffer map are the number of bytes
+		available for data as decimal text, and the data starts at byte 16.
+		Readers found the size with atoi for every read, and had nothing
+		to say what the data is or whether it has changed.
+
+		A binary header now follows the data and the 16 bytes reserved for
+		a null terminator. A marker at bytes 11 to 14, after the largest
+		size text, shows that the header is there. Older readers still find
+		the size and data where they were and ignore the rest.
+
+			0       size as decimal text, null terminated
+			11      marker "SPMH"
+			16      data
+			16 + n  null terminator space (16 bytes)
+			32 + n  header (64 bytes)
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutMemoryBuffer__ // standard way as well
+#define __spoutMemoryBuffer__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace spoutmemorybuffer {
+
+	// Bytes before the data with the size as text
+	const unsigned int TextBytes = 16;
+	// Bytes after the data for a null terminator
+	const unsigned int EndBytes = 16;
+	// Offset of the marker, after 10 digits and a null
+	const unsigned int MarkerOffset = 11;
+
+	const uint32_t Magic = 0x484D5053; // "SPMH"
+	const uint16_t Version = 1;
+
+	// Version 1 header. Later versions may add fields
+	// after these and increase headerSize.
+	struct Header {
+		uint32_t magic;
+		uint16_t version;
+		uint16_t headerSize; // Bytes of the header
+		uint32_t size;       // Bytes available for data
+		uint32_t length;     // Bytes of data in the last write
+		uint32_t width;      // Pixels, 0 for data that is not an image
+		uint32_t height;     // Lines
+		uint32_t pitch;      // Bytes of a line
+		uint32_t format;     // GL format, 0 if not known
+		uint64_t frame;      // Writes since the map was created
+		uint64_t timestamp;  // Microseconds of the writer's steady clock
+		uint32_t checksum;   // Of the 48 bytes before it
+		uint32_t reserved[3];
+	};
+
+	// Bytes of a map with "size" bytes for data
+	size_t MapSize(unsigned int size);
+
+	// Write the size text, marker and header of a new map
+	void Create(char *pBuffer, unsigned int size);
+
+	// Header of a map with "viewSize" bytes that can be read from the buffer.
+	// Returns nullptr for a map of an older writer without one, a header
+	// that is not complete, or a size that does not fit the view.
+	Header *Find(char *pBuffer, size_t viewSize);
+	const Header *Find(const char *pBuffer, size_t viewSize);
+
+	// Data size from the text of any map, without changing the map.
+	// Returns -1 if there is no size or the data does not fit the view.
+	int TextSize(const char *pBuffer, size_t viewSize);
+
+	// Record a write of "length" bytes in the header
+	void Update(Header *header, unsigned int length, unsigned int width = 0,
+		unsigned int height = 0, unsigned int pitch = 0, unsigned int format = 0);
+
+	// Check the magic number, version and checksum
+	bool IsValid(const Header *header);
+
+}
+
+#endif
@@ -0,0 +1,537 @@
+/*
+
+					SpoutMemoryRing.cpp
+
+		Ring buffer of frames in shared memory
+
+		Layout
+
+		A 64 byte ring header is followed by the slots. Each slot has a
+		64 byte header with a sequence lock and the frame header, followed
+		by the data at a 64 byte boundary.
+
+			ring header   magic, version, slots, slot size, slot stride,
+			              newest frame number, closed, newest slot
+			slot 0        sequence, frame header, leases, data
+			slot 1        ...
+
+		The writer fills the first slot after the newest that is not
+		leased, or the one after the newest if they all are. It changes
+		the sequence of the slot around each write and then makes the
+		slot and frame number the newest. A reader takes the newest slot,
+		copies it and keeps the copy if the sequence did not change.
+		With 3 slots the writer has to complete two more frames during
+		a copy before the slot being read is reused.
+
+		A lease counts itself in the slot while it is held and checks the
+		sequence when it is released. The count only steers the writer,
+		so a reader that exits without releasing a lease makes the writer
+		skip that slot but can not stop it.
+
+		The writer does not use the mutex of the shared memory and there
+		must only be one writer for a ring.
+
+	========================
+
+	16.10.26 - Create file
+			 - Add Lease. The writer skips leased slots, so the slot of
+			   a frame is recorded in the ring header (version 2).
+			 - Add SetLargePages and SetNumaNode for the shared memory.
+			 - Count leases and keep the map of a ring closed while
+			   any are held until the last is released.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#include "SpoutMemoryRing.h"
+#include "SpoutSeqLock.h"
+#include <atomic>
+#include <assert.h>
+#include <chrono>
+#include <climits>
+#include <string.h>
+
+namespace {
+
+	const uint32_t RingMagic = 0x47525053; // "SPRG"
+	const uint32_t RingVersion = 2;
+	const unsigned int RingAlign = 64;
+	// Attempts by Read before it gives up
+	const unsigned int RingRetries = 8;
+
+	struct RingHeader {
+		std::atomic<uint32_t> magic; // Set last by the writer
+		uint32_t version;
+		uint32_t slots;
+		uint32_t slotSize;   // Bytes of data in each slot
+		uint32_t slotStride; // Bytes from one slot to the next
+		std::atomic<uint32_t> latest; // Newest complete frame, 0 for none
+		std::atomic<uint32_t> closed; // Set when the writer closes
+		std::atomic<uint32_t> newest; // Slot of the newest frame
+	};
+
+	struct SlotHeader {
+		spoutseqlock::Header lock;
+		spoutMemoryFrame frame;
+		std::atomic<uint32_t> leases; // Readers holding a lease of the slot
+	};
+
+	static_assert(sizeof(RingHeader) <= RingAlign, "RingHeader must fit 64 bytes");
+	static_assert(sizeof(SlotHeader) <= RingAlign, "SlotHeader must fit 64 bytes");
+
+	RingHeader *GetRingHeader(char *pBuffer)
+	{
+		return reinterpret_cast<RingHeader *>(pBuffer);
+	}
+
+	SlotHeader *GetSlotHeader(char *pBuffer, unsigned int stride, unsigned int slot)
+	{
+		return reinterpret_cast<SlotHeader *>(pBuffer + RingAlign + (size_t)slot * stride);
+	}
+
+	unsigned char *GetSlotData(char *pBuffer, unsigned int stride, unsigned int slot)
+	{
+		return reinterpret_cast<unsigned char *>(pBuffer + RingAlign + (size_t)slot * stride + RingAlign);
+	}
+
+}
+
+spoutMemoryRing::spoutMemoryRing()
+{
+	m_pBuffer = nullptr;
+	m_bWriter = false;
+	m_slots = 0;
+	m_slotSize = 0;
+	m_slotStride = 0;
+	m_writeFrame = 0;
+	m_writeSlot = 0;
+	m_readFrame = 0;
+	m_leases.store(0, std::memory_order_relaxed);
+	m_bUnmap.store(false, std::memory_order_relaxed);
+}
+
+spoutMemoryRing::~spoutMemoryRing()
+{
+	// A lease can not outlive the ring
+	assert(m_leases.load() == 0);
+	Close();
+}
+
+bool spoutMemoryRing::Create(const char *name, unsigned int slotSize, unsigned int slots)
+{
+	if (!name || !name[0] || slotSize == 0 || slots < 2)
+		return false;
+
+	if (m_pBuffer) {
+		if (m_bWriter && slots == m_slots && slotSize == m_slotSize)
+			return true;
+		Close();
+	}
+
+	// The map of the last ring is still leased
+	if (m_bUnmap.load())
+		return false;
+
+	const uint64_t stride = RingAlign + ((uint64_t)slotSize + RingAlign - 1) / RingAlign * RingAlign;
+	const uint64_t size = RingAlign + stride * slots;
+	if (size > (uint64_t)INT_MAX)
+		return false;
+
+	const SpoutCreateResult result = m_memory.Create(name, (int)size);
+	if (result == SPOUT_CREATE_FAILED)
+		return false;
+
+	char *pBuffer = m_memory.Buffer();
+	RingHeader *header = GetRingHeader(pBuffer);
+	if (result == SPOUT_ALREADY_EXISTS) {
+		// A ring that has not been released by all readers. It can only be
+		// used again if it is the same size, otherwise try again when the
+		// readers have found that it is closed. A map that is not a ring
+		// keeps the size it was created with and is not used.
+		if (header->magic.load(std::memory_order_acquire) != RingMagic
+			|| header->version != RingVersion || header->slots != slots || header->slotSize != slotSize
+			|| m_memory.ViewSize() < size) {
+			m_memory.Close();
+			return false;
+		}
+		header->closed.store(0, std::memory_order_release);
+	}
+	else {
+		header->version = RingVersion;
+		header->slots = slots;
+		header->slotSize = slotSize;
+		header->slotStride = (uint32_t)stride;
+		header->latest.store(0, std::memory_order_relaxed);
+		header->closed.store(0, std::memory_order_relaxed);
+		header->newest.store(0, std::memory_order_relaxed);
+		for (unsigned int i = 0; i < slots; i++) {
+			SlotHeader *slot = GetSlotHeader(pBuffer, (unsigned int)stride, i);
+			slot->lock.magic.store(0, std::memory_order_relaxed);
+			slot->lock.sequence.store(0, std::memory_order_relaxed);
+			slot->frame = spoutMemoryFrame();
+			slot->leases.store(0, std::memory_order_relaxed);
+		}
+		header->magic.store(RingMagic, std::memory_order_release);
+	}
+
+	m_pBuffer = pBuffer;
+	m_bWriter = true;
+	m_slots = slots;
+	m_slotSize = slotSize;
+	m_slotStride = (unsigned int)stride;
+	m_writeFrame = 0;
+	m_readFrame = 0;
+
+	return true;
+}
+
+bool spoutMemoryRing::Open(const char *name)
+{
+	if (!name || !name[0])
+		return false;
+
+	if (m_pBuffer)
+		return true;
+
+	// The map of the last ring is still leased
+	if (m_bUnmap.load())
+		return false;
+
+	if (!m_memory.Open(name))
+		return false;
+
+	// A ring that is not ready or has been closed by the writer
+	char *pBuffer = m_memory.Buffer();
+	RingHeader *header = GetRingHeader(pBuffer);
+	if (header->magic.load(std::memory_order_acquire) != RingMagic
+		|| header->version != RingVersion
+		|| header->slots < 2
+		|| header->slotStride < RingAlign + (uint64_t)header->slotSize
+		|| m_memory.ViewSize() < RingAlign + (uint64_t)header->slotStride * header->slots
+		|| header->closed.load(std::memory_order_acquire)) {
+		m_memory.Close();
+		return false;
+	}
+
+	m_pBuffer = pBuffer;
+	m_bWriter = false;
+	m_slots = header->slots;
+	m_slotSize = header->slotSize;
+	m_slotStride = header->slotStride;
+	m_writeFrame = 0;
+	m_readFrame = 0;
+
+	return true;
+}
+
+void spoutMemoryRing::Close()
+{
+	if (m_pBuffer && m_bWriter)
+		GetRingHeader(m_pBuffer)->closed.store(1, std::memory_order_release);
+
+	m_pBuffer = nullptr;
+	m_bWriter = false;
+	m_slots = 0;
+	m_slotSize = 0;
+	m_slotStride = 0;
+	m_writeFrame = 0;
+	m_readFrame = 0;
+
+	// Unmap now, or when the last lease is released
+	m_bUnmap.store(true);
+	if (m_leases.load() == 0)
+		Unmap();
+}
+
+void spoutMemoryRing::ReleaseLease()
+{
+	if (m_leases.fetch_sub(1) == 1)
+		Unmap();
+}
+
+void spoutMemoryRing::Unmap()
+{
+	// Only once if Close and the last lease race
+	if (m_bUnmap.exchange(false))
+		m_memory.Close();
+}
+
+bool spoutMemoryRing::IsOpen() const
+{
+	return m_pBuffer != nullptr;
+}
+
+bool spoutMemoryRing::IsWriter() const
+{
+	return m_pBuffer && m_bWriter;
+}
+
+bool spoutMemoryRing::IsClosed() const
+{
+	return m_pBuffer && GetRingHeader(m_pBuffer)->closed.load(std::memory_order_acquire) != 0;
+}
+
+unsigned int spoutMemoryRing::GetSlots() const
+{
+	return m_slots;
+}
+
+unsigned int spoutMemoryRing::GetSlotSize() const
+{
+	return m_slotSize;
+}
+
+void spoutMemoryRing::SetLargePages(bool bLarge)
+{
+	m_memory.SetLargePages(bLarge);
+}
+
+void spoutMemoryRing::SetNumaNode(int node)
+{
+	m_memory.SetNumaNode(node);
+}
+
+bool spoutMemoryRing::IsLargePages()
+{
+	return m_memory.IsLargePages();
+}
+
+unsigned char *spoutMemoryRing::BeginWrite()
+{
+	if (!m_pBuffer || !m_bWriter)
+		return nullptr;
+
+	// Frame numbers start again from 1 after wrapping around
+	RingHeader *header = GetRingHeader(m_pBuffer);
+	m_writeFrame = header->latest.load(std::memory_order_relaxed) + 1;
+	if (m_writeFrame == 0)
+		m_writeFrame = 1;
+
+	// The first slot after the newest that is not leased,
+	// or the oldest if every slot is
+	const unsigned int newest = header->newest.load(std::memory_order_relaxed);
+	m_writeSlot = (newest + 1) % m_slots;
+	for (unsigned int i = 1; i < m_slots; i++) {
+		const unsigned int slot = (newest + i) % m_slots;
+		if (GetSlotHeader(m_pBuffer, m_slotStride, slot)->leases.load(std::memory_order_seq_cst) == 0) {
+			m_writeSlot = slot;
+			break;
+		}
+	}
+	spoutseqlock::BeginWrite(&GetSlotHeader(m_pBuffer, m_slotStride, m_writeSlot)->lock);
+
+	return GetSlotData(m_pBuffer, m_slotStride, m_writeSlot);
+}
+
+void spoutMemoryRing::EndWrite(unsigned int format, unsigned int width, unsigned int height,
+	unsigned int pitch, unsigned int size)
+{
+	if (!m_pBuffer || !m_bWriter || m_writeFrame == 0)
+		return;
+
+	SlotHeader *slot = GetSlotHeader(m_pBuffer, m_slotStride, m_writeSlot);
+	spoutMemoryFrame &frame = slot->frame;
+	frame.timestamp = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	frame.frame = m_writeFrame;
+	frame.format = format;
+	frame.width = width;
+	frame.height = height;
+	frame.pitch = pitch;
+	frame.size = (size < m_slotSize) ? size : m_slotSize;
+	spoutseqlock::EndWrite(&slot->lock);
+
+	RingHeader *header = GetRingHeader(m_pBuffer);
+	header->newest.store(m_writeSlot, std::memory_order_release);
+	header->latest.store(m_writeFrame, std::memory_order_release);
+	m_writeFrame = 0;
+}
+
+bool spoutMemoryRing::Write(const void *data, unsigned int size, unsigned int format,
+	unsigned int width, unsigned int height, unsigned int pitch)
+{
+	if (!data || size > m_slotSize)
+		return false;
+
+	unsigned char *pSlot = BeginWrite();
+	if (!pSlot)
+		return false;
+
+	memcpy(pSlot, data, size);
+	EndWrite(format, width, height, pitch, size);
+
+	return true;
+}
+
+unsigned int spoutMemoryRing::GetLatestFrame() const
+{
+	if (!m_pBuffer)
+		return 0;
+	return GetRingHeader(m_pBuffer)->latest.load(std::memory_order_acquire);
+}
+
+bool spoutMemoryRing::IsNewFrame() const
+{
+	const unsigned int latest = GetLatestFrame();
+	return latest != 0 && latest != m_readFrame;
+}
+
+bool spoutMemoryRing::Read(const std::function<void(const unsigned char *data,
+	const spoutMemoryFrame &frame)> &function, spoutMemoryFrame *frame)
+{
+	const unsigned int readFrame = m_readFrame;
+
+	for (unsigned int i = 0; i < RingRetries; i++) {
+		Lease lease = Acquire();
+		if (!lease.IsValid())
+			break;
+		function(lease.Data(), lease.Frame());
+		if (lease.Release()) {
+			if (frame)
+				*frame = lease.Frame();
+			return true;
+		}
+	}
+
+	// Not read after all
+	if (m_pBuffer)
+		m_readFrame = readFrame;
+
+	return false;
+}
+
+bool spoutMemoryRing::Read(void *data, unsigned int maxBytes, spoutMemoryFrame *frame)
+{
+	if (!data)
+		return false;
+
+	return Read([&](const unsigned char *pSlot, const spoutMemoryFrame &info) {
+		memcpy(data, pSlot, (info.size < maxBytes) ? info.size : maxBytes);
+	}, frame);
+}
+
+spoutMemoryRing::Lease spoutMemoryRing::Acquire()
+{
+	Lease lease;
+	if (!m_pBuffer)
+		return lease;
+
+	// Release a ring that the writer has closed
+	RingHeader *header = GetRingHeader(m_pBuffer);
+	if (!m_bWriter && IsClosed()) {
+		Close();
+		return lease;
+	}
+
+	for (unsigned int i = 0; i < RingRetries; i++) {
+		if (header->latest.load(std::memory_order_acquire) == 0)
+			return lease;
+		const unsigned int newest = header->newest.load(std::memory_order_acquire);
+		if (newest >= m_slots)
+			return lease;
+		// Counted before the sequence is read. A writer that chose the
+		// slot before the count changes the sequence, which is found.
+		SlotHeader *slot = GetSlotHeader(m_pBuffer, m_slotStride, newest);
+		slot->leases.fetch_add(1, std::memory_order_seq_cst);
+		const uint32_t sequence = spoutseqlock::ReadBegin(&slot->lock);
+		if ((sequence & 1) == 0) {
+			spoutMemoryFrame info;
+			memcpy(&info, &slot->frame, sizeof(info));
+			if (spoutseqlock::ReadEnd(&slot->lock, sequence) && info.frame != 0 && info.size <= m_slotSize) {
+				m_leases.fetch_add(1);
+				lease.m_pRing = this;
+				lease.m_pSlot = reinterpret_cast<char *>(slot);
+				lease.m_sequence = sequence;
+				lease.m_frame = info;
+				m_readFrame = info.frame;
+				return lease;
+			}
+		}
+		slot->leases.fetch_sub(1, std::memory_order_release);
+	}
+
+	return lease;
+}
+
+//
+// Lease
+//
+
+spoutMemoryRing::Lease::Lease()
+{
+	m_pRing = nullptr;
+	m_pSlot = nullptr;
+	m_sequence = 0;
+	memset(&m_frame, 0, sizeof(m_frame));
+}
+
+spoutMemoryRing::Lease::Lease(Lease &&other) noexcept
+{
+	m_pRing = other.m_pRing;
+	m_pSlot = other.m_pSlot;
+	m_sequence = other.m_sequence;
+	m_frame = other.m_frame;
+	other.m_pRing = nullptr;
+	other.m_pSlot = nullptr;
+}
+
+spoutMemoryRing::Lease &spoutMemoryRing::Lease::operator=(Lease &&other) noexcept
+{
+	if (this != &other) {
+		Release();
+		m_pRing = other.m_pRing;
+		m_pSlot = other.m_pSlot;
+		m_sequence = other.m_sequence;
+		m_frame = other.m_frame;
+		other.m_pRing = nullptr;
+		other.m_pSlot = nullptr;
+	}
+	return *this;
+}
+
+spoutMemoryRing::Lease::~Lease()
+{
+	Release();
+}
+
+bool spoutMemoryRing::Lease::Release()
+{
+	if (!m_pSlot)
+		return false;
+
+	SlotHeader *slot = reinterpret_cast<SlotHeader *>(m_pSlot);
+	const bool bValid = spoutseqlock::ReadEnd(&slot->lock, m_sequence);
+	slot->leases.fetch_sub(1, std::memory_order_release);
+	m_pSlot = nullptr;
+
+	// The ring may unmap a closed map now
+	spoutMemoryRing *pRing = m_pRing;
+	m_pRing = nullptr;
+	pRing->ReleaseLease();
+
+	return bValid;
+}
+
+bool spoutMemoryRing::Lease::IsValid() const
+{
+	return m_pSlot && spoutseqlock::ReadEnd(&reinterpret_cast<SlotHeader *>(m_pSlot)->lock, m_sequence);
+}
+
+const unsigned char *spoutMemoryRing::Lease::Data() const
+{
+	if (!m_pSlot)
+		return nullptr;
+	return reinterpret_cast<const unsigned char *>(m_pSlot + RingAlign);
+}
+
+unsigned int spoutMemoryRing::Lease::Size() const
+{
+	return m_pSlot ? m_frame.size : 0;
+}
+
+const spoutMemoryFrame &spoutMemoryRing::Lease::Frame() const
+{
+	return m_frame;
+}
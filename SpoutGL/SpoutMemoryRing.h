@@ -0,0 +1,186 @@
+/*
+
+					SpoutMemoryRing.h
+
+		Ring buffer of frames in shared memory
+
+		A single shared memory region with one mutex makes the sender wait
+		for every read and a slow receiver holds up the sender. The ring
+		has a number of slots (3 by default), each with a header giving the
+		frame number, time, format, size and line pitch. The writer fills
+		the slot after the newest frame without a lock and never waits for
+		readers. A reader copies the newest complete frame and checks the
+		sequence of the slot to find whether the writer has reused it
+		during the copy (see SpoutSeqLock.h), so a frame is never torn.
+
+			Sender :
+				ring.Create("name", width * height * 4);
+				unsigned char *data = ring.BeginWrite();
+				... write the frame
+				ring.EndWrite(GL_RGBA, width, height, width * 4, width * height * 4);
+
+			Receiver :
+				ring.Open("name");
+				if (ring.IsNewFrame())
+					ring.Read(pixels, maxBytes, &frame);
+
+		A receiver that converts the frame can lease the slot instead
+		of copying it out first. The writer does not reuse a leased slot
+		while another is free, and Release reports whether it had to.
+
+				spoutMemoryRing::Lease lease = ring.Acquire();
+				... convert from lease.Data()
+				if (!lease.Release())
+					... the frame was overwritten, discard the result
+
+		The ring counts its leases and a ring closed while any are held
+		stays mapped until the last is released. It can not be created
+		or opened again until then.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutMemoryRing__ // standard way as well
+#define __spoutMemoryRing__
+
+#include "SpoutSharedMemory.h"
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+
+// Header of a frame in a slot
+struct spoutMemoryFrame {
+	uint64_t timestamp; // microseconds of the writer's steady clock at EndWrite
+	uint32_t frame;     // frame number from 1
+	uint32_t format;    // GL format, or 0 for data
+	uint32_t width;     // pixels
+	uint32_t height;    // lines
+	uint32_t pitch;     // bytes of a line
+	uint32_t size;      // bytes of the frame
+};
+
+class SPOUT_DLLEXP spoutMemoryRing {
+
+	public:
+
+		spoutMemoryRing();
+		~spoutMemoryRing();
+
+		static const unsigned int DefaultSlots = 3;
+
+		// Create the ring for a writer with slots of "slotSize" bytes.
+		// A ring that exists already is used if it is the same size.
+		bool Create(const char *name, unsigned int slotSize, unsigned int slots = DefaultSlots);
+		// Open a ring created by a writer
+		bool Open(const char *name);
+		// Close the ring. Readers close it when the writer has.
+		// The map is kept until leases of it are released.
+		void Close();
+
+		bool IsOpen() const;
+		bool IsWriter() const;
+		// True if the writer has closed the ring. A reader should close
+		// it too, so that the writer can create it again at another size.
+		bool IsClosed() const;
+		unsigned int GetSlots() const;
+		unsigned int GetSlotSize() const;
+		// Large pages and NUMA node of a ring created after this
+		// (see SpoutSharedMemory::SetLargePages and SetNumaNode)
+		void SetLargePages(bool bLarge);
+		void SetNumaNode(int node);
+		bool IsLargePages();
+
+		// Writer
+		// Data of the slot for the next frame. This is never the newest
+		// frame, so the writer does not wait for readers.
+		unsigned char *BeginWrite();
+		// Make the frame written the newest with a header
+		void EndWrite(unsigned int format, unsigned int width, unsigned int height,
+			unsigned int pitch, unsigned int size);
+		// Copy a frame to the next slot
+		bool Write(const void *data, unsigned int size, unsigned int format = 0,
+			unsigned int width = 0, unsigned int height = 0, unsigned int pitch = 0);
+
+		// Reader
+		// Frame number of the newest frame, 0 if none has been written
+		unsigned int GetLatestFrame() const;
+		// True if the newest frame has not been read
+		bool IsNewFrame() const;
+		// Call "function" with the data and header of the newest frame.
+		// It is called again with the next newest frame if the writer
+		// reused the slot while it was running, and must only copy or
+		// upload the data. The header size is not more than the slot size.
+		// Returns false if there is no frame or no consistent frame
+		// after a few attempts.
+		bool Read(const std::function<void(const unsigned char *data,
+			const spoutMemoryFrame &frame)> &function, spoutMemoryFrame *frame = nullptr);
+		// Copy the newest frame, up to "maxBytes"
+		bool Read(void *data, unsigned int maxBytes, spoutMemoryFrame *frame = nullptr);
+
+		// Read only view of the slot of a frame. The slot is marked as
+		// leased so that the writer uses another while it can, but the
+		// writer never waits and with every other slot leased it writes
+		// the oldest anyway. Release or IsValid show whether that has
+		// happened. Release the lease before the ring is destroyed.
+		class SPOUT_DLLEXP Lease {
+
+			public:
+
+				Lease();
+				Lease(Lease &&other) noexcept;
+				Lease &operator=(Lease &&other) noexcept;
+				~Lease();
+
+				// End the lease. Returns true if the slot was not written
+				// during the lease, so what was read from it is the frame.
+				bool Release();
+				// True if a frame is leased and its slot has not been written
+				bool IsValid() const;
+				const unsigned char *Data() const;
+				unsigned int Size() const;
+				const spoutMemoryFrame &Frame() const;
+
+			private:
+
+				friend class spoutMemoryRing;
+				spoutMemoryRing *m_pRing;
+				char *m_pSlot; // slot header
+				uint32_t m_sequence;
+				spoutMemoryFrame m_frame;
+
+				Lease(const Lease &) = delete;
+				Lease &operator=(const Lease &) = delete;
+
+		};
+
+		// Lease the newest frame. The lease is not valid if there is none.
+		Lease Acquire();
+
+	protected :
+
+		SpoutSharedMemory m_memory;
+		char *m_pBuffer;
+		bool m_bWriter;
+		unsigned int m_slots;
+		unsigned int m_slotSize;
+		unsigned int m_slotStride;
+		unsigned int m_writeFrame; // frame number between BeginWrite and EndWrite
+		unsigned int m_writeSlot;  // slot between BeginWrite and EndWrite
+		unsigned int m_readFrame;  // frame number of the last Read
+		std::atomic<unsigned int> m_leases; // leases held
+		std::atomic<bool> m_bUnmap; // closed, unmap when no lease is held
+
+	private :
+
+		void ReleaseLease();
+		void Unmap();
+
+		spoutMemoryRing(const spoutMemoryRing &) = delete;
+		spoutMemoryRing &operator=(const spoutMemoryRing &) = delete;
+
+};
+
+#endif
@@ -67,6 +67,9 @@
 //		24.04.21	- Add OpenGL shared texture access functions
 //		03.06.21	- Add GetMemoryBufferSize
 //		15.10.21	- Allow no argument for SetReceiverName
+//		16.10.26	- Add ReadMemoryBuffer overload with the buffer header
+//					- Add LeaseMemoryBuffer and LeaseMemoryPixels
+//					- Add WaitNewFrame
 //
 // ====================================================================================
 //
@@ -183,6 +186,12 @@ bool SpoutReceiver::IsFrameNew()
 	return spout.IsFrameNew();
 }
 
+//---------------------------------------------------------
+bool SpoutReceiver::WaitNewFrame(DWORD dwTimeout)
+{
+	return spout.WaitNewFrame(dwTimeout);
+}
+
 //---------------------------------------------------------
 DWORD SpoutReceiver::GetSenderFormat()
 {
@@ -289,6 +298,24 @@ int SpoutReceiver::ReadMemoryBuffer(const char* name, char* data, int maxlength)
 	return spout.ReadMemoryBuffer(name, data, maxlength);
 }
 
+//---------------------------------------------------------
+int SpoutReceiver::ReadMemoryBuffer(const char* name, char* data, int maxlength, spoutmemorybuffer::Header* header)
+{
+	return spout.ReadMemoryBuffer(name, data, maxlength, header);
+}
+
+//---------------------------------------------------------
+SpoutSharedMemory::Lease SpoutReceiver::LeaseMemoryBuffer(const char* name, spoutmemorybuffer::Header* header)
+{
+	return spout.LeaseMemoryBuffer(name, header);
+}
+
+//---------------------------------------------------------
+spoutMemoryRing::Lease SpoutReceiver::LeaseMemoryPixels(const char* sendername)
+{
+	return spout.LeaseMemoryPixels(sendername);
+}
+
 //---------------------------------------------------------
 int SpoutReceiver::GetMemoryBufferSize(const char* name)
 {
@@ -70,6 +70,8 @@ class SPOUT_DLLEXP SpoutReceiver {
 	//   The receiving texture or pixel buffer is only refreshed if the sender has produced a new frame  
 	//   This can be queried to process texture data only for new frames
 	bool IsFrameNew();
+	// Wait for the sender to produce a new frame
+	bool WaitNewFrame(DWORD dwTimeout = INFINITE);
 	// Received sender name
 	const char * GetSenderName();
 	// Received sender width
@@ -114,6 +116,12 @@ class SPOUT_DLLEXP SpoutReceiver {
 
 	// Read data
 	int ReadMemoryBuffer(const char* name, char* data, int maxlength);
+	// Read data, and the buffer header if the sender wrote one
+	int ReadMemoryBuffer(const char* name, char* data, int maxlength, spoutmemorybuffer::Header* header);
+	// Lease the data without a copy, locked until the lease is released
+	SpoutSharedMemory::Lease LeaseMemoryBuffer(const char* name, spoutmemorybuffer::Header* header = nullptr);
+	// Lease the newest frame of a sender writing memoryshare pixels
+	spoutMemoryRing::Lease LeaseMemoryPixels(const char* sendername);
 	// Get the size of a shared memory buffer
 	int GetMemoryBufferSize(const char* name);
 
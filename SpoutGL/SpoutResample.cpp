@@ -0,0 +1,535 @@
+/*
+
+					SpoutResample.cpp
+
+		Separable image resampling for spoutCopy
+
+		An image is resampled in two passes. For each destination line,
+		the source lines used are first combined vertically to one line of
+		16 bit channels, which is then resampled horizontally. The weights
+		are 14 bit fixed point so that both passes use the SSE2 16 bit
+		multiply-add on pairs of lines or pixels.
+
+		Bilinear maps pixel centres : src = (dst + 0.5) * srcSize/dstSize - 0.5
+		Area weights each source pixel by its overlap with the destination pixel.
+		Nearest uses src = dst * srcSize/dstSize as the previous resample functions.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutResample.h"
+#include <string.h>
+#include <mutex>
+#include <utility> // for std::swap
+
+namespace spoutresample {
+
+	// Number of axes kept. Enough for the horizontal and vertical
+	// axes of several senders and receivers of different sizes.
+	static const size_t cacheSize = 16;
+
+	//
+	// Calculate the source pixels and weights for each destination pixel
+	//
+	static void BuildAxis(spoutResampleAxis &axis)
+	{
+		const unsigned int src = axis.srcSize;
+		const unsigned int n = axis.dstSize;
+		axis.first.resize(n);
+
+		if (axis.filter == SPOUT_RESAMPLE_NEAREST) {
+			axis.taps = 1;
+			for (unsigned int i = 0; i < n; i++)
+				axis.first[i] = (unsigned int)((uint64_t)i * src / n);
+		}
+		else {
+			// Most source pixels used by any destination pixel, rounded up to even
+			unsigned int taps = 2;
+			if (axis.filter == SPOUT_RESAMPLE_AREA)
+				taps = (src + n - 1) / n + 1;
+			taps = (taps + 1) & ~1u;
+			axis.taps = taps;
+			axis.weights.assign((size_t)n * taps, 0);
+
+			std::vector<int> w(taps);
+			for (unsigned int i = 0; i < n; i++) {
+
+				unsigned int k0 = 0; // first source pixel used
+				unsigned int count = 0; // number of source pixels used
+
+				if (axis.filter == SPOUT_RESAMPLE_BILINEAR) {
+					// Source position in 16.16 fixed point
+					int64_t pos = (int64_t)(((uint64_t)(2 * i + 1) * src << 16) / (2 * (uint64_t)n)) - 32768;
+					if (pos < 0) pos = 0;
+					k0 = (unsigned int)(pos >> 16);
+					const int frac = (int)(pos & 0xFFFF) >> (16 - SPOUT_RESAMPLE_BITS);
+					if (k0 + 1 >= src || frac == 0) {
+						k0 = (k0 < src) ? k0 : src - 1;
+						w[0] = SPOUT_RESAMPLE_ONE;
+						count = 1;
+					}
+					else {
+						w[0] = SPOUT_RESAMPLE_ONE - frac;
+						w[1] = frac;
+						count = 2;
+					}
+				}
+				else {
+					// In units of 1/n of a source pixel, destination pixel i
+					// covers [i*src, (i+1)*src) and source pixel k covers [k*n, (k+1)*n)
+					const uint64_t start = (uint64_t)i * src;
+					const uint64_t end = start + src;
+					k0 = (unsigned int)(start / n);
+					const unsigned int k1 = (unsigned int)((end - 1) / n);
+					count = k1 - k0 + 1;
+					int sum = 0;
+					unsigned int largest = 0;
+					for (unsigned int k = 0; k < count; k++) {
+						const uint64_t lo = (uint64_t)(k0 + k) * n;
+						const uint64_t overlap = (end < lo + n ? end : lo + n) - (start > lo ? start : lo);
+						w[k] = (int)((overlap * SPOUT_RESAMPLE_ONE + src / 2) / src);
+						sum += w[k];
+						if (w[k] > w[largest])
+							largest = k;
+					}
+					// Rounding error to the largest weight so that the total is exact
+					w[largest] += SPOUT_RESAMPLE_ONE - sum;
+				}
+
+				// Move the window back from the end of the source
+				unsigned int f = k0;
+				if (f + taps > src)
+					f = src > taps ? src - taps : 0;
+				axis.first[i] = f;
+				for (unsigned int k = 0; k < count; k++)
+					axis.weights[(size_t)i * taps + (k0 - f) + k] = (int16_t)w[k];
+			}
+		}
+
+		if (axis.bMirror) {
+			const unsigned int taps = axis.taps;
+			for (unsigned int i = 0; i < n / 2; i++) {
+				const unsigned int j = n - 1 - i;
+				std::swap(axis.first[i], axis.first[j]);
+				if (!axis.weights.empty()) {
+					for (unsigned int t = 0; t < taps; t++)
+						std::swap(axis.weights[(size_t)i * taps + t], axis.weights[(size_t)j * taps + t]);
+				}
+			}
+		}
+	}
+
+
+	std::shared_ptr<const spoutResampleAxis> GetAxis(SpoutResampleFilter filter,
+		unsigned int srcSize, unsigned int dstSize, bool bMirror)
+	{
+		static std::mutex cacheMutex;
+		static std::vector<std::shared_ptr<const spoutResampleAxis>> cache;
+
+		if (srcSize == 0 || dstSize == 0)
+			return nullptr;
+
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		// Most recently used first
+		for (size_t i = 0; i < cache.size(); i++) {
+			const spoutResampleAxis &axis = *cache[i];
+			if (axis.filter == filter && axis.srcSize == srcSize
+				&& axis.dstSize == dstSize && axis.bMirror == bMirror) {
+				std::shared_ptr<const spoutResampleAxis> found = cache[i];
+				cache.erase(cache.begin() + i);
+				cache.insert(cache.begin(), found);
+				return found;
+			}
+		}
+
+		auto axis = std::make_shared<spoutResampleAxis>();
+		axis->filter = filter;
+		axis->srcSize = srcSize;
+		axis->dstSize = dstSize;
+		axis->bMirror = bMirror;
+		BuildAxis(*axis);
+
+		if (cache.size() >= cacheSize)
+			cache.pop_back();
+		cache.insert(cache.begin(), axis);
+
+		return axis;
+	}
+
+
+	void NearestRow(const spoutResampleAxis &axis, const unsigned char *src, unsigned char *dst,
+		unsigned int pixelBytes)
+	{
+		const unsigned int *first = axis.first.data();
+		for (unsigned int x = 0; x < axis.dstSize; x++)
+			memcpy(dst + (size_t)x * pixelBytes, src + (size_t)first[x] * pixelBytes, pixelBytes);
+	}
+
+
+	// Pair of weights w[0] w[1] as one 32 bit value for the 16 bit multiply-add
+	static inline int WeightPair(const int16_t *w)
+	{
+		return (int)(uint16_t)w[0] | ((int)w[1] << 16);
+	}
+
+	//
+	// Vertical pass
+	//
+	// The SIMD versions interleave the channels of two lines a0 b0 a1 b1 ...
+	// to multiply by the pair of weights wa wb and add.
+	// They return the number of channels done.
+	//
+
+	static unsigned int VerticalRowSSE2(const unsigned char *const *rows, const int16_t *weights,
+		unsigned int taps, unsigned int count, int16_t *dst)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi32(64);
+		const __m128i w01 = _mm_set1_epi32(WeightPair(weights));
+		unsigned int i = 0;
+		for (; i + 16 <= count; i += 16) {
+			__m128i sum0 = zero, sum1 = zero, sum2 = zero, sum3 = zero;
+			for (unsigned int t = 0; t < taps; t += 2) {
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[t] + i));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[t + 1] + i));
+				const __m128i lo = _mm_unpacklo_epi8(a, b);
+				const __m128i hi = _mm_unpackhi_epi8(a, b);
+				const __m128i wt = (t == 0) ? w01 : _mm_set1_epi32(WeightPair(weights + t));
+				sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), wt));
+				sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), wt));
+				sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), wt));
+				sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), wt));
+			}
+			sum0 = _mm_srai_epi32(_mm_add_epi32(sum0, round), 7);
+			sum1 = _mm_srai_epi32(_mm_add_epi32(sum1, round), 7);
+			sum2 = _mm_srai_epi32(_mm_add_epi32(sum2, round), 7);
+			sum3 = _mm_srai_epi32(_mm_add_epi32(sum3, round), 7);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(sum0, sum1));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8), _mm_packs_epi32(sum2, sum3));
+		}
+		return i;
+	}
+
+	// The unpack and pack work within each 128 bit lane.
+	// Sums 0-3 are channels 0-3 4-7 8-11 12-15 in the low lane
+	// and 16-19 20-23 24-27 28-31 in the high lane.
+	SPOUT_TARGET_AVX2
+	static unsigned int VerticalRowAVX2(const unsigned char *const *rows, const int16_t *weights,
+		unsigned int taps, unsigned int count, int16_t *dst)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i round = _mm256_set1_epi32(64);
+		const __m256i w01 = _mm256_set1_epi32(WeightPair(weights));
+		unsigned int i = 0;
+		for (; i + 32 <= count; i += 32) {
+			__m256i sum0 = zero, sum1 = zero, sum2 = zero, sum3 = zero;
+			for (unsigned int t = 0; t < taps; t += 2) {
+				const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[t] + i));
+				const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[t + 1] + i));
+				const __m256i lo = _mm256_unpacklo_epi8(a, b);
+				const __m256i hi = _mm256_unpackhi_epi8(a, b);
+				const __m256i wt = (t == 0) ? w01 : _mm256_set1_epi32(WeightPair(weights + t));
+				sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), wt));
+				sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), wt));
+				sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), wt));
+				sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), wt));
+			}
+			sum0 = _mm256_srai_epi32(_mm256_add_epi32(sum0, round), 7);
+			sum1 = _mm256_srai_epi32(_mm256_add_epi32(sum1, round), 7);
+			sum2 = _mm256_srai_epi32(_mm256_add_epi32(sum2, round), 7);
+			sum3 = _mm256_srai_epi32(_mm256_add_epi32(sum3, round), 7);
+			const __m256i words01 = _mm256_packs_epi32(sum0, sum1); // 0-7 | 16-23
+			const __m256i words23 = _mm256_packs_epi32(sum2, sum3); // 8-15 | 24-31
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permute2x128_si256(words01, words23, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 16), _mm256_permute2x128_si256(words01, words23, 0x31));
+		}
+		return i;
+	}
+
+	void VerticalRow(const unsigned char *const *rows, const int16_t *weights, unsigned int taps,
+		unsigned int count, int16_t *dst, SpoutCopyTier tier)
+	{
+		unsigned int i = 0;
+		if (tier >= SPOUT_COPY_AVX2)
+			i = VerticalRowAVX2(rows, weights, taps, count, dst);
+		else if (tier >= SPOUT_COPY_SSE2)
+			i = VerticalRowSSE2(rows, weights, taps, count, dst);
+
+		for (; i < count; i++) {
+			int sum = 0;
+			for (unsigned int t = 0; t < taps; t++)
+				sum += rows[t][i] * weights[t];
+			dst[i] = (int16_t)((sum + 64) >> 7);
+		}
+	}
+
+
+	//
+	// Horizontal pass
+	//
+	// The SIMD versions shuffle two adjacent pixels r0 g0 b0 a0 r1 g1 b1 a1
+	// to r0 r1 g0 g1 b0 b1 a0 a1 to multiply by the pair of weights w0 w1 and add.
+	// They return the number of pixels done.
+	//
+
+	// 7 bits from the vertical pass and 14 bits of weight
+	static const int horizontalShift = 7 + SPOUT_RESAMPLE_BITS;
+
+	// One pixel of four 32 bit channels
+	// "taps" is a constant for the common bilinear case after inlining
+	static inline __m128i HorizontalPixelSSE2(const spoutResampleAxis &axis, const int16_t *src,
+		unsigned int x, unsigned int taps)
+	{
+		const int16_t *s = src + (size_t)axis.first[x] * 4;
+		const int16_t *w = axis.weights.data() + (size_t)x * taps;
+		__m128i sum = _mm_set1_epi32(1 << (horizontalShift - 1));
+		for (unsigned int t = 0; t < taps; t += 2) {
+			__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + t * 4));
+			p = _mm_unpacklo_epi16(p, _mm_srli_si128(p, 8));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(p, _mm_set1_epi32(WeightPair(w + t))));
+		}
+		return _mm_srai_epi32(sum, horizontalShift);
+	}
+
+	static inline void HorizontalPairSSE2(const spoutResampleAxis &axis, const int16_t *src,
+		unsigned char *dst, unsigned int x, unsigned int taps)
+	{
+		const __m128i words = _mm_packs_epi32(HorizontalPixelSSE2(axis, src, x, taps),
+			HorizontalPixelSSE2(axis, src, x + 1, taps));
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + (size_t)x * 4), _mm_packus_epi16(words, words));
+	}
+
+	static unsigned int HorizontalRowSSE2(const spoutResampleAxis &axis, const int16_t *src, unsigned char *dst)
+	{
+		const unsigned int taps = axis.taps;
+		unsigned int x = 0;
+		if (taps == 2) {
+			for (; x + 2 <= axis.dstSize; x += 2)
+				HorizontalPairSSE2(axis, src, dst, x, 2);
+		}
+		else {
+			for (; x + 2 <= axis.dstSize; x += 2)
+				HorizontalPairSSE2(axis, src, dst, x, taps);
+		}
+		return x;
+	}
+
+	// Pixels x and x+1, one in each 128 bit lane
+	SPOUT_TARGET_AVX2
+	static inline __m256i HorizontalPixelsAVX2(const spoutResampleAxis &axis, const int16_t *src,
+		unsigned int x, unsigned int taps)
+	{
+		const int16_t *s0 = src + (size_t)axis.first[x] * 4;
+		const int16_t *s1 = src + (size_t)axis.first[x + 1] * 4;
+		const int16_t *w0 = axis.weights.data() + (size_t)x * taps;
+		const int16_t *w1 = w0 + taps;
+		__m256i sum = _mm256_set1_epi32(1 << (horizontalShift - 1));
+		for (unsigned int t = 0; t < taps; t += 2) {
+			__m256i p = _mm256_inserti128_si256(_mm256_castsi128_si256(
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(s0 + t * 4))),
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(s1 + t * 4)), 1);
+			p = _mm256_unpacklo_epi16(p, _mm256_srli_si256(p, 8));
+			const __m256i wt = _mm256_inserti128_si256(_mm256_set1_epi32(WeightPair(w0 + t)),
+				_mm_set1_epi32(WeightPair(w1 + t)), 1);
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(p, wt));
+		}
+		return _mm256_srai_epi32(sum, horizontalShift);
+	}
+
+	SPOUT_TARGET_AVX2
+	static inline void HorizontalQuadAVX2(const spoutResampleAxis &axis, const int16_t *src,
+		unsigned char *dst, unsigned int x, unsigned int taps)
+	{
+		// Words x, x+2 | x+1, x+3 then bytes in each lane
+		__m256i words = _mm256_packs_epi32(HorizontalPixelsAVX2(axis, src, x, taps),
+			HorizontalPixelsAVX2(axis, src, x + 2, taps));
+		words = _mm256_packus_epi16(words, words);
+		// Pixels x x+2 and x+1 x+3 to x x+1 x+2 x+3
+		const __m128i out = _mm_unpacklo_epi32(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (size_t)x * 4), out);
+	}
+
+	SPOUT_TARGET_AVX2
+	static unsigned int HorizontalRowAVX2(const spoutResampleAxis &axis, const int16_t *src, unsigned char *dst)
+	{
+		const unsigned int taps = axis.taps;
+		unsigned int x = 0;
+		if (taps == 2) {
+			for (; x + 4 <= axis.dstSize; x += 4)
+				HorizontalQuadAVX2(axis, src, dst, x, 2);
+		}
+		else {
+			for (; x + 4 <= axis.dstSize; x += 4)
+				HorizontalQuadAVX2(axis, src, dst, x, taps);
+		}
+		return x;
+	}
+
+	void HorizontalRow(const spoutResampleAxis &axis, const int16_t *src, unsigned char *dst, SpoutCopyTier tier)
+	{
+		const unsigned int taps = axis.taps;
+		const unsigned int *first = axis.first.data();
+		const int16_t *weights = axis.weights.data();
+
+		unsigned int x = 0;
+		if (tier >= SPOUT_COPY_AVX2)
+			x = HorizontalRowAVX2(axis, src, dst);
+		else if (tier >= SPOUT_COPY_SSE2)
+			x = HorizontalRowSSE2(axis, src, dst);
+
+		for (; x < axis.dstSize; x++) {
+			const int16_t *s = src + (size_t)first[x] * 4;
+			const int16_t *w = weights + (size_t)x * taps;
+			for (unsigned int c = 0; c < 4; c++) {
+				int sum = 0;
+				for (unsigned int t = 0; t < taps; t++)
+					sum += s[t * 4 + c] * w[t];
+				sum = (sum + (1 << (horizontalShift - 1))) >> horizontalShift;
+				dst[(size_t)x * 4 + c] = (unsigned char)(sum > 255 ? 255 : (sum < 0 ? 0 : sum));
+			}
+		}
+	}
+
+
+	//
+	// Float passes
+	//
+	// 16 bit and floating point pixels are resampled as four floats so
+	// that they keep their precision. The fixed point weights are exact
+	// in float. One pixel is one SSE2 register.
+	//
+
+	static const float weightScale = 1.0f / SPOUT_RESAMPLE_ONE;
+
+	// The AVX2 versions do 8 channels or 2 pixels at a time with
+	// the same operations in the same order as SSE2 and scalar.
+	SPOUT_TARGET_AVX2
+	static unsigned int VerticalRowFloatAVX2(const float *const *rows, const int16_t *weights,
+		unsigned int taps, unsigned int count, float *dst)
+	{
+		unsigned int i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256 sum = _mm256_setzero_ps();
+			for (unsigned int t = 0; t < taps; t++) {
+				const __m256 w = _mm256_set1_ps(weights[t] * weightScale);
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[t] + i), w));
+			}
+			_mm256_storeu_ps(dst + i, sum);
+		}
+		return i;
+	}
+
+	// "taps" is a constant for the common bilinear case after inlining
+	static inline void HorizontalPixelFloatSSE2(const spoutResampleAxis &axis, const float *src,
+		float *dst, unsigned int x, unsigned int taps)
+	{
+		const float *s = src + (size_t)axis.first[x] * 4;
+		const int16_t *w = axis.weights.data() + (size_t)x * taps;
+		__m128 sum = _mm_setzero_ps();
+		for (unsigned int t = 0; t < taps; t++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(s + t * 4), _mm_set1_ps(w[t] * weightScale)));
+		_mm_storeu_ps(dst + (size_t)x * 4, sum);
+	}
+
+	// Pixels x and x+1, one in each 128 bit lane
+	SPOUT_TARGET_AVX2
+	static inline void HorizontalPairFloatAVX2(const spoutResampleAxis &axis, const float *src,
+		float *dst, unsigned int x, unsigned int taps)
+	{
+		const float *s0 = src + (size_t)axis.first[x] * 4;
+		const float *s1 = src + (size_t)axis.first[x + 1] * 4;
+		const int16_t *w0 = axis.weights.data() + (size_t)x * taps;
+		const int16_t *w1 = w0 + taps;
+		__m256 sum = _mm256_setzero_ps();
+		for (unsigned int t = 0; t < taps; t++) {
+			const __m256 p = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(s0 + t * 4)),
+				_mm_loadu_ps(s1 + t * 4), 1);
+			const __m256 wt = _mm256_insertf128_ps(_mm256_set1_ps(w0[t] * weightScale),
+				_mm_set1_ps(w1[t] * weightScale), 1);
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(p, wt));
+		}
+		_mm256_storeu_ps(dst + (size_t)x * 4, sum);
+	}
+
+	SPOUT_TARGET_AVX2
+	static unsigned int HorizontalRowFloatAVX2(const spoutResampleAxis &axis, const float *src, float *dst)
+	{
+		const unsigned int taps = axis.taps;
+		unsigned int x = 0;
+		if (taps == 2) {
+			for (; x + 2 <= axis.dstSize; x += 2)
+				HorizontalPairFloatAVX2(axis, src, dst, x, 2);
+		}
+		else {
+			for (; x + 2 <= axis.dstSize; x += 2)
+				HorizontalPairFloatAVX2(axis, src, dst, x, taps);
+		}
+		return x;
+	}
+
+	void VerticalRowFloat(const float *const *rows, const int16_t *weights, unsigned int taps,
+		unsigned int count, float *dst, SpoutCopyTier tier)
+	{
+		unsigned int i = 0;
+		if (tier >= SPOUT_COPY_AVX2)
+			i = VerticalRowFloatAVX2(rows, weights, taps, count, dst);
+		if (tier >= SPOUT_COPY_SSE2) {
+			for (; i + 4 <= count; i += 4) {
+				__m128 sum = _mm_setzero_ps();
+				for (unsigned int t = 0; t < taps; t++) {
+					const __m128 w = _mm_set1_ps(weights[t] * weightScale);
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[t] + i), w));
+				}
+				_mm_storeu_ps(dst + i, sum);
+			}
+		}
+
+		for (; i < count; i++) {
+			float sum = 0.0f;
+			for (unsigned int t = 0; t < taps; t++)
+				sum += rows[t][i] * (weights[t] * weightScale);
+			dst[i] = sum;
+		}
+	}
+
+	void HorizontalRowFloat(const spoutResampleAxis &axis, const float *src, float *dst, SpoutCopyTier tier)
+	{
+		const unsigned int taps = axis.taps;
+		const unsigned int *first = axis.first.data();
+		const int16_t *weights = axis.weights.data();
+
+		if (tier >= SPOUT_COPY_SSE2) {
+			unsigned int x = 0;
+			if (tier >= SPOUT_COPY_AVX2)
+				x = HorizontalRowFloatAVX2(axis, src, dst);
+			if (taps == 2) {
+				for (; x < axis.dstSize; x++)
+					HorizontalPixelFloatSSE2(axis, src, dst, x, 2);
+			}
+			else {
+				for (; x < axis.dstSize; x++)
+					HorizontalPixelFloatSSE2(axis, src, dst, x, taps);
+			}
+			return;
+		}
+
+		for (unsigned int x = 0; x < axis.dstSize; x++) {
+			const float *s = src + (size_t)first[x] * 4;
+			const int16_t *w = weights + (size_t)x * taps;
+			for (unsigned int c = 0; c < 4; c++) {
+				float sum = 0.0f;
+				for (unsigned int t = 0; t < taps; t++)
+					sum += s[t * 4 + c] * (w[t] * weightScale);
+				dst[(size_t)x * 4 + c] = sum;
+			}
+		}
+	}
+
+}
@@ -0,0 +1,78 @@
+/*
+
+					SpoutResample.h
+
+		Separable image resampling for spoutCopy
+
+		Nearest, bilinear and area (box) filters. The source position
+		and weights of every destination column or line are calculated
+		once in fixed point for each source and destination size and
+		kept in a cache shared by all spoutCopy objects.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutResample__ // standard way as well
+#define __spoutResample__
+
+#include "SpoutCopy.h"
+#include <vector>
+#include <memory>
+
+// Weights are 14 bit fixed point and the weights of each
+// destination pixel add up to exactly SPOUT_RESAMPLE_ONE
+#define SPOUT_RESAMPLE_BITS 14
+#define SPOUT_RESAMPLE_ONE (1 << SPOUT_RESAMPLE_BITS)
+
+//
+// Source pixels used for each destination pixel along one axis.
+// Destination pixel "i" uses "taps" source pixels starting at first[i]
+// with weights[i*taps] to weights[i*taps+taps-1].
+// For nearest, taps is 1 and only "first" is used.
+// For bilinear and area, taps is even so that pairs of pixels can be
+// weighted together, and padding taps have zero weight.
+// first[i]+taps does not exceed the source size unless the source
+// is smaller than taps. Then first[i] is 0.
+//
+struct spoutResampleAxis {
+	SpoutResampleFilter filter;
+	unsigned int srcSize;
+	unsigned int dstSize;
+	bool bMirror; // destination reversed
+	unsigned int taps;
+	std::vector<unsigned int> first;
+	std::vector<int16_t> weights;
+};
+
+namespace spoutresample {
+
+	// Axis for a filter and size pair from the cache, calculated if not found.
+	// Thread safe. The axis remains valid while the pointer is held.
+	std::shared_ptr<const spoutResampleAxis> GetAxis(SpoutResampleFilter filter,
+		unsigned int srcSize, unsigned int dstSize, bool bMirror = false);
+
+	// Nearest source pixel for each destination pixel of a line
+	void NearestRow(const spoutResampleAxis &axis, const unsigned char *src, unsigned char *dst,
+		unsigned int pixelBytes = 4);
+
+	// Vertical pass. Weighted sum of "taps" lines of 8 bit channels
+	// to 16 bit channels with 7 bits of extra precision (value * 128).
+	void VerticalRow(const unsigned char *const *rows, const int16_t *weights, unsigned int taps,
+		unsigned int count, int16_t *dst, SpoutCopyTier tier);
+
+	// Horizontal pass. 16 bit channels from the vertical pass
+	// to 4 byte destination pixels. "src" must have at least "taps" pixels.
+	void HorizontalRow(const spoutResampleAxis &axis, const int16_t *src, unsigned char *dst, SpoutCopyTier tier);
+
+	// Vertical and horizontal passes for pixels of four floats,
+	// used for 16 bit and floating point formats.
+	void VerticalRowFloat(const float *const *rows, const int16_t *weights, unsigned int taps,
+		unsigned int count, float *dst, SpoutCopyTier tier);
+	void HorizontalRowFloat(const spoutResampleAxis &axis, const float *src, float *dst, SpoutCopyTier tier);
+
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*
+
+					SpoutRotate.h
+
+		Rotation and transpose of 4 and 8 byte pixels
+
+		90, 180 and 270 degrees, transpose and transverse in
+		cache sized tiles with SIMD block transposes.
+		Use spoutCopy::Rotate to rotate an image with multiple threads.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutRotate__ // standard way as well
+#define __spoutRotate__
+
+#include "SpoutCopy.h"
+
+namespace spoutrotate {
+
+	// Rotations that swap width and height
+	bool IsTransposed(SpoutRotation rotation);
+
+	// Destination pixels per side of a tile
+	const unsigned int TileSize = 32;
+
+	// Write destination lines y0 to y1 of a transposed rotation.
+	// "width" and "height" are the source size and "bytes" is 4 or 8.
+	void TransposeLines(const unsigned char *src, unsigned int sourcePitch,
+		unsigned int width, unsigned int height, unsigned int bytes, SpoutRotation rotation,
+		unsigned char *dst, unsigned int destPitch, SpoutCopyTier tier,
+		unsigned int y0, unsigned int y1);
+
+}
+
+#endif
@@ -70,6 +70,7 @@
 //		24.04.21	- Add OpenGL shared texture access functions
 //		03.06.21	- Add CreateMemoryBuffer, DeleteMemoryBuffer, GetMemoryBufferSize
 //		22.11.21	- Remove ReleaseSender() from destructor
+//		16.10.26	- Add WriteMemoryBuffer overload with the image size and format for the buffer header
 //
 // ====================================================================================
 /*
@@ -275,6 +276,13 @@ bool SpoutSender::WriteMemoryBuffer(const char *name, const char* data, int leng
 	return spout.WriteMemoryBuffer(name, data, length);
 }
 
+//---------------------------------------------------------
+bool SpoutSender::WriteMemoryBuffer(const char *name, const char* data, int length,
+	unsigned int width, unsigned int height, unsigned int pitch, unsigned int format)
+{
+	return spout.WriteMemoryBuffer(name, data, length, width, height, pitch, format);
+}
+
 //---------------------------------------------------------
 bool SpoutSender::CreateMemoryBuffer(const char *name, int length)
 {
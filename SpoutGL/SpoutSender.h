@@ -99,6 +99,9 @@ class SPOUT_DLLEXP SpoutSender {
 
 	// Write data
 	bool WriteMemoryBuffer(const char *name, const char* data, int length);
+	// Write data, with the image size and format for the buffer header
+	bool WriteMemoryBuffer(const char *name, const char* data, int length,
+		unsigned int width, unsigned int height, unsigned int pitch = 0, unsigned int format = 0);
 	// Create a shared memory buffer
 	bool CreateMemoryBuffer(const char *name, int length);
 	// Delete a shared memory buffer
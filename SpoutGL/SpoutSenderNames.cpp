@@ -79,6 +79,18 @@
 			   testing function
 	31.07.21 - Add m_senders size check in UpdateSender
 	15.12.21 - Remove noisy SpoutLogNotice from SetSenderID
+	16.10.26 - Sequence lock after the SharedTextureInfo structure of a sender map.
+			   SetSenderInfo and setSharedInfo change the sequence while locked and
+			   getSharedInfo reads without the mutex unless the sender does not use it.
+			   The sender map is created with 8192 bytes so that readers and writers
+			   use the sequence lock only for maps of senders that have it.
+			 - getSharedInfo keeps the map of a sender with the sequence lock open
+			   for later reads. ReleaseSenderName marks the map closed for readers
+			   that have it open, and readers check that the sender process is
+			   still running once a second. Add CloseSharedInfo.
+			 - A map marked closed is read once with the mutex, for an older sender
+			   that uses the name again and does not clear the mark. Maps of senders
+			   that are no longer in the sender set are closed when the set is cleaned.
 
 
 	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -107,8 +119,86 @@
 
 */
 #include "SpoutSenderNames.h"
+#include "SpoutSeqLock.h"
 #include <assert.h>
 
+// Senders that use the sequence lock create the map larger than a page.
+// Maps of older senders are 280 bytes, less than a page on any system,
+// so a map this size or larger is known to have the sequence lock header.
+static const int SenderInfoMapSize = 8192;
+
+// Milliseconds between checks by a reader that the sender process is running
+static const DWORD SenderCheckInterval = 1000;
+
+// After the SharedTextureInfo structure of a sender map with the sequence lock
+struct SenderInfoState {
+	spoutseqlock::Header lock;
+	std::atomic<uint32_t> closed; // Set when the sender is released
+	std::atomic<uint32_t> processId; // Process of the sender
+};
+
+// State after the SharedTextureInfo structure of a sender map,
+// or nullptr for the map of an older sender, which is only used with the mutex.
+static SenderInfoState* SenderState(SpoutSharedMemory& mem)
+{
+	char* pBuf = mem.Buffer();
+	if (!pBuf || mem.ViewSize() < (size_t)SenderInfoMapSize)
+		return nullptr;
+	return reinterpret_cast<SenderInfoState*>(pBuf + sizeof(SharedTextureInfo));
+}
+
+// Copy the SharedTextureInfo structure of a sender map with the mutex
+static bool ReadSenderInfo(SpoutSharedMemory& mem, SharedTextureInfo* info)
+{
+	char *pBuf = mem.Lock();
+	if (!pBuf)
+		return false;
+	__movsd((unsigned long *)info, (unsigned long const *)pBuf, sizeof(SharedTextureInfo) / 4); // 280 bytes
+	mem.Unlock();
+	return true;
+}
+
+// A reader that keeps the map open also keeps it from being removed when
+// the sender closes it. Test whether the sender process is still running,
+// in case it ended without releasing the sender.
+static bool SenderProcessRunning(DWORD processId)
+{
+	if (processId == 0 || processId == GetCurrentProcessId())
+		return true;
+	HANDLE hProcess = OpenProcess(SYNCHRONIZE, FALSE, processId);
+	if (!hProcess)
+		return GetLastError() == ERROR_ACCESS_DENIED; // Running as another user
+	const bool bRunning = (WaitForSingleObject(hProcess, 0) == WAIT_TIMEOUT);
+	CloseHandle(hProcess);
+	return bRunning;
+}
+
+// Sender map kept open by getSharedInfo
+struct spoutSenderNames::SenderInfoReader {
+	std::string name;
+	SpoutSharedMemory memory;
+	SenderInfoState* state = nullptr;
+	DWORD checked = 0; // Time of the last check of the sender process
+};
+
+// Set when the sender was released. An older sender that opens the
+// map with the same name later does not clear it.
+static bool SenderInfoClosed(const SenderInfoState* state)
+{
+	return state->closed.load(std::memory_order_acquire) != 0;
+}
+
+// False if the sender process of a map kept open has ended
+static bool SenderInfoRunning(SenderInfoState* state, DWORD &checked)
+{
+	const DWORD now = GetTickCount();
+	if (now - checked >= SenderCheckInterval) {
+		checked = now;
+		return SenderProcessRunning((DWORD)state->processId.load(std::memory_order_relaxed));
+	}
+	return true;
+}
+
 //
 // Class: spoutSenderNames
 //
@@ -120,6 +210,8 @@
 spoutSenderNames::spoutSenderNames() {
 
 	m_senders = new std::unordered_map<std::string, SpoutSharedMemory*>();
+	m_senderInfo = new std::unordered_map<std::string, SenderInfoReader*>();
+	m_pLastInfo = nullptr;
 
 	// 15.09.18 - moved from interop class
 	// 06.06.19 - increase default maximum number of senders from 10 to 256
@@ -139,6 +231,9 @@ spoutSenderNames::~spoutSenderNames() {
 		delete itr->second;
 	}
 	delete m_senders;
+
+	CloseSharedInfo();
+	delete m_senderInfo;
 	
 }
 
@@ -221,9 +316,15 @@ bool spoutSenderNames::ReleaseSenderName(const char* Sendername)
 	namestring = Sendername;
 	auto foundSender = m_senders->find(namestring);
 	if (foundSender != m_senders->end()) {
+		// Readers that keep the map open find that the sender has closed
+		SenderInfoState* state = SenderState(*foundSender->second);
+		if (state)
+			state->closed.store(1, std::memory_order_release);
 		delete foundSender->second;
 		m_senders->erase(namestring);
 	}
+	// A map of the sender kept open by this object
+	CloseSharedInfo(Sendername);
 
 	// Read the buffer to a set to iterate through the names
 	readSenderSetFromBuffer(pBuf, SenderNames, m_MaxSenders);
@@ -298,6 +399,9 @@ void spoutSenderNames::cleanSenderSet()
 	std::set<std::string> SenderNames;
 	readSenderSetFromBuffer(pBuf, SenderNames, m_MaxSenders);
 
+	// Maps kept open by getSharedInfo would be found below
+	PruneSharedInfo(SenderNames);
+
 	bool changed = false;
 
 	for (auto itr = SenderNames.begin(); itr != SenderNames.end(); )
@@ -385,6 +489,7 @@ int spoutSenderNames::GetSenderCount() {
 
 	// Get the new set back
 	if(GetSenderNames(&SenderSet)) {
+		PruneSharedInfo(SenderSet);
 		m_senderNames.Unlock();
 		return((int)SenderSet.size());
 	}
@@ -553,7 +658,16 @@ bool spoutSenderNames::SetSenderInfo(const char* sendername, unsigned int width,
 	memcpy((void *)info.description, (void *)exepath, 256); // wchar 128
 
 	// Set data to the memory map
+	SenderInfoState* state = SenderState(*senderInfoMap);
+	if (state) {
+		spoutseqlock::BeginWrite(&state->lock);
+		// Open again if a sender of the same name was released
+		state->processId.store((uint32_t)GetCurrentProcessId(), std::memory_order_relaxed);
+		state->closed.store(0, std::memory_order_relaxed);
+	}
 	__movsd((unsigned long *)pBuf, (unsigned long const *)&info, sizeof(SharedTextureInfo) / 4); // 280 bytes
+	if (state)
+		spoutseqlock::EndWrite(&state->lock);
 
 	senderInfoMap->Unlock();
 	
@@ -741,7 +855,7 @@ bool spoutSenderNames::UpdateSender(const char *sendername, unsigned int width,
 
 		// Create or open a shared memory map for this sender - allocate enough for the texture info
 		SpoutSharedMemory *senderInfoMem = new SpoutSharedMemory();
-		SpoutCreateResult result = senderInfoMem->Create(sendername, sizeof(SharedTextureInfo));
+		SpoutCreateResult result = senderInfoMem->Create(sendername, SenderInfoMapSize);
 
 		if (result == SPOUT_CREATE_FAILED) {
 			delete senderInfoMem;
@@ -902,6 +1016,8 @@ void spoutSenderNames::CleanSenders()
 
 	// Now we have cleaned up the list in shared memory
 	Senders.clear();
+	if (GetSenderNames(&Senders))
+		PruneSharedInfo(Senders);
 
 }
 // ================================================
@@ -1072,23 +1188,116 @@ bool spoutSenderNames::getActiveSenderName(char SenderName[SpoutMaxSenderNameLen
 // A receiver checks this all the time so it has to be compact
 // Does not have to be the info of this instance
 // so the creation pointer and handle may not be known
+//
+// The map of a sender that uses the sequence lock is kept open after the
+// first read, and later reads need no mutex or system call. The map of an
+// older sender is opened and locked for every read.
 bool spoutSenderNames::getSharedInfo(const char* sharedMemoryName, SharedTextureInfo* info) 
 {
-	SpoutSharedMemory mem;
-
-	// Possibly faster because the function is called all the time
-	if(mem.Open(sharedMemoryName)) {
-		char *pBuf = mem.Lock();
-		if(pBuf) {
-			__movsd((unsigned long *)info, (unsigned long const *)pBuf, sizeof(SharedTextureInfo) / 4); // 280 bytes
-			mem.Unlock();
-			return true;
+	SenderInfoReader* reader = FindSharedInfo(sharedMemoryName);
+
+	if (reader) {
+		if (SenderInfoClosed(reader->state)) {
+			// Released, or the name used again by an older sender.
+			// Read a freshly opened map once with the mutex.
+			CloseSharedInfo(sharedMemoryName);
+			SpoutSharedMemory mem;
+			if (!mem.Open(sharedMemoryName))
+				return false;
+			return ReadSenderInfo(mem, info);
+		}
+		if (!SenderInfoRunning(reader->state, reader->checked)) {
+			// The sender process has ended
+			CloseSharedInfo(sharedMemoryName);
+			return false;
 		}
 	}
-	return false;
+	else {
+		reader = new SenderInfoReader();
+		if (!reader->memory.Open(sharedMemoryName)) {
+			delete reader;
+			return false;
+		}
+		reader->state = SenderState(reader->memory);
+		if (!reader->state || SenderInfoClosed(reader->state)) {
+			// Older senders, and maps marked closed, are read with the mutex
+			const bool bRead = ReadSenderInfo(reader->memory, info);
+			delete reader;
+			return bRead;
+		}
+		// The map can be open after the sender process has ended
+		reader->checked = GetTickCount() - SenderCheckInterval;
+		if (!SenderInfoRunning(reader->state, reader->checked)) {
+			delete reader;
+			return false;
+		}
+		reader->name = sharedMemoryName;
+		(*m_senderInfo)[reader->name] = reader;
+	}
+	m_pLastInfo = reader;
+
+	if (spoutseqlock::Read(&reader->state->lock, reader->memory.Buffer(), info, sizeof(SharedTextureInfo)))
+		return true;
+
+	// A writer that did not finish
+	return ReadSenderInfo(reader->memory, info);
 
 } // end getSharedInfo
 
+// Sender map kept open by getSharedInfo
+spoutSenderNames::SenderInfoReader* spoutSenderNames::FindSharedInfo(const char* sharedMemoryName)
+{
+	// A receiver reads the same sender every frame
+	if (m_pLastInfo && m_pLastInfo->name == sharedMemoryName)
+		return m_pLastInfo;
+
+	auto found = m_senderInfo->find(sharedMemoryName);
+	if (found == m_senderInfo->end())
+		return nullptr;
+	return found->second;
+}
+
+// Close a sender map kept open by getSharedInfo
+void spoutSenderNames::CloseSharedInfo(const char* sharedMemoryName)
+{
+	auto found = m_senderInfo->find(sharedMemoryName);
+	if (found == m_senderInfo->end())
+		return;
+	if (found->second == m_pLastInfo)
+		m_pLastInfo = nullptr;
+	delete found->second;
+	m_senderInfo->erase(found);
+}
+
+// Close the maps of senders that are no longer in the sender set,
+// or have been released, so that their maps can be removed
+void spoutSenderNames::PruneSharedInfo(const std::set<std::string>& SenderNames)
+{
+	for (auto itr = m_senderInfo->begin(); itr != m_senderInfo->end(); )
+	{
+		if (SenderNames.find(itr->first) == SenderNames.end() || SenderInfoClosed(itr->second->state)) {
+			if (itr->second == m_pLastInfo)
+				m_pLastInfo = nullptr;
+			delete itr->second;
+			itr = m_senderInfo->erase(itr);
+		}
+		else {
+			++itr;
+		}
+	}
+}
+
+// Close every sender map kept open by getSharedInfo
+void spoutSenderNames::CloseSharedInfo()
+{
+	for (auto itr = m_senderInfo->begin(); itr != m_senderInfo->end(); itr++)
+	{
+		delete itr->second;
+	}
+	m_senderInfo->clear();
+	m_pLastInfo = nullptr;
+}
+
 // 12.06.15 - Added to allow direct modification of a sender's information in shared memory
 bool spoutSenderNames::setSharedInfo(const char* sharedMemoryName, SharedTextureInfo* info) 
 {
@@ -1105,7 +1314,12 @@ bool spoutSenderNames::setSharedInfo(const char* sharedMemoryName, SharedTexture
 		return false;
 	}
 
+	SenderInfoState* state = SenderState(mem);
+	if (state)
+		spoutseqlock::BeginWrite(&state->lock);
 	__movsd((unsigned long *)pBuf, (unsigned long const *)info, sizeof(SharedTextureInfo) / 4); // 280 bytes
+	if (state)
+		spoutseqlock::EndWrite(&state->lock);
 
 	mem.Unlock();
 	
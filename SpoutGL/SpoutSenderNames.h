@@ -143,6 +143,8 @@ class SPOUT_DLLEXP spoutSenderNames {
 		bool setSharedInfo (const char* sendername, SharedTextureInfo* info);
 		// Test for shared info memory map existence
 		bool hasSharedInfo(const char* sendername);
+		// Close the sender maps kept open by getSharedInfo
+		void CloseSharedInfo();
 
 		//
 		// Functions to maintain the active sender
@@ -205,6 +207,17 @@ protected:
 		std::unordered_map<std::string, SpoutSharedMemory*>*	m_senders;
 		int m_MaxSenders; // maximum number of senders via registry
 
+		// Sender maps opened by getSharedInfo and kept open for later reads.
+		// Maps of older senders without the sequence lock, and maps marked
+		// closed by a released sender, are read with the mutex and not kept.
+		struct SenderInfoReader;
+		std::unordered_map<std::string, SenderInfoReader*>*	m_senderInfo;
+		SenderInfoReader* m_pLastInfo; // the map of the last read
+		SenderInfoReader* FindSharedInfo(const char* sendername);
+		void CloseSharedInfo(const char* sendername);
+		// Close the maps of senders that are not in the set or have closed
+		void PruneSharedInfo(const std::set<std::string>& SenderNames);
+
 };
 
 #endif
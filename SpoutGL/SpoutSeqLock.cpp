@@ -0,0 +1,83 @@
+/*
+
+					SpoutSeqLock.cpp
+
+		Sequence lock for small structures in shared memory
+
+		See SpoutSeqLock.h
+
+		The copy is made between an acquire load of the sequence and an
+		acquire fence before the second load, so that it is not moved
+		outside the two. The writer makes the sequence odd with a release
+		fence before the data changes and even with a release store after.
+		The sequence is 32 bits so that the header is lock free and address
+		free in shared memory between 32 and 64 bit processes.
+
+	========================
+
+	16.10.26 - Create file
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#include "SpoutSeqLock.h"
+#include <string.h>
+#include <thread>
+
+namespace spoutseqlock {
+
+	static_assert(sizeof(Header) == 8, "Header must be 8 bytes");
+
+	void BeginWrite(Header *header)
+	{
+		const uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+		header->sequence.store(sequence | 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	void EndWrite(Header *header)
+	{
+		// The next even value, also after a writer ended without EndWrite
+		const uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+		header->magic.store(Magic, std::memory_order_relaxed);
+		header->sequence.store((sequence | 1) + 1, std::memory_order_release);
+	}
+
+	bool Read(const Header *header, const void *data, void *copy, size_t size, unsigned int retries)
+	{
+		if (header->magic.load(std::memory_order_acquire) != Magic)
+			return false;
+
+		for (unsigned int i = 0; i < retries; i++) {
+			const uint32_t before = ReadBegin(header);
+			if ((before & 1) == 0) {
+				memcpy(copy, data, size);
+				if (ReadEnd(header, before))
+					return true;
+			}
+			// Let the writer finish
+			if (i >= 8)
+				std::this_thread::yield();
+		}
+		return false;
+	}
+
+	uint32_t Sequence(const Header *header)
+	{
+		return header->sequence.load(std::memory_order_acquire);
+	}
+
+	uint32_t ReadBegin(const Header *header)
+	{
+		return header->sequence.load(std::memory_order_acquire);
+	}
+
+	bool ReadEnd(const Header *header, uint32_t sequence)
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return (sequence & 1) == 0 && header->sequence.load(std::memory_order_relaxed) == sequence;
+	}
+
+}
@@ -0,0 +1,87 @@
+/*
+
+					SpoutSeqLock.h
+
+		Sequence lock for small structures in shared memory
+
+		A writer makes the sequence odd before changing the data and even
+		again after it. A reader copies the data and takes the copy if the
+		sequence was even and the same before and after. Readers need no
+		mutex and never hold up the writer. Writers must still be serialized,
+		for example with the SpoutSharedMemory mutex.
+
+		The header follows the data in shared memory, so that the data stays
+		at the start where older applications expect it. Older writers do not
+		change the sequence, and "magic" is only set by writers that do,
+		so a reader can use the mutex instead if it is not set.
+
+		Reads without the mutex assume that every writer of the data uses
+		the sequence lock. "magic" stays set once a writer has set it, and
+		a later writer that locks the mutex but does not change the sequence
+		is not seen by a reader, which can then copy a partly changed
+		structure. Use the sequence lock only for memory that is known to
+		have the header because it was created for it, for example from its
+		size, and is not written by older applications. Use the mutex for
+		any other. Do not place the header in memory that was not created
+		large enough for it.
+
+			Writer :
+				char *pBuf = memory.Lock();
+				spoutseqlock::BeginWrite(header);
+				... change the data
+				spoutseqlock::EndWrite(header);
+				memory.Unlock();
+
+			Reader :
+				if (!spoutseqlock::Read(header, data, &copy, sizeof(copy)))
+					... lock the memory and copy the data
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutSeqLock__ // standard way as well
+#define __spoutSeqLock__
+
+#include "SpoutCommon.h"
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace spoutseqlock {
+
+	// Set by writers that change the sequence
+	const uint32_t Magic = 0x4B4C5153; // "SQLK"
+
+	// Attempts by Read before it gives up
+	const unsigned int DefaultRetries = 64;
+
+	struct Header {
+		std::atomic<uint32_t> magic;    // Magic if the sequence is used
+		std::atomic<uint32_t> sequence; // Odd while the data is changed
+	};
+
+	// Start and end a change to the data. The caller serializes writers.
+	void BeginWrite(Header *header);
+	void EndWrite(Header *header);
+
+	// Copy "size" bytes of data changed by writers using the header.
+	// Returns false if the header has not been set by a writer,
+	// or there is no consistent copy after "retries" attempts.
+	bool Read(const Header *header, const void *data, void *copy,
+		size_t size, unsigned int retries = DefaultRetries);
+
+	// Sequence for a test of whether the data has changed since a Read
+	uint32_t Sequence(const Header *header);
+
+	// Steps of Read for data that is not copied with memcpy. Use the data
+	// between ReadBegin and ReadEnd and keep it only if ReadEnd returns true.
+	// ReadBegin returns an odd sequence while a writer is changing the data.
+	uint32_t ReadBegin(const Header *header);
+	bool ReadEnd(const Header *header, uint32_t sequence);
+
+}
+
+#endif
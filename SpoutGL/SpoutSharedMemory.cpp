@@ -32,12 +32,44 @@
 	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	16.10.26 - POSIX backend with shm_open and mmap.
+			   The segment starts with a header containing a process-shared
+			   robust pthread mutex, followed by the buffer.
+			   The mutex is recursive like a Windows mutex.
+			   The segment is removed when the last object using it is closed.
+			 - Add Lease for reads from a locked map without a copy.
+			 - Add SetLargePages and SetNumaNode for large maps. Windows uses
+			   SEC_LARGE_PAGES if the lock memory privilege can be enabled.
+			   POSIX uses hugetlbfs if it is mounted, otherwise asks for
+			   transparent huge pages. Normal pages are used if neither works.
+			 - Add ViewSize for the size of a map opened by another process.
+			 - Count leases. A map closed while any are held stays locked and
+			   mapped until the last is released, and can't be created or
+			   opened again until then.
 	
 */
 
 #include "SpoutSharedMemory.h"
 #include <assert.h>
 #include <string>
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#endif
+#endif
 
 
 //
@@ -52,16 +84,53 @@
 SpoutSharedMemory::SpoutSharedMemory()
 {
 	m_pBuffer = NULL;
+#if defined(_WIN32)
 	m_hMutex = NULL;
 	m_hMap = NULL;
+#else
+	m_pMap = NULL;
+	m_mapSize = 0;
+#endif
 	m_pName = NULL;
 	m_size = 0;
 	m_lockCount = 0;
+	m_bLargePages = false;
+	m_bLargeMap = false;
+	m_numaNode = NumaDefault;
+	m_leases = 0;
+	m_bClosed = false;
 }
 
 SpoutSharedMemory::~SpoutSharedMemory()
 {
-	Close();
+	// A lease can not outlive the map
+	assert(m_leases == 0);
+	m_leases = 0;
+	m_bClosed = false;
+	Unmap();
+}
+
+#if defined(_WIN32)
+
+// Large pages need the lock memory privilege, which is
+// only given to accounts allowed to "Lock pages in memory"
+static bool EnableLockMemoryPrivilege()
+{
+	HANDLE hToken = NULL;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &hToken))
+		return false;
+
+	TOKEN_PRIVILEGES tp = {};
+	tp.PrivilegeCount = 1;
+	tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+	bool bEnabled = false;
+	if (LookupPrivilegeValueA(NULL, "SeLockMemoryPrivilege", &tp.Privileges[0].Luid)) {
+		// Succeeds with ERROR_NOT_ALL_ASSIGNED if the account does not have it
+		bEnabled = AdjustTokenPrivileges(hToken, FALSE, &tp, 0, NULL, NULL)
+			&& GetLastError() == ERROR_SUCCESS;
+	}
+	CloseHandle(hToken);
+	return bEnabled;
 }
 
 // Create a new memory segment, or attach to an existing one
@@ -73,6 +142,10 @@ SpoutCreateResult SpoutSharedMemory::Create(const char* name, int size)
 	assert(name);
 	assert(size);
 
+	// The last map is closed but still leased
+	if (m_bClosed)
+		return SPOUT_CREATE_FAILED;
+
 	if (m_hMap != NULL)	{
 		assert(strcmp(name, m_pName) == 0);
 		assert(m_pBuffer && m_hMutex);
@@ -86,12 +159,43 @@ SpoutCreateResult SpoutSharedMemory::Create(const char* name, int size)
 	// In this scenario, CreateFileMapping creates a file mapping object of a specified size
 	// that is backed by the system paging file instead of by a file in the file system.
 
-	m_hMap = CreateFileMappingA ( INVALID_HANDLE_VALUE,
-									NULL,
-									PAGE_READWRITE,
-									0,
-									(DWORD)size,
-									(LPCSTR)name);
+	// The NUMA node for the pages, if one is requested
+	DWORD node = NUMA_NO_PREFERRED_NODE;
+	if (m_numaNode == NumaCurrent) {
+		PROCESSOR_NUMBER processor;
+		USHORT current = 0;
+		GetCurrentProcessorNumberEx(&processor);
+		if (GetNumaProcessorNodeEx(&processor, &current))
+			node = current;
+	}
+	else if (m_numaNode >= 0) {
+		node = (DWORD)m_numaNode;
+	}
+
+	// Large pages for a map of at least one large page. The size is rounded up
+	// to whole large pages. Large pages are committed when the map is created
+	// and it fails if there are not enough, so try again with normal pages.
+	const SIZE_T largePage = m_bLargePages ? GetLargePageMinimum() : 0;
+	m_bLargeMap = false;
+	if (largePage > 0 && (SIZE_T)size >= largePage && EnableLockMemoryPrivilege()) {
+		const unsigned __int64 largeSize = ((unsigned __int64)size + largePage - 1) / largePage * largePage;
+		m_hMap = CreateFileMappingNumaA(INVALID_HANDLE_VALUE, NULL,
+			PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES,
+			(DWORD)(largeSize >> 32), (DWORD)largeSize, (LPCSTR)name, node);
+		err = GetLastError();
+		m_bLargeMap = (m_hMap != NULL && err != ERROR_ALREADY_EXISTS);
+	}
+
+	if (m_hMap == NULL) {
+		m_hMap = CreateFileMappingNumaA(INVALID_HANDLE_VALUE,
+										NULL,
+										PAGE_READWRITE,
+										0,
+										(DWORD)size,
+										(LPCSTR)name,
+										node);
+		err = GetLastError();
+	}
 
 	if (m_hMap == NULL)	{
 		return SPOUT_CREATE_FAILED;
@@ -100,7 +204,6 @@ SpoutCreateResult SpoutSharedMemory::Create(const char* name, int size)
 	// If the object exists before the function call, the function returns a handle
 	// to the existing object (with its current size, not the specified size),
 	// and GetLastError returns ERROR_ALREADY_EXISTS.
-	err = GetLastError();
 	bool alreadyExists = false;
 	if (err == ERROR_ALREADY_EXISTS) {
 		alreadyExists = true;
@@ -116,7 +219,12 @@ SpoutCreateResult SpoutSharedMemory::Create(const char* name, int size)
 	// We can depend on the mapping object to be initially zeros.
 	// https://docs.microsoft.com/en-us/windows/win32/api/winbase/nf-winbase-createfilemappinga
 
-	m_pBuffer = (char*)MapViewOfFile(m_hMap, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	DWORD access = FILE_MAP_ALL_ACCESS;
+#if defined(FILE_MAP_LARGE_PAGES)
+	if (m_bLargeMap)
+		access |= FILE_MAP_LARGE_PAGES;
+#endif
+	m_pBuffer = (char*)MapViewOfFileExNuma(m_hMap, access, 0, 0, 0, NULL, node);
 
 	if (!m_pBuffer)	{
 		Close();
@@ -148,6 +256,10 @@ bool SpoutSharedMemory::Open(const char* name)
 	// Don't call open twice on the same object without a Close()
 	assert(name);
 
+	// The last map is closed but still leased
+	if (m_bClosed)
+		return false;
+
 	if (m_hMap)	{
 		assert(strcmp(name, m_pName) == 0);
 		assert(m_pBuffer && m_hMutex);
@@ -184,7 +296,7 @@ bool SpoutSharedMemory::Open(const char* name)
 
 }
 
-void SpoutSharedMemory::Close()
+void SpoutSharedMemory::Unmap()
 {
 	if (m_pBuffer) {
 		UnmapViewOfFile((LPCVOID)m_pBuffer);
@@ -207,6 +319,7 @@ void SpoutSharedMemory::Close()
 	}
 
 	m_size = 0;
+	m_bLargeMap = false;
 
 }
 
@@ -216,7 +329,7 @@ char* SpoutSharedMemory::Lock()
 	assert(m_lockCount >= 0);
 	assert(m_hMutex);
 
-	if(m_lockCount < 0) {
+	if(m_lockCount < 0 || m_bClosed) {
 		return NULL;
 	}
 
@@ -257,23 +370,643 @@ void SpoutSharedMemory::Unlock()
 	}
 }
 
-const char* SpoutSharedMemory::Name()
+void SpoutSharedMemory::Debug()
 {
-	return m_pName;
+	if (m_pName) {
+		SpoutLogNotice("SpoutSharedMemory::Debug : (%s) m_hMap = [0x%.7X], m_pBuffer = [0x%.7X]", m_pName, LOWORD(m_hMap), PtrToUint(m_pBuffer));
+	}
+	else {
+		SpoutLogNotice("SpoutSharedMemory::Debug : Shared Memory Map is not open\n");
+	}
+
 }
 
-int SpoutSharedMemory::Size()
+size_t SpoutSharedMemory::ViewSize()
 {
-	return m_size;
+	if (!m_pBuffer || m_bClosed)
+		return 0;
+
+	// The view is the whole map, rounded up to pages
+	MEMORY_BASIC_INFORMATION info;
+	if (VirtualQuery(m_pBuffer, &info, sizeof(info)) == 0)
+		return 0;
+
+	return info.RegionSize;
+}
+
+#else
+
+//
+// POSIX shared memory
+//
+
+// Milliseconds to wait for the mutex, as for WaitForSingleObject
+#define SPOUT_LOCK_TIMEOUT 67
+// Milliseconds to wait for the creator to initialize the header
+#define SPOUT_INIT_TIMEOUT 1000
+
+// Start of the segment before the buffer
+struct SpoutSharedMemoryHeader {
+	pthread_mutex_t mutex; // Process-shared, robust and recursive
+	uint32_t ready;    // Set when the mutex is initialized
+	uint32_t attached; // Objects using the segment
+	uint32_t unlinked; // Removed by the last Close
+	int size;          // Buffer size given to Create
+};
+
+// The buffer follows the header at a cache line boundary
+static const size_t SpoutSharedHeaderBytes = (sizeof(SpoutSharedMemoryHeader) + 63) & ~(size_t)63;
+
+// Names must start with a slash and contain no other
+static std::string SharedMemoryName(const char* name)
+{
+	std::string shmName = "/";
+	shmName += name;
+	for (size_t i = 1; i < shmName.size(); i++) {
+		if (shmName[i] == '/')
+			shmName[i] = '_';
+	}
+	return shmName;
+}
+
+#if defined(__linux__)
+
+// Mount point of hugetlbfs and its page size, found once.
+// Empty if it is not mounted.
+static const std::string& HugePageMount(size_t* pPageSize)
+{
+	static size_t pageSize = 0;
+	static const std::string mount = [] {
+		std::string path;
+		FILE* file = fopen("/proc/mounts", "r");
+		if (!file)
+			return path;
+		char device[256], dir[256], type[64];
+		while (fscanf(file, "%255s %255s %63s %*[^\n]", device, dir, type) == 3) {
+			struct statfs fs;
+			if (strcmp(type, "hugetlbfs") == 0 && access(dir, W_OK) == 0 && statfs(dir, &fs) == 0) {
+				path = dir;
+				pageSize = (size_t)fs.f_bsize;
+				break;
+			}
+		}
+		fclose(file);
+		return path;
+	}();
+	*pPageSize = pageSize;
+	return mount;
+}
+
+// Prefer the pages of a NUMA node for a new segment. The kernel takes
+// pages from another node if it has none, so this can't fail the segment.
+static void BindSegment(void* pMap, size_t size, int node)
+{
+	if (node == SpoutSharedMemory::NumaCurrent) {
+		unsigned int cpu = 0, current = 0;
+		if (syscall(SYS_getcpu, &cpu, &current, NULL) != 0)
+			return;
+		node = (int)current;
+	}
+	if (node < 0 || node >= (int)(sizeof(unsigned long) * 8))
+		return;
+
+	const int preferred = 1; // MPOL_PREFERRED
+	const unsigned long mask = 1UL << node;
+	syscall(SYS_mbind, pMap, size, preferred, &mask, sizeof(mask) * 8 + 1, 0);
+}
+
+#endif
+
+// Open an existing segment, in hugetlbfs first
+static int OpenSegment(const std::string& shmName, bool* pbHuge)
+{
+	*pbHuge = false;
+#if defined(__linux__)
+	size_t pageSize = 0;
+	const std::string& mount = HugePageMount(&pageSize);
+	if (!mount.empty()) {
+		const int fd = open((mount + shmName).c_str(), O_RDWR);
+		if (fd >= 0) {
+			*pbHuge = true;
+			return fd;
+		}
+	}
+#endif
+	return shm_open(shmName.c_str(), O_RDWR, 0666);
+}
+
+static void UnlinkSegment(const std::string& shmName, bool bHuge)
+{
+#if defined(__linux__)
+	if (bHuge) {
+		size_t pageSize = 0;
+		unlink((HugePageMount(&pageSize) + shmName).c_str());
+		return;
+	}
+#endif
+	(void)bHuge;
+	shm_unlink(shmName.c_str());
+}
+
+// Absolute CLOCK_REALTIME time "msec" from now for pthread_mutex_timedlock
+static struct timespec SharedMemoryTimeout(int msec)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_nsec += (long)(msec % 1000) * 1000000L;
+	ts.tv_sec += msec / 1000 + ts.tv_nsec / 1000000000L;
+	ts.tv_nsec %= 1000000000L;
+	return ts;
+}
+
+// Lock the mutex of the header, recovering it if the owner
+// ended without unlocking it
+static bool LockHeader(SpoutSharedMemoryHeader* header, int msec)
+{
+	const struct timespec ts = SharedMemoryTimeout(msec);
+	int result = pthread_mutex_timedlock(&header->mutex, &ts);
+	if (result == EOWNERDEAD)
+		result = pthread_mutex_consistent(&header->mutex);
+	return result == 0;
+}
+
+// Map a segment opened by shm_open and wait for the creator to initialize
+// it, or initialize it if created. Returns false if the segment has been
+// removed by the last Close of another object and should be opened again.
+// A new segment is a whole number of pages of "pageSize" if it is not 0.
+// "bLarge" asks for transparent huge pages and "node" is the NUMA node.
+static bool MapSegment(int fd, bool bCreated, int size, size_t pageSize,
+	bool bLarge, int node, char** ppMap, size_t* pMapSize)
+{
+	*ppMap = NULL;
+	*pMapSize = 0;
+
+	size_t mapSize = SpoutSharedHeaderBytes + (size_t)size;
+	if (pageSize > 0)
+		mapSize = (mapSize + pageSize - 1) / pageSize * pageSize;
+	if (bCreated) {
+		// A new segment is initially zeros
+		if (ftruncate(fd, (off_t)mapSize) != 0)
+			return true;
+	}
+	else {
+		// Map the size that the segment was created with, waiting
+		// for the creator to set it
+		struct stat st;
+		for (int i = 0; i < SPOUT_INIT_TIMEOUT; i++) {
+			if (fstat(fd, &st) != 0)
+				return true;
+			if ((size_t)st.st_size > SpoutSharedHeaderBytes)
+				break;
+			usleep(1000);
+		}
+		if ((size_t)st.st_size <= SpoutSharedHeaderBytes)
+			return true;
+		mapSize = (size_t)st.st_size;
+	}
+
+	// Pages of hugetlbfs are reserved here and it fails if there are not enough
+	void* pMap = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (pMap == MAP_FAILED)
+		return true;
+
+#if defined(__linux__)
+	// Before the pages are first used by the header
+	if (bCreated && node != SpoutSharedMemory::NumaDefault)
+		BindSegment(pMap, mapSize, node);
+	// Used if shmem_enabled in /sys/kernel/mm/transparent_hugepage allows it
+	if (bLarge && pageSize == 0)
+		madvise(pMap, mapSize, MADV_HUGEPAGE);
+#else
+	(void)bLarge;
+	(void)node;
+#endif
+
+	SpoutSharedMemoryHeader* header = static_cast<SpoutSharedMemoryHeader*>(pMap);
+	if (bCreated) {
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+		pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		const int result = pthread_mutex_init(&header->mutex, &attr);
+		pthread_mutexattr_destroy(&attr);
+		if (result != 0) {
+			munmap(pMap, mapSize);
+			return true;
+		}
+		header->size = size;
+		__atomic_store_n(&header->ready, 1u, __ATOMIC_RELEASE);
+	}
+	else {
+		int i = 0;
+		while (!__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE) && i++ < SPOUT_INIT_TIMEOUT)
+			usleep(1000);
+		if (!__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE)) {
+			munmap(pMap, mapSize);
+			return true;
+		}
+	}
+
+	// Count the objects using the segment. A segment removed
+	// since it was opened is mapped again.
+	if (!LockHeader(header, SPOUT_INIT_TIMEOUT)) {
+		munmap(pMap, mapSize);
+		return true;
+	}
+	if (header->unlinked) {
+		pthread_mutex_unlock(&header->mutex);
+		munmap(pMap, mapSize);
+		return false;
+	}
+	header->attached++;
+	pthread_mutex_unlock(&header->mutex);
+
+	*ppMap = static_cast<char*>(pMap);
+	*pMapSize = mapSize;
+	return true;
+}
+
+// Create a new memory segment, or attach to an existing one
+SpoutCreateResult SpoutSharedMemory::Create(const char* name, int size)
+{
+	// Don't call open twice on the same object without a Close()
+	assert(name);
+	assert(size);
+
+	// The last map is closed but still leased
+	if (m_bClosed)
+		return SPOUT_CREATE_FAILED;
+
+	if (m_pMap != NULL) {
+		assert(strcmp(name, m_pName) == 0);
+		assert(m_pBuffer);
+		return SPOUT_ALREADY_CREATED;
+	}
+
+	if (!name || size <= 0)
+		return SPOUT_CREATE_FAILED;
+
+	const std::string shmName = SharedMemoryName(name);
+	bool alreadyExists = false;
+	// Large pages from hugetlbfs for a segment of at least one page
+	size_t hugePageSize = 0;
+	std::string hugePath;
+#if defined(__linux__)
+	if (m_bLargePages) {
+		const std::string& mount = HugePageMount(&hugePageSize);
+		if (!mount.empty() && hugePageSize > 0 && SpoutSharedHeaderBytes + (size_t)size >= hugePageSize)
+			hugePath = mount + shmName;
+	}
+#endif
+	// Retry if the segment is removed between opening and mapping it
+	for (int attempt = 0; attempt < 8 && !m_pMap; attempt++) {
+		// A segment that exists, or a new one
+		bool bHuge = false;
+		bool bCreated = false;
+		int fd = OpenSegment(shmName, &bHuge);
+		if (fd < 0 && errno == ENOENT) {
+			bCreated = true;
+			if (!hugePath.empty()) {
+				fd = open(hugePath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+				if (fd < 0 && errno == EEXIST)
+					continue; // Created by another process meanwhile
+				bHuge = (fd >= 0);
+			}
+			if (fd < 0) {
+				fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+				if (fd < 0 && errno == EEXIST)
+					continue;
+			}
+		}
+		if (fd < 0)
+			return SPOUT_CREATE_FAILED;
+		const bool bMapped = MapSegment(fd, bCreated, size, bHuge ? hugePageSize : 0,
+			m_bLargePages, m_numaNode, &m_pMap, &m_mapSize);
+		close(fd);
+		if (!bMapped)
+			continue;
+		if (!m_pMap) {
+			if (bCreated)
+				UnlinkSegment(shmName, bHuge);
+			// Not enough huge pages, use normal pages
+			if (bCreated && bHuge) {
+				hugePath.clear();
+				continue;
+			}
+			return SPOUT_CREATE_FAILED;
+		}
+		alreadyExists = !bCreated;
+		m_bLargeMap = bHuge;
+	}
+	if (!m_pMap)
+		return SPOUT_CREATE_FAILED;
+
+	// Set the name and size
+	m_pBuffer = m_pMap + SpoutSharedHeaderBytes;
+	m_pName = strdup(name);
+	m_size = size;
+
+	// The size of the map will be the same as when it was created.
+	// An existing segment too small for the size requested can't be used.
+	if (m_mapSize < SpoutSharedHeaderBytes + (size_t)size) {
+		Close();
+		return SPOUT_CREATE_FAILED;
+	}
+
+	return alreadyExists ? SPOUT_ALREADY_EXISTS : SPOUT_CREATE_SUCCESS;
+}
+
+bool SpoutSharedMemory::Open(const char* name)
+{
+	// Don't call open twice on the same object without a Close()
+	assert(name);
+
+	// The last map is closed but still leased
+	if (m_bClosed)
+		return false;
+
+	if (m_pMap) {
+		assert(strcmp(name, m_pName) == 0);
+		assert(m_pBuffer);
+		return true;
+	}
+
+	if (!name)
+		return false;
+
+	const std::string shmName = SharedMemoryName(name);
+	for (int attempt = 0; attempt < 8 && !m_pMap; attempt++) {
+		bool bHuge = false;
+		const int fd = OpenSegment(shmName, &bHuge);
+		if (fd < 0)
+			return false;
+		const bool bMapped = MapSegment(fd, false, 0, 0, m_bLargePages && !bHuge, NumaDefault, &m_pMap, &m_mapSize);
+		close(fd);
+		if (bMapped && !m_pMap)
+			return false;
+		m_bLargeMap = bHuge;
+	}
+	if (!m_pMap)
+		return false;
+
+	m_pBuffer = m_pMap + SpoutSharedHeaderBytes;
+	m_pName = strdup(name);
+	// As for Windows, only the process that creates the shared memory saves its size
+	m_size = 0;
+
+	return true;
+}
+
+void SpoutSharedMemory::Unmap()
+{
+	if (m_pMap) {
+		// Release a lock still held by this object. The mutex is taken
+		// once and the recursion is counted by m_lockCount.
+		SpoutSharedMemoryHeader* header = reinterpret_cast<SpoutSharedMemoryHeader*>(m_pMap);
+		if (m_lockCount > 0)
+			pthread_mutex_unlock(&header->mutex);
+		m_lockCount = 0;
+		// Remove the segment with the last object using it
+		if (LockHeader(header, SPOUT_INIT_TIMEOUT)) {
+			if (header->attached > 0)
+				header->attached--;
+			if (header->attached == 0 && m_pName) {
+				header->unlinked = 1;
+				UnlinkSegment(SharedMemoryName(m_pName), m_bLargeMap);
+			}
+			pthread_mutex_unlock(&header->mutex);
+		}
+		munmap(m_pMap, m_mapSize);
+		m_pMap = NULL;
+		m_mapSize = 0;
+		m_pBuffer = NULL;
+	}
+
+	if (m_pName) {
+		free((void*)m_pName);
+		m_pName = NULL;
+	}
+
+	m_size = 0;
+	m_lockCount = 0;
+	m_bLargeMap = false;
+}
+
+char* SpoutSharedMemory::Lock()
+{
+	assert(m_lockCount >= 0);
+
+	if (m_lockCount < 0 || m_bClosed || !m_pMap || !m_pBuffer) {
+		return NULL;
+	}
+
+	if (m_lockCount > 0) {
+		m_lockCount++;
+		return m_pBuffer;
+	}
+
+	// A mutex left locked by a process that ended is recovered.
+	// The buffer may be partly written.
+	SpoutSharedMemoryHeader* header = reinterpret_cast<SpoutSharedMemoryHeader*>(m_pMap);
+	if (!LockHeader(header, SPOUT_LOCK_TIMEOUT)) {
+		return NULL;
+	}
+
+	m_lockCount++;
+	return m_pBuffer;
+}
+
+void SpoutSharedMemory::Unlock()
+{
+	assert(m_pMap);
+
+	m_lockCount--;
+	assert(m_lockCount >= 0);
+
+	if (m_lockCount == 0 && m_pMap) {
+		pthread_mutex_unlock(&reinterpret_cast<SpoutSharedMemoryHeader*>(m_pMap)->mutex);
+	}
 }
 
 void SpoutSharedMemory::Debug()
 {
 	if (m_pName) {
-		SpoutLogNotice("SpoutSharedMemory::Debug : (%s) m_hMap = [0x%.7X], m_pBuffer = [0x%.7X]", m_pName, LOWORD(m_hMap), PtrToUint(m_pBuffer));
+		printf("SpoutSharedMemory::Debug : (%s) m_pMap = [%p], m_pBuffer = [%p], %zu bytes mapped\n",
+			m_pName, (void*)m_pMap, (void*)m_pBuffer, m_mapSize);
 	}
 	else {
-		SpoutLogNotice("SpoutSharedMemory::Debug : Shared Memory Map is not open\n");
+		printf("SpoutSharedMemory::Debug : Shared Memory Map is not open\n");
+	}
+}
+
+size_t SpoutSharedMemory::ViewSize()
+{
+	if (!m_pMap || m_bClosed || m_mapSize < SpoutSharedHeaderBytes)
+		return 0;
+
+	// The size of the segment less the header
+	return m_mapSize - SpoutSharedHeaderBytes;
+}
+
+#endif
+
+void SpoutSharedMemory::Close()
+{
+	// Unmap when the last lease is released
+	if (m_leases > 0) {
+		m_bClosed = true;
+		return;
+	}
+	Unmap();
+}
+
+void SpoutSharedMemory::ReleaseLease()
+{
+	assert(m_leases > 0);
+	m_leases--;
+	Unlock();
+	if (m_leases == 0 && m_bClosed) {
+		m_bClosed = false;
+		Unmap();
 	}
+}
+
+const char* SpoutSharedMemory::Name()
+{
+	return m_bClosed ? NULL : m_pName;
+}
+
+int SpoutSharedMemory::Size()
+{
+	return m_bClosed ? 0 : m_size;
+}
+
+char* SpoutSharedMemory::Buffer()
+{
+	return m_bClosed ? NULL : m_pBuffer;
+}
+
+void SpoutSharedMemory::SetLargePages(bool bLarge)
+{
+	m_bLargePages = bLarge;
+}
+
+bool SpoutSharedMemory::GetLargePages()
+{
+	return m_bLargePages;
+}
+
+bool SpoutSharedMemory::IsLargePages()
+{
+	return m_pBuffer && !m_bClosed && m_bLargeMap;
+}
 
+void SpoutSharedMemory::SetNumaNode(int node)
+{
+	m_numaNode = (node < NumaCurrent) ? NumaDefault : node;
+}
+
+int SpoutSharedMemory::GetNumaNode()
+{
+	return m_numaNode;
+}
+
+
+//
+// Lease
+//
+
+SpoutSharedMemory::Lease SpoutSharedMemory::Acquire(size_t offset, size_t size)
+{
+	return Lease(this, offset, size);
+}
+
+SpoutSharedMemory::Lease::Lease()
+{
+	m_pMemory = NULL;
+	m_pData = NULL;
+	m_size = 0;
+}
+
+SpoutSharedMemory::Lease::Lease(SpoutSharedMemory* memory, size_t offset, size_t size)
+{
+	m_pMemory = NULL;
+	m_pData = NULL;
+	m_size = 0;
+
+	// Lock asserts an open map
+	if (!memory || !memory->Name())
+		return;
+
+	// The size of the map is only known by the creator,
+	// others can use the view of the map
+	const size_t mapSize = memory->Size() > 0 ? (size_t)memory->Size() : memory->ViewSize();
+	if (mapSize == 0 || offset > mapSize || size > mapSize - offset)
+		return;
+	if (size == 0)
+		size = mapSize - offset;
+
+	const char* pBuffer = memory->Lock();
+	if (!pBuffer)
+		return;
+
+	memory->m_leases++;
+	m_pMemory = memory;
+	m_pData = pBuffer + offset;
+	m_size = size;
+}
+
+SpoutSharedMemory::Lease::Lease(Lease&& other) noexcept
+{
+	m_pMemory = other.m_pMemory;
+	m_pData = other.m_pData;
+	m_size = other.m_size;
+	other.m_pMemory = NULL;
+	other.m_pData = NULL;
+	other.m_size = 0;
+}
+
+SpoutSharedMemory::Lease& SpoutSharedMemory::Lease::operator=(Lease&& other) noexcept
+{
+	if (this != &other) {
+		Release();
+		m_pMemory = other.m_pMemory;
+		m_pData = other.m_pData;
+		m_size = other.m_size;
+		other.m_pMemory = NULL;
+		other.m_pData = NULL;
+		other.m_size = 0;
+	}
+	return *this;
+}
+
+SpoutSharedMemory::Lease::~Lease()
+{
+	Release();
+}
+
+void SpoutSharedMemory::Lease::Release()
+{
+	// The map may be unmapped now if it has been closed
+	if (m_pMemory)
+		m_pMemory->ReleaseLease();
+	m_pMemory = NULL;
+	m_pData = NULL;
+	m_size = 0;
+}
+
+bool SpoutSharedMemory::Lease::IsValid() const
+{
+	return m_pMemory != NULL;
+}
+
+const char* SpoutSharedMemory::Lease::Data() const
+{
+	return m_pData;
+}
+
+size_t SpoutSharedMemory::Lease::Size() const
+{
+	return m_size;
 }
@@ -36,11 +36,15 @@
 #define __SpoutSharedMemory_
 
 #include "SpoutCommon.h"
+#if defined(_WIN32)
 #include <windowsx.h>
 #include <d3d9.h>
 #include <wingdi.h>
 
 using namespace spoututils;
+#else
+#include <stddef.h>
+#endif
 
 // Result of memory segment creation
 enum SpoutCreateResult
@@ -64,7 +68,8 @@ public:
 	// Open an existing memory map
 	bool Open(const char* name);
 
-	// Close a map
+	// Close a map. A map that is leased stays locked and mapped
+	// until the last lease is released.
 	void Close();
 
 	// Lock an open map and return the buffer
@@ -79,17 +84,98 @@ public:
 	// Size of an existing map
 	int Size();
 
+	// Bytes that can be used from the buffer of an open map, also one
+	// opened or created by another process. This is at least the size
+	// the map was created with. On Windows it is whole pages.
+	size_t ViewSize();
+
+	// Buffer of an open map without locking, for readers
+	// that check the consistency of what they read
+	char* Buffer();
+
 	// Print map information for debugging
 	void Debug();
 
+	// Use large pages for maps created after this of at least one large
+	// page, to reduce TLB misses copying large frames. Normal pages are
+	// used if the system has no large pages available (see Create).
+	void SetLargePages(bool bLarge);
+	bool GetLargePages();
+	// True if the open map has large pages
+	bool IsLargePages();
+
+	// NUMA node for the pages of maps created after this.
+	// NumaCurrent is the node of the thread calling Create.
+	void SetNumaNode(int node);
+	int GetNumaNode();
+
+	static const int NumaDefault = -2; // No preference
+	static const int NumaCurrent = -1; // Node of the thread calling Create
+
+	// Read only view of a locked map. The map stays locked while
+	// the lease exists, so that the data can be used where it is
+	// instead of being copied out first. Release it promptly,
+	// a writer waits for it. A map closed while it is leased can't
+	// be used, created or opened again until the lease is released.
+	// Release it before the object is destroyed.
+	class SPOUT_DLLEXP Lease {
+
+	public:
+
+		Lease();
+		// Lock the map for a view of "size" bytes from "offset".
+		// A size of 0 is the rest of the map, or of the view of a map
+		// opened by another process. The lease is not valid if the
+		// view does not fit in the map.
+		Lease(SpoutSharedMemory* memory, size_t offset = 0, size_t size = 0);
+		Lease(Lease&& other) noexcept;
+		Lease& operator=(Lease&& other) noexcept;
+		~Lease();
+
+		// Unlock the map. The view can not be used after this.
+		void Release();
+		// True if the map is locked
+		bool IsValid() const;
+		const char* Data() const;
+		size_t Size() const;
+
+	private:
+
+		SpoutSharedMemory* m_pMemory;
+		const char* m_pData;
+		size_t m_size;
+
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+
+	};
+
+	// Lock the map and lease "size" bytes from "offset"
+	Lease Acquire(size_t offset = 0, size_t size = 0);
+
 private:
 
+	void Unmap();
+	void ReleaseLease();
+
 	char*  m_pBuffer; // Buffer pointer
+#if defined(_WIN32)
 	HANDLE m_hMap; // Map handle
 	HANDLE m_hMutex; // Mutex for map access
+#else
+	// POSIX shared memory with a header containing the mutex
+	// before the buffer (see SpoutSharedMemory.cpp)
+	char*  m_pMap; // Start of the mapping
+	size_t m_mapSize; // Bytes mapped
+#endif
 	int m_lockCount; // Map access lock count
 	const char*	m_pName; // Map name
 	int m_size; // Map size
+	bool m_bLargePages; // Large pages requested
+	bool m_bLargeMap; // The open map has large pages
+	int m_numaNode; // NUMA node requested
+	int m_leases; // Leases held
+	bool m_bClosed; // Closed, unmap when no lease is held
 
 };
 
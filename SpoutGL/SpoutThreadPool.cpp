@@ -0,0 +1,166 @@
+/*
+
+					SpoutThreadPool.cpp
+
+		Worker threads for parallel pixel processing
+
+		A job is a count of independent items, for example stripes of
+		image lines. Workers and the calling thread take the next item
+		from an atomic counter until all have been taken, so faster
+		threads take more items.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutThreadPool.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+struct spoutThreadPoolData {
+	std::vector<std::thread> threads;
+	std::mutex mutex; // job state
+	std::condition_variable wake; // workers wait for a job
+	std::condition_variable done; // calling thread waits for workers
+	std::mutex jobMutex; // one job at a time
+	const std::function<void(unsigned int)> *job = nullptr;
+	unsigned int count = 0;
+	std::atomic<unsigned int> next{ 0 };
+	unsigned int maxWorkers = 0; // workers allowed to join the current job
+	unsigned int joined = 0; // workers that joined the current job
+	unsigned int active = 0; // workers still running the current job
+	unsigned long long generation = 0;
+	bool bQuit = false;
+};
+
+// Set for pool worker threads to prevent a nested job waiting for itself
+static thread_local bool t_bWorker = false;
+
+// Take items until all have been taken
+static void RunItems(spoutThreadPoolData *d, const std::function<void(unsigned int)> &function, unsigned int count)
+{
+	for (;;) {
+		const unsigned int i = d->next.fetch_add(1);
+		if (i >= count)
+			break;
+		function(i);
+	}
+}
+
+static void WorkerThread(spoutThreadPoolData *d)
+{
+	t_bWorker = true;
+	unsigned long long seen = 0;
+	std::unique_lock<std::mutex> lock(d->mutex);
+	for (;;) {
+		d->wake.wait(lock, [&]() { return d->bQuit || d->generation != seen; });
+		if (d->bQuit)
+			return;
+		seen = d->generation;
+		// The job may not need every worker
+		// or may already be complete
+		if (d->joined >= d->maxWorkers)
+			continue;
+		d->joined++;
+		d->active++;
+		const std::function<void(unsigned int)> *job = d->job;
+		const unsigned int count = d->count;
+		lock.unlock();
+		RunItems(d, *job, count);
+		lock.lock();
+		if (--d->active == 0)
+			d->done.notify_one();
+	}
+}
+
+
+spoutThreadPool::spoutThreadPool(unsigned int nWorkers)
+{
+	m_pData = new spoutThreadPoolData;
+	if (nWorkers == 0) {
+		const unsigned int nHardware = std::thread::hardware_concurrency();
+		nWorkers = nHardware > 1 ? nHardware - 1 : 0;
+	}
+	for (unsigned int i = 0; i < nWorkers; i++)
+		m_pData->threads.emplace_back(WorkerThread, m_pData);
+}
+
+
+spoutThreadPool::~spoutThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_pData->mutex);
+		m_pData->bQuit = true;
+	}
+	m_pData->wake.notify_all();
+	for (auto &thread : m_pData->threads)
+		thread.join();
+	delete m_pData;
+}
+
+
+unsigned int spoutThreadPool::GetThreadCount() const
+{
+	return (unsigned int)m_pData->threads.size() + 1;
+}
+
+
+void spoutThreadPool::ParallelFor(unsigned int count, unsigned int maxThreads,
+	const std::function<void(unsigned int)> &function)
+{
+	if (count == 0)
+		return;
+
+	spoutThreadPoolData *d = m_pData;
+	unsigned int nWorkers = maxThreads > 1 ? maxThreads - 1 : 0;
+	if (nWorkers > (unsigned int)d->threads.size())
+		nWorkers = (unsigned int)d->threads.size();
+	if (nWorkers > count - 1)
+		nWorkers = count - 1;
+
+	std::unique_lock<std::mutex> jobLock(d->jobMutex, std::defer_lock);
+	if (nWorkers == 0 || t_bWorker || !jobLock.try_lock()) {
+		for (unsigned int i = 0; i < count; i++)
+			function(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(d->mutex);
+		d->job = &function;
+		d->count = count;
+		d->next = 0;
+		d->maxWorkers = nWorkers;
+		d->joined = 0;
+		d->generation++;
+	}
+	d->wake.notify_all();
+
+	// The calling thread works too
+	RunItems(d, function, count);
+
+	// Wait for the workers that joined. Workers that wake
+	// after this see that the job is closed and do not
+	// use the function which is about to go out of scope.
+	std::unique_lock<std::mutex> lock(d->mutex);
+	d->done.wait(lock, [&]() { return d->active == 0; });
+	d->maxWorkers = 0;
+	d->job = nullptr;
+}
+
+
+// The global pool is not deleted. Worker threads end with the process,
+// avoiding a join during static destruction or dll unload.
+spoutThreadPool &spoutThreadPool::Global()
+{
+	static spoutThreadPool *pool = new spoutThreadPool();
+	return *pool;
+}
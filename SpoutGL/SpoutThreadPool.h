@@ -0,0 +1,56 @@
+/*
+
+					SpoutThreadPool.h
+
+		Worker threads for parallel pixel processing
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutThreadPool__ // standard way as well
+#define __spoutThreadPool__
+
+#include "SpoutCommon.h"
+#include <functional>
+
+struct spoutThreadPoolData;
+
+class SPOUT_DLLEXP spoutThreadPool {
+
+	public:
+
+		// Start "nWorkers" worker threads
+		// 0 starts one worker less than the number of hardware threads
+		// because the calling thread also takes part in each job
+		spoutThreadPool(unsigned int nWorkers = 0);
+		~spoutThreadPool();
+
+		// Threads available for a job, including the calling thread
+		unsigned int GetThreadCount() const;
+
+		// Call function(index) for every index from 0 to count-1
+		// using up to "maxThreads" threads including the calling thread.
+		// Returns when all are complete.
+		// The calling thread does all the work if the pool is busy
+		// with another job or if called from a worker thread.
+		void ParallelFor(unsigned int count, unsigned int maxThreads,
+			const std::function<void(unsigned int)> &function);
+
+		// Pool shared by the process, created on first use
+		static spoutThreadPool &Global();
+
+	protected :
+
+		spoutThreadPoolData *m_pData;
+
+	private :
+
+		spoutThreadPool(const spoutThreadPool &) = delete;
+		spoutThreadPool &operator=(const spoutThreadPool &) = delete;
+
+};
+
+#endif
@@ -0,0 +1,383 @@
+/*
+
+					SpoutThumbnail.cpp
+
+		Thumbnails for monitoring
+
+		Downsample
+
+		Each level is half the size of the one before, rounded up, with
+		each pixel the rounded average of 2 x 2 pixels of the level above.
+		The first level converts two source lines to 8 bit rgba with the
+		line conversion functions and averages them, so the source is
+		read once at its own format. Further levels are made from the
+		level before and add 1/3 to the cost of the first.
+
+		Publisher
+
+		Submit copies the frame to a buffer of the publisher and wakes
+		the publisher thread. Frames submitted while the thread is busy,
+		or before the interval has passed, are ignored without waiting.
+		The thread makes the thumbnail with its own spoutCopy, single
+		threaded so that it does not take workers from the caller.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutThumbnail.h"
+#include "SpoutSharedMemory.h"
+#include <string.h>
+#include <stdio.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace spoutthumbnail {
+
+	unsigned int HalfSize(unsigned int size)
+	{
+		return (size > 1) ? (size + 1) / 2 : 1;
+	}
+
+	static void HalveScalar(const unsigned char *line0, const unsigned char *line1,
+		unsigned char *dst, unsigned int x0, unsigned int sourceWidth)
+	{
+		const unsigned int destWidth = HalfSize(sourceWidth);
+		for (unsigned int x = x0; x < destWidth; x++) {
+			const unsigned int s0 = x * 2;
+			const unsigned int s1 = (s0 + 1 < sourceWidth) ? s0 + 1 : s0;
+			for (unsigned int c = 0; c < 4; c++)
+				dst[x * 4 + c] = (unsigned char)((line0[s0 * 4 + c] + line0[s1 * 4 + c]
+					+ line1[s0 * 4 + c] + line1[s1 * 4 + c] + 2) >> 2);
+		}
+	}
+
+	void HalveLine(const unsigned char *line0, const unsigned char *line1,
+		unsigned char *dst, unsigned int sourceWidth, SpoutCopyTier tier)
+	{
+		if (!line0 || !line1 || !dst || sourceWidth == 0)
+			return;
+
+		unsigned int x = 0;
+		if (tier >= SPOUT_COPY_SSE2) {
+			// 4 source pixels of each line to 2 destination pixels
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i round = _mm_set1_epi16(2);
+			for (; x * 2 + 4 <= sourceWidth; x += 2) {
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(line0 + x * 8));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(line1 + x * 8));
+				// Vertical sums of pixels 0-1 and 2-3
+				const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+				// Pixels 0 + 1 and 2 + 3
+				__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+				sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+				_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x * 4), _mm_packus_epi16(sum, sum));
+			}
+		}
+		HalveScalar(line0, line1, dst, x, sourceWidth);
+	}
+
+	bool WriteBitmap(const char *path, const unsigned char *rgba,
+		unsigned int width, unsigned int height)
+	{
+		if (!path || !*path || !rgba || width == 0 || height == 0)
+			return false;
+
+		// BITMAPFILEHEADER and BITMAPINFOHEADER, little endian.
+		// Negative height for lines from the top down.
+		const unsigned int imageBytes = width * height * 4;
+		unsigned char header[54] = {};
+		auto put32 = [&](unsigned int offset, uint32_t value) {
+			for (int i = 0; i < 4; i++)
+				header[offset + i] = (unsigned char)(value >> (i * 8));
+		};
+		header[0] = 'B';
+		header[1] = 'M';
+		put32(2, 54 + imageBytes);
+		put32(10, 54);
+		put32(14, 40);
+		put32(18, width);
+		put32(22, (uint32_t)(-(int32_t)height));
+		header[26] = 1; // planes
+		header[28] = 32; // bits per pixel
+		put32(34, imageBytes);
+
+		// Write a temporary file and replace the old one
+		// so that a reader does not see a partial image
+		const std::string temp = std::string(path) + ".tmp";
+		FILE *file = fopen(temp.c_str(), "wb");
+		if (!file)
+			return false;
+		bool bResult = (fwrite(header, 1, sizeof(header), file) == sizeof(header));
+		std::vector<unsigned char> line((size_t)width * 4);
+		for (unsigned int y = 0; y < height && bResult; y++) {
+			// rgba to bgra
+			const unsigned char *src = rgba + (size_t)y * width * 4;
+			for (unsigned int x = 0; x < width; x++) {
+				line[x * 4 + 0] = src[x * 4 + 2];
+				line[x * 4 + 1] = src[x * 4 + 1];
+				line[x * 4 + 2] = src[x * 4 + 0];
+				line[x * 4 + 3] = src[x * 4 + 3];
+			}
+			bResult = (fwrite(line.data(), 1, line.size(), file) == line.size());
+		}
+		bResult = (fclose(file) == 0) && bResult;
+		if (!bResult) {
+			remove(temp.c_str());
+			return false;
+		}
+		remove(path);
+		return rename(temp.c_str(), path) == 0;
+	}
+
+}
+
+//
+// Publisher
+//
+
+struct spoutThumbnailPublisherData {
+	std::thread thread;
+	mutable std::mutex mutex;
+	std::condition_variable wake;
+	bool bRunning = false;
+	bool bQuit = false;
+	bool bPending = false; // a frame is waiting or being processed
+	unsigned int interval = 1000;
+	unsigned int levels = 3;
+	std::chrono::steady_clock::time_point next;
+	// Frame copied by Submit. Owned by the thread while pending.
+	std::vector<unsigned char> frame;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	GLenum format = GL_RGBA;
+	bool bInvert = false;
+	// Sinks
+	std::string filePath;
+	std::string memoryName;
+	std::function<void(const unsigned char *, unsigned int, unsigned int)> callback;
+	// Last thumbnail
+	std::vector<unsigned char> thumbnail;
+	unsigned int thumbnailWidth = 0;
+	unsigned int thumbnailHeight = 0;
+	unsigned int count = 0;
+	spoutCopy copy;
+	SpoutSharedMemory memory;
+	int memorySize = 0;
+};
+
+spoutThumbnailPublisher::spoutThumbnailPublisher()
+{
+	m_pData = new spoutThumbnailPublisherData;
+}
+
+spoutThumbnailPublisher::~spoutThumbnailPublisher()
+{
+	Stop();
+	delete m_pData;
+}
+
+bool spoutThumbnailPublisher::Start(unsigned int interval, unsigned int factor)
+{
+	// Levels for the factor, 2 is one level, 4 two and so on
+	unsigned int levels = 0;
+	while ((2u << levels) <= factor && levels < 16)
+		levels++;
+	if (levels == 0 || (1u << levels) != factor)
+		return false;
+
+	Stop();
+	std::lock_guard<std::mutex> lock(m_pData->mutex);
+	m_pData->interval = interval;
+	m_pData->levels = levels;
+	m_pData->next = std::chrono::steady_clock::now();
+	m_pData->bQuit = false;
+	m_pData->bPending = false;
+	m_pData->bRunning = true;
+	m_pData->thread = std::thread(&spoutThumbnailPublisher::Run, this);
+	return true;
+}
+
+void spoutThumbnailPublisher::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_pData->mutex);
+		if (!m_pData->bRunning)
+			return;
+		m_pData->bQuit = true;
+	}
+	m_pData->wake.notify_one();
+	m_pData->thread.join();
+	std::lock_guard<std::mutex> lock(m_pData->mutex);
+	m_pData->bRunning = false;
+	m_pData->bPending = false;
+}
+
+bool spoutThumbnailPublisher::IsRunning() const
+{
+	std::lock_guard<std::mutex> lock(m_pData->mutex);
+	return m_pData->bRunning;
+}
+
+void spoutThumbnailPublisher::SetFileSink(const std::string &path)
+{
+	std::lock_guard<std::mutex> lock(m_pData->mutex);
+	m_pData->filePath = path;
+}
+
+void spoutThumbnailPublisher::SetSharedMemorySink(const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(m_pData->mutex);
+	m_pData->memoryName = name;
+}
+
+void spoutThumbnailPublisher::SetCallback(const std::function<void(const unsigned char *rgba,
+	unsigned int width, unsigned int height)> &callback)
+{
+	std::lock_guard<std::mutex> lock(m_pData->mutex);
+	m_pData->callback = callback;
+}
+
+bool spoutThumbnailPublisher::IsDue() const
+{
+	std::unique_lock<std::mutex> lock(m_pData->mutex, std::try_to_lock);
+	return lock.owns_lock() && m_pData->bRunning && !m_pData->bPending
+		&& std::chrono::steady_clock::now() >= m_pData->next;
+}
+
+bool spoutThumbnailPublisher::Submit(const void *pixels, unsigned int width, unsigned int height,
+	unsigned int pitch, GLenum glFormat, bool bInvert)
+{
+	const unsigned int bytes = spoutCopy::GetPixelBytes(glFormat);
+	if (!pixels || width == 0 || height == 0 || bytes == 0)
+		return false;
+
+	// Never wait for the publisher thread
+	std::unique_lock<std::mutex> lock(m_pData->mutex, std::try_to_lock);
+	if (!lock.owns_lock() || !m_pData->bRunning || m_pData->bPending)
+		return false;
+	const auto now = std::chrono::steady_clock::now();
+	if (now < m_pData->next)
+		return false;
+
+	const size_t lineBytes = (size_t)width * bytes;
+	if (pitch == 0)
+		pitch = (unsigned int)lineBytes;
+	m_pData->frame.resize(lineBytes * height);
+	const unsigned char *src = static_cast<const unsigned char *>(pixels);
+	if (pitch == lineBytes) {
+		memcpy(m_pData->frame.data(), src, lineBytes * height);
+	}
+	else {
+		for (unsigned int y = 0; y < height; y++)
+			memcpy(m_pData->frame.data() + y * lineBytes, src + (size_t)y * pitch, lineBytes);
+	}
+	m_pData->width = width;
+	m_pData->height = height;
+	m_pData->format = glFormat;
+	m_pData->bInvert = bInvert;
+	m_pData->bPending = true;
+	m_pData->next = now + std::chrono::milliseconds(m_pData->interval);
+	lock.unlock();
+	m_pData->wake.notify_one();
+	return true;
+}
+
+unsigned int spoutThumbnailPublisher::GetCount() const
+{
+	std::lock_guard<std::mutex> lock(m_pData->mutex);
+	return m_pData->count;
+}
+
+bool spoutThumbnailPublisher::GetThumbnail(std::vector<unsigned char> &rgba,
+	unsigned int &width, unsigned int &height) const
+{
+	std::lock_guard<std::mutex> lock(m_pData->mutex);
+	if (m_pData->thumbnail.empty())
+		return false;
+	rgba = m_pData->thumbnail;
+	width = m_pData->thumbnailWidth;
+	height = m_pData->thumbnailHeight;
+	return true;
+}
+
+void spoutThumbnailPublisher::Run()
+{
+	std::unique_lock<std::mutex> lock(m_pData->mutex);
+	for (;;) {
+		m_pData->wake.wait(lock, [&]() { return m_pData->bQuit || m_pData->bPending; });
+		if (m_pData->bQuit)
+			return;
+		lock.unlock();
+		Publish();
+		lock.lock();
+		m_pData->bPending = false;
+	}
+}
+
+// Thumbnail of the pending frame, made on the publisher thread.
+// Submit does not change the frame while it is pending.
+void spoutThumbnailPublisher::Publish()
+{
+	spoutThumbnailPublisherData *d = m_pData;
+
+	// Every level
+	std::vector<std::vector<unsigned char>> levels(d->levels);
+	std::vector<unsigned char *> dest(d->levels);
+	unsigned int width = d->width;
+	unsigned int height = d->height;
+	for (unsigned int i = 0; i < d->levels; i++) {
+		width = spoutthumbnail::HalfSize(width);
+		height = spoutthumbnail::HalfSize(height);
+		levels[i].resize((size_t)width * height * 4);
+		dest[i] = levels[i].data();
+	}
+	if (!d->copy.Downsample(d->frame.data(), d->width, d->height, 0, d->format,
+		dest.data(), d->levels, d->bInvert))
+		return;
+	const std::vector<unsigned char> &rgba = levels.back();
+
+	std::string filePath, memoryName;
+	std::function<void(const unsigned char *, unsigned int, unsigned int)> callback;
+	{
+		std::lock_guard<std::mutex> lock(d->mutex);
+		filePath = d->filePath;
+		memoryName = d->memoryName;
+		callback = d->callback;
+	}
+
+	if (!filePath.empty())
+		spoutthumbnail::WriteBitmap(filePath.c_str(), rgba.data(), width, height);
+
+	if (!memoryName.empty()) {
+		const int size = (int)(16 + rgba.size());
+		if (size != d->memorySize) {
+			d->memory.Close();
+			d->memorySize = (d->memory.Create(memoryName.c_str(), size) == SPOUT_CREATE_FAILED) ? 0 : size;
+		}
+		char *buffer = d->memorySize ? d->memory.Lock() : nullptr;
+		if (buffer) {
+			const uint32_t header[4] = { width, height, d->count + 1, 0 };
+			memcpy(buffer, header, sizeof(header));
+			memcpy(buffer + sizeof(header), rgba.data(), rgba.size());
+			d->memory.Unlock();
+		}
+	}
+
+	if (callback)
+		callback(rgba.data(), width, height);
+
+	std::lock_guard<std::mutex> lock(d->mutex);
+	d->thumbnail = rgba;
+	d->thumbnailWidth = width;
+	d->thumbnailHeight = height;
+	d->count++;
+}
@@ -0,0 +1,102 @@
+/*
+
+					SpoutThumbnail.h
+
+		Thumbnails for monitoring
+
+		spoutCopy::Downsample reduces an image of any format to 8 bit rgba
+		thumbnails of 1/2, 1/4, 1/8 ... size with a 2 x 2 box filter at each step.
+
+		spoutThumbnailPublisher makes a thumbnail of a frame at a low rate
+		on its own thread and writes it to a file, shared memory or a function.
+		The frame is copied by Submit when a thumbnail is due and all other
+		work is done by the publisher thread, so the cost to the caller is
+		at most one copy of a frame for each interval.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutThumbnail__ // standard way as well
+#define __spoutThumbnail__
+
+#include "SpoutCopy.h"
+#include <string>
+#include <vector>
+
+namespace spoutthumbnail {
+
+	// Width or height of the next level, half rounded up and at least 1
+	unsigned int HalfSize(unsigned int size);
+
+	// One line of 8 bit rgba pixels of half width from two source lines.
+	// Each destination pixel is the rounded average of 2 x 2 source pixels.
+	// The last source pixel is repeated for an odd width.
+	void HalveLine(const unsigned char *line0, const unsigned char *line1,
+		unsigned char *dst, unsigned int sourceWidth, SpoutCopyTier tier);
+
+	// Write 8 bit rgba pixels to a 32 bit .bmp file
+	bool WriteBitmap(const char *path, const unsigned char *rgba,
+		unsigned int width, unsigned int height);
+
+}
+
+struct spoutThumbnailPublisherData;
+
+class SPOUT_DLLEXP spoutThumbnailPublisher {
+
+	public:
+
+		spoutThumbnailPublisher();
+		~spoutThumbnailPublisher();
+
+		// Start the publisher thread. A thumbnail every "interval" milliseconds
+		// reduced by "factor" (2, 4, 8 ...) from the frame size.
+		bool Start(unsigned int interval = 1000, unsigned int factor = 8);
+		// Stop the thread after any thumbnail in progress
+		void Stop();
+		bool IsRunning() const;
+
+		// Destinations. Any or all can be used.
+		// A .bmp file replaced by each thumbnail. Empty for none.
+		void SetFileSink(const std::string &path);
+		// Shared memory with a header of four 32 bit values, width, height,
+		// thumbnail count and 0, followed by the rgba pixels. Empty for none.
+		void SetSharedMemorySink(const std::string &name);
+		// Function called on the publisher thread with each thumbnail
+		void SetCallback(const std::function<void(const unsigned char *rgba,
+			unsigned int width, unsigned int height)> &callback);
+
+		// True if the interval has passed and the thread is not busy,
+		// so that Submit would take a frame
+		bool IsDue() const;
+		// Copy a frame for the next thumbnail if one is due and return
+		// immediately otherwise, allowing for line pitch (0 for no padding).
+		// Formats : any supported by spoutCopy::Downsample.
+		// Returns true if the frame was taken.
+		bool Submit(const void *pixels, unsigned int width, unsigned int height,
+			unsigned int pitch, GLenum glFormat, bool bInvert = false);
+
+		// Thumbnails written so far
+		unsigned int GetCount() const;
+		// Copy of the last thumbnail. Returns false if there is none yet.
+		bool GetThumbnail(std::vector<unsigned char> &rgba,
+			unsigned int &width, unsigned int &height) const;
+
+	protected :
+
+		spoutThumbnailPublisherData *m_pData;
+
+		void Run();
+		void Publish();
+
+	private :
+
+		spoutThumbnailPublisher(const spoutThumbnailPublisher &) = delete;
+		spoutThumbnailPublisher &operator=(const spoutThumbnailPublisher &) = delete;
+
+};
+
+#endif
@@ -0,0 +1,427 @@
+/*
+
+					SpoutTransfer.cpp
+
+		Transfer functions for linear and encoded pixel values
+
+		sRGB      IEC 61966-2-1
+		Rec.709   ITU-R BT.709 camera curve (also BT.601 and BT.2020)
+		PQ        SMPTE ST 2084 perceptual quantizer. Linear 1.0 is 10000 cd/m2.
+		HLG       ITU-R BT.2100 hybrid log-gamma. Scene linear without the OOTF.
+
+		A conversion decodes each value to linear with the source function
+		and encodes it with the destination function. Linear to linear is a copy.
+
+		Tables
+
+		8 bit and 16 bit values have 256 and 65536 entry tables with the
+		result of the double precision functions rounded to nearest.
+		Half float uses a 65536 entry table indexed by the half bits.
+		Tables are built on first use for each pair of functions.
+
+		Float
+
+		pow, exp and log are calculated with exp2 and log2 polynomials
+		for four values at once with SSE2.
+
+		log2(x) : x = m * 2^e with m from 0.707 to 1.414
+			log2(m) = 2/ln2 * (t + t^3/3 + t^5/5 + t^7/7 + t^9/9), t = (m-1)/(m+1)
+			|t| < 0.172 and the next term is less than 1e-9.
+
+		exp2(y) : y = n + f with f from -0.5 to 0.5
+			2^f = sum of (f*ln2)^k / k! for k = 0 to 7
+			The next term is less than 6e-9 and 2^n is set in the exponent.
+
+		PQ raises values close to 1 to large powers, so the encode and decode
+		functions work with the difference from 1 to keep the precision.
+
+		The results are within spouttransfer::FloatErrorBound of the double
+		precision functions for every pair of functions. The benchmark checks
+		this for 1 million values of each.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutTransfer.h"
+#include "SpoutConvert.h"
+#include <string.h>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <mutex>
+
+namespace spouttransfer {
+
+	// sRGB
+	static const double srgb_a = 0.055;
+	static const double srgb_linear = 0.0031308; // linear segment limit
+	// Rec.709 with the BT.2020 constants to more places (1.099 and 0.018)
+	// so that the two segments meet
+	static const double rec709_a = 0.09929682680944;
+	static const double rec709_linear = 0.018053968510807;
+	// PQ
+	static const double pq_m1 = 2610.0 / 16384.0;
+	static const double pq_m2 = 2523.0 / 4096.0 * 128.0;
+	static const double pq_c1 = 3424.0 / 4096.0;
+	static const double pq_c2 = 2413.0 / 4096.0 * 32.0;
+	static const double pq_c3 = 2392.0 / 4096.0 * 32.0;
+	// HLG
+	static const double hlg_a = 0.17883277;
+	static const double hlg_b = 0.28466892; // 1 - 4a
+	static const double hlg_c = 0.55991073; // 0.5 - a*ln(4a)
+
+	static inline double Clamp01(double x)
+	{
+		// NaN to 0
+		return (x > 0.0) ? ((x < 1.0) ? x : 1.0) : 0.0;
+	}
+
+	double Decode(SpoutTransferFunction transfer, double value)
+	{
+		const double v = Clamp01(value);
+		switch (transfer) {
+			case SPOUT_TRANSFER_SRGB:
+				return (v <= srgb_linear * 12.92) ? v / 12.92 : std::pow((v + srgb_a) / (1.0 + srgb_a), 2.4);
+			case SPOUT_TRANSFER_REC709:
+				return (v < rec709_linear * 4.5) ? v / 4.5 : std::pow((v + rec709_a) / (1.0 + rec709_a), 1.0 / 0.45);
+			case SPOUT_TRANSFER_PQ: {
+				const double e = std::pow(v, 1.0 / pq_m2);
+				const double n = (e > pq_c1) ? e - pq_c1 : 0.0;
+				return std::pow(n / (pq_c2 - pq_c3 * e), 1.0 / pq_m1);
+			}
+			case SPOUT_TRANSFER_HLG:
+				return (v <= 0.5) ? v * v / 3.0 : (std::exp((v - hlg_c) / hlg_a) + hlg_b) / 12.0;
+			default:
+				return v;
+		}
+	}
+
+	double Encode(SpoutTransferFunction transfer, double value)
+	{
+		const double l = Clamp01(value);
+		switch (transfer) {
+			case SPOUT_TRANSFER_SRGB:
+				return (l <= srgb_linear) ? l * 12.92 : (1.0 + srgb_a) * std::pow(l, 1.0 / 2.4) - srgb_a;
+			case SPOUT_TRANSFER_REC709:
+				return (l < rec709_linear) ? l * 4.5 : (1.0 + rec709_a) * std::pow(l, 0.45) - rec709_a;
+			case SPOUT_TRANSFER_PQ: {
+				const double y = std::pow(l, pq_m1);
+				return std::pow((pq_c1 + pq_c2 * y) / (1.0 + pq_c3 * y), pq_m2);
+			}
+			case SPOUT_TRANSFER_HLG:
+				return (l <= 1.0 / 12.0) ? std::sqrt(3.0 * l) : hlg_a * std::log(12.0 * l - hlg_b) + hlg_c;
+			default:
+				return l;
+		}
+	}
+
+	static inline double Convert(SpoutTransferFunction from, SpoutTransferFunction to, double value)
+	{
+		return Encode(to, Decode(from, value));
+	}
+
+	//
+	// Tables
+	//
+
+	struct TransferTables {
+		unsigned char unorm8[256];
+		std::vector<uint16_t> unorm16;
+		std::vector<uint16_t> half;
+	};
+
+	static TransferTables tables[SPOUT_TRANSFER_COUNT][SPOUT_TRANSFER_COUNT];
+	static std::once_flag tables8[SPOUT_TRANSFER_COUNT][SPOUT_TRANSFER_COUNT];
+	static std::once_flag tables16[SPOUT_TRANSFER_COUNT][SPOUT_TRANSFER_COUNT];
+	static std::once_flag tablesHalf[SPOUT_TRANSFER_COUNT][SPOUT_TRANSFER_COUNT];
+
+	static const unsigned char *Unorm8Table(SpoutTransferFunction from, SpoutTransferFunction to)
+	{
+		TransferTables &t = tables[from][to];
+		std::call_once(tables8[from][to], [&]() {
+			for (unsigned int v = 0; v < 256; v++)
+				t.unorm8[v] = (unsigned char)std::floor(Convert(from, to, v / 255.0) * 255.0 + 0.5);
+		});
+		return t.unorm8;
+	}
+
+	static const uint16_t *Unorm16Table(SpoutTransferFunction from, SpoutTransferFunction to)
+	{
+		TransferTables &t = tables[from][to];
+		std::call_once(tables16[from][to], [&]() {
+			t.unorm16.resize(65536);
+			for (unsigned int v = 0; v < 65536; v++)
+				t.unorm16[v] = (uint16_t)std::floor(Convert(from, to, v / 65535.0) * 65535.0 + 0.5);
+		});
+		return t.unorm16.data();
+	}
+
+	static const uint16_t *HalfTable(SpoutTransferFunction from, SpoutTransferFunction to)
+	{
+		TransferTables &t = tables[from][to];
+		std::call_once(tablesHalf[from][to], [&]() {
+			t.half.resize(65536);
+			for (unsigned int h = 0; h < 65536; h++) {
+				const double v = spoutconvert::HalfToFloat((uint16_t)h);
+				t.half[h] = spoutconvert::FloatToHalf((float)Convert(from, to, v));
+			}
+		});
+		return t.half.data();
+	}
+
+	void Prepare(SpoutRGBAFormat format, SpoutTransferFunction from, SpoutTransferFunction to)
+	{
+		if (from == to || from >= SPOUT_TRANSFER_COUNT || to >= SPOUT_TRANSFER_COUNT)
+			return;
+		if (format == SPOUT_RGBA8)
+			Unorm8Table(from, to);
+		else if (format == SPOUT_RGBA16)
+			Unorm16Table(from, to);
+		else if (format == SPOUT_RGBA16F)
+			HalfTable(from, to);
+	}
+
+	//
+	// SSE2 float functions
+	//
+
+	static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	// log2(m) for m from 0.707 to 1.414 as m = (1 + t) / (1 - t).
+	// "u" is m - 1, which can be more precise than m.
+	static inline __m128 Log2Mantissa(__m128 u)
+	{
+		const __m128 t = _mm_div_ps(u, _mm_add_ps(u, _mm_set1_ps(2.0f)));
+		const __m128 t2 = _mm_mul_ps(t, t);
+		__m128 p = _mm_set1_ps(0.320598898f);
+		p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.412198583f));
+		p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.577078016f));
+		p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.961796694f));
+		p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(2.885390082f));
+		return _mm_mul_ps(p, t);
+	}
+
+	// log2 of positive normal values
+	static inline __m128 Log2(__m128 x)
+	{
+		const __m128i bits = _mm_castps_si128(x);
+		__m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+		__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+			_mm_set1_epi32(0x3f800000)));
+		// m from 1 to 2, halve above sqrt(2)
+		const __m128 high = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+		m = Select(high, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+		e = _mm_sub_epi32(e, _mm_castps_si128(high)); // mask is -1
+		return _mm_add_ps(_mm_cvtepi32_ps(e), Log2Mantissa(_mm_sub_ps(m, _mm_set1_ps(1.0f))));
+	}
+
+	// 2^f - 1 for f from -0.5 to 0.5, without the loss of precision
+	// from subtracting 1 when the result is close to 0
+	static inline __m128 Exp2m1(__m128 f)
+	{
+		__m128 p = _mm_set1_ps(1.52527338e-05f);
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.54035304e-04f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.33335581e-03f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.61812911e-03f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.55041087e-02f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.40226507e-01f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.93147181e-01f));
+		return _mm_mul_ps(p, f);
+	}
+
+	static inline __m128 Exp2(__m128 y)
+	{
+		y = _mm_min_ps(_mm_max_ps(y, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.0f));
+		const __m128i n = _mm_cvtps_epi32(y); // nearest
+		const __m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(n));
+		const __m128 p = _mm_add_ps(Exp2m1(f), _mm_set1_ps(1.0f));
+		const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+		return _mm_mul_ps(p, scale);
+	}
+
+	// x^y for x >= 0
+	static inline __m128 Pow(__m128 x, float y)
+	{
+		const __m128 r = Exp2(_mm_mul_ps(_mm_set1_ps(y), Log2(_mm_max_ps(x, _mm_set1_ps(FLT_MIN)))));
+		return _mm_and_ps(_mm_cmpgt_ps(x, _mm_setzero_ps()), r);
+	}
+
+	static inline __m128 DecodeSSE2(SpoutTransferFunction transfer, __m128 v)
+	{
+		switch (transfer) {
+			case SPOUT_TRANSFER_SRGB: {
+				const __m128 lin = _mm_mul_ps(v, _mm_set1_ps((float)(1.0 / 12.92)));
+				const __m128 p = Pow(_mm_mul_ps(_mm_add_ps(v, _mm_set1_ps((float)srgb_a)),
+					_mm_set1_ps((float)(1.0 / (1.0 + srgb_a)))), 2.4f);
+				return Select(_mm_cmple_ps(v, _mm_set1_ps((float)(srgb_linear * 12.92))), lin, p);
+			}
+			case SPOUT_TRANSFER_REC709: {
+				const __m128 lin = _mm_mul_ps(v, _mm_set1_ps((float)(1.0 / 4.5)));
+				const __m128 p = Pow(_mm_mul_ps(_mm_add_ps(v, _mm_set1_ps((float)rec709_a)),
+					_mm_set1_ps((float)(1.0 / (1.0 + rec709_a)))), (float)(1.0 / 0.45));
+				return Select(_mm_cmplt_ps(v, _mm_set1_ps((float)(rec709_linear * 4.5))), lin, p);
+			}
+			case SPOUT_TRANSFER_PQ: {
+				// e = v^(1/m2) is close to 1 and c2 - c3*e loses precision, so use e - 1.
+				// c2 - c3 = 1 - c1. Results below 2^-0.5 are less than c1 and give 0.
+				const __m128 y = _mm_mul_ps(Log2(_mm_max_ps(v, _mm_set1_ps(FLT_MIN))), _mm_set1_ps((float)(1.0 / pq_m2)));
+				const __m128 em1 = Exp2m1(_mm_max_ps(y, _mm_set1_ps(-0.5f)));
+				const __m128 k = _mm_set1_ps((float)(1.0 - pq_c1));
+				const __m128 n = _mm_max_ps(_mm_add_ps(k, em1), _mm_setzero_ps());
+				const __m128 d = _mm_sub_ps(k, _mm_mul_ps(_mm_set1_ps((float)pq_c3), em1));
+				return Pow(_mm_div_ps(n, d), (float)(1.0 / pq_m1));
+			}
+			case SPOUT_TRANSFER_HLG: {
+				const __m128 sq = _mm_mul_ps(_mm_mul_ps(v, v), _mm_set1_ps((float)(1.0 / 3.0)));
+				// exp(x) = 2^(x*log2(e))
+				const __m128 x = _mm_mul_ps(_mm_sub_ps(v, _mm_set1_ps((float)hlg_c)),
+					_mm_set1_ps((float)(1.0 / (hlg_a * std::log(2.0)))));
+				const __m128 ex = _mm_mul_ps(_mm_add_ps(Exp2(x), _mm_set1_ps((float)hlg_b)),
+					_mm_set1_ps((float)(1.0 / 12.0)));
+				return Select(_mm_cmple_ps(v, _mm_set1_ps(0.5f)), sq, ex);
+			}
+			default:
+				return v;
+		}
+	}
+
+	static inline __m128 EncodeSSE2(SpoutTransferFunction transfer, __m128 l)
+	{
+		switch (transfer) {
+			case SPOUT_TRANSFER_SRGB: {
+				const __m128 lin = _mm_mul_ps(l, _mm_set1_ps(12.92f));
+				const __m128 p = _mm_sub_ps(_mm_mul_ps(Pow(l, (float)(1.0 / 2.4)),
+					_mm_set1_ps((float)(1.0 + srgb_a))), _mm_set1_ps((float)srgb_a));
+				return Select(_mm_cmple_ps(l, _mm_set1_ps((float)srgb_linear)), lin, p);
+			}
+			case SPOUT_TRANSFER_REC709: {
+				const __m128 lin = _mm_mul_ps(l, _mm_set1_ps(4.5f));
+				const __m128 p = _mm_sub_ps(_mm_mul_ps(Pow(l, 0.45f),
+					_mm_set1_ps((float)(1.0 + rec709_a))), _mm_set1_ps((float)rec709_a));
+				return Select(_mm_cmplt_ps(l, _mm_set1_ps((float)rec709_linear)), lin, p);
+			}
+			case SPOUT_TRANSFER_PQ: {
+				// The ratio r is from c1 to 1 and is raised to the power 78.8,
+				// so log2(r) is from r - 1 = (1 - c1)(y - 1) / (1 + c3*y)
+				const __m128 y = Pow(l, (float)pq_m1);
+				const __m128 u = _mm_div_ps(_mm_mul_ps(_mm_set1_ps((float)(1.0 - pq_c1)), _mm_sub_ps(y, _mm_set1_ps(1.0f))),
+					_mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps((float)pq_c3), y)));
+				return Exp2(_mm_mul_ps(Log2Mantissa(u), _mm_set1_ps((float)pq_m2)));
+			}
+			case SPOUT_TRANSFER_HLG: {
+				const __m128 sq = _mm_sqrt_ps(_mm_mul_ps(l, _mm_set1_ps(3.0f)));
+				// ln(x) = log2(x)*ln(2). 12l - b is positive where used.
+				const __m128 x = _mm_max_ps(_mm_sub_ps(_mm_mul_ps(l, _mm_set1_ps(12.0f)),
+					_mm_set1_ps((float)hlg_b)), _mm_set1_ps(FLT_MIN));
+				const __m128 lg = _mm_add_ps(_mm_mul_ps(Log2(x), _mm_set1_ps((float)(hlg_a * std::log(2.0)))),
+					_mm_set1_ps((float)hlg_c));
+				return Select(_mm_cmple_ps(l, _mm_set1_ps((float)(1.0 / 12.0))), sq, lg);
+			}
+			default:
+				return l;
+		}
+	}
+
+	// Generated for each pair so that the function selection is at compile time
+	template <SpoutTransferFunction From, SpoutTransferFunction To>
+	static void FloatLineSSE2(const unsigned char *src, unsigned char *dst, unsigned int width)
+	{
+		const __m128 rgb = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+		for (unsigned int x = 0; x < width; x++) {
+			const __m128 v = _mm_loadu_ps(reinterpret_cast<const float *>(src + (size_t)x * 16));
+			// _mm_max_ps returns the second operand for NaN
+			const __m128 c = _mm_min_ps(_mm_max_ps(v, zero), one);
+			const __m128 out = EncodeSSE2(To, _mm_min_ps(DecodeSSE2(From, c), one));
+			_mm_storeu_ps(reinterpret_cast<float *>(dst + (size_t)x * 16), Select(rgb, out, v));
+		}
+	}
+
+	typedef void (*FloatLineFunction)(const unsigned char *src, unsigned char *dst, unsigned int width);
+
+#define SPOUT_TRANSFER_FROM(from) { \
+		FloatLineSSE2<from, SPOUT_TRANSFER_LINEAR>, FloatLineSSE2<from, SPOUT_TRANSFER_SRGB>, \
+		FloatLineSSE2<from, SPOUT_TRANSFER_REC709>, FloatLineSSE2<from, SPOUT_TRANSFER_PQ>, \
+		FloatLineSSE2<from, SPOUT_TRANSFER_HLG> }
+
+	static const FloatLineFunction floatLines[SPOUT_TRANSFER_COUNT][SPOUT_TRANSFER_COUNT] = {
+		SPOUT_TRANSFER_FROM(SPOUT_TRANSFER_LINEAR),
+		SPOUT_TRANSFER_FROM(SPOUT_TRANSFER_SRGB),
+		SPOUT_TRANSFER_FROM(SPOUT_TRANSFER_REC709),
+		SPOUT_TRANSFER_FROM(SPOUT_TRANSFER_PQ),
+		SPOUT_TRANSFER_FROM(SPOUT_TRANSFER_HLG),
+	};
+
+#undef SPOUT_TRANSFER_FROM
+
+	static void FloatLineScalar(const unsigned char *src, unsigned char *dst, unsigned int width,
+		SpoutTransferFunction from, SpoutTransferFunction to)
+	{
+		for (unsigned int x = 0; x < width; x++) {
+			float v[3];
+			memcpy(v, src + (size_t)x * 16, 12);
+			for (int c = 0; c < 3; c++)
+				v[c] = (float)Convert(from, to, v[c]);
+			memcpy(dst + (size_t)x * 16, v, 12);
+			if (dst != src)
+				memcpy(dst + (size_t)x * 16 + 12, src + (size_t)x * 16 + 12, 4);
+		}
+	}
+
+	template <typename T>
+	static void TableLine(const unsigned char *src, unsigned char *dst, unsigned int width, const T *table)
+	{
+		for (unsigned int x = 0; x < width; x++) {
+			T v[4];
+			memcpy(v, src + (size_t)x * sizeof(v), sizeof(v));
+			v[0] = table[v[0]];
+			v[1] = table[v[1]];
+			v[2] = table[v[2]];
+			memcpy(dst + (size_t)x * sizeof(v), v, sizeof(v));
+		}
+	}
+
+	void ApplyLine(const unsigned char *src, unsigned char *dst, unsigned int width,
+		SpoutRGBAFormat format, SpoutTransferFunction from, SpoutTransferFunction to,
+		SpoutCopyTier tier)
+	{
+		if (!src || !dst || width == 0 || format >= SPOUT_RGBA_FORMAT_COUNT
+			|| from >= SPOUT_TRANSFER_COUNT || to >= SPOUT_TRANSFER_COUNT)
+			return;
+
+		if (from == to) {
+			if (dst != src)
+				memmove(dst, src, (size_t)width * spoutconvert::PixelBytes(format));
+			return;
+		}
+
+		switch (format) {
+			case SPOUT_RGBA8:
+				TableLine(src, dst, width, Unorm8Table(from, to));
+				break;
+			case SPOUT_RGBA16:
+				TableLine(src, dst, width, Unorm16Table(from, to));
+				break;
+			case SPOUT_RGBA16F:
+				TableLine(src, dst, width, HalfTable(from, to));
+				break;
+			default:
+				if (tier == SPOUT_COPY_SCALAR)
+					FloatLineScalar(src, dst, width, from, to);
+				else
+					floatLines[from][to](src, dst, width);
+				break;
+		}
+	}
+
+}
@@ -0,0 +1,47 @@
+/*
+
+					SpoutTransfer.h
+
+		Transfer functions for linear and encoded pixel values
+
+		sRGB, Rec.709, PQ and HLG encoding and decoding of rgba pixels.
+		Use spoutCopy::ApplyTransfer to convert an image with multiple threads.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutTransfer__ // standard way as well
+#define __spoutTransfer__
+
+#include "SpoutCopy.h"
+
+namespace spouttransfer {
+
+	// Double precision reference functions for values 0-1.
+	// Decode gives the linear value of an encoded value
+	// and Encode the encoded value of a linear value.
+	double Decode(SpoutTransferFunction transfer, double value);
+	double Encode(SpoutTransferFunction transfer, double value);
+
+	// Maximum difference of the float functions from the reference
+	// for values 0-1. Checked by SpoutCopyTest.
+	const float FloatErrorBound = 1.0e-6f;
+
+	// Convert one line of rgba pixels from one transfer function to another.
+	// 8 bit, 16 bit and half float pixels use tables. Float pixels use
+	// SSE2 polynomial functions, or the reference functions for the
+	// scalar tier. Values are clamped to 0-1. Alpha is not changed.
+	// Source and destination can be the same.
+	void ApplyLine(const unsigned char *src, unsigned char *dst, unsigned int width,
+		SpoutRGBAFormat format, SpoutTransferFunction from, SpoutTransferFunction to,
+		SpoutCopyTier tier);
+
+	// Build the tables for a conversion before use by multiple threads
+	void Prepare(SpoutRGBAFormat format, SpoutTransferFunction from, SpoutTransferFunction to);
+
+}
+
+#endif
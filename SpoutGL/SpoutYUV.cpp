@@ -0,0 +1,759 @@
+/*
+
+					SpoutYUV.cpp
+
+		Conversion between YUV and rgba pixels
+
+		Formats
+
+		NV12   8 bit 4:2:0. A plane of Y bytes, followed by a plane of
+		       Cb Cr byte pairs for every second line and pixel.
+		P010   10 bit 4:2:0. As NV12 with 16 bit little-endian words
+		       and the value in the high 10 bits.
+		UYVY   8 bit 4:2:2. Cb Y0 Cr Y1 for each pair of pixels.
+		v210   10 bit 4:2:2. Groups of 6 pixels in four 32 bit words with
+		       three 10 bit values each, in the order Cb Y Cr Y as UYVY.
+		       Lines are aligned to 128 bytes.
+
+		Chroma position
+
+		Horizontally the chroma samples are at the even pixels (co-sited)
+		and vertically between the two lines (centred) as for H.264 and HEVC.
+		RGBA to YUV filters the chroma with [1 2 1]/4 horizontally and
+		averages the two lines for 4:2:0. YUV to rgba interpolates
+		the odd pixels and weights the nearest two chroma lines 3/4 and 1/4.
+
+		Matrix
+
+		Each line is unpacked to Y, Cb and Cr floats at full width and
+		converted to rgba with SSE2 for four pixels at a time, or the reverse.
+		Coefficients include the range and the rgba scale so that each channel
+		is one multiply and add per component, in single precision to keep
+		10 bit values exact. The scalar version gives the same result.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+	========================
+
+	16.10.26 - Create file
+
+*/
+#include "SpoutYUV.h"
+#include <string.h>
+#include <cmath>
+#include <vector>
+
+namespace spoutyuv {
+
+	// Kr and Kb of each matrix. Kg = 1 - Kr - Kb.
+	static const double matrixK[SPOUT_YUV_MATRIX_COUNT][2] = {
+		{ 0.299,  0.114 },  // BT.601
+		{ 0.2126, 0.0722 }, // BT.709
+		{ 0.2627, 0.0593 }, // BT.2020
+	};
+
+	unsigned int LinePitch(SpoutYUVFormat format, unsigned int width)
+	{
+		const unsigned int chroma = (width + 1) / 2;
+		switch (format) {
+			case SPOUT_YUV_NV12: return chroma * 2;
+			case SPOUT_YUV_P010: return chroma * 4;
+			case SPOUT_YUV_UYVY: return chroma * 4;
+			case SPOUT_YUV_V210: return ((width + 47) / 48) * 128;
+			default: return 0;
+		}
+	}
+
+	bool IsVerticalSubsampled(SpoutYUVFormat format)
+	{
+		return format == SPOUT_YUV_NV12 || format == SPOUT_YUV_P010;
+	}
+
+	size_t FrameBytes(SpoutYUVFormat format, unsigned int width, unsigned int height, unsigned int pitch)
+	{
+		if (pitch == 0)
+			pitch = LinePitch(format, width);
+		size_t lines = height;
+		if (IsVerticalSubsampled(format))
+			lines += (height + 1) / 2;
+		return lines * pitch;
+	}
+
+	static bool Is10Bit(SpoutYUVFormat format)
+	{
+		return format == SPOUT_YUV_P010 || format == SPOUT_YUV_V210;
+	}
+
+	//
+	// Coefficients
+	//
+
+	// Code values : Y = yOffset + yScale * luma, C = cOffset + cScale * chroma
+	struct Range {
+		double yOffset;
+		double yScale;
+		double cOffset;
+		double cScale;
+		float max; // largest code value
+	};
+
+	static Range GetRange(const Frame &frame)
+	{
+		const double shift = Is10Bit(frame.format) ? 4.0 : 1.0;
+		Range range;
+		range.max = Is10Bit(frame.format) ? 1023.0f : 255.0f;
+		range.cOffset = 128.0 * shift;
+		if (frame.bFullRange) {
+			range.yOffset = 0.0;
+			range.yScale = range.max;
+			range.cScale = range.max;
+		}
+		else {
+			range.yOffset = 16.0 * shift;
+			range.yScale = 219.0 * shift;
+			range.cScale = 224.0 * shift;
+		}
+		return range;
+	}
+
+	// YUV code values to rgba from 0 to "max"
+	// r = (Y - yo)*ky + (V - co)*rv
+	// g = (Y - yo)*ky + (U - co)*gu + (V - co)*gv
+	// b = (Y - yo)*ky + (U - co)*bu
+	struct Decoder {
+		float yo, co;
+		float ky, rv, gu, gv, bu;
+		float max;
+	};
+
+	static Decoder GetDecoder(const Frame &frame, float max)
+	{
+		const Range range = GetRange(frame);
+		const double kr = matrixK[frame.matrix][0];
+		const double kb = matrixK[frame.matrix][1];
+		const double kg = 1.0 - kr - kb;
+		Decoder d;
+		d.yo = (float)range.yOffset;
+		d.co = (float)range.cOffset;
+		d.ky = (float)(max / range.yScale);
+		d.rv = (float)(max * 2.0 * (1.0 - kr) / range.cScale);
+		d.bu = (float)(max * 2.0 * (1.0 - kb) / range.cScale);
+		d.gu = (float)(-max * 2.0 * kb * (1.0 - kb) / (kg * range.cScale));
+		d.gv = (float)(-max * 2.0 * kr * (1.0 - kr) / (kg * range.cScale));
+		d.max = max;
+		return d;
+	}
+
+	// rgba from 0 to "max" to YUV code values
+	// Y = yo + r*yr + g*yg + b*yb
+	// U = co + r*ur + g*ug + b*ub
+	// V = co + r*vr + g*vg + b*vb
+	struct Encoder {
+		float yo, co;
+		float yr, yg, yb;
+		float ur, ug, ub;
+		float vr, vg, vb;
+	};
+
+	static Encoder GetEncoder(const Frame &frame, float max)
+	{
+		const Range range = GetRange(frame);
+		const double kr = matrixK[frame.matrix][0];
+		const double kb = matrixK[frame.matrix][1];
+		const double kg = 1.0 - kr - kb;
+		const double ys = range.yScale / max;
+		const double us = range.cScale / (2.0 * (1.0 - kb) * max);
+		const double vs = range.cScale / (2.0 * (1.0 - kr) * max);
+		Encoder e;
+		e.yo = (float)range.yOffset;
+		e.co = (float)range.cOffset;
+		e.yr = (float)(kr * ys);
+		e.yg = (float)(kg * ys);
+		e.yb = (float)(kb * ys);
+		e.ur = (float)(-kr * us);
+		e.ug = (float)(-kg * us);
+		e.ub = (float)((1.0 - kb) * us);
+		e.vr = (float)((1.0 - kr) * vs);
+		e.vg = (float)(-kg * vs);
+		e.vb = (float)(-kb * vs);
+		return e;
+	}
+
+	static inline float RGBAMax(SpoutRGBAFormat format)
+	{
+		if (format == SPOUT_RGBA8) return 255.0f;
+		if (format == SPOUT_RGBA16) return 65535.0f;
+		return 1.0f;
+	}
+
+	static inline unsigned int RGBABytes(SpoutRGBAFormat format)
+	{
+		if (format == SPOUT_RGBA8) return 4;
+		if (format == SPOUT_RGBA32F) return 16;
+		return 8;
+	}
+
+	static inline float Clamp(float v, float max)
+	{
+		return (v > 0.0f) ? ((v < max) ? v : max) : 0.0f;
+	}
+
+	// Nearest code value
+	static inline unsigned int Quantize(float v, float max)
+	{
+		return (unsigned int)(Clamp(v, max) + 0.5f);
+	}
+
+	//
+	// Line buffers for one thread
+	//
+	struct Lines {
+		std::vector<float> y, u, v;       // full width
+		std::vector<float> u2, v2;        // second line for 4:2:0
+		std::vector<float> uh, vh;        // half width chroma
+		std::vector<float> uh2, vh2;
+		std::vector<uint16_t> samples;    // 4:2:2 values in Cb Y Cr Y order
+		Lines(unsigned int width)
+		{
+			const size_t full = (size_t)width + 4;
+			const size_t half = (size_t)(width + 1) / 2 + 4;
+			y.resize(full); u.resize(full); v.resize(full);
+			u2.resize(full); v2.resize(full);
+			uh.resize(half); vh.resize(half);
+			uh2.resize(half); vh2.resize(half);
+			samples.resize(((size_t)width + 5) / 6 * 12);
+		}
+	};
+
+	//
+	// Chroma resampling
+	//
+
+	// Co-sited : even pixels have a chroma sample, odd pixels are between two
+	static void UpsampleLine(const float *half, float *full, unsigned int width)
+	{
+		const unsigned int chroma = (width + 1) / 2;
+		for (unsigned int x = 0; x < width; x++) {
+			const unsigned int i = x >> 1;
+			if ((x & 1) == 0)
+				full[x] = half[i];
+			else
+				full[x] = 0.5f * (half[i] + half[(i + 1 < chroma) ? i + 1 : i]);
+		}
+	}
+
+	static void DownsampleLine(const float *full, float *half, unsigned int width)
+	{
+		const unsigned int chroma = (width + 1) / 2;
+		for (unsigned int i = 0; i < chroma; i++) {
+			const unsigned int x = i * 2;
+			const float left = full[(x > 0) ? x - 1 : x];
+			const float right = full[(x + 1 < width) ? x + 1 : x];
+			half[i] = 0.25f * left + 0.5f * full[x] + 0.25f * right;
+		}
+	}
+
+	//
+	// Unpack and pack YUV lines
+	//
+
+	// 4:2:2 values in Cb Y Cr Y order
+	static void UnpackSamples(const Frame &frame, const unsigned char *line, Lines &lines)
+	{
+		const unsigned int count = ((frame.width + 1) / 2) * 4;
+		uint16_t *s = lines.samples.data();
+		if (frame.format == SPOUT_YUV_UYVY) {
+			for (unsigned int i = 0; i < count; i++)
+				s[i] = line[i];
+		}
+		else {
+			// v210 groups of four words
+			const unsigned int groups = (frame.width + 5) / 6;
+			for (unsigned int g = 0; g < groups; g++) {
+				for (unsigned int w = 0; w < 4; w++) {
+					uint32_t word;
+					memcpy(&word, line + (size_t)g * 16 + w * 4, 4);
+					s[g * 12 + w * 3 + 0] = (uint16_t)(word & 0x3ff);
+					s[g * 12 + w * 3 + 1] = (uint16_t)((word >> 10) & 0x3ff);
+					s[g * 12 + w * 3 + 2] = (uint16_t)((word >> 20) & 0x3ff);
+				}
+			}
+		}
+	}
+
+	static void PackSamples(const Frame &frame, const Lines &lines, unsigned char *line)
+	{
+		const unsigned int count = ((frame.width + 1) / 2) * 4;
+		const uint16_t *s = lines.samples.data();
+		if (frame.format == SPOUT_YUV_UYVY) {
+			for (unsigned int i = 0; i < count; i++)
+				line[i] = (unsigned char)s[i];
+		}
+		else {
+			const unsigned int groups = (frame.width + 5) / 6;
+			for (unsigned int g = 0; g < groups; g++) {
+				for (unsigned int w = 0; w < 4; w++) {
+					const uint32_t word = (uint32_t)s[g * 12 + w * 3]
+						| ((uint32_t)s[g * 12 + w * 3 + 1] << 10)
+						| ((uint32_t)s[g * 12 + w * 3 + 2] << 20);
+					memcpy(line + (size_t)g * 16 + w * 4, &word, 4);
+				}
+			}
+		}
+	}
+
+	static void UnpackLuma(const Frame &frame, const unsigned char *line, float *y, bool bSSE2)
+	{
+		unsigned int x = 0;
+		if (bSSE2) {
+			const __m128i zero = _mm_setzero_si128();
+			if (frame.format == SPOUT_YUV_NV12) {
+				for (; x + 16 <= frame.width; x += 16) {
+					const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i *>(line + x));
+					const __m128i lo = _mm_unpacklo_epi8(q, zero);
+					const __m128i hi = _mm_unpackhi_epi8(q, zero);
+					_mm_storeu_ps(y + x, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+					_mm_storeu_ps(y + x + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+					_mm_storeu_ps(y + x + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+					_mm_storeu_ps(y + x + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+				}
+			}
+			else {
+				for (; x + 8 <= frame.width; x += 8) {
+					const __m128i q = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(line + (size_t)x * 2)), 6);
+					_mm_storeu_ps(y + x, _mm_cvtepi32_ps(_mm_unpacklo_epi16(q, zero)));
+					_mm_storeu_ps(y + x + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(q, zero)));
+				}
+			}
+		}
+		if (frame.format == SPOUT_YUV_NV12) {
+			for (; x < frame.width; x++)
+				y[x] = (float)line[x];
+		}
+		else {
+			for (; x < frame.width; x++) {
+				uint16_t w;
+				memcpy(&w, line + (size_t)x * 2, 2);
+				y[x] = (float)(w >> 6);
+			}
+		}
+	}
+
+	static void PackLuma(const Frame &frame, const float *y, float max, unsigned char *line, bool bSSE2)
+	{
+		unsigned int x = 0;
+		if (bSSE2) {
+			// The same as Quantize
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 maxv = _mm_set1_ps(max);
+			const __m128 half = _mm_set1_ps(0.5f);
+			if (frame.format == SPOUT_YUV_NV12) {
+				for (; x + 16 <= frame.width; x += 16) {
+					__m128i q[4];
+					for (int i = 0; i < 4; i++)
+						q[i] = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(y + x + i * 4), zero), maxv), half));
+					const __m128i lo = _mm_packs_epi32(q[0], q[1]);
+					const __m128i hi = _mm_packs_epi32(q[2], q[3]);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(line + x), _mm_packus_epi16(lo, hi));
+				}
+			}
+			else {
+				for (; x + 8 <= frame.width; x += 8) {
+					const __m128i lo = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(y + x), zero), maxv), half));
+					const __m128i hi = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(y + x + 4), zero), maxv), half));
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(line + (size_t)x * 2), _mm_slli_epi16(_mm_packs_epi32(lo, hi), 6));
+				}
+			}
+		}
+		if (frame.format == SPOUT_YUV_NV12) {
+			for (; x < frame.width; x++)
+				line[x] = (unsigned char)Quantize(y[x], max);
+		}
+		else {
+			for (; x < frame.width; x++) {
+				const uint16_t w = (uint16_t)(Quantize(y[x], max) << 6);
+				memcpy(line + (size_t)x * 2, &w, 2);
+			}
+		}
+	}
+
+	static void UnpackChroma(const Frame &frame, const unsigned char *line, float *u, float *v)
+	{
+		const unsigned int chroma = (frame.width + 1) / 2;
+		if (frame.format == SPOUT_YUV_NV12) {
+			for (unsigned int i = 0; i < chroma; i++) {
+				u[i] = (float)line[i * 2];
+				v[i] = (float)line[i * 2 + 1];
+			}
+		}
+		else {
+			for (unsigned int i = 0; i < chroma; i++) {
+				uint16_t w[2];
+				memcpy(w, line + (size_t)i * 4, 4);
+				u[i] = (float)(w[0] >> 6);
+				v[i] = (float)(w[1] >> 6);
+			}
+		}
+	}
+
+	static void PackChroma(const Frame &frame, const float *u, const float *v, float max, unsigned char *line)
+	{
+		const unsigned int chroma = (frame.width + 1) / 2;
+		if (frame.format == SPOUT_YUV_NV12) {
+			for (unsigned int i = 0; i < chroma; i++) {
+				line[i * 2] = (unsigned char)Quantize(u[i], max);
+				line[i * 2 + 1] = (unsigned char)Quantize(v[i], max);
+			}
+		}
+		else {
+			for (unsigned int i = 0; i < chroma; i++) {
+				const uint16_t w[2] = { (uint16_t)(Quantize(u[i], max) << 6), (uint16_t)(Quantize(v[i], max) << 6) };
+				memcpy(line + (size_t)i * 4, w, 4);
+			}
+		}
+	}
+
+	//
+	// Matrix
+	//
+
+	template <int F>
+	static inline void StorePixel(unsigned char *p, float r, float g, float b, float a)
+	{
+		if (F == SPOUT_RGBA8) {
+			p[0] = (unsigned char)std::nearbyint(r);
+			p[1] = (unsigned char)std::nearbyint(g);
+			p[2] = (unsigned char)std::nearbyint(b);
+			p[3] = (unsigned char)a;
+		}
+		else if (F == SPOUT_RGBA16) {
+			const uint16_t s[4] = { (uint16_t)std::nearbyint(r), (uint16_t)std::nearbyint(g),
+				(uint16_t)std::nearbyint(b), (uint16_t)a };
+			memcpy(p, s, 8);
+		}
+		else {
+			const float s[4] = { r, g, b, a };
+			memcpy(p, s, 16);
+		}
+	}
+
+	template <int F>
+	static inline void LoadPixel(const unsigned char *p, float &r, float &g, float &b)
+	{
+		if (F == SPOUT_RGBA8) {
+			r = (float)p[0];
+			g = (float)p[1];
+			b = (float)p[2];
+		}
+		else if (F == SPOUT_RGBA16) {
+			uint16_t s[3];
+			memcpy(s, p, 6);
+			r = (float)s[0];
+			g = (float)s[1];
+			b = (float)s[2];
+		}
+		else {
+			float s[3];
+			memcpy(s, p, 12);
+			r = s[0];
+			g = s[1];
+			b = s[2];
+		}
+	}
+
+	template <int F>
+	static void DecodeMatrixScalar(const float *Y, const float *U, const float *V,
+		unsigned char *dst, unsigned int width, const Decoder &d, bool bBGRA)
+	{
+		const unsigned int bytes = RGBABytes((SpoutRGBAFormat)F);
+		for (unsigned int x = 0; x < width; x++) {
+			const float y = (Y[x] - d.yo) * d.ky;
+			const float u = U[x] - d.co;
+			const float v = V[x] - d.co;
+			float r = Clamp(y + v * d.rv, d.max);
+			const float g = Clamp((y + u * d.gu) + v * d.gv, d.max);
+			float b = Clamp(y + u * d.bu, d.max);
+			if (bBGRA) {
+				const float t = r; r = b; b = t;
+			}
+			StorePixel<F>(dst + (size_t)x * bytes, r, g, b, d.max);
+		}
+	}
+
+	template <int F>
+	static void EncodeMatrixScalar(const unsigned char *src, float *Y, float *U, float *V,
+		unsigned int width, const Encoder &e, bool bBGRA)
+	{
+		const unsigned int bytes = RGBABytes((SpoutRGBAFormat)F);
+		for (unsigned int x = 0; x < width; x++) {
+			float r, g, b;
+			LoadPixel<F>(src + (size_t)x * bytes, r, g, b);
+			if (bBGRA) {
+				const float t = r; r = b; b = t;
+			}
+			Y[x] = ((e.yo + r * e.yr) + g * e.yg) + b * e.yb;
+			U[x] = ((e.co + r * e.ur) + g * e.ug) + b * e.ub;
+			V[x] = ((e.co + r * e.vr) + g * e.vg) + b * e.vb;
+		}
+	}
+
+	// Four rgba pixels to and from four vectors of r, g, b, a
+	template <int F>
+	static inline void Store4(unsigned char *p, __m128 p0, __m128 p1, __m128 p2, __m128 p3)
+	{
+		if (F == SPOUT_RGBA8) {
+			const __m128i lo = _mm_packs_epi32(_mm_cvtps_epi32(p0), _mm_cvtps_epi32(p1));
+			const __m128i hi = _mm_packs_epi32(_mm_cvtps_epi32(p2), _mm_cvtps_epi32(p3));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(lo, hi));
+		}
+		else if (F == SPOUT_RGBA16) {
+			// No unsigned 32 to 16 bit pack in SSE2, so offset to signed and back
+			const __m128i offset = _mm_set1_epi32(32768);
+			const __m128i sign = _mm_set1_epi16((short)0x8000);
+			const __m128i lo = _mm_packs_epi32(_mm_sub_epi32(_mm_cvtps_epi32(p0), offset), _mm_sub_epi32(_mm_cvtps_epi32(p1), offset));
+			const __m128i hi = _mm_packs_epi32(_mm_sub_epi32(_mm_cvtps_epi32(p2), offset), _mm_sub_epi32(_mm_cvtps_epi32(p3), offset));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_xor_si128(lo, sign));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(p + 16), _mm_xor_si128(hi, sign));
+		}
+		else {
+			_mm_storeu_ps(reinterpret_cast<float *>(p), p0);
+			_mm_storeu_ps(reinterpret_cast<float *>(p + 16), p1);
+			_mm_storeu_ps(reinterpret_cast<float *>(p + 32), p2);
+			_mm_storeu_ps(reinterpret_cast<float *>(p + 48), p3);
+		}
+	}
+
+	template <int F>
+	static inline void Load4(const unsigned char *p, __m128 &p0, __m128 &p1, __m128 &p2, __m128 &p3)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		if (F == SPOUT_RGBA8) {
+			const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+			const __m128i lo = _mm_unpacklo_epi8(q, zero);
+			const __m128i hi = _mm_unpackhi_epi8(q, zero);
+			p0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+			p1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+			p2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+			p3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+		}
+		else if (F == SPOUT_RGBA16) {
+			const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+			const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+			p0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+			p1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+			p2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+			p3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+		}
+		else {
+			p0 = _mm_loadu_ps(reinterpret_cast<const float *>(p));
+			p1 = _mm_loadu_ps(reinterpret_cast<const float *>(p + 16));
+			p2 = _mm_loadu_ps(reinterpret_cast<const float *>(p + 32));
+			p3 = _mm_loadu_ps(reinterpret_cast<const float *>(p + 48));
+		}
+	}
+
+	template <int F>
+	static void DecodeMatrixSSE2(const float *Y, const float *U, const float *V,
+		unsigned char *dst, unsigned int width, const Decoder &d, bool bBGRA)
+	{
+		const unsigned int bytes = RGBABytes((SpoutRGBAFormat)F);
+		const __m128 yo = _mm_set1_ps(d.yo);
+		const __m128 co = _mm_set1_ps(d.co);
+		const __m128 ky = _mm_set1_ps(d.ky);
+		const __m128 rv = _mm_set1_ps(d.rv);
+		const __m128 gu = _mm_set1_ps(d.gu);
+		const __m128 gv = _mm_set1_ps(d.gv);
+		const __m128 bu = _mm_set1_ps(d.bu);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 max = _mm_set1_ps(d.max);
+		unsigned int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			const __m128 y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(Y + x), yo), ky);
+			const __m128 u = _mm_sub_ps(_mm_loadu_ps(U + x), co);
+			const __m128 v = _mm_sub_ps(_mm_loadu_ps(V + x), co);
+			__m128 r = _mm_min_ps(_mm_max_ps(_mm_add_ps(y, _mm_mul_ps(v, rv)), zero), max);
+			__m128 g = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_add_ps(y, _mm_mul_ps(u, gu)), _mm_mul_ps(v, gv)), zero), max);
+			__m128 b = _mm_min_ps(_mm_max_ps(_mm_add_ps(y, _mm_mul_ps(u, bu)), zero), max);
+			__m128 a = max;
+			if (bBGRA) {
+				const __m128 t = r; r = b; b = t;
+			}
+			// Four pixels of r, g, b, a
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+			Store4<F>(dst + (size_t)x * bytes, r, g, b, a);
+		}
+		DecodeMatrixScalar<F>(Y + x, U + x, V + x, dst + (size_t)x * bytes, width - x, d, bBGRA);
+	}
+
+	template <int F>
+	static void EncodeMatrixSSE2(const unsigned char *src, float *Y, float *U, float *V,
+		unsigned int width, const Encoder &e, bool bBGRA)
+	{
+		const unsigned int bytes = RGBABytes((SpoutRGBAFormat)F);
+		const __m128 yo = _mm_set1_ps(e.yo);
+		const __m128 co = _mm_set1_ps(e.co);
+		unsigned int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			__m128 r, g, b, a;
+			Load4<F>(src + (size_t)x * bytes, r, g, b, a);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+			if (bBGRA) {
+				const __m128 t = r; r = b; b = t;
+			}
+			__m128 y = _mm_add_ps(yo, _mm_mul_ps(r, _mm_set1_ps(e.yr)));
+			y = _mm_add_ps(_mm_add_ps(y, _mm_mul_ps(g, _mm_set1_ps(e.yg))), _mm_mul_ps(b, _mm_set1_ps(e.yb)));
+			__m128 u = _mm_add_ps(co, _mm_mul_ps(r, _mm_set1_ps(e.ur)));
+			u = _mm_add_ps(_mm_add_ps(u, _mm_mul_ps(g, _mm_set1_ps(e.ug))), _mm_mul_ps(b, _mm_set1_ps(e.ub)));
+			__m128 v = _mm_add_ps(co, _mm_mul_ps(r, _mm_set1_ps(e.vr)));
+			v = _mm_add_ps(_mm_add_ps(v, _mm_mul_ps(g, _mm_set1_ps(e.vg))), _mm_mul_ps(b, _mm_set1_ps(e.vb)));
+			_mm_storeu_ps(Y + x, y);
+			_mm_storeu_ps(U + x, u);
+			_mm_storeu_ps(V + x, v);
+		}
+		EncodeMatrixScalar<F>(src + (size_t)x * bytes, Y + x, U + x, V + x, width - x, e, bBGRA);
+	}
+
+	typedef void (*DecodeMatrixFunction)(const float *Y, const float *U, const float *V,
+		unsigned char *dst, unsigned int width, const Decoder &d, bool bBGRA);
+	typedef void (*EncodeMatrixFunction)(const unsigned char *src, float *Y, float *U, float *V,
+		unsigned int width, const Encoder &e, bool bBGRA);
+
+	static DecodeMatrixFunction GetDecodeMatrix(SpoutRGBAFormat format, SpoutCopyTier tier)
+	{
+		const bool bSSE2 = (tier != SPOUT_COPY_SCALAR);
+		if (format == SPOUT_RGBA8)
+			return bSSE2 ? DecodeMatrixSSE2<SPOUT_RGBA8> : DecodeMatrixScalar<SPOUT_RGBA8>;
+		if (format == SPOUT_RGBA16)
+			return bSSE2 ? DecodeMatrixSSE2<SPOUT_RGBA16> : DecodeMatrixScalar<SPOUT_RGBA16>;
+		return bSSE2 ? DecodeMatrixSSE2<SPOUT_RGBA32F> : DecodeMatrixScalar<SPOUT_RGBA32F>;
+	}
+
+	static EncodeMatrixFunction GetEncodeMatrix(SpoutRGBAFormat format, SpoutCopyTier tier)
+	{
+		const bool bSSE2 = (tier != SPOUT_COPY_SCALAR);
+		if (format == SPOUT_RGBA8)
+			return bSSE2 ? EncodeMatrixSSE2<SPOUT_RGBA8> : EncodeMatrixScalar<SPOUT_RGBA8>;
+		if (format == SPOUT_RGBA16)
+			return bSSE2 ? EncodeMatrixSSE2<SPOUT_RGBA16> : EncodeMatrixScalar<SPOUT_RGBA16>;
+		return bSSE2 ? EncodeMatrixSSE2<SPOUT_RGBA32F> : EncodeMatrixScalar<SPOUT_RGBA32F>;
+	}
+
+	//
+	// Lines
+	//
+
+	void DecodeLines(const Frame &frame, const unsigned char *yuv,
+		unsigned char *rgba, unsigned int rgbaPitch, SpoutRGBAFormat rgbaFormat, bool bBGRA,
+		bool bInvert, SpoutCopyTier tier, unsigned int y0, unsigned int y1)
+	{
+		if (rgbaFormat != SPOUT_RGBA8)
+			bBGRA = false;
+		const Decoder d = GetDecoder(frame, RGBAMax(rgbaFormat));
+		const DecodeMatrixFunction matrix = GetDecodeMatrix(rgbaFormat, tier);
+		const bool bSSE2 = (tier != SPOUT_COPY_SCALAR);
+		const unsigned int width = frame.width;
+		const unsigned int chromaLines = (frame.height + 1) / 2;
+		const unsigned char *chromaPlane = yuv + (size_t)frame.pitch * frame.height;
+		Lines lines(width);
+
+		for (unsigned int y = y0; y < y1; y++) {
+			const unsigned char *line = yuv + (size_t)y * frame.pitch;
+			if (IsVerticalSubsampled(frame.format)) {
+				UnpackLuma(frame, line, lines.y.data(), bSSE2);
+				// Nearest chroma line 3/4 and the next nearest 1/4
+				const unsigned int j = y / 2;
+				unsigned int k = j;
+				if (y & 1) {
+					if (j + 1 < chromaLines) k = j + 1;
+				}
+				else if (j > 0) {
+					k = j - 1;
+				}
+				UnpackChroma(frame, chromaPlane + (size_t)j * frame.pitch, lines.uh.data(), lines.vh.data());
+				UnpackChroma(frame, chromaPlane + (size_t)k * frame.pitch, lines.uh2.data(), lines.vh2.data());
+				for (unsigned int i = 0; i < (width + 1) / 2; i++) {
+					lines.uh[i] = 0.75f * lines.uh[i] + 0.25f * lines.uh2[i];
+					lines.vh[i] = 0.75f * lines.vh[i] + 0.25f * lines.vh2[i];
+				}
+			}
+			else {
+				UnpackSamples(frame, line, lines);
+				const uint16_t *s = lines.samples.data();
+				for (unsigned int i = 0; i < (width + 1) / 2; i++) {
+					lines.uh[i] = (float)s[i * 4];
+					lines.y[i * 2] = (float)s[i * 4 + 1];
+					lines.vh[i] = (float)s[i * 4 + 2];
+					if (i * 2 + 1 < width)
+						lines.y[i * 2 + 1] = (float)s[i * 4 + 3];
+				}
+			}
+			UpsampleLine(lines.uh.data(), lines.u.data(), width);
+			UpsampleLine(lines.vh.data(), lines.v.data(), width);
+
+			const unsigned int yd = bInvert ? (frame.height - 1 - y) : y;
+			matrix(lines.y.data(), lines.u.data(), lines.v.data(),
+				rgba + (size_t)yd * rgbaPitch, width, d, bBGRA);
+		}
+	}
+
+	void EncodeLines(const Frame &frame, const unsigned char *rgba, unsigned int rgbaPitch,
+		SpoutRGBAFormat rgbaFormat, bool bBGRA, unsigned char *yuv,
+		bool bInvert, SpoutCopyTier tier, unsigned int y0, unsigned int y1)
+	{
+		if (rgbaFormat != SPOUT_RGBA8)
+			bBGRA = false;
+		const Encoder e = GetEncoder(frame, RGBAMax(rgbaFormat));
+		const EncodeMatrixFunction matrix = GetEncodeMatrix(rgbaFormat, tier);
+		const bool bSSE2 = (tier != SPOUT_COPY_SCALAR);
+		const float max = GetRange(frame).max;
+		const unsigned int width = frame.width;
+		const unsigned int chroma = (width + 1) / 2;
+		unsigned char *chromaPlane = yuv + (size_t)frame.pitch * frame.height;
+		Lines lines(width);
+
+		auto rgbaLine = [&](unsigned int y) {
+			return rgba + (size_t)(bInvert ? (frame.height - 1 - y) : y) * rgbaPitch;
+		};
+
+		if (IsVerticalSubsampled(frame.format)) {
+			for (unsigned int y = y0; y < y1; y += 2) {
+				matrix(rgbaLine(y), lines.y.data(), lines.u.data(), lines.v.data(), width, e, bBGRA);
+				PackLuma(frame, lines.y.data(), max, yuv + (size_t)y * frame.pitch, bSSE2);
+				if (y + 1 < frame.height) {
+					matrix(rgbaLine(y + 1), lines.y.data(), lines.u2.data(), lines.v2.data(), width, e, bBGRA);
+					PackLuma(frame, lines.y.data(), max, yuv + (size_t)(y + 1) * frame.pitch, bSSE2);
+					for (unsigned int x = 0; x < width; x++) {
+						lines.u[x] = 0.5f * (lines.u[x] + lines.u2[x]);
+						lines.v[x] = 0.5f * (lines.v[x] + lines.v2[x]);
+					}
+				}
+				DownsampleLine(lines.u.data(), lines.uh.data(), width);
+				DownsampleLine(lines.v.data(), lines.vh.data(), width);
+				PackChroma(frame, lines.uh.data(), lines.vh.data(), max, chromaPlane + (size_t)(y / 2) * frame.pitch);
+			}
+		}
+		else {
+			uint16_t *s = lines.samples.data();
+			const size_t count = lines.samples.size();
+			for (unsigned int y = y0; y < y1; y++) {
+				matrix(rgbaLine(y), lines.y.data(), lines.u.data(), lines.v.data(), width, e, bBGRA);
+				DownsampleLine(lines.u.data(), lines.uh.data(), width);
+				DownsampleLine(lines.v.data(), lines.vh.data(), width);
+				for (unsigned int i = 0; i < chroma; i++) {
+					const unsigned int x1 = (i * 2 + 1 < width) ? i * 2 + 1 : i * 2;
+					s[i * 4] = (uint16_t)Quantize(lines.uh[i], max);
+					s[i * 4 + 1] = (uint16_t)Quantize(lines.y[i * 2], max);
+					s[i * 4 + 2] = (uint16_t)Quantize(lines.vh[i], max);
+					s[i * 4 + 3] = (uint16_t)Quantize(lines.y[x1], max);
+				}
+				// The rest of the last v210 group
+				for (size_t i = (size_t)chroma * 4; i < count; i++)
+					s[i] = 0;
+				PackSamples(frame, lines, yuv + (size_t)y * frame.pitch);
+			}
+		}
+	}
+
+}
@@ -0,0 +1,56 @@
+/*
+
+					SpoutYUV.h
+
+		Conversion between YUV and rgba pixels
+
+		NV12, P010, UYVY and v210 with BT.601, BT.709 and BT.2020
+		matrices and full or limited range.
+		Use spoutCopy::YUVToRGBA and spoutCopy::RGBAToYUV to convert
+		an image with multiple threads.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#pragma once
+#ifndef __spoutYUV__ // standard way as well
+#define __spoutYUV__
+
+#include "SpoutCopy.h"
+
+namespace spoutyuv {
+
+	// Layout of a YUV frame
+	struct Frame {
+		SpoutYUVFormat format;
+		SpoutYUVMatrix matrix;
+		bool bFullRange;
+		unsigned int width;
+		unsigned int height;
+		unsigned int pitch; // bytes per line of each plane
+	};
+
+	// Bytes per line without padding. v210 lines are aligned to 128 bytes.
+	unsigned int LinePitch(SpoutYUVFormat format, unsigned int width);
+	// Bytes of a frame including the CbCr plane of NV12 and P010
+	size_t FrameBytes(SpoutYUVFormat format, unsigned int width, unsigned int height, unsigned int pitch = 0);
+	// Formats with chroma for every second line (NV12 and P010)
+	bool IsVerticalSubsampled(SpoutYUVFormat format);
+
+	// Convert YUV lines y0 to y1 to rgba lines. The rgba lines are
+	// in reverse order for bInvert.
+	void DecodeLines(const Frame &frame, const unsigned char *yuv,
+		unsigned char *rgba, unsigned int rgbaPitch, SpoutRGBAFormat rgbaFormat, bool bBGRA,
+		bool bInvert, SpoutCopyTier tier, unsigned int y0, unsigned int y1);
+
+	// Convert rgba lines y0 to y1 to YUV lines. For NV12 and P010
+	// y0 must be even and y1 even or the frame height.
+	void EncodeLines(const Frame &frame, const unsigned char *rgba, unsigned int rgbaPitch,
+		SpoutRGBAFormat rgbaFormat, bool bBGRA, unsigned char *yuv,
+		bool bInvert, SpoutCopyTier tier, unsigned int y0, unsigned int y1);
+
+}
+
+#endif
@@ -0,0 +1,1494 @@
+/*
+
+					SpoutCopyTest.cpp
+
+		Correctness tests of the spoutCopy pixel functions and shared memory
+
+		"tiers" compares every copy and conversion method and the line
+		kernels of each instruction set tier byte for byte with the scalar
+		tier, and the simple copies with a plain loop, for random sizes,
+		line padding, alignment and options (--iterations, --seed).
+		It fails if any result is different.
+
+		"transfer" compares the float transfer functions of each tier with
+		the double precision functions for 1 million values of each pair.
+		It fails if any difference is more than spouttransfer::FloatErrorBound.
+
+		"rotate" compares rotation and transpose of 4 and 8 byte pixels
+		by each tier with one and 4 threads with a pixel by pixel loop.
+
+		"framehash" fails if the tiers give different tile hashes or
+		a changed pixel is not found in its tile.
+
+		"sharedmemory" fails if an increment of a counter by threads with
+		their own SpoutSharedMemory objects for the same memory is lost.
+
+		"seqlock" fails if a copy of shared memory read with the sequence
+		lock while another thread changes it is not from a single write.
+		"senderinfo" (Windows) does the same with getSharedInfo of
+		spoutSenderNames and UpdateSender.
+
+		"memoryring" fails if a frame read from a ring buffer has the
+		marks of another frame.
+
+		"memorybuffer" fails if a buffer header is not found, is found in
+		a map without one, is used after a change or gives a size that is
+		more than the view of the map.
+
+		"memorylease" fails if converting a frame from a lease of a memory
+		buffer or ring gives a different result than from a copy, if the
+		writer reuses a leased slot of a 3 slot ring, if a lease does not
+		find that a 2 slot ring has reused it or if a lease of a map opened
+		by a receiver is not bounded by its view.
+
+		"largepages" fails if shared memory with large pages or on a NUMA
+		node can't be created or the data read back is different.
+
+		"framenotify" fails if a waiting receiver misses a frame or a wait
+		does not last for its timeout.
+
+		Give the names of tests to run only those. The program returns 1
+		if any test fails. Each test is registered with CTest.
+
+		Build with the SPOUT_SANITIZE CMake option to run the tests with
+		AddressSanitizer and UndefinedBehaviorSanitizer.
+
+		Built with the SPOUT_BUILD_TESTS CMake option, which is on by default.
+
+	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+	Distributed under the Spout SDK BSD 2-Clause license (SpoutLicense).
+
+*/
+#include "../SpoutCopy.h"
+#include "../SpoutLut.h"
+#include "../SpoutTransfer.h"
+#include "../SpoutConvert.h"
+#include "../SpoutYUV.h"
+#include "../SpoutDither.h"
+#include "../SpoutThumbnail.h"
+#include "../SpoutFrameHash.h"
+#include "../SpoutSharedMemory.h"
+#include "../SpoutSeqLock.h"
+#include "../SpoutMemoryRing.h"
+#include "../SpoutMemoryBuffer.h"
+#include "../SpoutFrameNotify.h"
+#if defined(_WIN32)
+#include "../SpoutSenderNames.h"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cmath>
+#include <stdlib.h>
+#include <string.h>
+
+// A contrast and warmth grade in .cube text
+static std::string GradeCube(unsigned int size)
+{
+	std::ostringstream text;
+	text.precision(6);
+	text << "TITLE \"Test\"\nLUT_3D_SIZE " << size << "\n";
+	for (unsigned int b = 0; b < size; b++) {
+		for (unsigned int g = 0; g < size; g++) {
+			for (unsigned int r = 0; r < size; r++) {
+				const double v[3] = { (double)r / (size - 1), (double)g / (size - 1), (double)b / (size - 1) };
+				for (int c = 0; c < 3; c++) {
+					const double s = v[c] * v[c] * (3.0 - 2.0 * v[c]);
+					text << (c == 0 ? s * 1.05 : c == 1 ? s : s * 0.92) << (c < 2 ? " " : "\n");
+				}
+			}
+		}
+	}
+	return text.str();
+}
+
+// Source pixel values
+enum VerifySource {
+	VERIFY_BYTES = 0, // Random bytes for 8 and 16 bit and YUV formats
+	VERIFY_HALF,      // Half floats from 0 to 1
+	VERIFY_FLOAT,     // Floats from 0 to 1
+	VERIFY_SOURCE_COUNT
+};
+
+//
+// Differential check of every tier against the scalar tier
+//
+
+// Largest random size and the bytes of each buffer, allowing for
+// 16 byte pixels, line padding and offset, 4:2:0 chroma planes and
+// a rotated destination
+static const unsigned int verifyMaxWidth = 1100;
+static const unsigned int verifyMaxHeight = 300;
+static const size_t verifyBufferBytes = ((size_t)verifyMaxWidth * 16 + 128) * (verifyMaxWidth * 3 / 2 + 1) + 128;
+// Bytes after the destination that are compared to find overruns
+static const size_t verifyGuardBytes = 64;
+
+// Random size, layout and options of one test
+struct VerifyFrame {
+	const unsigned char *src[VERIFY_SOURCE_COUNT]; // 64 byte aligned sources
+	unsigned char *dst; // 64 byte aligned destination
+	unsigned int width;
+	unsigned int height;
+	unsigned int srcPad; // bytes added to each line
+	unsigned int dstPad;
+	unsigned int srcOffset; // bytes from 64 byte alignment
+	unsigned int dstOffset;
+	bool bInvert;
+	unsigned int choice[4]; // options of each test
+};
+
+// Buffers and line pitch of a test with the padding and offsets
+// rounded to the size of a component
+struct VerifyLayout {
+	const unsigned char *src;
+	unsigned char *dst;
+	unsigned int srcPitch;
+	unsigned int dstPitch;
+	size_t extent; // bytes from the start of the destination buffer
+};
+
+static unsigned int ComponentBytes(GLenum glFormat)
+{
+	if (glFormat == GL_RGBA32F)
+		return 4;
+	if (glFormat == GL_RGBA16 || glFormat == GL_RGBA16F)
+		return 2;
+	return 1;
+}
+
+static VerifySource SourceOf(GLenum glFormat)
+{
+	if (glFormat == GL_RGBA32F)
+		return VERIFY_FLOAT;
+	if (glFormat == GL_RGBA16F)
+		return VERIFY_HALF;
+	return VERIFY_BYTES;
+}
+
+// srcLine and dstLine are the bytes of packed lines
+static VerifyLayout Layout(const VerifyFrame &f, VerifySource source, unsigned int srcComponent,
+	unsigned int srcLine, unsigned int dstComponent, unsigned int dstLine, unsigned int dstLines)
+{
+	VerifyLayout layout;
+	const unsigned int dstOffset = f.dstOffset - f.dstOffset % dstComponent;
+	layout.src = f.src[source] + (f.srcOffset - f.srcOffset % srcComponent);
+	layout.dst = f.dst + dstOffset;
+	layout.srcPitch = srcLine + (f.srcPad - f.srcPad % srcComponent);
+	layout.dstPitch = dstLine + (f.dstPad - f.dstPad % dstComponent);
+	layout.extent = dstOffset + (size_t)layout.dstPitch * dstLines;
+	return layout;
+}
+
+static VerifyLayout Layout(const VerifyFrame &f, GLenum srcFormat, GLenum dstFormat,
+	unsigned int dstWidth, unsigned int dstHeight)
+{
+	return Layout(f, SourceOf(srcFormat), ComponentBytes(srcFormat),
+		f.width * spoutCopy::GetPixelBytes(srcFormat), ComponentBytes(dstFormat),
+		dstWidth * spoutCopy::GetPixelBytes(dstFormat), dstHeight);
+}
+
+// Plain loop copy of 3 and 4 byte pixels for the reference results.
+// A 3 byte source has alpha 255 or the destination alpha is not changed.
+static void ReferenceLines(const unsigned char *src, unsigned char *dst,
+	unsigned int width, unsigned int height, unsigned int srcPitch, unsigned int dstPitch,
+	unsigned int srcBytes, unsigned int dstBytes, bool bSwapRB, bool bInvert,
+	bool bMirror = false, bool bKeepAlpha = false)
+{
+	for (unsigned int y = 0; y < height; y++) {
+		const unsigned char *s = src + (size_t)(bInvert ? height - 1 - y : y) * srcPitch;
+		unsigned char *d = dst + (size_t)y * dstPitch;
+		for (unsigned int x = 0; x < width; x++) {
+			const unsigned char *p = s + (size_t)(bMirror ? width - 1 - x : x) * srcBytes;
+			unsigned char *q = d + (size_t)x * dstBytes;
+			q[0] = p[bSwapRB ? 2 : 0];
+			q[1] = p[1];
+			q[2] = p[bSwapRB ? 0 : 2];
+			if (dstBytes == 4 && !(srcBytes == 3 && bKeepAlpha))
+				q[3] = (srcBytes == 4) ? p[3] : 255;
+		}
+	}
+}
+
+struct VerifyCase {
+	const char *name;
+	// Returns the bytes of the destination buffer to compare
+	std::function<size_t(spoutCopy &, const VerifyFrame &)> function;
+	// Plain loop result for the simple copies, compared with the scalar tier
+	std::function<size_t(const VerifyFrame &)> reference;
+	// Largest difference of float results from the scalar tier, 0 for none
+	float tolerance = 0.0f;
+};
+
+//
+// Random sizes, line padding, alignment and options for each test.
+// The result of each tier with one thread and with three threads and
+// streaming stores is compared byte for byte with the scalar tier with
+// one thread, including the destination padding and the bytes after it.
+// Simple copies are also compared with a plain loop.
+// Build with SPOUT_SANITIZE to check with AddressSanitizer and
+// UndefinedBehaviorSanitizer.
+// Returns false if any result is different.
+//
+static bool VerifyTiers(unsigned int iterations, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	const SpoutCopyTier supported = spoutCopy::GetSupportedTier();
+
+	spoutLut lut;
+	lut.Parse(GradeCube(17).c_str());
+
+	static const GLenum rgbaFormats[] = { GL_RGBA, GL_BGRA_EXT, GL_RGBA16, GL_RGBA16F, GL_RGBA32F };
+	static const GLenum allFormats[] = { GL_RGBA, GL_BGRA_EXT, GL_RGB, GL_BGR_EXT, GL_RGBA16, GL_RGBA16F, GL_RGBA32F };
+	static const GLenum byteFormats[] = { GL_RGBA, GL_BGRA_EXT, GL_RGB, GL_BGR_EXT };
+	static const GLenum lutFormats[] = { GL_RGBA, GL_BGRA_EXT, GL_RGBA16, GL_RGBA32F };
+	static const GLenum rotateFormats[] = { GL_RGBA, GL_BGRA_EXT, GL_RGBA16, GL_RGBA16F };
+	static const GLenum tableFormats[] = { GL_RGBA, GL_BGRA_EXT, GL_RGBA16, GL_RGBA16F };
+	static const GLenum ditherFormats[] = { GL_RGBA16, GL_RGBA16F, GL_RGBA32F };
+	const unsigned int nRGBA = sizeof(rgbaFormats) / sizeof(rgbaFormats[0]);
+	const unsigned int nAll = sizeof(allFormats) / sizeof(allFormats[0]);
+
+	// Resampled size from 1 to twice the source, or the same size
+	auto resampled = [](unsigned int size, unsigned int choice) {
+		return (choice & 1) ? size : 1 + (choice >> 1) % (size * 2);
+	};
+
+	// Layouts of 8 bit pixels with packed lines for the functions without
+	// a pitch and with padding for the source or destination pitch
+	auto packed = [](const VerifyFrame &f, unsigned int srcBytes, unsigned int dstBytes) {
+		VerifyFrame p = f;
+		p.srcPad = 0;
+		p.dstPad = 0;
+		return Layout(p, VERIFY_BYTES, 1, f.width * srcBytes, 1, f.width * dstBytes, f.height);
+	};
+	auto srcPitch = [](const VerifyFrame &f, unsigned int srcBytes, unsigned int dstBytes) {
+		VerifyFrame p = f;
+		p.dstPad = 0;
+		return Layout(p, VERIFY_BYTES, 1, f.width * srcBytes, 1, f.width * dstBytes, f.height);
+	};
+	auto dstPitch = [](const VerifyFrame &f, unsigned int srcBytes, unsigned int dstBytes) {
+		VerifyFrame p = f;
+		p.srcPad = 0;
+		return Layout(p, VERIFY_BYTES, 1, f.width * srcBytes, 1, f.width * dstBytes, f.height);
+	};
+	auto bothPitch = [](const VerifyFrame &f, unsigned int srcBytes, unsigned int dstBytes) {
+		return Layout(f, VERIFY_BYTES, 1, f.width * srcBytes, 1, f.width * dstBytes, f.height);
+	};
+
+	// Plain loop for a copy of 3 or 4 byte pixels
+	auto reference = [](VerifyLayout (*layout)(const VerifyFrame &, unsigned int, unsigned int),
+		unsigned int srcBytes, unsigned int dstBytes, bool bSwapRB, bool bKeepAlpha) {
+		return [=](const VerifyFrame &f) {
+			const VerifyLayout l = layout(f, srcBytes, dstBytes);
+			ReferenceLines(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch,
+				srcBytes, dstBytes, bSwapRB, f.bInvert, false, bKeepAlpha);
+			return l.extent;
+		};
+	};
+
+	const VerifyCase cases[] = {
+		{ "CopyPixels", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum format = byteFormats[f.choice[0] % 4];
+			const unsigned int bytes = spoutCopy::GetPixelBytes(format);
+			const VerifyLayout l = packed(f, bytes, bytes);
+			copy.CopyPixels(l.src, l.dst, f.width, f.height, format, f.bInvert);
+			return l.extent; },
+			[&](const VerifyFrame &f) {
+			const unsigned int bytes = spoutCopy::GetPixelBytes(byteFormats[f.choice[0] % 4]);
+			const VerifyLayout l = packed(f, bytes, bytes);
+			for (unsigned int y = 0; y < f.height; y++)
+				memcpy(l.dst + (size_t)y * l.dstPitch,
+					l.src + (size_t)(f.bInvert ? f.height - 1 - y : y) * l.srcPitch, l.srcPitch);
+			return l.extent; } },
+		{ "FlipBuffer", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 4, 4);
+			copy.FlipBuffer(l.src, l.dst, f.width, f.height, GL_RGBA);
+			return l.extent; },
+			[&](const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 4, 4);
+			for (unsigned int y = 0; y < f.height; y++)
+				memcpy(l.dst + (size_t)y * l.dstPitch, l.src + (size_t)(f.height - 1 - y) * l.srcPitch, l.srcPitch);
+			return l.extent; } },
+		{ "memcpy_sse2", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 4, 4);
+			const size_t size = (size_t)f.width * f.height * 4 + f.choice[0] % 64;
+			copy.memcpy_sse2(l.dst, l.src, size);
+			return (size_t)(l.dst - f.dst) + size; },
+			[&](const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 4, 4);
+			const size_t size = (size_t)f.width * f.height * 4 + f.choice[0] % 64;
+			memcpy(l.dst, l.src, size);
+			return (size_t)(l.dst - f.dst) + size; } },
+		{ "RemovePadding", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum format = byteFormats[f.choice[0] % 4];
+			const unsigned int bytes = spoutCopy::GetPixelBytes(format);
+			const VerifyLayout l = srcPitch(f, bytes, bytes);
+			copy.RemovePadding(l.src, l.dst, f.width, f.height, l.srcPitch, format);
+			return l.extent; },
+			[&](const VerifyFrame &f) {
+			const unsigned int bytes = spoutCopy::GetPixelBytes(byteFormats[f.choice[0] % 4]);
+			const VerifyLayout l = srcPitch(f, bytes, bytes);
+			ReferenceLines(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, bytes, bytes, false, false);
+			return l.extent; } },
+		{ "rgba2rgba", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = srcPitch(f, 4, 4);
+			copy.rgba2rgba(l.src, l.dst, f.width, f.height, l.srcPitch, f.bInvert);
+			return l.extent; }, reference(srcPitch, 4, 4, false, false) },
+		{ "rgba2rgba (dest pitch)", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = bothPitch(f, 4, 4);
+			copy.rgba2rgba(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, f.bInvert);
+			return l.extent; }, reference(bothPitch, 4, 4, false, false) },
+		{ "rgba2bgra", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 4, 4);
+			copy.rgba2bgra(l.src, l.dst, f.width, f.height, f.bInvert);
+			return l.extent; }, reference(packed, 4, 4, true, false) },
+		{ "rgba2bgra (pitch)", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = srcPitch(f, 4, 4);
+			copy.rgba2bgra(l.src, l.dst, f.width, f.height, l.srcPitch, f.bInvert);
+			return l.extent; }, reference(srcPitch, 4, 4, true, false) },
+		{ "rgba2bgra (dest pitch)", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = bothPitch(f, 4, 4);
+			copy.rgba2bgra(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, f.bInvert);
+			return l.extent; }, reference(bothPitch, 4, 4, true, false) },
+		{ "bgra2rgba", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 4, 4);
+			copy.bgra2rgba(l.src, l.dst, f.width, f.height, f.bInvert);
+			return l.extent; }, reference(packed, 4, 4, true, false) },
+		{ "rgb2rgba", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 3, 4);
+			copy.rgb2rgba(l.src, l.dst, f.width, f.height, f.bInvert);
+			return l.extent; }, reference(packed, 3, 4, false, false) },
+		{ "rgb2rgba (dest pitch)", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = dstPitch(f, 3, 4);
+			copy.rgb2rgba(l.src, l.dst, f.width, f.height, l.dstPitch, f.bInvert);
+			return l.extent; }, reference(dstPitch, 3, 4, false, true) },
+		{ "bgr2rgba", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 3, 4);
+			copy.bgr2rgba(l.src, l.dst, f.width, f.height, f.bInvert);
+			return l.extent; }, reference(packed, 3, 4, true, false) },
+		{ "bgr2rgba (dest pitch)", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = dstPitch(f, 3, 4);
+			copy.bgr2rgba(l.src, l.dst, f.width, f.height, l.dstPitch, f.bInvert);
+			return l.extent; }, reference(dstPitch, 3, 4, true, true) },
+		{ "rgb2bgra", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 3, 4);
+			copy.rgb2bgra(l.src, l.dst, f.width, f.height, f.bInvert);
+			return l.extent; }, reference(packed, 3, 4, true, false) },
+		{ "rgb2bgra (dest pitch)", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = dstPitch(f, 3, 4);
+			copy.rgb2bgra(l.src, l.dst, f.width, f.height, l.dstPitch, f.bInvert);
+			return l.extent; }, reference(dstPitch, 3, 4, true, true) },
+		{ "bgr2bgra", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 3, 4);
+			copy.bgr2bgra(l.src, l.dst, f.width, f.height, f.bInvert);
+			return l.extent; }, reference(packed, 3, 4, false, false) },
+		{ "rgba2bgr", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 4, 3);
+			copy.rgba2bgr(l.src, l.dst, f.width, f.height, f.bInvert);
+			return l.extent; }, reference(packed, 4, 3, true, false) },
+		{ "rgba2bgr (pitch)", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = srcPitch(f, 4, 3);
+			copy.rgba2bgr(l.src, l.dst, f.width, f.height, l.srcPitch, f.bInvert);
+			return l.extent; }, reference(srcPitch, 4, 3, true, false) },
+		{ "bgra2rgb", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 4, 3);
+			copy.bgra2rgb(l.src, l.dst, f.width, f.height, f.bInvert);
+			return l.extent; }, reference(packed, 4, 3, true, false) },
+		{ "bgra2bgr", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = packed(f, 4, 3);
+			copy.bgra2bgr(l.src, l.dst, f.width, f.height, f.bInvert);
+			return l.extent; }, reference(packed, 4, 3, false, false) },
+		{ "rgba2rgb (pitch)", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = srcPitch(f, 4, 3);
+			copy.rgba2rgb(l.src, l.dst, f.width, f.height, l.srcPitch, f.bInvert,
+				(f.choice[0] & 1) != 0, (f.choice[0] & 2) != 0);
+			return l.extent; },
+			[&](const VerifyFrame &f) {
+			const VerifyLayout l = srcPitch(f, 4, 3);
+			ReferenceLines(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, 4, 3,
+				(f.choice[0] & 2) != 0, f.bInvert, (f.choice[0] & 1) != 0);
+			return l.extent; } },
+		{ "rgba2rgbaResample", [&](spoutCopy &copy, const VerifyFrame &f) {
+			copy.SetResampleFilter((SpoutResampleFilter)(f.choice[0] % 3));
+			const unsigned int width = resampled(f.width, f.choice[1]);
+			const unsigned int height = resampled(f.height, f.choice[2]);
+			VerifyFrame p = f;
+			p.dstPad = 0;
+			const VerifyLayout l = Layout(p, VERIFY_BYTES, 1, f.width * 4, 1, width * 4, height);
+			copy.rgba2rgbaResample(l.src, l.dst, f.width, f.height, l.srcPitch, width, height, f.bInvert);
+			return l.extent; }, nullptr },
+		{ "rgba2rgbaResample (dest pitch)", [&](spoutCopy &copy, const VerifyFrame &f) {
+			copy.SetResampleFilter((SpoutResampleFilter)(f.choice[0] % 3));
+			const unsigned int width = resampled(f.width, f.choice[1]);
+			const unsigned int height = resampled(f.height, f.choice[2]);
+			const VerifyLayout l = Layout(f, VERIFY_BYTES, 1, f.width * 4, 1, width * 4, height);
+			copy.rgba2rgbaResample(l.src, l.dst, f.width, f.height, l.srcPitch, width, height, l.dstPitch, f.bInvert);
+			return l.extent; }, nullptr },
+		{ "rgba2rgbResample", [&](spoutCopy &copy, const VerifyFrame &f) {
+			copy.SetResampleFilter((SpoutResampleFilter)(f.choice[0] % 3));
+			const unsigned int width = resampled(f.width, f.choice[1]);
+			const unsigned int height = resampled(f.height, f.choice[2]);
+			VerifyFrame p = f;
+			p.dstPad = 0;
+			const VerifyLayout l = Layout(p, VERIFY_BYTES, 1, f.width * 4, 1, width * 3, height);
+			copy.rgba2rgbResample(l.src, l.dst, f.width, f.height, l.srcPitch, width, height,
+				f.bInvert, (f.choice[3] & 1) != 0, (f.choice[3] & 2) != 0);
+			return l.extent; }, nullptr },
+		{ "rgba2bgrResample", [&](spoutCopy &copy, const VerifyFrame &f) {
+			copy.SetResampleFilter((SpoutResampleFilter)(f.choice[0] % 3));
+			const unsigned int width = resampled(f.width, f.choice[1]);
+			const unsigned int height = resampled(f.height, f.choice[2]);
+			VerifyFrame p = f;
+			p.dstPad = 0;
+			const VerifyLayout l = Layout(p, VERIFY_BYTES, 1, f.width * 4, 1, width * 3, height);
+			copy.rgba2bgrResample(l.src, l.dst, f.width, f.height, l.srcPitch, width, height, f.bInvert);
+			return l.extent; }, nullptr },
+		{ "Convert", [&](spoutCopy &copy, const VerifyFrame &f) {
+			copy.SetResampleFilter((SpoutResampleFilter)(f.choice[0] % 3));
+			const GLenum srcFormat = allFormats[f.choice[0] / 3 % nAll];
+			const GLenum dstFormat = allFormats[f.choice[1] % nAll];
+			const unsigned int width = resampled(f.width, f.choice[1] / nAll);
+			const unsigned int height = resampled(f.height, f.choice[2]);
+			const VerifyLayout l = Layout(f, srcFormat, dstFormat, width, height);
+			SpoutPixelDesc source(srcFormat, f.width, f.height, l.srcPitch);
+			SpoutPixelDesc dest(dstFormat, width, height, l.dstPitch);
+			const unsigned int c = f.choice[3];
+			source.bInvert = f.bInvert;
+			source.bMirror = (c & 1) != 0;
+			dest.bInvert = (c & 2) != 0;
+			dest.bMirror = (c & 4) != 0;
+			dest.bKeepAlpha = (c & 8) != 0;
+			source.alpha = (SpoutAlphaMode)((c >> 4) % 3);
+			dest.alpha = (SpoutAlphaMode)((c >> 6) % 3);
+			copy.Convert(l.src, source, l.dst, dest, (c & 256) != 0);
+			return l.extent; }, nullptr },
+		{ "ConvertRegion", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum srcFormat = allFormats[f.choice[0] % nAll];
+			const GLenum dstFormat = allFormats[f.choice[1] % nAll];
+			// A region that may be partly outside the source
+			const SpoutRegion region(f.choice[2] % f.width, (f.choice[2] >> 12) % f.height,
+				1 + f.choice[3] % f.width, 1 + (f.choice[3] >> 12) % f.height);
+			const unsigned int width = (f.choice[1] & 256) ? region.width : resampled(region.width, f.choice[1] >> 9);
+			const unsigned int height = (f.choice[1] & 256) ? region.height : resampled(region.height, f.choice[1] >> 20);
+			const VerifyLayout l = Layout(f, srcFormat, dstFormat, width, height);
+			SpoutPixelDesc source(srcFormat, f.width, f.height, l.srcPitch);
+			source.bInvert = f.bInvert;
+			source.bMirror = (f.choice[0] & 512) != 0;
+			copy.ConvertRegion(l.src, source, region, l.dst, SpoutPixelDesc(dstFormat, width, height, l.dstPitch));
+			return l.extent; }, nullptr },
+		{ "ConvertRGBA", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum srcFormat = rgbaFormats[f.choice[0] % nRGBA];
+			const GLenum dstFormat = rgbaFormats[f.choice[1] % nRGBA];
+			const VerifyLayout l = Layout(f, srcFormat, dstFormat, f.width, f.height);
+			copy.ConvertRGBA(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch,
+				srcFormat, dstFormat, f.bInvert, (f.choice[2] & 1) != 0);
+			return l.extent; }, nullptr },
+		{ "ApplyLut", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum format = lutFormats[f.choice[0] % 4];
+			const VerifyLayout l = Layout(f, format, format, f.width, f.height);
+			copy.ApplyLut(lut, l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, format, f.bInvert);
+			return l.extent; }, nullptr },
+		{ "ApplyTransfer", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum format = tableFormats[f.choice[0] % 4];
+			const VerifyLayout l = Layout(f, format, format, f.width, f.height);
+			copy.ApplyTransfer(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, format,
+				(SpoutTransferFunction)(f.choice[1] % SPOUT_TRANSFER_COUNT),
+				(SpoutTransferFunction)(f.choice[2] % SPOUT_TRANSFER_COUNT), f.bInvert);
+			return l.extent; }, nullptr },
+		// The SIMD tiers use polynomials for float pixels
+		{ "ApplyTransfer rgba32f", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const VerifyLayout l = Layout(f, GL_RGBA32F, GL_RGBA32F, f.width, f.height);
+			copy.ApplyTransfer(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, GL_RGBA32F,
+				(SpoutTransferFunction)(f.choice[1] % SPOUT_TRANSFER_COUNT),
+				(SpoutTransferFunction)(f.choice[2] % SPOUT_TRANSFER_COUNT), f.bInvert);
+			return l.extent; }, nullptr, spouttransfer::FloatErrorBound },
+		{ "YUVToRGBA", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const SpoutYUVFormat yuv = (SpoutYUVFormat)(f.choice[0] % SPOUT_YUV_FORMAT_COUNT);
+			const GLenum format = lutFormats[f.choice[1] % 4];
+			const VerifyLayout l = Layout(f, VERIFY_BYTES, 4, spoutyuv::LinePitch(yuv, f.width),
+				ComponentBytes(format), f.width * spoutCopy::GetPixelBytes(format), f.height);
+			copy.YUVToRGBA(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, yuv, format,
+				(SpoutYUVMatrix)(f.choice[2] % SPOUT_YUV_MATRIX_COUNT), (f.choice[3] & 1) != 0, f.bInvert);
+			return l.extent; }, nullptr },
+		{ "RGBAToYUV", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const SpoutYUVFormat yuv = (SpoutYUVFormat)(f.choice[0] % SPOUT_YUV_FORMAT_COUNT);
+			const GLenum format = lutFormats[f.choice[1] % 4];
+			const unsigned int lines = (yuv == SPOUT_YUV_NV12 || yuv == SPOUT_YUV_P010)
+				? f.height + (f.height + 1) / 2 : f.height;
+			const VerifyLayout l = Layout(f, SourceOf(format), ComponentBytes(format),
+				f.width * spoutCopy::GetPixelBytes(format), 4, spoutyuv::LinePitch(yuv, f.width), lines);
+			copy.RGBAToYUV(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, format, yuv,
+				(SpoutYUVMatrix)(f.choice[2] % SPOUT_YUV_MATRIX_COUNT), (f.choice[3] & 1) != 0, f.bInvert);
+			return l.extent; }, nullptr },
+		{ "DitherRGBA", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum srcFormat = ditherFormats[f.choice[0] % 3];
+			const GLenum dstFormat = (f.choice[1] & 1) ? GL_BGRA_EXT : GL_RGBA;
+			const VerifyLayout l = Layout(f, srcFormat, dstFormat, f.width, f.height);
+			copy.DitherRGBA(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, srcFormat, dstFormat,
+				(SpoutDitherMethod)(f.choice[2] % SPOUT_DITHER_METHOD_COUNT), f.choice[3] % 1000, f.bInvert);
+			return l.extent; }, nullptr },
+		{ "ApplyAlpha", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum format = rgbaFormats[f.choice[0] % nRGBA];
+			const VerifyLayout l = Layout(f, format, format, f.width, f.height);
+			copy.ApplyAlpha(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, format,
+				(SpoutAlphaOp)(f.choice[1] % SPOUT_ALPHA_OP_COUNT), f.bInvert);
+			return l.extent; }, nullptr },
+		{ "Rotate", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum format = rotateFormats[f.choice[0] % 4];
+			const SpoutRotation rotation = (SpoutRotation)(f.choice[1] % SPOUT_ROTATION_COUNT);
+			const bool bSwap = rotation == SPOUT_ROTATE_90 || rotation == SPOUT_ROTATE_270
+				|| rotation == SPOUT_TRANSPOSE || rotation == SPOUT_TRANSVERSE;
+			const VerifyLayout l = Layout(f, format, format,
+				bSwap ? f.height : f.width, bSwap ? f.width : f.height);
+			copy.Rotate(l.src, l.dst, f.width, f.height, l.srcPitch, l.dstPitch, format, rotation);
+			return l.extent; }, nullptr },
+		{ "Downsample", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const GLenum format = allFormats[f.choice[0] % nAll];
+			const unsigned int levels = 1 + f.choice[1] % 4;
+			VerifyFrame p = f;
+			p.dstPad = 0;
+			const VerifyLayout l = Layout(p, format, GL_RGBA, 0, 0);
+			unsigned char *dest[4];
+			unsigned char *level = l.dst;
+			unsigned int width = f.width;
+			unsigned int height = f.height;
+			for (unsigned int i = 0; i < levels; i++) {
+				dest[i] = level;
+				width = spoutthumbnail::HalfSize(width);
+				height = spoutthumbnail::HalfSize(height);
+				level += (size_t)width * height * 4;
+			}
+			copy.Downsample(l.src, f.width, f.height, l.srcPitch, format, dest, levels, f.bInvert);
+			return (size_t)(level - f.dst); }, nullptr },
+		{ "GetLineKernel", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const unsigned int c = f.choice[0];
+			const unsigned int srcBytes = (c & 1) ? 4 : 3;
+			const unsigned int dstBytes = (c & 2) ? 4 : 3;
+			const unsigned int width = f.width * f.height % 4096 + 1;
+			const VerifyLayout l = Layout(f, VERIFY_BYTES, 1, width * srcBytes, 1, width * dstBytes, 1);
+			SpoutRowKernel kernel = spoutCopy::GetLineKernel(copy.GetCopyTier(), srcBytes, dstBytes,
+				(c & 4) != 0, (c & 8) != 0, (c & 16) != 0);
+			if (kernel)
+				kernel(l.src, l.dst, width);
+			return l.extent; }, nullptr },
+		{ "spoutconvert::GetKernel", [&](spoutCopy &copy, const VerifyFrame &f) {
+			const SpoutCopyTier tier = copy.GetCopyTier();
+			const SpoutRGBAFormat srcFormat = (SpoutRGBAFormat)(f.choice[0] % SPOUT_RGBA_FORMAT_COUNT);
+			const SpoutRGBAFormat dstFormat = (SpoutRGBAFormat)(f.choice[1] % SPOUT_RGBA_FORMAT_COUNT);
+			static const GLenum glFormats[] = { GL_RGBA, GL_RGBA16, GL_RGBA16F, GL_RGBA32F };
+			const unsigned int width = f.width * f.height % 4096 + 1;
+			VerifyFrame p = f;
+			p.width = width;
+			const VerifyLayout l = Layout(p, glFormats[srcFormat], glFormats[dstFormat], width, 1);
+			SpoutRowKernel kernel = spoutconvert::GetKernel(srcFormat, dstFormat,
+				(f.choice[2] & 1) != 0, (f.choice[2] & 2) != 0, tier, tier >= SPOUT_COPY_AVX2);
+			if (kernel)
+				kernel(l.src, l.dst, width);
+			return l.extent; }, nullptr },
+	};
+
+	// Sources of random bytes and of half and float values from 0 to 1,
+	// with some outside that range to be clamped
+	std::vector<unsigned char> sources[VERIFY_SOURCE_COUNT];
+	for (int i = 0; i < VERIFY_SOURCE_COUNT; i++)
+		sources[i].resize(verifyBufferBytes);
+	for (size_t i = 0; i < verifyBufferBytes; i++)
+		sources[VERIFY_BYTES][i] = (unsigned char)rng();
+	float *values = reinterpret_cast<float *>(sources[VERIFY_FLOAT].data());
+	for (size_t i = 0; i < verifyBufferBytes / sizeof(float); i++)
+		values[i] = (float)((int)(rng() % 1200) - 100) / 1000.0f;
+	uint16_t *halves = reinterpret_cast<uint16_t *>(sources[VERIFY_HALF].data());
+	for (size_t i = 0; i < verifyBufferBytes / sizeof(uint16_t); i++)
+		halves[i] = spoutconvert::FloatToHalf(values[i / 2]);
+
+	// Result of the scalar tier, a plain loop and each tier
+	// in destination buffers of a fixed pattern
+	const unsigned char fill = 0xCD;
+	std::vector<unsigned char> expected(verifyBufferBytes, fill);
+	std::vector<unsigned char> plain(verifyBufferBytes, fill);
+	std::vector<unsigned char> result(verifyBufferBytes, fill);
+	auto aligned = [](std::vector<unsigned char> &buffer) {
+		unsigned char *p = buffer.data();
+		return p + ((64 - ((uintptr_t)p & 63)) & 63);
+	};
+
+	printf("Verify %u iterations of %u tests, seed %u, tiers up to %s\n",
+		iterations, (unsigned int)(sizeof(cases) / sizeof(cases[0])), seed,
+		spoutCopy::GetKernels(supported)->name);
+
+	unsigned int failures = 0;
+	unsigned int checks = 0;
+	for (unsigned int n = 0; n < iterations; n++) {
+
+		// Mostly small sizes with a large size in every 8 for
+		// the multi-threaded stripes
+		VerifyFrame f;
+		const bool bLarge = (n % 8) == 7;
+		f.width = 1 + rng() % (bLarge ? verifyMaxWidth : 160);
+		f.height = 1 + rng() % (bLarge ? verifyMaxHeight : 40);
+		f.srcPad = (rng() & 1) ? rng() % 64 : 0;
+		f.dstPad = (rng() & 1) ? rng() % 64 : 0;
+		f.srcOffset = (rng() & 1) ? rng() % 64 : 0;
+		f.dstOffset = (rng() & 1) ? rng() % 64 : 0;
+		f.bInvert = (rng() & 1) != 0;
+		for (unsigned int &c : f.choice)
+			c = (unsigned int)rng();
+		for (int i = 0; i < VERIFY_SOURCE_COUNT; i++)
+			f.src[i] = aligned(sources[i]);
+
+		for (const VerifyCase &test : cases) {
+
+			spoutCopy scalar;
+			scalar.SetCopyTier(SPOUT_COPY_SCALAR);
+			scalar.SetCopyThreads(1);
+			f.dst = aligned(expected);
+			const size_t extent = test.function(scalar, f) + verifyGuardBytes;
+
+			auto compare = [&](const std::vector<unsigned char> &buffer, const char *what) {
+				const unsigned char *a = aligned(expected);
+				const unsigned char *b = aligned(const_cast<std::vector<unsigned char> &>(buffer));
+				checks++;
+				if (memcmp(a, b, extent) == 0)
+					return;
+				size_t i = 0;
+				if (test.tolerance > 0.0f) {
+					// Float values from a 4 byte aligned destination
+					const float *fa = reinterpret_cast<const float *>(a);
+					const float *fb = reinterpret_cast<const float *>(b);
+					const size_t count = extent / sizeof(float);
+					while (i < count && (memcmp(&fa[i], &fb[i], sizeof(float)) == 0
+						|| fabsf(fa[i] - fb[i]) <= test.tolerance))
+						i++;
+					if (i == count)
+						return;
+					i *= sizeof(float);
+				}
+				while (a[i] == b[i])
+					i++;
+				failures++;
+				printf("  %s : %s different at byte %zu of %zu, %ux%u, pad %u/%u, offset %u/%u, invert %d, options %08x %08x %08x %08x\n",
+					test.name, what, i, extent, f.width, f.height, f.srcPad, f.dstPad,
+					f.srcOffset, f.dstOffset, f.bInvert, f.choice[0], f.choice[1], f.choice[2], f.choice[3]);
+			};
+
+			if (test.reference) {
+				f.dst = aligned(plain);
+				test.reference(f);
+				compare(plain, "plain loop");
+				memset(aligned(plain), fill, extent);
+			}
+
+			for (int t = SPOUT_COPY_SCALAR; t <= supported; t++) {
+				// One thread, and three threads with streaming stores
+				for (int m = 0; m < 2; m++) {
+					if (t == SPOUT_COPY_SCALAR && m == 0)
+						continue;
+					spoutCopy copy;
+					copy.SetCopyTier((SpoutCopyTier)t);
+					copy.SetCopyThreads(m ? 3 : 1, 0);
+					if (m)
+						copy.SetStreamThreshold(0);
+					f.dst = aligned(result);
+					test.function(copy, f);
+					char what[64];
+					snprintf(what, sizeof(what), "%s with %d thread%s", spoutCopy::GetKernels((SpoutCopyTier)t)->name,
+						m ? 3 : 1, m ? "s" : "");
+					compare(result, what);
+					memset(aligned(result), fill, extent);
+				}
+			}
+			memset(aligned(expected), fill, extent);
+		}
+	}
+
+	printf("  %u comparisons, %u different\n\n", checks, failures);
+	return failures == 0;
+}
+
+//
+// Float transfer functions against the double precision functions
+// for 1 million values of each pair with each tier.
+// Returns false if any difference is more than spouttransfer::FloatErrorBound.
+//
+static bool TestTransfer(unsigned int seed)
+{
+	static const char *transferNames[] = { "linear", "srgb", "rec709", "pq", "hlg" };
+	std::mt19937 rng(seed);
+	bool bResult = true;
+
+	// Values evenly spaced from 0 to 1 followed by small values down to 2^-20
+	const unsigned int pixels = 349526; // 1 million rgb values
+	std::vector<float> values(pixels * 4);
+	std::vector<float> result(pixels * 4);
+	for (unsigned int i = 0; i < pixels * 4; i++) {
+		if (i < pixels * 2)
+			values[i] = (float)((double)i / (pixels * 2 - 1));
+		else
+			values[i] = std::ldexp((float)(rng() % 1000000) / 1000000.0f, -(int)(rng() % 20));
+	}
+
+	printf("Transfer function float error, bound %g\n", spouttransfer::FloatErrorBound);
+	printf("  %-18s %-8s %12s %12s\n", "conversion", "tier", "max error", "at");
+	const SpoutCopyTier supported = spoutCopy::GetSupportedTier();
+	for (int t = SPOUT_COPY_SCALAR; t <= supported; t++) {
+		spoutCopy copy;
+		copy.SetCopyTier((SpoutCopyTier)t);
+		for (int from = 0; from < SPOUT_TRANSFER_COUNT; from++) {
+			for (int to = 0; to < SPOUT_TRANSFER_COUNT; to++) {
+				if (from == to)
+					continue;
+				copy.ApplyTransfer(values.data(), result.data(), pixels, 1, 0, 0, GL_RGBA32F,
+					(SpoutTransferFunction)from, (SpoutTransferFunction)to);
+				double maxError = 0.0;
+				float at = 0.0f;
+				for (unsigned int i = 0; i < pixels * 4; i++) {
+					if (i % 4 == 3)
+						continue; // alpha
+					const double ref = spouttransfer::Encode((SpoutTransferFunction)to,
+						spouttransfer::Decode((SpoutTransferFunction)from, values[i]));
+					const double error = std::fabs(result[i] - ref);
+					if (!(error <= maxError)) {
+						maxError = error;
+						at = values[i];
+					}
+				}
+				const bool bPass = (maxError <= spouttransfer::FloatErrorBound);
+				const std::string name = std::string(transferNames[from]) + " > " + transferNames[to];
+				printf("  %-18s %-8s %12.3g %12.6f %s\n", name.c_str(), spoutCopy::GetKernels((SpoutCopyTier)t)->name,
+					maxError, at, bPass ? "" : "FAIL");
+				if (!bPass)
+					bResult = false;
+			}
+		}
+	}
+	return bResult;
+}
+
+//
+// Rotation by reading the source pixel of each destination pixel in turn
+//
+static void NaiveRotate(const unsigned char *src, unsigned char *dst,
+	unsigned int width, unsigned int height, unsigned int bytes, SpoutRotation rotation)
+{
+	const bool bTranspose = (rotation != SPOUT_ROTATE_NONE && rotation != SPOUT_ROTATE_180);
+	const unsigned int destWidth = bTranspose ? height : width;
+	const unsigned int destHeight = bTranspose ? width : height;
+	for (unsigned int y = 0; y < destHeight; y++) {
+		for (unsigned int x = 0; x < destWidth; x++) {
+			unsigned int xs = x, ys = y;
+			switch (rotation) {
+				case SPOUT_ROTATE_90:   xs = y; ys = height - 1 - x; break;
+				case SPOUT_ROTATE_180:  xs = width - 1 - x; ys = height - 1 - y; break;
+				case SPOUT_ROTATE_270:  xs = width - 1 - y; ys = x; break;
+				case SPOUT_TRANSPOSE:   xs = y; ys = x; break;
+				case SPOUT_TRANSVERSE:  xs = width - 1 - y; ys = height - 1 - x; break;
+				default: break;
+			}
+			memcpy(dst + ((size_t)y * destWidth + x) * bytes, src + ((size_t)ys * width + xs) * bytes, bytes);
+		}
+	}
+}
+
+//
+// Rotation and transpose of 4 and 8 byte pixels by each tier
+// with one and 4 threads against a pixel by pixel loop
+//
+static bool TestRotate(unsigned int seed)
+{
+	struct Format {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	const Format formats[] = {
+		{ "rgba8", GL_RGBA, 4 },
+		{ "rgba16", GL_RGBA16, 8 },
+	};
+	const char *rotations[] = { "none", "90", "180", "270", "transpose", "transverse" };
+	// Sizes of whole and part blocks
+	const unsigned int sizes[][2] = { { 1, 1 }, { 37, 23 }, { 64, 64 }, { 301, 173 } };
+	std::mt19937 rng(seed);
+
+	printf("Rotate against a pixel loop\n");
+	unsigned int checks = 0, failures = 0;
+	spoutCopy copy;
+	for (const Format &f : formats) {
+		for (const auto &size : sizes) {
+			const unsigned int width = size[0];
+			const unsigned int height = size[1];
+			const size_t bytes = (size_t)width * height * f.bytes;
+			std::vector<unsigned char> source(bytes), dest(bytes), expected(bytes);
+			for (size_t i = 0; i < bytes; i++)
+				source[i] = (unsigned char)rng();
+			for (int r = SPOUT_ROTATE_90; r < SPOUT_ROTATION_COUNT; r++) {
+				const SpoutRotation rotation = (SpoutRotation)r;
+				NaiveRotate(source.data(), expected.data(), width, height, f.bytes, rotation);
+				for (int t = SPOUT_COPY_SCALAR; t <= spoutCopy::GetSupportedTier(); t++) {
+					copy.SetCopyTier((SpoutCopyTier)t);
+					for (unsigned int threads = 1; threads <= 4; threads += 3) {
+						copy.SetCopyThreads(threads, 0);
+						memset(dest.data(), 0, bytes);
+						copy.Rotate(source.data(), dest.data(), width, height, 0, 0, f.format, rotation);
+						checks++;
+						if (memcmp(dest.data(), expected.data(), bytes) != 0) {
+							printf("  %s %s %u x %u %s %u threads is different\n", f.name, rotations[r],
+								width, height, spoutCopy::GetKernels((SpoutCopyTier)t)->name, threads);
+							failures++;
+						}
+					}
+				}
+			}
+		}
+	}
+	printf("  %u comparisons, %u different\n", checks, failures);
+	return failures == 0;
+}
+
+//
+// Tile hashes of each tier with one and 4 threads. Every tier gives
+// the same hash and finds the one tile changed by a changed pixel.
+//
+static bool TestFrameHash(unsigned int seed)
+{
+	struct Format {
+		const char *name;
+		GLenum format;
+		unsigned int bytes;
+	};
+	const Format formats[] = {
+		{ "rgba8", GL_RGBA, 4 },
+		{ "rgba16", GL_RGBA16, 8 },
+	};
+	// Not a multiple of the tile size, for part tiles at the edges
+	const unsigned int width = 1000;
+	const unsigned int height = 600;
+	std::mt19937 rng(seed);
+
+	printf("Frame hash of each tier\n");
+	std::vector<unsigned char> frame((size_t)width * height * 8);
+	for (size_t i = 0; i < frame.size(); i++)
+		frame[i] = (unsigned char)rng();
+
+	unsigned int checks = 0, failures = 0;
+	for (const Format &f : formats) {
+		uint64_t expected = 0;
+		for (int t = SPOUT_COPY_SCALAR; t <= spoutCopy::GetSupportedTier(); t++) {
+			spoutFrameHash framehash;
+			if (!framehash.SetTier((SpoutCopyTier)t))
+				continue;
+			const char *tier = spoutCopy::GetKernels((SpoutCopyTier)t)->name;
+			for (unsigned int threads = 1; threads <= 4; threads += 3) {
+				framehash.SetThreads(threads);
+				framehash.Update(frame.data(), width, height, 0, f.format);
+				if (t == SPOUT_COPY_SCALAR && threads == 1)
+					expected = framehash.GetFrameHash();
+				checks++;
+				if (framehash.GetFrameHash() != expected) {
+					printf("  %s %s %u threads hash is different\n", f.name, tier, threads);
+					failures++;
+				}
+				const unsigned int x = (unsigned int)(rng() % width);
+				const unsigned int y = (unsigned int)(rng() % height);
+				frame[((size_t)y * width + x) * f.bytes] ^= 1;
+				const bool bFound = framehash.Update(frame.data(), width, height, 0, f.format)
+					&& framehash.GetChangedTiles() == 1
+					&& framehash.IsTileChanged(x / spoutFrameHash::TileSize, y / spoutFrameHash::TileSize);
+				frame[((size_t)y * width + x) * f.bytes] ^= 1;
+				framehash.Update(frame.data(), width, height, 0, f.format);
+				checks++;
+				if (!bFound) {
+					printf("  %s %s %u threads change at %u, %u not found\n", f.name, tier, threads, x, y);
+					failures++;
+				}
+			}
+		}
+	}
+	printf("  %u comparisons, %u different\n", checks, failures);
+	return failures == 0;
+}
+
+//
+// Threads with their own SpoutSharedMemory objects for the same memory
+// increment a counter in the buffer while locked. No increment is lost.
+//
+static bool TestSharedMemory()
+{
+	const char *name = "SpoutTestMemory";
+	const unsigned int threadCount = 4;
+	const unsigned int increments = 20000;
+
+	printf("Shared memory lock, %u threads\n", threadCount);
+	SpoutSharedMemory sender;
+	if (sender.Create(name, 4096) == SPOUT_CREATE_FAILED) {
+		printf("  Could not create %s\n", name);
+		return false;
+	}
+	char *pBuffer = sender.Lock();
+	if (!pBuffer) {
+		printf("  Could not lock %s\n", name);
+		return false;
+	}
+	memset(pBuffer, 0, sizeof(uint64_t));
+	sender.Unlock();
+
+	std::atomic<unsigned int> locked(0);
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&]() {
+			SpoutSharedMemory memory;
+			if (!memory.Open(name))
+				return;
+			for (unsigned int i = 0; i < increments; i++) {
+				char *pBuf = memory.Lock();
+				if (!pBuf)
+					continue;
+				uint64_t count = 0;
+				memcpy(&count, pBuf, sizeof(count));
+				count++;
+				memcpy(pBuf, &count, sizeof(count));
+				memory.Unlock();
+				locked++;
+			}
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+
+	uint64_t count = 0;
+	pBuffer = sender.Lock();
+	if (pBuffer) {
+		memcpy(&count, pBuffer, sizeof(count));
+		sender.Unlock();
+	}
+	printf("  %u of %u locks, count %llu\n", locked.load(), increments * threadCount, (unsigned long long)count);
+	// Timed out locks are not lost increments, but none are expected
+	return pBuffer && locked == increments * threadCount && count == locked;
+}
+
+//
+// Data in shared memory read with the sequence lock by 8 threads
+// while one thread changes it. Every copy is from a single write.
+//
+static bool TestSeqLock()
+{
+	const char *name = "SpoutTestSeqLock";
+	const unsigned int readers = 8;
+	const unsigned int writes = 200000;
+
+	// Every value is the write count
+	struct Data {
+		uint32_t value[64];
+	};
+
+	printf("Sequence lock, 1 writer and %u readers\n", readers);
+	SpoutSharedMemory sender;
+	if (sender.Create(name, (int)(sizeof(Data) + sizeof(spoutseqlock::Header))) == SPOUT_CREATE_FAILED) {
+		printf("  Could not create %s\n", name);
+		return false;
+	}
+
+	std::atomic<bool> bStop(false);
+	std::atomic<uint64_t> reads(0);
+	std::atomic<uint64_t> torn(0);
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < readers; t++) {
+		threads.emplace_back([&]() {
+			SpoutSharedMemory memory;
+			if (!memory.Open(name))
+				return;
+			const char *pBuf = memory.Buffer();
+			const spoutseqlock::Header *header = reinterpret_cast<const spoutseqlock::Header *>(pBuf + sizeof(Data));
+			uint64_t count = 0, inconsistent = 0;
+			while (!bStop.load(std::memory_order_relaxed)) {
+				Data data;
+				if (!spoutseqlock::Read(header, pBuf, &data, sizeof(data)))
+					continue;
+				for (unsigned int i = 1; i < 64; i++) {
+					if (data.value[i] != data.value[0]) {
+						inconsistent++;
+						break;
+					}
+				}
+				count++;
+			}
+			reads += count;
+			torn += inconsistent;
+		});
+	}
+
+	for (uint32_t w = 1; w <= writes; w++) {
+		char *pBuf = sender.Lock();
+		if (!pBuf)
+			continue;
+		spoutseqlock::Header *header = reinterpret_cast<spoutseqlock::Header *>(pBuf + sizeof(Data));
+		spoutseqlock::BeginWrite(header);
+		Data *data = reinterpret_cast<Data *>(pBuf);
+		for (unsigned int i = 0; i < 64; i++)
+			data->value[i] = w;
+		spoutseqlock::EndWrite(header);
+		sender.Unlock();
+	}
+	bStop = true;
+	for (std::thread &thread : threads)
+		thread.join();
+
+	printf("  %llu reads, %llu inconsistent\n", (unsigned long long)reads.load(), (unsigned long long)torn.load());
+	return reads > 0 && torn == 0;
+}
+
+#if defined(_WIN32)
+//
+// Sender information read with getSharedInfo by 8 threads, each with
+// its own spoutSenderNames, while UpdateSender changes it. Width, height,
+// format and share handle are the write count, so that a copy from
+// different writes can be found.
+//
+static bool TestSenderInfo()
+{
+	const char *name = "SpoutTestInfo";
+	const unsigned int readers = 8;
+	const unsigned int writes = 20000;
+
+	printf("Sender info, 1 writer and %u readers\n", readers);
+	spoutSenderNames sender;
+	if (!sender.CreateSender(name, 1, 1, LongToHandle(1), 1)) {
+		printf("  Could not create %s\n", name);
+		return false;
+	}
+
+	std::atomic<bool> bStop(false);
+	std::atomic<uint64_t> reads(0);
+	std::atomic<uint64_t> torn(0);
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < readers; t++) {
+		threads.emplace_back([&]() {
+			spoutSenderNames receiver;
+			uint64_t count = 0, inconsistent = 0;
+			SharedTextureInfo info;
+			while (!bStop.load(std::memory_order_relaxed)) {
+				if (!receiver.getSharedInfo(name, &info))
+					continue;
+				if (info.width != info.height || info.width != info.format
+					|| info.width != info.shareHandle)
+					inconsistent++;
+				count++;
+			}
+			reads += count;
+			torn += inconsistent;
+		});
+	}
+
+	for (unsigned int w = 2; w <= writes; w++)
+		sender.UpdateSender(name, w, w, LongToHandle((long)w), w);
+	bStop = true;
+	for (std::thread &thread : threads)
+		thread.join();
+	sender.ReleaseSenderName(name);
+
+	printf("  %llu reads, %llu inconsistent\n", (unsigned long long)reads.load(), (unsigned long long)torn.load());
+	return reads > 0 && torn == 0;
+}
+#endif
+
+//
+// Frames written to a 3 slot ring by one thread and read by another.
+// Each frame is marked with its number every 4KB, and no frame read
+// has the marks of another.
+//
+static bool TestMemoryRing()
+{
+	const char *name = "SpoutTestRing";
+	const unsigned int size = 1 << 20;
+	const unsigned int markStride = 4096;
+	const uint64_t minReads = 1000;
+
+	printf("Memory ring, 1 writer and 1 reader\n");
+	spoutMemoryRing ring;
+	if (!ring.Create(name, size)) {
+		printf("  Could not create %s\n", name);
+		return false;
+	}
+
+	// Mark a frame with its number, or find whether all marks are the same
+	auto Mark = [&](unsigned char *data, uint32_t number) {
+		for (size_t i = 0; i + sizeof(number) <= size; i += markStride)
+			memcpy(data + i, &number, sizeof(number));
+	};
+	auto Marked = [&](const unsigned char *data, uint32_t number) {
+		for (size_t i = 0; i + sizeof(number) <= size; i += markStride) {
+			if (memcmp(data + i, &number, sizeof(number)) != 0)
+				return false;
+		}
+		return true;
+	};
+
+	std::atomic<bool> bStop(false);
+	std::atomic<uint64_t> reads(0);
+	uint64_t failed = 0, torn = 0;
+	std::thread reader([&]() {
+		spoutMemoryRing readRing;
+		if (!readRing.Open(name))
+			return;
+		std::vector<unsigned char> pixels(size);
+		while (!bStop.load(std::memory_order_relaxed)) {
+			if (!readRing.IsNewFrame()) {
+				std::this_thread::yield();
+				continue;
+			}
+			spoutMemoryFrame info;
+			if (!readRing.Read([&](const unsigned char *data, const spoutMemoryFrame &) {
+				memcpy(pixels.data(), data, size);
+			}, &info)) {
+				failed++;
+				continue;
+			}
+			if (!Marked(pixels.data(), info.frame))
+				torn++;
+			reads++;
+		}
+	});
+
+	// Frame numbers start at 1. Writes continue until the reader
+	// has read enough frames, for at most 10 seconds.
+	const auto start = std::chrono::steady_clock::now();
+	uint32_t number = 0;
+	while (reads < minReads && std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+		unsigned char *pSlot = ring.BeginWrite();
+		Mark(pSlot, ++number);
+		ring.EndWrite(GL_RGBA, size / 4, 1, size, size);
+	}
+	bStop = true;
+	reader.join();
+
+	printf("  %u writes, %llu reads, %llu failed, %llu torn\n", number, (unsigned long long)reads.load(),
+		(unsigned long long)failed, (unsigned long long)torn);
+	return reads >= minReads && torn == 0;
+}
+
+//
+// Memory buffer header found with the values written, not found without
+// a header, not used after a change or with a size more than the view
+//
+static bool TestMemoryBuffer()
+{
+	const unsigned int size = 1920 * 1080 * 4;
+
+	printf("Memory buffer header\n");
+	// A map with the header and one as created by older writers
+	std::vector<char> map(spoutmemorybuffer::MapSize(size));
+	spoutmemorybuffer::Create(map.data(), size);
+	spoutmemorybuffer::Update(spoutmemorybuffer::Find(map.data(), map.size()), size, 1920, 1080, 1920 * 4, GL_RGBA);
+	std::vector<char> older(size + 32);
+	snprintf(older.data(), 16, "%u", size);
+
+	bool bPass = true;
+	auto Check = [&](bool bResult, const char *name) {
+		if (!bResult) {
+			printf("  %s failed\n", name);
+			bPass = false;
+		}
+	};
+
+	const spoutmemorybuffer::Header *header = spoutmemorybuffer::Find(map.data(), map.size());
+	Check(header && header->size == size && header->length == size
+		&& header->width == 1920 && header->height == 1080 && header->pitch == 1920 * 4
+		&& header->format == GL_RGBA && header->frame == 1, "header values");
+	Check(!spoutmemorybuffer::Find(older.data(), older.size()), "map without a header");
+	Check(spoutmemorybuffer::TextSize(older.data(), older.size()) == (int)size, "size text");
+	Check(!spoutmemorybuffer::Find(map.data(), map.size() - 1), "header beyond the view");
+	Check(spoutmemorybuffer::TextSize(older.data(), spoutmemorybuffer::TextBytes + size - 1) < 0, "size text beyond the view");
+	char *pHeader = map.data() + spoutmemorybuffer::TextBytes + size + spoutmemorybuffer::EndBytes;
+	pHeader[20] ^= 1;
+	Check(!spoutmemorybuffer::Find(map.data(), map.size()), "changed header");
+	pHeader[20] ^= 1;
+	map[0] = (char)(map[0] == '9' ? '1' : map[0] + 1);
+	Check(!spoutmemorybuffer::Find(map.data(), map.size()), "changed size text");
+	return bPass;
+}
+
+//
+// A frame in a memory buffer and in a ring converted from a lease
+// and from a copy gives the same result. The writer uses the other
+// slots of a 3 slot ring while the newest is leased, and a lease of
+// a 2 slot ring finds that the writer has reused it. A lease of a map
+// opened by a receiver is bounded by its view.
+//
+static bool TestMemoryLease(unsigned int seed)
+{
+	const unsigned int width = 640;
+	const unsigned int height = 360;
+	const unsigned int size = width * height * 4;
+	std::mt19937 rng(seed);
+
+	printf("Memory lease\n");
+	std::vector<unsigned char> source(size);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = (unsigned char)rng();
+
+	// Memory buffer written with a header and a ring with one frame
+	SpoutSharedMemory writeMap, readMap;
+	spoutMemoryRing writeRing, readRing;
+	if (writeMap.Create("SpoutTestLeaseMap", (int)spoutmemorybuffer::MapSize(size)) == SPOUT_CREATE_FAILED
+		|| !writeRing.Create("SpoutTestLeaseRing", size)) {
+		printf("  Could not create shared memory\n");
+		return false;
+	}
+	char *pBuffer = writeMap.Lock();
+	if (!pBuffer) {
+		printf("  Could not lock shared memory\n");
+		return false;
+	}
+	spoutmemorybuffer::Create(pBuffer, size);
+	memcpy(pBuffer + spoutmemorybuffer::TextBytes, source.data(), size);
+	spoutmemorybuffer::Update(spoutmemorybuffer::Find(pBuffer, writeMap.ViewSize()), size, width, height, width * 4, GL_RGBA);
+	writeMap.Unlock();
+	writeRing.Write(source.data(), size, GL_RGBA, width, height, width * 4);
+	if (!readMap.Open("SpoutTestLeaseMap") || !readRing.Open("SpoutTestLeaseRing")) {
+		printf("  Could not open shared memory\n");
+		return false;
+	}
+
+	bool bPass = true;
+	spoutCopy copy;
+	std::vector<unsigned char> pixels(size), copied(size), leased(size);
+	for (int m = 0; m < 2; m++) {
+		const bool bRing = (m == 1);
+		const char *name = bRing ? "ring" : "buffer";
+		bool bRead = true;
+		if (bRing) {
+			bRead = readRing.Read(pixels.data(), size);
+			copy.rgba2bgra(pixels.data(), copied.data(), width, height);
+			spoutMemoryRing::Lease lease = readRing.Acquire();
+			bRead = bRead && lease.IsValid();
+			if (lease.IsValid())
+				copy.rgba2bgra(lease.Data(), leased.data(), width, height);
+			bRead = bRead && lease.Release();
+		}
+		else {
+			const char *pMap = readMap.Lock();
+			const spoutmemorybuffer::Header *header = pMap ? spoutmemorybuffer::Find(pMap, readMap.ViewSize()) : nullptr;
+			bRead = header && header->length == size;
+			if (bRead)
+				memcpy(pixels.data(), pMap + spoutmemorybuffer::TextBytes, size);
+			SpoutSharedMemory::Lease lease = readMap.Acquire(spoutmemorybuffer::TextBytes, bRead ? size : 0);
+			if (pMap)
+				readMap.Unlock();
+			bRead = bRead && lease.Data();
+			if (bRead) {
+				copy.rgba2bgra(pixels.data(), copied.data(), width, height);
+				copy.rgba2bgra(lease.Data(), leased.data(), width, height);
+			}
+		}
+		const bool bSame = bRead && memcmp(copied.data(), leased.data(), size) == 0;
+		printf("  %-22s %s\n", name, !bRead ? "not read" : bSame ? "same" : "different");
+		if (!bSame)
+			bPass = false;
+	}
+
+	// A lease of a map opened by a receiver is bounded by the view
+	{
+		const size_t view = readMap.ViewSize();
+		SpoutSharedMemory::Lease rest = readMap.Acquire(spoutmemorybuffer::TextBytes);
+		const bool bRest = rest.IsValid() && rest.Size() == view - spoutmemorybuffer::TextBytes;
+		rest.Release();
+		const bool bBeyond = !readMap.Acquire(view + 1).IsValid()
+			&& !readMap.Acquire(spoutmemorybuffer::TextBytes, view).IsValid();
+		printf("  %-22s %s\n", "lease of the view", bRest && bBeyond ? "bounded" : "not bounded");
+		if (!bRest || !bBeyond)
+			bPass = false;
+	}
+
+	for (unsigned int slots = 2; slots <= 3; slots++) {
+		spoutMemoryRing writer, reader;
+		const std::string name = "SpoutTestLease" + std::to_string(slots);
+		if (!writer.Create(name.c_str(), 4096, slots) || !reader.Open(name.c_str())) {
+			printf("  Could not create %s\n", name.c_str());
+			bPass = false;
+			break;
+		}
+		writer.Write(source.data(), 4096);
+		spoutMemoryRing::Lease lease = reader.Acquire();
+		for (unsigned int i = 0; i < 8; i++)
+			writer.Write(source.data(), 4096);
+		const bool bKept = lease.Release();
+		printf("  %-22s %s\n", (std::to_string(slots) + " slot ring, 8 writes").c_str(), bKept ? "lease kept" : "lease lost");
+		if (bKept != (slots == 3))
+			bPass = false;
+	}
+	return bPass;
+}
+
+//
+// Shared memory with normal pages, large pages requested and pages
+// on the NUMA node of the thread is created and reads back its data
+//
+static bool TestLargePages(unsigned int seed)
+{
+	const size_t size = 8 << 20;
+	std::mt19937 rng(seed);
+
+	printf("Large pages\n");
+	std::vector<unsigned char> source(size);
+	for (size_t i = 0; i < size; i++)
+		source[i] = (unsigned char)rng();
+
+	bool bPass = true;
+	const char *methods[] = { "shared", "shared large pages", "shared NUMA node" };
+	for (int m = 0; m < 3; m++) {
+		SpoutSharedMemory memory;
+		memory.SetLargePages(m == 1);
+		if (m == 2)
+			memory.SetNumaNode(SpoutSharedMemory::NumaCurrent);
+		if (memory.Create("SpoutTestLargePages", (int)size) == SPOUT_CREATE_FAILED) {
+			printf("  %-22s not created\n", methods[m]);
+			bPass = false;
+			continue;
+		}
+		const char *pages = memory.IsLargePages() ? "large" : (m == 1 ? "fallback" : "normal");
+		unsigned char *pBuffer = reinterpret_cast<unsigned char *>(memory.Lock());
+		bool bSame = false;
+		if (pBuffer) {
+			memcpy(pBuffer, source.data(), size);
+			bSame = memcmp(pBuffer, source.data(), size) == 0;
+			memory.Unlock();
+		}
+		printf("  %-22s %-9s %s\n", methods[m], pages, bSame ? "same" : "different");
+		if (!bSame)
+			bPass = false;
+	}
+	return bPass;
+}
+
+//
+// A receiver waiting on the frame notifier finds every frame published,
+// and a wait without a new frame lasts for its timeout
+//
+static bool TestFrameNotify()
+{
+	const char *name = "SpoutTestNotify";
+	const unsigned int frames = 200;
+
+	printf("Frame notification, %u frames\n", frames);
+	spoutFrameNotify sender;
+	if (!sender.Create(name)) {
+		printf("  Could not create %s\n", name);
+		return false;
+	}
+
+	// The sender publishes each frame after the receiver has found the last
+	std::atomic<uint64_t> found(sender.GetFrame());
+	std::atomic<bool> bReady(false);
+	uint64_t received = 0, missed = 0, timeouts = 0;
+	std::thread receiver([&]() {
+		spoutFrameNotify notify;
+		if (!notify.Open(name))
+			return;
+		uint64_t last = notify.GetFrame();
+		bReady = true;
+		for (unsigned int i = 0; i < frames; i++) {
+			const uint64_t frame = notify.Wait(last, 1000);
+			if (frame <= last) {
+				timeouts++;
+				break;
+			}
+			missed += frame - last - 1;
+			last = frame;
+			received++;
+			found.store(frame, std::memory_order_release);
+		}
+	});
+
+	while (!bReady)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	for (unsigned int i = 0; i < frames; i++) {
+		const uint64_t frame = sender.GetFrame();
+		sender.Publish();
+		const auto start = std::chrono::steady_clock::now();
+		while (found.load(std::memory_order_acquire) <= frame
+			&& std::chrono::steady_clock::now() - start < std::chrono::seconds(2))
+			std::this_thread::yield();
+		if (found.load(std::memory_order_acquire) <= frame)
+			break;
+	}
+	receiver.join();
+	printf("  %llu received, %llu missed, %llu timeouts\n",
+		(unsigned long long)received,
+		(unsigned long long)missed, (unsigned long long)timeouts);
+
+	const auto start = std::chrono::steady_clock::now();
+	const uint64_t frame = sender.GetFrame();
+	const bool bTimeout = sender.Wait(frame, 20) == frame
+		&& std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(19);
+	printf("  wait timeout %s\n", bTimeout ? "passed" : "failed");
+
+	return received == frames && missed == 0 && bTimeout;
+}
+
+// Random iterations and seed of the tests that use them
+struct TestOptions {
+	unsigned int iterations;
+	unsigned int seed;
+};
+
+struct Test {
+	const char *name;
+	std::function<bool(const TestOptions &)> function;
+};
+
+int main(int argc, char *argv[])
+{
+	TestOptions options;
+	options.iterations = 100;
+	options.seed = 1;
+	std::vector<std::string> names;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+			options.iterations = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			options.seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		else
+			names.push_back(argv[i]);
+	}
+
+	const Test tests[] = {
+		{ "tiers", [](const TestOptions &o) { return VerifyTiers(o.iterations, o.seed); } },
+		{ "transfer", [](const TestOptions &o) { return TestTransfer(o.seed); } },
+		{ "rotate", [](const TestOptions &o) { return TestRotate(o.seed); } },
+		{ "framehash", [](const TestOptions &o) { return TestFrameHash(o.seed); } },
+		{ "sharedmemory", [](const TestOptions &) { return TestSharedMemory(); } },
+		{ "seqlock", [](const TestOptions &) { return TestSeqLock(); } },
+#if defined(_WIN32)
+		{ "senderinfo", [](const TestOptions &) { return TestSenderInfo(); } },
+#endif
+		{ "memoryring", [](const TestOptions &) { return TestMemoryRing(); } },
+		{ "memorybuffer", [](const TestOptions &) { return TestMemoryBuffer(); } },
+		{ "memorylease", [](const TestOptions &o) { return TestMemoryLease(o.seed); } },
+		{ "largepages", [](const TestOptions &o) { return TestLargePages(o.seed); } },
+		{ "framenotify", [](const TestOptions &) { return TestFrameNotify(); } },
+	};
+
+	// Every test runs, also after one has failed
+	unsigned int run = 0;
+	unsigned int failed = 0;
+	for (const Test &test : tests) {
+		if (!names.empty() && std::find(names.begin(), names.end(), test.name) == names.end())
+			continue;
+		run++;
+		const bool bPass = test.function(options);
+		printf("%s : %s\n\n", test.name, bPass ? "passed" : "FAILED");
+		if (!bPass)
+			failed++;
+	}
+	if (run == 0 || run < names.size()) {
+		printf("Unknown test name\n");
+		return 1;
+	}
+	printf("%u of %u tests passed\n", run - failed, run);
+	return failed ? 1 : 0;
+}
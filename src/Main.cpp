@@ -1,8 +1,13 @@
 
 #define NOMINMAX
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <cstdio>
+#include <iterator>
 #include <memory>
+#include <string>
 #include <vector>
 #include <wrl/client.h>
 #include <d3d11.h>
@@ -14,6 +19,7 @@
 
 #include "../SpoutGL/SpoutReceiver.h"
 #include "../SpoutGL/SpoutSender.h"
+#include "../SpoutGL/SpoutThumbnail.h"
 #include "graphics.hpp"
 #include "renderstream.hpp"
 #include "PixelShader.h"
@@ -41,6 +47,15 @@ typedef struct RenderTarget {
     Microsoft::WRL::ComPtr<ID3D11RenderTargetView> view;
 } RenderTarget_t;
 
+// Low rate preview of a stream for monitoring.
+// The frame is copied to a staging texture when a thumbnail is due
+// and mapped on a later frame so that the render loop never waits.
+struct StreamThumbnail {
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> readback;
+    bool pending = false;
+    std::unique_ptr<spoutThumbnailPublisher> publisher;
+};
+
 
 // Vertex structure
 struct Vertex { float x, y, z, u, v; };
@@ -72,6 +87,116 @@ DXGI_FORMAT toDxgiFormat(RSPixelFormat format)
     }
 }
 
+// Pixels of a texture covered by the normalised clipping of a stream.
+// The edges are rounded to the nearest pixel so that streams split
+// from one canvas meet without a gap or overlap.
+// No clipping is the whole texture.
+FrameRegion toFrameRegion(const ProjectionClipping& clipping, uint32_t width, uint32_t height)
+{
+    const float left = std::clamp(std::min(clipping.left, clipping.right), 0.f, 1.f);
+    const float right = std::clamp(std::max(clipping.left, clipping.right), 0.f, 1.f);
+    const float top = std::clamp(std::min(clipping.top, clipping.bottom), 0.f, 1.f);
+    const float bottom = std::clamp(std::max(clipping.top, clipping.bottom), 0.f, 1.f);
+
+    const uint32_t x0 = static_cast<uint32_t>(std::lround(left * width));
+    const uint32_t x1 = static_cast<uint32_t>(std::lround(right * width));
+    const uint32_t y0 = static_cast<uint32_t>(std::lround(top * height));
+    const uint32_t y1 = static_cast<uint32_t>(std::lround(bottom * height));
+    if (x1 <= x0 || y1 <= y0)
+        return { 0, 0, width, height };
+
+    return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+GLenum toGlFormat(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+        return GL_BGRA_EXT;
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+        return GL_RGBA16;
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        return GL_RGBA32F;
+    default:
+        return 0;
+    }
+}
+
+// Stream names are used for file and shared memory names
+std::string toThumbnailName(const char* name)
+{
+    std::string result = name ? name : "";
+    for (char& c : result) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+            c = '_';
+    }
+    return "SpoutRS_" + result;
+}
+
+bool GenerateThumbnail(
+    Microsoft::WRL::ComPtr<ID3D11Device> device,
+    StreamThumbnail& thumbnail,
+    const StreamDescription& description,
+    const std::string& directory,
+    bool sharedMemory,
+    int interval
+)
+{
+    thumbnail.readback.Reset();
+    thumbnail.pending = false;
+    thumbnail.publisher.reset();
+
+    D3D11_TEXTURE2D_DESC desc;
+    ZeroMemory(&desc, sizeof(desc));
+    desc.Width = description.width;
+    desc.Height = description.height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = toDxgiFormat(description.format);
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.BindFlags = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    desc.MiscFlags = 0;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, thumbnail.readback.GetAddressOf())))
+        return false;
+
+    const std::string name = toThumbnailName(description.name);
+    thumbnail.publisher = std::make_unique<spoutThumbnailPublisher>();
+    if (!directory.empty())
+        thumbnail.publisher->SetFileSink(directory + "\\" + name + ".bmp");
+    if (sharedMemory)
+        thumbnail.publisher->SetSharedMemorySink(name);
+    return thumbnail.publisher->Start(static_cast<unsigned int>(std::max(interval, 1)), 8);
+}
+
+// Copy a stream for the next thumbnail when one is due, or pass the last
+// copy to the publisher once the GPU has finished with it
+void UpdateThumbnail(ID3D11DeviceContext* context, StreamThumbnail& thumbnail, ID3D11Texture2D* texture)
+{
+    if (!thumbnail.publisher || !thumbnail.readback)
+        return;
+
+    if (!thumbnail.pending) {
+        if (thumbnail.publisher->IsDue()) {
+            context->CopyResource(thumbnail.readback.Get(), texture);
+            thumbnail.pending = true;
+        }
+        return;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context->Map(thumbnail.readback.Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped)))
+        return; // Still in use, try the next frame
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    thumbnail.readback->GetDesc(&desc);
+    thumbnail.publisher->Submit(mapped.pData, desc.Width, desc.Height, mapped.RowPitch, toGlFormat(desc.Format));
+    context->Unmap(thumbnail.readback.Get(), 0);
+    thumbnail.pending = false;
+}
+
 void GenerateRenderStreamSchema(
     std::set<std::string> &senders,
     ScopedSchema& scoped,
@@ -303,6 +428,17 @@ int main(int argc, char* argv[])
         .default_value(5000)
         .action([](const std::string& value) { return std::stoi(value); });
 
+    program.add_argument("--thumbnails").help("Writes a thumbnail of each stream to a .bmp file in this folder.")
+        .default_value(std::string(""));
+
+    program.add_argument("--thumbnail-memory").help("Publishes a thumbnail of each stream to shared memory named SpoutRS_<stream>.")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--thumbnail-interval").help("Sets the milliseconds between thumbnails.")
+        .default_value(1000)
+        .action([](const std::string& value) { return std::stoi(value); });
+
 
     try {
         program.parse_args(argc, argv);
@@ -319,6 +455,10 @@ int main(int argc, char* argv[])
     int graphicsAdapter = program.get<int>("--graphics-adapter");
     bool StoreChannels = program.get<bool>("--store-channels");
     int timeoutLimit = program.get<int>("--timeout-limit");
+    std::string thumbnailDirectory = program.get<std::string>("--thumbnails");
+    bool ThumbnailMemory = program.get<bool>("--thumbnail-memory");
+    int thumbnailInterval = program.get<int>("--thumbnail-interval");
+    bool EnableThumbnails = !thumbnailDirectory.empty() || ThumbnailMemory;
 
 
 
@@ -495,6 +635,7 @@ int main(int argc, char* argv[])
 
 
     std::unordered_map<StreamHandle, RenderTarget> renderTargets;
+    std::unordered_map<StreamHandle, StreamThumbnail> thumbnails;
 
     std::atomic_bool isRunning = true;
 
@@ -527,11 +668,21 @@ int main(int argc, char* argv[])
             {
                 Descriptions.reset(rs.getStreams());
                 const size_t numStreams = Descriptions ? Descriptions->nStreams : 0;
+                // Stop the thumbnails of streams that have been removed
+                for (auto thumbnail = thumbnails.begin(); thumbnail != thumbnails.end();)
+                {
+                    bool found = false;
+                    for (size_t i = 0; i < numStreams && !found; ++i)
+                        found = (Descriptions->streams[i].handle == thumbnail->first);
+                    thumbnail = found ? std::next(thumbnail) : thumbnails.erase(thumbnail);
+                }
                 for (size_t i = 0; i < numStreams; ++i)
                 {
                     const StreamDescription& description = Descriptions->streams[i];
                     RenderTarget& target = renderTargets[description.handle];
                     GenerateDX11Texture(Graphics.GetDevice(), target, description.width, description.height, description.format);
+                    if (EnableThumbnails && !GenerateThumbnail(Graphics.GetDevice(), thumbnails[description.handle], description, thumbnailDirectory, ThumbnailMemory, thumbnailInterval))
+                        logger->error("Failed to create thumbnail for {}", description.name);
                    // Graphics.AddSpoutSource(description.channel);
                 }
 
@@ -660,48 +811,82 @@ int main(int argc, char* argv[])
                 logger->error("Failed to get context");
                 continue;
             }
-            //Using a pixel shader and vertex shader we will blit the output
+            // Only the part of the canvas clipped for this stream is used.
+            // A region the size of the stream is copied and any other
+            // size is scaled by the draw below.
+            D3D11_TEXTURE2D_DESC stagingDesc = {};
+            if (stagingTexture)
+                stagingTexture->GetDesc(&stagingDesc);
+            D3D11_TEXTURE2D_DESC targetDesc = {};
+            target.texture->GetDesc(&targetDesc);
+            const FrameRegion region = toFrameRegion(description.clipping, stagingDesc.Width, stagingDesc.Height);
+
+            if (stagingTexture && stagingDesc.Format == targetDesc.Format
+                && region.width == description.width && region.height == description.height) {
+                D3D11_BOX box = { region.xOffset, region.yOffset, 0,
+                    region.xOffset + region.width, region.yOffset + region.height, 1 };
+                D3DContext->CopySubresourceRegion(target.texture.Get(), 0, 0, 0, 0, stagingTexture.Get(), 0, &box);
+            }
+            else {
+                // Texture coordinates of the region
+                Vertex clipped[ARRAYSIZE(quad)];
+                for (size_t v = 0; v < ARRAYSIZE(quad); ++v) {
+                    clipped[v] = quad[v];
+                    if (stagingDesc.Width > 0 && stagingDesc.Height > 0) {
+                        clipped[v].u = (region.xOffset + quad[v].u * region.width) / stagingDesc.Width;
+                        clipped[v].v = (region.yOffset + quad[v].v * region.height) / stagingDesc.Height;
+                    }
+                }
+                D3DContext->UpdateSubresource(vertexBuffer.Get(), 0, nullptr, clipped, 0, 0);
 
-            D3DContext->OMSetRenderTargets(1, target.view.GetAddressOf(), nullptr);
+                //Using a pixel shader and vertex shader we will blit the output
 
-            const float clearColour[4] = { 0.f, 0.8f, 0.f, 0.f };
-            D3DContext->ClearRenderTargetView(target.view.Get(), clearColour);
+                D3DContext->OMSetRenderTargets(1, target.view.GetAddressOf(), nullptr);
 
-            D3D11_VIEWPORT viewport;
-            ZeroMemory(&viewport, sizeof(D3D11_VIEWPORT));
-            viewport.Width = static_cast<float>(description.width);
-            viewport.Height = static_cast<float>(description.height);
-            viewport.MinDepth = 0;
-            viewport.MaxDepth = 1;
-            D3DContext->RSSetViewports(1, &viewport);
+                const float clearColour[4] = { 0.f, 0.8f, 0.f, 0.f };
+                D3DContext->ClearRenderTargetView(target.view.Get(), clearColour);
 
+                D3D11_VIEWPORT viewport;
+                ZeroMemory(&viewport, sizeof(D3D11_VIEWPORT));
+                viewport.Width = static_cast<float>(description.width);
+                viewport.Height = static_cast<float>(description.height);
+                viewport.MinDepth = 0;
+                viewport.MaxDepth = 1;
+                D3DContext->RSSetViewports(1, &viewport);
 
-            // Set what the inputs to the shader are
 
-            UINT stride = sizeof(Vertex);
-            UINT offset = 0;
-            D3DContext->IASetInputLayout(inputLayout.Get());
-            D3DContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-            D3DContext->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
+                // Set what the inputs to the shader are
 
+                UINT stride = sizeof(Vertex);
+                UINT offset = 0;
+                D3DContext->IASetInputLayout(inputLayout.Get());
+                D3DContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+                D3DContext->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
 
-           // D3DContext->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+
+               // D3DContext->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
  
-            // Set the shaders
-            D3DContext->VSSetShader(vertexShader.Get(), nullptr, 0);
+                // Set the shaders
+                D3DContext->VSSetShader(vertexShader.Get(), nullptr, 0);
 
-            D3DContext->PSSetSamplers(0, 1, samplerState.GetAddressOf());
-            D3DContext->PSSetShaderResources(0, 1, stagingSRV.GetAddressOf());
+                D3DContext->PSSetSamplers(0, 1, samplerState.GetAddressOf());
+                D3DContext->PSSetShaderResources(0, 1, stagingSRV.GetAddressOf());
 
-            D3DContext->PSSetShader(pixelShader.Get(), nullptr, 0);
+                D3DContext->PSSetShader(pixelShader.Get(), nullptr, 0);
 
 
 
-           // D3DContext->PSSetShaderResources(0, 1, stagingSRV.GetAddressOf());
-            D3DContext->Draw(6,0);
+               // D3DContext->PSSetShaderResources(0, 1, stagingSRV.GetAddressOf());
+                D3DContext->Draw(6,0);
+            }
 
             //Check for errors
 
+            if (EnableThumbnails) {
+                auto thumbnail = thumbnails.find(description.handle);
+                if (thumbnail != thumbnails.end())
+                    UpdateThumbnail(D3DContext.Get(), thumbnail->second, target.texture.Get());
+            }
 
             SenderFrame data;
             data.type = RS_FRAMETYPE_DX11_TEXTURE;